@@ -0,0 +1,555 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * ROM translator
+ *
+ * Copyright (c) 1999-2019 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file ROM translator.
+ *
+ * Build-time tool that translates the code of 16K ROM images to C.
+ * Starting from the reset, interrupt and NMI entry points it follows
+ * the control flow through the ROM and splits the code into basic
+ * blocks. Each block becomes a C function which executes the decoded
+ * instructions one after another by calling their handlers directly.
+ * The handlers (and with them the T-state accounting) are the same ones
+ * the interpreter uses, their names are taken from z80itab.c.
+ *
+ * The output is included into z80.c (see z80_aot_find()).
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Size of a ROM image */
+#define AOT_ROM_SIZE 0x4000
+/** Maximum number of instructions in one block */
+#define AOT_BLK_MAX 32
+
+/*
+ * Handler names from the instruction decode tables, in the order of
+ * the decode table index used by z80.c
+ */
+#define EI_TAB_BEGIN(name) static const char *name[256] = {
+#define EI4(op, f0, f1, f2, f3, t0, t1, t2, t3) #f0, #f1, #f2, #f3,
+#define EI_TAB_END };
+
+#include "z80itab.c"
+
+static const char **ei_tabs[7] = {
+	ei_op, ei_ddop, ei_fdop, ei_cbop, ei_ddcbop, ei_fdcbop, ei_edop
+};
+
+/** Decode table of unprefixed CB instructions */
+#define TAB_CB 3
+/** Decode table of ED instructions */
+#define TAB_ED 6
+
+/** How an instruction affects the control flow */
+typedef enum {
+	/** Execution continues with the next instruction */
+	aot_next,
+	/** Execution may continue at a target or the next instruction */
+	aot_cond,
+	/** Execution does not continue with the next instruction */
+	aot_end
+} aot_flow_t;
+
+/** Decoded instruction */
+typedef struct {
+	/** Address */
+	uint16_t pc;
+	/** Number of bytes fetched by the decoder */
+	uint8_t dlen;
+	/** Total length in bytes */
+	uint8_t len;
+	/** Decode table index */
+	uint8_t tabi;
+	/** Opcode */
+	uint8_t opcode;
+	/** Displacement of DDCB/FDCB instruction */
+	uint8_t cbop;
+	/** Decoder increments R for the CB/ED prefix */
+	uint8_t rinc;
+	/** DD/FD modifier in effect */
+	uint8_t modifier;
+	/** Handler from the decode table */
+	const char *fn;
+	/** Handler that actually determines what the instruction does */
+	const char *sem;
+} aot_instr_t;
+
+/** Translated ROM */
+typedef struct {
+	/** Name used in generated identifiers */
+	const char *name;
+	/** Image */
+	uint8_t img[AOT_ROM_SIZE];
+	/** Block number + 1 of unprefixed instruction at each address */
+	uint16_t owner[AOT_ROM_SIZE];
+	/** Address is a pending entry point */
+	uint8_t queued[AOT_ROM_SIZE];
+	/** Byte belongs to a translated instruction */
+	uint8_t covered[AOT_ROM_SIZE];
+	/** Pending entry points */
+	uint16_t work[AOT_ROM_SIZE];
+	/** Number of pending entry points */
+	unsigned nwork;
+	/** Number of blocks */
+	unsigned nblk;
+	/** Number of translated instructions */
+	unsigned ninstr;
+} aot_rom_t;
+
+/** Instructions of the block being translated */
+static aot_instr_t blk[AOT_BLK_MAX];
+
+/** Read ROM byte.
+ *
+ * @param rom ROM
+ * @param addr Address (may lie past the end of the ROM)
+ * @return Byte value, zero past the end of the ROM
+ */
+static uint8_t aot_byte(aot_rom_t *rom, unsigned addr)
+{
+	return addr < AOT_ROM_SIZE ? rom->img[addr] : 0;
+}
+
+/** Determine length of instruction operands from handler name.
+ *
+ * Handler names spell out the operands, N stands for a byte, NN for
+ * a word and iIXN/iIYN for an indexed memory operand.
+ *
+ * @param sem Handler name
+ * @return Number of operand bytes following the opcode
+ */
+static unsigned aot_oplen(const char *sem)
+{
+	char buf[64];
+	char *tok;
+	unsigned len = 0;
+
+	if (strcmp(sem, "ei_djnz") == 0)
+		return 1;
+
+	strncpy(buf, sem + 3, sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = '\0';
+
+	for (tok = strtok(buf, "_"); tok != NULL; tok = strtok(NULL, "_")) {
+		if (strcmp(tok, "NN") == 0 || strcmp(tok, "iNN") == 0)
+			len += 2;
+		else if (strcmp(tok, "N") == 0 || strcmp(tok, "iN") == 0 ||
+		    strcmp(tok, "iIXN") == 0 || strcmp(tok, "iIYN") == 0)
+			len += 1;
+	}
+
+	return len;
+}
+
+/** Decode instruction.
+ *
+ * Mirrors z80_decode() in z80.c.
+ *
+ * @param rom ROM
+ * @param pc Address
+ * @param modifier DD/FD modifier in effect (0, 1 or 2)
+ * @param ins Place to store decoded instruction
+ * @return Zero on success, -1 if the instruction does not fit in the ROM
+ */
+static int aot_decode(aot_rom_t *rom, unsigned pc, uint8_t modifier,
+    aot_instr_t *ins)
+{
+	uint8_t b = aot_byte(rom, pc);
+
+	memset(ins, 0, sizeof(aot_instr_t));
+	ins->pc = pc;
+	ins->modifier = modifier;
+
+	if (b == 0xed) {
+		ins->tabi = TAB_ED;
+		ins->rinc = 1;
+		ins->opcode = aot_byte(rom, pc + 1);
+		ins->dlen = 2;
+	} else if (b == 0xcb && modifier != 0) {
+		ins->tabi = TAB_CB + modifier;
+		ins->cbop = aot_byte(rom, pc + 1);
+		ins->opcode = aot_byte(rom, pc + 2);
+		ins->dlen = 3;
+	} else if (b == 0xcb) {
+		ins->tabi = TAB_CB;
+		ins->rinc = 1;
+		ins->opcode = aot_byte(rom, pc + 1);
+		ins->dlen = 2;
+	} else {
+		ins->tabi = modifier;
+		ins->opcode = b;
+		ins->dlen = 1;
+	}
+
+	ins->fn = ei_tabs[ins->tabi][ins->opcode];
+	ins->sem = ins->fn;
+	if (strcmp(ins->fn, "Si_stray") == 0)
+		ins->sem = ei_op[ins->opcode];
+
+	ins->len = ins->dlen;
+	if (ins->tabi < TAB_CB || ins->tabi == TAB_ED)
+		ins->len += aot_oplen(ins->sem);
+
+	if (pc + ins->len > AOT_ROM_SIZE)
+		return -1;
+
+	return 0;
+}
+
+/** Queue entry point for translation.
+ *
+ * @param rom ROM
+ * @param addr Entry point address
+ */
+static void aot_queue(aot_rom_t *rom, unsigned addr)
+{
+	if (addr >= AOT_ROM_SIZE || rom->queued[addr])
+		return;
+
+	rom->queued[addr] = 1;
+	rom->work[rom->nwork++] = addr;
+}
+
+/** Determine control flow effect of instruction and queue its targets.
+ *
+ * @param rom ROM
+ * @param ins Instruction
+ * @return Control flow effect
+ */
+static aot_flow_t aot_flow(aot_rom_t *rom, aot_instr_t *ins)
+{
+	const char *s = ins->sem + 3;
+	unsigned next = ins->pc + ins->len;
+	unsigned nn = aot_byte(rom, next - 2) | (aot_byte(rom, next - 1) << 8);
+	unsigned rel = (next + (int8_t)aot_byte(rom, next - 1)) & 0xffff;
+
+	/* DD/FD after CB/ED leaves the modifier in effect */
+	if (ins->tabi >= TAB_CB && (ins->opcode == 0xdd || ins->opcode == 0xfd))
+		return aot_end;
+
+	if (strcmp(s, "jp_NN") == 0) {
+		aot_queue(rom, nn);
+		return aot_end;
+	}
+	if (strcmp(s, "jr_N") == 0) {
+		aot_queue(rom, rel);
+		return aot_end;
+	}
+	if (strcmp(s, "call_NN") == 0) {
+		aot_queue(rom, nn);
+		aot_queue(rom, next);
+		return aot_end;
+	}
+	if (strncmp(s, "rst_", 4) == 0) {
+		aot_queue(rom, strtoul(s + 4, NULL, 16));
+		return aot_end;
+	}
+	if (strcmp(s, "ret") == 0 || strcmp(s, "reti") == 0 ||
+	    strcmp(s, "retn") == 0 || strcmp(s, "halt") == 0 ||
+	    (strncmp(s, "jp_", 3) == 0 && aot_oplen(ins->sem) == 0))
+		return aot_end;
+
+	/* Output can page in a different ROM */
+	if (strncmp(s, "out", 3) == 0 || strncmp(s, "ot", 2) == 0) {
+		aot_queue(rom, next);
+		return aot_end;
+	}
+
+	if (strncmp(s, "jp_", 3) == 0 || strncmp(s, "call_", 5) == 0) {
+		aot_queue(rom, nn);
+		aot_queue(rom, next);
+		return aot_cond;
+	}
+	if (strncmp(s, "jr_", 3) == 0 || strcmp(s, "djnz") == 0) {
+		aot_queue(rom, rel);
+		return aot_cond;
+	}
+
+	return aot_next;
+}
+
+/** Translate one basic block.
+ *
+ * The block is emitted as a switch with one case label per unprefixed
+ * instruction so that it can be entered at any of them.
+ *
+ * @param rom ROM
+ * @param addr Entry point
+ * @param f Output file
+ */
+static void aot_block(aot_rom_t *rom, unsigned addr, FILE *f)
+{
+	unsigned n = 0;
+	unsigned pc = addr;
+	uint8_t modifier = 0;
+	aot_flow_t flow;
+	unsigned i;
+
+	while (n < AOT_BLK_MAX) {
+		if (modifier == 0 && rom->owner[pc] != 0)
+			break;
+		if (pc >= AOT_ROM_SIZE || aot_decode(rom, pc, modifier,
+		    &blk[n]) < 0)
+			break;
+		if (modifier == 0)
+			rom->owner[pc] = rom->nblk + 1;
+		memset(rom->covered + pc, 1, blk[n].len);
+
+		flow = aot_flow(rom, &blk[n]);
+		pc += blk[n].len;
+		++n;
+
+		if (flow == aot_end)
+			break;
+
+		if (strcmp(blk[n - 1].sem, "Mi_dd") == 0)
+			modifier = 1;
+		else if (strcmp(blk[n - 1].sem, "Mi_fd") == 0)
+			modifier = 2;
+		else
+			modifier = 0;
+	}
+
+	if (n >= AOT_BLK_MAX && modifier == 0)
+		aot_queue(rom, pc);
+
+	/* Block that would start with a prefixed instruction */
+	if (n == 0)
+		return;
+
+	fprintf(f, "static void aot_%s_%u(z80_t *z) {\n", rom->name, rom->nblk);
+	fprintf(f, "  switch(z->cpus.PC) {\n");
+	for (i = 0; i < n; i++) {
+		if (blk[i].modifier == 0)
+			fprintf(f, "  case 0x%04x:\n", blk[i].pc);
+		fprintf(f, "    AOT_I(%u, %u, 0x%02x, 0x%02x, %u, %s, 0x%04x)\n",
+		    blk[i].dlen, blk[i].tabi, blk[i].opcode, blk[i].cbop,
+		    blk[i].rinc, blk[i].fn, blk[i].pc + blk[i].len);
+	}
+	fprintf(f, "  }\n");
+	fprintf(f, "}\n\n");
+
+	rom->ninstr += n;
+	++rom->nblk;
+}
+
+/** Compute ROM image hash (64-bit FNV-1a).
+ *
+ * Must give the same result as aot_hash() in z80.c.
+ *
+ * @param img ROM image
+ * @return Hash
+ */
+static uint64_t aot_hash(const uint8_t *img)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	unsigned i;
+
+	for (i = 0; i < AOT_ROM_SIZE; i++) {
+		h ^= img[i];
+		h *= 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+/** Translate ROM image.
+ *
+ * @param rom ROM with image loaded
+ * @param f Output file
+ */
+static void aot_rom(aot_rom_t *rom, FILE *f)
+{
+	unsigned a;
+	unsigned i;
+	unsigned j;
+
+	/* Reset, maskable interrupt and NMI */
+	aot_queue(rom, 0x0000);
+	aot_queue(rom, 0x0038);
+	aot_queue(rom, 0x0066);
+
+	fprintf(f, "/* %s */\n\n", rom->name);
+
+	for (i = 0; i < rom->nwork; i++)
+		aot_block(rom, rom->work[i], f);
+
+	/*
+	 * Much of the ROM code is only reached through JP (HL), RST 28h and
+	 * tables of addresses, so sweep up whatever bytes are left. Decoding
+	 * does not depend on how the code is reached, so translating data
+	 * by mistake costs space, but not correctness.
+	 */
+	for (a = 0; a < AOT_ROM_SIZE; a++) {
+		if (rom->covered[a])
+			continue;
+		aot_queue(rom, a);
+		for (; i < rom->nwork; i++)
+			aot_block(rom, rom->work[i], f);
+	}
+
+	fprintf(f, "static void (*const aot_%s_blk[])(z80_t *) = {\n",
+	    rom->name);
+	for (i = 0; i < rom->nblk; i++)
+		fprintf(f, "  aot_%s_%u,\n", rom->name, i);
+	fprintf(f, "};\n\n");
+
+	fprintf(f, "static const uint16_t aot_%s_ents[] = {\n", rom->name);
+	for (i = 0, j = 0; i < AOT_ROM_SIZE; i++) {
+		if (rom->owner[i] == 0)
+			continue;
+		fprintf(f, "%s0x%04x, %u,", j % 4 == 0 ? "  " : " ", i,
+		    rom->owner[i] - 1);
+		if (++j % 4 == 0)
+			fprintf(f, "\n");
+	}
+	if (j % 4 != 0)
+		fprintf(f, "\n");
+	fprintf(f, "};\n\n");
+
+	fprintf(f, "static uint16_t aot_%s_idx[0x4000];\n\n", rom->name);
+}
+
+/** Load ROM image.
+ *
+ * @param fname File name
+ * @param rom ROM to fill in
+ * @return Zero on success, -1 on error
+ */
+static int aot_load(const char *fname, aot_rom_t *rom)
+{
+	FILE *f;
+	const char *base;
+	char *name;
+	char *p;
+
+	f = fopen(fname, "rb");
+	if (f == NULL) {
+		fprintf(stderr, "Cannot open '%s'.\n", fname);
+		return -1;
+	}
+
+	if (fread(rom->img, 1, AOT_ROM_SIZE, f) != AOT_ROM_SIZE) {
+		fprintf(stderr, "'%s' is shorter than 16K.\n", fname);
+		fclose(f);
+		return -1;
+	}
+
+	fclose(f);
+
+	/* Base name without extension */
+	base = strrchr(fname, '/');
+	base = base != NULL ? base + 1 : fname;
+	name = strdup(base);
+	if (name == NULL)
+		return -1;
+	p = strchr(name, '.');
+	if (p != NULL)
+		*p = '\0';
+	for (p = name; *p != '\0'; p++) {
+		if (!(*p >= 'a' && *p <= 'z') && !(*p >= 'A' && *p <= 'Z') &&
+		    !(*p >= '0' && *p <= '9'))
+			*p = '_';
+	}
+
+	rom->name = name;
+	return 0;
+}
+
+/** Print command line syntax help. */
+static void print_syntax(void)
+{
+	fprintf(stderr, "GZX ROM translator\n");
+	fprintf(stderr, "syntax: aotgen <output.c> <rom-file>...\n");
+}
+
+int main(int argc, char *argv[])
+{
+	aot_rom_t *roms;
+	FILE *f;
+	int nroms;
+	int i;
+
+	if (argc < 3) {
+		print_syntax();
+		return 1;
+	}
+
+	nroms = argc - 2;
+	roms = calloc(nroms, sizeof(aot_rom_t));
+	if (roms == NULL) {
+		fprintf(stderr, "Out of memory.\n");
+		return 1;
+	}
+
+	for (i = 0; i < nroms; i++) {
+		if (aot_load(argv[2 + i], &roms[i]) < 0)
+			return 1;
+	}
+
+	f = fopen(argv[1], "wt");
+	if (f == NULL) {
+		fprintf(stderr, "Cannot create '%s'.\n", argv[1]);
+		return 1;
+	}
+
+	fprintf(f, "/*\n * Translated ROM code, generated by aotgen. "
+	    "Do not edit.\n *\n * This file is included into z80.c\n */\n\n");
+
+	for (i = 0; i < nroms; i++)
+		aot_rom(&roms[i], f);
+
+	fprintf(f, "static z80_aot_t aot_roms[] = {\n");
+	for (i = 0; i < nroms; i++) {
+		fprintf(f, "  { 0x%016llxULL, aot_%s_blk, aot_%s_ents,\n"
+		    "    sizeof(aot_%s_ents) / (2 * sizeof(uint16_t)), "
+		    "aot_%s_idx, 0 },\n",
+		    (unsigned long long)aot_hash(roms[i].img), roms[i].name,
+		    roms[i].name, roms[i].name, roms[i].name);
+	}
+	fprintf(f, "};\n");
+
+	if (fclose(f) != 0) {
+		fprintf(stderr, "Error writing '%s'.\n", argv[1]);
+		return 1;
+	}
+
+	for (i = 0; i < nroms; i++) {
+		printf("%s: %u blocks, %u instructions\n", roms[i].name,
+		    roms[i].nblk, roms[i].ninstr);
+	}
+
+	return 0;
+}
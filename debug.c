@@ -39,6 +39,7 @@
 #include "zx_scr.h"
 #include "z80.h"
 #include "disasm.h"
+#include "zx.h"
 #include "sys_all.h"
 
 #define MK_PAIR(hi,lo) ( (((uint16_t)(hi)) << 8) | (lo) )
@@ -77,7 +78,7 @@ static void dflag(char *name, int value) {
   snprintf(buf,8,"%d ",value); gputs(buf);
 }
 
-static void d_regs(void) {
+static void d_regs(zx_machine_t *mach) {
   
   mgfx_fillrect(0,0,scr_xs-1,scr_ys-1,0);
   
@@ -89,38 +90,38 @@ static void d_regs(void) {
   
   fgc=5;
   
-  gmovec(1,2); dreg("AF", MK_PAIR(cpus.r[rA],cpus.F));
-  gmovec(1,3); dreg("BC", MK_PAIR(cpus.r[rB],cpus.r[rC]));
-  gmovec(1,4); dreg("DE", MK_PAIR(cpus.r[rD],cpus.r[rE]));
-  gmovec(1,5); dreg("HL", MK_PAIR(cpus.r[rH],cpus.r[rL]));
+  gmovec(1,2); dreg("AF", MK_PAIR(mach->cpu.cpus.r[rA],mach->cpu.cpus.F));
+  gmovec(1,3); dreg("BC", MK_PAIR(mach->cpu.cpus.r[rB],mach->cpu.cpus.r[rC]));
+  gmovec(1,4); dreg("DE", MK_PAIR(mach->cpu.cpus.r[rD],mach->cpu.cpus.r[rE]));
+  gmovec(1,5); dreg("HL", MK_PAIR(mach->cpu.cpus.r[rH],mach->cpu.cpus.r[rL]));
   
-  gmovec(10,2); dreg("A'F'", MK_PAIR(cpus.r_[rA],cpus.F_));
-  gmovec(10,3); dreg("B'C'", MK_PAIR(cpus.r_[rB],cpus.r_[rC]));
-  gmovec(10,4); dreg("D'E'", MK_PAIR(cpus.r_[rD],cpus.r_[rE]));
-  gmovec(10,5); dreg("H'L'", MK_PAIR(cpus.r_[rH],cpus.r_[rL]));
+  gmovec(10,2); dreg("A'F'", MK_PAIR(mach->cpu.cpus.r_[rA],mach->cpu.cpus.F_));
+  gmovec(10,3); dreg("B'C'", MK_PAIR(mach->cpu.cpus.r_[rB],mach->cpu.cpus.r_[rC]));
+  gmovec(10,4); dreg("D'E'", MK_PAIR(mach->cpu.cpus.r_[rD],mach->cpu.cpus.r_[rE]));
+  gmovec(10,5); dreg("H'L'", MK_PAIR(mach->cpu.cpus.r_[rH],mach->cpu.cpus.r_[rL]));
   
-  gmovec(21,2); dreg("IX", cpus.IX);
-  gmovec(21,3); dreg("IY", cpus.IY);
-  gmovec(21,4); dreg("IR", MK_PAIR(cpus.I, cpus.R));
-  gmovec(21,5); dreg("SP", cpus.SP);
+  gmovec(21,2); dreg("IX", mach->cpu.cpus.IX);
+  gmovec(21,3); dreg("IY", mach->cpu.cpus.IY);
+  gmovec(21,4); dreg("IR", MK_PAIR(mach->cpu.cpus.I, mach->cpu.cpus.R));
+  gmovec(21,5); dreg("SP", mach->cpu.cpus.SP);
 
-  gmovec(30,2); dflag("IFF1:",cpus.IFF1);
-  gmovec(30,3); dflag("IFF2:",cpus.IFF2);
-  gmovec(30,4); dflag("IM:  ",cpus.int_mode);
-  gmovec(30,5); dflag("HLT: ",cpus.halted);
+  gmovec(30,2); dflag("IFF1:",mach->cpu.cpus.IFF1);
+  gmovec(30,3); dflag("IFF2:",mach->cpu.cpus.IFF2);
+  gmovec(30,4); dflag("IM:  ",mach->cpu.cpus.int_mode);
+  gmovec(30,5); dflag("HLT: ",mach->cpu.cpus.halted);
 
   gmovec(1,7);
-  dflag("S:",(cpus.F&fS)!=0);
-  dflag("Z:",(cpus.F&fZ)!=0);
-  dflag("H:",(cpus.F&fHC)!=0);
-  dflag("PV:",(cpus.F&fPV)!=0);
-  dflag("N:",(cpus.F&fN)!=0);
-  dflag("C:",(cpus.F&fC)!=0);
+  dflag("S:",(mach->cpu.cpus.F&fS)!=0);
+  dflag("Z:",(mach->cpu.cpus.F&fZ)!=0);
+  dflag("H:",(mach->cpu.cpus.F&fHC)!=0);
+  dflag("PV:",(mach->cpu.cpus.F&fPV)!=0);
+  dflag("N:",(mach->cpu.cpus.F&fN)!=0);
+  dflag("C:",(mach->cpu.cpus.F&fC)!=0);
   
-  gmovec(30,7); dreg("PC", cpus.PC);
+  gmovec(30,7); dreg("PC", mach->cpu.cpus.PC);
 }
 
-static void d_hex(void) {
+static void d_hex(zx_machine_t *mach) {
   int i,j;
   char buf[16];
   uint8_t b;
@@ -131,11 +132,11 @@ static void d_hex(void) {
     gmovec(1,HEX_CY+i); gputs(buf);
     fgc=5;
     for(j=0;j<8;j++) {      
-      b=zx_memget8(hex_base+8*i+j);
+      b=zx_memget8(mach,hex_base+8*i+j);
       gputc(b);
     }
     for(j=0;j<8;j++) {
-      b=zx_memget8(hex_base+8*i+j);
+      b=zx_memget8(mach,hex_base+8*i+j);
       snprintf(buf,16,"%02X", b);
       gmovec(16+3*j,HEX_CY+i);
       gputs(buf);
@@ -143,7 +144,7 @@ static void d_hex(void) {
   }
 }
 
-static void d_instr(void) {
+static void d_instr(zx_machine_t *mach) {
   int i;
   uint16_t xpos,c;
   char buf[16];
@@ -156,11 +157,11 @@ static void d_instr(void) {
     snprintf(buf,16,"%04X:",disasm_org&0xffff);
     gmovec(1,INSTR_CY+i); gputs(buf);
     
-    disasm_instr();
+    disasm_instr(mach);
 
     fgc=5;    
     for(c=xpos;c!=disasm_org;c++) {
-      snprintf(buf,16,"%02X",zx_memget8(c));
+      snprintf(buf,16,"%02X",zx_memget8(mach,c));
       gputs(buf);
     }
     
@@ -172,9 +173,9 @@ static void d_instr(void) {
   bgc=0;
 }
 
-static void instr_next(void) {
+static void instr_next(zx_machine_t *mach) {
   disasm_org=instr_base;
-  disasm_instr();
+  disasm_instr(mach);
   instr_base=disasm_org;
 }
 
@@ -187,14 +188,14 @@ static void instr_next(void) {
 
 #define BKTRACE 8
 
-static void instr_prev(void) {
+static void instr_prev(zx_machine_t *mach) {
   uint16_t c,last;
   
   disasm_org = instr_base-BKTRACE;
   c=0;
   do {
     last=disasm_org;
-    disasm_instr();
+    disasm_instr(mach);
     c++;
   } while(c<BKTRACE && disasm_org!=instr_base);
   
@@ -216,34 +217,34 @@ static void d_run_upto(uint16_t addr) {
   dbg_exit = true;
 }
 
-static void d_stepover(void) {
+static void d_stepover(zx_machine_t *mach) {
   uint8_t b;
   
-  b = zx_memget8(cpus.PC);
+  b = zx_memget8(mach, mach->cpu.cpus.PC);
   if(b==0xCD || (b&0xC7)==0xC4) {
     /* CALL or CALL cond */
-    disasm_org=cpus.PC;
-    disasm_instr();
+    disasm_org=mach->cpu.cpus.PC;
+    disasm_instr(mach);
     d_run_upto(disasm_org);
   } else {
     d_trace();
   }
 }
 
-static void d_to_cursor(void) {
+static void d_to_cursor(zx_machine_t *mach) {
   int i;
   
   disasm_org=instr_base;
   for(i=0;i<ic_ln;i++)
-    disasm_instr();
+    disasm_instr(mach);
     
   d_run_upto(disasm_org);
 }
 
-static void d_view_scr(void) {
+static void d_view_scr(zx_machine_t *mach) {
   wkey_t k;
   
-  zx_scr_disp_fast();
+  zx_scr_disp_fast(mach);
   mgfx_updscr();
   while(1) {
     mgfx_input_update();
@@ -254,43 +255,43 @@ static void d_view_scr(void) {
   }
 }
 
-static void curs_up(void) {
+static void curs_up(zx_machine_t *mach) {
   if(ic_ln>0) ic_ln--;
-    else instr_prev();
+    else instr_prev(mach);
 }
 
-static void curs_down(void) {
+static void curs_down(zx_machine_t *mach) {
   if(ic_ln<INSTR_LINES-1) ic_ln++;
-    else instr_next();
+    else instr_next(mach);
 }
 
-static void curs_pgup(void) {
+static void curs_pgup(zx_machine_t *mach) {
   int i;
   for(i=0;i<INSTR_LINES-1;i++)
-    curs_up();
+    curs_up(mach);
 }
 
-static void curs_pgdown(void) {
+static void curs_pgdown(zx_machine_t *mach) {
   int i;
   for(i=0;i<INSTR_LINES-1;i++)
-    curs_down();
+    curs_down(mach);
 }
 
-void debugger(void) {
+void debugger(zx_machine_t *mach) {
   wkey_t k;
   
   dbg_stop_enabled = false;
   dbg_itrap_enabled = false;
   
-  instr_base = cpus.PC;
+  instr_base = mach->cpu.cpus.PC;
   ic_ln = 0;
   dbg_exit = false;
       
   while(!dbg_exit) {
     mgfx_selln(3);
-    d_regs();
-    d_hex();
-    d_instr();
+    d_regs(mach);
+    d_hex(mach);
+    d_instr(mach);
     mgfx_updscr();
     do {
       mgfx_input_update();
@@ -307,17 +308,17 @@ void debugger(void) {
 	//zx_save_snap(fn_line.buf);
 	return;
 
-      case WKEY_UP: curs_up(); break;
-      case WKEY_DOWN: curs_down(); break;
-      case WKEY_PGUP: curs_pgup(); break;
-      case WKEY_PGDN: curs_pgdown(); break;
+      case WKEY_UP: curs_up(mach); break;
+      case WKEY_DOWN: curs_down(mach); break;
+      case WKEY_PGUP: curs_pgup(mach); break;
+      case WKEY_PGDN: curs_pgdown(mach); break;
       case WKEY_HOME: instr_base-=256; break;
       case WKEY_END: instr_base+=256; break;
 	
       case WKEY_F7: d_trace(); break;
-      case WKEY_F8: d_stepover(); break;
-      case WKEY_F9: d_to_cursor(); break;
-      case WKEY_F11: d_view_scr(); break;
+      case WKEY_F8: d_stepover(mach); break;
+      case WKEY_F9: d_to_cursor(mach); break;
+      case WKEY_F11: d_view_scr(mach); break;
         
       default:
         //teline_key(&fn_line,&k);
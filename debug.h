@@ -38,6 +38,8 @@ extern bool dbg_itrap_enabled;
 extern bool dbg_stop_enabled;
 extern uint16_t dbg_stop_addr;
 
-void debugger(void);
+struct zx_machine;
+
+void debugger(struct zx_machine *);
 
 #endif
@@ -234,6 +234,8 @@ static int edcb; /* 0=none 1=ED 2=CB */
 
 static int cur_arg;
 static uint16_t in_pos;
+/* machine whose memory is being disassembled */
+static zx_machine_t *in_mach;
 
 uint16_t disasm_org;
 char disasm_buf[BUF_SIZE];
@@ -243,7 +245,7 @@ static int out_pos;
 static int da_getc(void) {
   int b;
 
-  b=zx_memget8(in_pos++);
+  b=zx_memget8(in_mach,in_pos++);
   disasm_org=in_pos;
   
   return b;
@@ -413,10 +415,11 @@ static int dec_instr(void) {
   return 0;
 }
 
-int disasm_instr(void) {
+int disasm_instr(zx_machine_t *mach) {
   char *ops;
   int l;
 
+  in_mach = mach;
   in_pos = disasm_org;
   
   out_pos=0;  
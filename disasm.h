@@ -34,9 +34,11 @@
 
 #include <stdint.h>
 
+struct zx_machine;
+
 extern uint16_t disasm_org;
 extern char disasm_buf[];
 
-int disasm_instr(void);
+int disasm_instr(struct zx_machine *);
 
 #endif
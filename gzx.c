@@ -38,16 +38,16 @@
 #include <ctype.h>
 #include <string.h>
 #include <time.h>
-#include "clock.h"
 #include "memio.h"
 #include "midi.h"
 #include "mgfx.h"
 #include "gzx.h"
 #include "iorec.h"
 #include "z80.h"
+#include "z80dep.h"
 #include "zx_kbd.h"
 #include "zx_scr.h"
-#include "rs232.h"
+#include "sched.h"
 #include "snap.h"
 #include "tape/quick.h"
 #include "ui/display.h"
@@ -63,27 +63,16 @@
 #include "xtrace.h"
 #include "z80g.h"
 #include "zx.h"
+#include "zx_run.h"
 #include "sys_all.h"
 #include "sysmidi.h"
 
-/*
-  Clock comparison is calculated in unsigned long. It works as long
-  as u.long has least 32 bits, and as long
-  as the clocks don't diverge by more than 2^31 T-states (=~600s).
-  (Much more than what is needed.)
-*/
-#define CLOCK_LT(a,b) ( (((a)-(b)) >> 31) != 0 )
-#define CLOCK_GE(a,b) ( (((a)-(b)) >> 31) == 0 )
-
 static void zx_scr_save(void);
-static void zx_proc_instr(void);
 
 int scr_no=0;
 
 FILE *logfi;
 
-static unsigned long disp_t;
-
 int quit=0;
 int slow_load=0;
 
@@ -94,39 +83,37 @@ bool ui_lock = false;
 /* ... used as base for finding the ROM files */
 char *start_dir;
 
+/** Machine the front end runs and displays */
+zx_machine_t *gzx_mach;
+
 /** MIDI device specification */
 const char *midi_dev;
 
-/** I/O recording */
-iorec_t *iorec;
+/** Z80 JIT mode (Z80_JIT_xxx) */
+static int jit_mode = Z80_JIT_OFF;
+
+/** Time every PROF_PERIOD-th instruction while profiling */
+#define PROF_PERIOD 16
+
+/** Z80 profiling is on */
+static bool prof_on;
+
+/** Count executed Z80 opcodes (written to the log file at exit) */
+static bool stat_on;
 
 int key_lalt_held;
 int key_lshift_held;
 
-static uint8_t tape_smp;
-
 /** Lock down user interface */
 void gzx_ui_lock(void)
 {
 	ui_lock = true;
 }
 
-/** Notify on 48K mode change.
- *
- * 48K mode is on if we're Spectrum 48K (or lower) or if we are Spectrum
- * 128K or higher locked in 48K emulation mode.
- */
-void gzx_notify_mode_48k(bool mode48k)
-{
-	/* Tape needs to know to handle Stop the tape if in 48K mode */
-	if (tape_deck != NULL)
-		tape_deck_set_48k(tape_deck, mode48k);
-}
-
 void gzx_toggle_dbl_ln(void)
 {
 	mgfx_toggle_dbl_ln();
-	zx_scr_disp_fast();
+	zx_scr_disp_fast(gzx_mach);
 }
 
 static void key_unmod(wkey_t *k)
@@ -136,7 +123,7 @@ static void key_unmod(wkey_t *k)
 	main_menu();
 	break;
       case WKEY_F1:
-	zx_load_snap("test.sna");
+	zx_load_snap(gzx_mach, "test.sna");
 	break;
       case WKEY_F2:
         save_snap_dialog();
@@ -146,34 +133,73 @@ static void key_unmod(wkey_t *k)
       case WKEY_F3: load_snap_dialog(); break;
       case WKEY_F5: tape_menu(); break;
       case WKEY_F6: hwopts_menu(); break;
-      case WKEY_F7: zx_select_memmodel(ZXM_48K); zx_reset(); break;
-      case WKEY_F8: zx_select_memmodel(ZXM_128K); zx_reset(); break;
+      case WKEY_F7:
+        zx_select_memmodel(gzx_mach, ZXM_48K);
+        zx_reset(gzx_mach);
+        break;
+      case WKEY_F8:
+        zx_select_memmodel(gzx_mach, ZXM_128K);
+        zx_reset(gzx_mach);
+        break;
       case WKEY_F9: select_tapefile_dialog(); break;
       case WKEY_F10: printf("F10 pressed\n"); quit=1; break;
       case WKEY_F11: mgfx_toggle_fs(); break;
-      case WKEY_NPLUS: tape_deck_play(tape_deck); break;
-      case WKEY_NMINUS: tape_deck_stop(tape_deck); break;
-      case WKEY_NSTAR: tape_deck_rewind(tape_deck); break;
+      case WKEY_NPLUS: tape_deck_play(gzx_mach->tape_deck); break;
+      case WKEY_NMINUS: tape_deck_stop(gzx_mach->tape_deck); break;
+      case WKEY_NSTAR: tape_deck_rewind(gzx_mach->tape_deck); break;
       case WKEY_NSLASH: slow_load=!slow_load; break;
-#ifdef XMAP
-      case WKEY_N5: xmap_clear(); break;
-#endif
-      case WKEY_F12: debugger(); break;
+      case WKEY_N5: if (xmap_enabled) xmap_clear(); break;
+      case WKEY_F12: debugger(gzx_mach); break;
       default: break;
     }
 }
 
+/** Start profiling Z80 opcodes */
+static void prof_start(void)
+{
+	if (prof_on)
+		return;
+
+	z80_prof_reset(&gzx_mach->cpu);
+	z80_prof_enable(&gzx_mach->cpu, 1, PROF_PERIOD, sys_time_ns);
+	prof_on = true;
+}
+
+/** Stop profiling Z80 opcodes and write out the profile */
+static void prof_stop(void)
+{
+	FILE *f;
+
+	if (!prof_on)
+		return;
+
+	z80_prof_enable(&gzx_mach->cpu, 0, 0, NULL);
+	prof_on = false;
+
+	f = fopen("prof.csv", "wt");
+	if (f != NULL) {
+		(void) z80_prof_write_csv(&gzx_mach->cpu, f);
+		fclose(f);
+	}
+
+	f = fopen("prof.json", "wt");
+	if (f != NULL) {
+		(void) z80_prof_write_json(&gzx_mach->cpu, f);
+		fclose(f);
+	}
+}
+
 static void key_lalt(wkey_t *k)
 {
    switch(k->key) {
       case WKEY_R:
-	if (iorec == NULL)
-	  (void) iorec_open("out.ior", &iorec);
+	if (gzx_mach->iorec == NULL)
+	  (void) iorec_open("out.ior", &gzx_mach->iorec);
 	break;
       case WKEY_T:
-        if (iorec != NULL) {
-	  iorec_close(iorec);
-	  iorec = NULL;
+        if (gzx_mach->iorec != NULL) {
+	  iorec_close(gzx_mach->iorec);
+	  gzx_mach->iorec = NULL;
 	}
 	break;
       case WKEY_W:
@@ -184,17 +210,23 @@ static void key_lalt(wkey_t *k)
         printf("Stopping audio capture.\n");
         zx_sound_stop_capture();
         break;
+      case WKEY_P:
+        prof_start();
+        break;
+      case WKEY_O:
+        prof_stop();
+        break;
       case WKEY_N:
-        zx_scr_prev_bg();
+        zx_scr_prev_bg(gzx_mach);
         break;
       case WKEY_M:
-        zx_scr_next_bg();
+        zx_scr_next_bg(gzx_mach);
         break;
       case WKEY_9:
-        zx_scr_mode(0);
+        zx_scr_mode(gzx_mach, 0);
         break;
       case WKEY_0:
-        zx_scr_mode(1);
+        zx_scr_mode(gzx_mach, 1);
         break;
     }
 }
@@ -216,25 +248,25 @@ static void key_joy_state_set(int key, int press)
 {
 	switch (key) {
 	case WKEY_UP:
-		kempston_joy_set_reset(&kjoy0, kempston_up, press);
+		kempston_joy_set_reset(&gzx_mach->kjoy, kempston_up, press);
 		break;
 	case WKEY_DOWN:
-		kempston_joy_set_reset(&kjoy0, kempston_down, press);
+		kempston_joy_set_reset(&gzx_mach->kjoy, kempston_down, press);
 		break;
 	case WKEY_LEFT:
-		kempston_joy_set_reset(&kjoy0, kempston_left, press);
+		kempston_joy_set_reset(&gzx_mach->kjoy, kempston_left, press);
 		break;
 	case WKEY_RIGHT:
-		kempston_joy_set_reset(&kjoy0, kempston_right, press);
+		kempston_joy_set_reset(&gzx_mach->kjoy, kempston_right, press);
 		break;
 	case WKEY_INS:
-		kempston_joy_set_reset(&kjoy0, kempston_button_1, press);
+		kempston_joy_set_reset(&gzx_mach->kjoy, kempston_button_1, press);
 		break;
 	case WKEY_DEL:
-		kempston_joy_set_reset(&kjoy0, kempston_button_2, press);
+		kempston_joy_set_reset(&gzx_mach->kjoy, kempston_button_2, press);
 		break;
 	case WKEY_HOME:
-		kempston_joy_set_reset(&kjoy0, kempston_button_3, press);
+		kempston_joy_set_reset(&gzx_mach->kjoy, kempston_button_3, press);
 		break;
 	}
 }
@@ -265,7 +297,7 @@ static void key_handler(wkey_t *k) {
     return;
   }
   
-  zx_key_state_set(&keys, k->key, k->press?1:0);
+  zx_key_state_set(&gzx_mach->keys, k->key, k->press?1:0);
   key_joy_state_set(k->key, k->press?1:0);
   
   if (k->press && !ui_lock) {
@@ -279,71 +311,50 @@ static void zx_scr_save(void) {
 
   snprintf(name, 32, "scr%04d.bin",scr_no++);
   f=fopen(name,"wb");
-  fwrite(zxscr,1,0x1B00,f);
+  fwrite(gzx_mach->scr,1,0x1B00,f);
   fclose(f);
 }
 
-/** Value was written to AY I/O port.
- *
- * @param arg Callback argument
- * @param val Value
- */
-static void gzx_ay_ioport_write(void *arg, uint8_t val)
-{
-	rs232_write(&rs232, val);
-}
-
-/** Character was sent via RS-232 port */
-static void gzx_rs232_sendchar(void *arg, uint8_t val)
-{
-	midi_port_write(&midi, val);
-}
-
 /** Midi event was sent via MIDI port */
 static void gzx_midi_msg(void *arg, midi_msg_t *msg)
 {
 #ifdef WITH_MIDI
-	sysmidi_send_msg(z80_clock, msg);
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	sysmidi_send_msg(mach->cpu.iclock, msg);
 #endif
 }
 
-static unsigned long snd_t,tapp_t;
+static void zx_frame_event(void *arg);
 
-void zx_reset(void) {
-#ifdef XTRACE
-  xtrace_reset();
-#endif
-  if (gpu_is_on()) {
-    gpu_reset();
-    gpu_disable();
+void zx_reset(zx_machine_t *mach) {
+  if (xtrace_enabled)
+    xtrace_reset();
+  if (gpu_is_on(mach)) {
+    gpu_reset(mach);
+    gpu_disable(mach);
   }
-  zx_scr_reset();
-  z80_reset();
-  ay_reset(&ay0);
-  
-  /* select default banks */
-  bnk_lock48=0;
-  zx_out8(0x7ffd,0x07);
+  zx_machine_reset(mach);
 }
 
 static int zx_init(void) {
+  zx_machine_t *mach;
+
 //  printf("coreleft:%lu\n",coreleft());
 
   z80_init_tables();
 
-  /* important! otherwise zx_select_memmodel would crash reallocing */
-  zxrom=NULL;
-  zxram=NULL;
-  zx_select_memmodel(ZXM_48K);
-
-  gpu_init();
 //  if (gpu_enable() < 0)
 //    return -1;
   printf("load font\n");
   gloadfont("font.bin");
   printf("init screen\n");
-  if(zx_scr_init(0)<0) return -1;
-  if(zx_keys_init(&keys)<0) return -1;
+  if(zx_scr_init()<0) return -1;
+  if(zx_machine_create(&video_out, &mach)<0) return -1;
+  gzx_mach = mach;
+  mach->frame = zx_frame_event;
+  mach->frame_arg = mach;
+  mach->run = zx_run_plain;
   printf("sound\n");
   if(zx_sound_init()<0) return -1;
 #ifdef WITH_MIDI
@@ -352,32 +363,9 @@ static int zx_init(void) {
   }
 #endif
 
-  printf("ay\n");
-  if(ay_init(&ay0, ZX_SOUND_TICKS_SMP)<0) return -1;
-  ay0.ioport_write = gzx_ay_ioport_write;
-  ay0.ioport_write_arg = &ay0;
-
-  rs232_init(&rs232, Z80_CLOCK / MIDI_BAUD);
-  rs232.sendchar = gzx_rs232_sendchar;
-  rs232.sendchar_arg = &rs232;
-
-  midi_port_init(&midi);
-  midi.midi_msg = gzx_midi_msg;
-  midi.midi_msg_arg = &midi;
-
-  kempston_joy_init(&kjoy0);
-
-  if(tape_deck_create(&tape_deck, true) != 0) return -1;
-  tape_deck->delta_t = ZX_TAPE_TICKS_SMP;
+  mach->midi.midi_msg = gzx_midi_msg;
+  mach->midi.midi_msg_arg = mach;
 
-  zx_reset();
-  
-  disp_t=0;
-  snd_t=0;
-  tapp_t=0;
-
-  border=7;
-  
   return 0;
 }
 
@@ -386,77 +374,78 @@ static void writestat_i(int i) {
   
   for(j=0;j<64;j++)
     fprintf(logfi,"0x%02x: %10d, %10d, %10d, %10d\n",j*4,
-      z80_getstat(i,4*j),  z80_getstat(i,4*j+1),
-      z80_getstat(i,4*j+2),z80_getstat(i,4*j+3));
+      z80_getstat(&gzx_mach->cpu, i,4*j),
+      z80_getstat(&gzx_mach->cpu, i,4*j+1),
+      z80_getstat(&gzx_mach->cpu, i,4*j+2),
+      z80_getstat(&gzx_mach->cpu, i,4*j+3));
+}
+
+static void writestat_idle(void) {
+  z80_idle_stat_t is;
+  unsigned i;
+
+  z80_idle_getstat(&gzx_mach->cpu, &is);
+  fprintf(logfi,"\nIdle loops:\n");
+  fprintf(logfi,"skips: %lu, iterations: %lu, T-states: %lu\n",
+    is.skips, is.iters, is.tstates);
+#ifndef NO_Z80IDLE
+  for(i=0;i<is.nloops;i++)
+    fprintf(logfi,"0x%04x: %lu T/iteration, %10lu skips, %10lu iterations\n",
+      is.loop[i].pc, is.loop[i].period, is.loop[i].skips, is.loop[i].iters);
+#else
+  (void)i;
+#endif
 }
 
 static void writestat(void) {
-  fprintf(logfi,"\nop:\n");     writestat_i(0);
-  fprintf(logfi,"\nDDop:\n");   writestat_i(1);
-  fprintf(logfi,"\nFDop:\n");   writestat_i(2);
-  fprintf(logfi,"\nCBop:\n");   writestat_i(3);
-  fprintf(logfi,"\nDDCBop:\n"); writestat_i(4);
-  fprintf(logfi,"\nFDCBop:\n"); writestat_i(5);
-  fprintf(logfi,"\nEDop:\n");   writestat_i(6);
+  if(stat_on) {
+    fprintf(logfi,"\nop:\n");     writestat_i(0);
+    fprintf(logfi,"\nDDop:\n");   writestat_i(1);
+    fprintf(logfi,"\nFDop:\n");   writestat_i(2);
+    fprintf(logfi,"\nCBop:\n");   writestat_i(3);
+    fprintf(logfi,"\nDDCBop:\n"); writestat_i(4);
+    fprintf(logfi,"\nFDCBop:\n"); writestat_i(5);
+    fprintf(logfi,"\nEDop:\n");   writestat_i(6);
+  }
+
+  writestat_idle();
+
+  if(jit_mode!=Z80_JIT_OFF) {
+    z80_jit_stat_t js;
+
+    z80_jit_getstat(&gzx_mach->cpu, &js);
+    fprintf(logfi,"\nJIT:\n");
+    fprintf(logfi,"blocks: %lu, runs: %lu, chains: %lu\n",
+      js.blocks, js.runs, js.chains);
+    fprintf(logfi,"invalidated: %lu, flushes: %lu\n", js.invals, js.flushes);
+    if(jit_mode==Z80_JIT_CHECK)
+      fprintf(logfi,"checked: %lu, mismatches: %lu (last at 0x%04x)\n",
+        js.checked, js.mismatch, js.mismatch_pc);
+  }
 }
 
-/** Process an instruction and anything that we check for every instruction. */
-static void zx_proc_instr(void)
+/** End of field: refresh the host display and process user input. */
+static void zx_frame_event(void *arg)
 {
-    if (!gpu_is_on()) {
-      while(CLOCK_LT(zx_scr_get_clock(),z80_clock)) {
-        zx_scr_disp();
-      }
-    } else {
-      while(CLOCK_LT(zx_scr_get_clock(),z80_clock)) {
-        zx_scr_disp_fast();
-      }
-    }
-    
-    if(CLOCK_GE(z80_clock-snd_t,ZX_SOUND_TICKS_SMP)) { 
-      zx_sound_smp(ay_get_sample(&ay0)+(tape_smp?+16:-16));
-      /* build a new sound sample */
-      snd_t+=ZX_SOUND_TICKS_SMP;
-    }
-    if(CLOCK_GE(z80_clock-tapp_t,ZX_TAPE_TICKS_SMP)) {
-      tape_deck_getsmp(tape_deck, &tape_smp);
-      ear=tape_smp;
-      tapp_t+=ZX_TAPE_TICKS_SMP;
-    }
-    if(!slow_load) {
-      if(cpus.PC==TAPE_LDBYTES_TRAP) {
-        printf("load trapped!\n");
-	tape_quick_ldbytes(tape_deck);
-      }
-      if(cpus.PC==TAPE_SABYTES_TRAP) {
-        printf("save trapped!\n");
-	tape_quick_sabytes(tape_deck);
-      }
-    }
-    if (dbg_stop_enabled && cpus.PC == dbg_stop_addr) {
-      debugger();
-    }
-#ifdef XMAP
-    xmap_mark();
-#endif
-#ifdef XTRACE
-    xtrace_instr();
-#endif
+  zx_machine_t *mach = (zx_machine_t *)arg;
+  wkey_t k;
 
-    if (gpu_is_on())
-      z80_g_execinstr();
-    else
-      z80_execinstr();
+#ifdef WITH_MIDI
+  sysmidi_poll(mach->cpu.clock);
+#endif
+  mgfx_updscr();
 
-    if (dbg_itrap_enabled) {
-      debugger();
-    }
+  mgfx_input_update();
+  while(w_getkey(&k)) key_handler(&k);
+#ifdef LOG
+  if(mach->cpu.cpus.iff1) fprintf(logfi,"interrupt\n");
+#endif
+  zx_run_select(mach);
 }
 
 int main(int argc, char **argv) {
   int argi;
   timer frmt;
-  wkey_t k;
   
   argi = 1;
   
@@ -470,28 +459,46 @@ int main(int argc, char **argv) {
 	    }
 	    midi_dev = argv[argi + 1];
 	    argi+=2;
+    } else if (!strcmp(argv[argi],"-jit")) {
+	    jit_mode = Z80_JIT_ON;
+	    ++argi;
+    } else if (!strcmp(argv[argi],"-jit-check")) {
+	    jit_mode = Z80_JIT_CHECK;
+	    ++argi;
+    } else if (!strcmp(argv[argi],"-stat")) {
+	    stat_on = true;
+	    ++argi;
+    } else if (!strcmp(argv[argi],"-xmap")) {
+	    xmap_enabled = true;
+	    ++argi;
+    } else if (!strcmp(argv[argi],"-xtrace")) {
+	    xtrace_enabled = true;
+	    ++argi;
     } else {
 	    printf("Invalid option '%s'.\n", argv[argi]);
 	    exit(1);
     }
   }
 
-  uoc=0;
-  smc=0;
-  
   logfi=fopen("log.txt","wt");
   
   start_dir = sys_getcwd(NULL,0);
   
   printf("\n\n\n");
   if(zx_init()<0) return -1;
+  z80_stat_enable(&gzx_mach->cpu, stat_on);
+  z80_idle_enable(&gzx_mach->cpu, 1);
+  if(jit_mode!=Z80_JIT_OFF && z80_jit_enable(&gzx_mach->cpu, jit_mode)<0) {
+    printf("JIT not available.\n");
+    jit_mode=Z80_JIT_OFF;
+  }
 /*  slow_load=1;*/
   /*if(zx_load_snap(SNAP_NAME1)<0) {
     printf("error loading snapshot\n");
     return -1;
   }*/
 
-  if(argc > argi && zx_load_snap(argv[argi])<0) {
+  if(argc > argi && zx_load_snap(gzx_mach, argv[argi])<0) {
     printf("error loading snapshot\n");
     return -1;
   }
@@ -500,36 +507,21 @@ int main(int argc, char **argv) {
   
   timer_reset(&frmt);
   
-  while(!quit) {
-    if(CLOCK_GE(z80_clock-disp_t,ULA_FIELD_TICKS)) { /* every 50th of a second */
-      disp_t+=ULA_FIELD_TICKS;
-#ifdef WITH_MIDI
-      sysmidi_poll(z80_clock);
-#endif
-      mgfx_updscr();
-
-      mgfx_input_update();
-      while(w_getkey(&k)) key_handler(&k);
-#ifdef LOG
-      if(cpus.iff1) fprintf(logfi,"interrupt\n");
-#endif
-    }
-    
-    zx_proc_instr();
-  }
+  zx_run_select(gzx_mach);
+  while(!quit)
+    zx_machine_step(gzx_mach);
   
   /* Graphics is closed automatically atexit() */
   
-#ifdef XMAP
-  xmap_save();
-#endif
+  if (xmap_enabled)
+    xmap_save();
   
   zx_sound_done();
-  tape_deck_destroy(tape_deck);
-  tape_deck = NULL;
 
+  prof_stop();
   writestat();  
   fclose(logfi);
-  printf("uoc:%lu\nsmc:%lu\n",uoc,smc);
+  printf("uoc:%lu\nsmc:%lu\n",gzx_mach->cpu.uoc,gzx_mach->cpu.smc);
+  zx_machine_destroy(gzx_mach);
   return 0;
 }
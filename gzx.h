@@ -34,21 +34,20 @@
 
 #include <stdbool.h>
 #include <stdio.h>
-#include "iorec.h"
 
-void zx_reset(void);
+struct zx_machine;
+
+void zx_reset(struct zx_machine *);
 
 void zx_debug_mstep(void);
 void gzx_ui_lock(void);
-void gzx_notify_mode_48k(bool);
 void gzx_toggle_dbl_ln(void);
 
+extern struct zx_machine *gzx_mach;
 extern char *start_dir;
 extern FILE *logfi;
 extern int quit;
 
 extern int slow_load;
 
-extern iorec_t *iorec;
-
 #endif
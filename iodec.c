@@ -0,0 +1,93 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * I/O port decoder
+ *
+ * Copyright (c) 1999-2017 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file I/O port decoder.
+ *
+ * The decode tables are filled in when devices are registered, so they
+ * can decode the address any way they like (often only some bits are
+ * decoded, like with the ULA or 128K paging) at no cost per access.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "iodec.h"
+
+/** Initialize I/O port decoder.
+ *
+ * @param iodec I/O port decoder
+ * @param none Device answering ports no other device claims. Its
+ *             @c mask and @c val are ignored, @c in8 and @c out8 must
+ *             not be NULL
+ */
+void iodec_init(iodec_t *iodec, iodec_dev_t *none)
+{
+	unsigned i;
+
+	iodec->dev[0] = none;
+	iodec->ndevs = 1;
+	for (i = 0; i < iodec_nports; i++) {
+		iodec->rd[i] = 0;
+		iodec->wr[i] = 0;
+	}
+}
+
+/** Attach device to I/O space.
+ *
+ * The device claims the ports it decodes, except those claimed by
+ * devices registered earlier.
+ *
+ * @param iodec I/O port decoder
+ * @param dev Device
+ * @return Zero on success, -1 if there are too many devices
+ */
+int iodec_register(iodec_t *iodec, iodec_dev_t *dev)
+{
+	unsigned idx;
+	unsigned i;
+
+	if (iodec->ndevs >= iodec_max_devs)
+		return -1;
+
+	idx = iodec->ndevs++;
+	iodec->dev[idx] = dev;
+
+	for (i = 0; i < iodec_nports; i++) {
+		if ((i & dev->mask) != dev->val)
+			continue;
+		if (dev->in8 != NULL && iodec->rd[i] == 0)
+			iodec->rd[i] = idx;
+		if (dev->out8 != NULL && iodec->wr[i] == 0)
+			iodec->wr[i] = idx;
+	}
+
+	return 0;
+}
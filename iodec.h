@@ -0,0 +1,88 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * I/O port decoder
+ *
+ * Copyright (c) 1999-2017 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file I/O port decoder.
+ *
+ * Maps every I/O port address to the device that answers it, so that
+ * a port access is a table lookup and an indirect call.
+ */
+
+#ifndef IODEC_H
+#define IODEC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types/iodec.h"
+
+extern void iodec_init(iodec_t *, iodec_dev_t *);
+extern int iodec_register(iodec_t *, iodec_dev_t *);
+
+/** Read I/O port.
+ *
+ * @param iodec I/O port decoder
+ * @param addr Port address
+ * @return Value read
+ */
+static inline uint8_t iodec_in8(iodec_t *iodec, uint16_t addr)
+{
+	iodec_dev_t *dev = iodec->dev[iodec->rd[addr]];
+
+	return dev->in8(dev->arg, addr);
+}
+
+/** Write I/O port.
+ *
+ * @param iodec I/O port decoder
+ * @param addr Port address
+ * @param val Value to write
+ */
+static inline void iodec_out8(iodec_t *iodec, uint16_t addr, uint8_t val)
+{
+	iodec_dev_t *dev = iodec->dev[iodec->wr[addr]];
+
+	dev->out8(dev->arg, addr, val);
+}
+
+/** Determine if reading I/O port returns the same value until next event.
+ *
+ * @param iodec I/O port decoder
+ * @param addr Port address
+ * @return @c true if the value does not change
+ */
+static inline bool iodec_in8_stable(iodec_t *iodec, uint16_t addr)
+{
+	iodec_dev_t *dev = iodec->dev[iodec->rd[addr]];
+
+	return dev->in8_stable != NULL && dev->in8_stable(dev->arg, addr);
+}
+
+#endif
@@ -29,282 +29,498 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
 #include "ay.h"
 #include "gzx.h"
+#include "iodec.h"
 #include "iorec.h"
 #include "iospace.h"
 #include "memio.h"
 #include "sys_all.h"
 #include "video/ulaplus.h"
 #include "z80.h"
+#include "z80dep.h"
 #include "z80g.h"
 #include "zx.h"
 #include "zx_kbd.h"
 #include "zx_scr.h"
 
-uint8_t *zxram,*zxrom; /* whole memory */
-uint8_t *zxbnk[4];	  /* currently switched in banks */
-uint8_t *zxscr;	  /* selected screen bank */
-uint8_t border;
-uint8_t spk,mic,ear;
+static int rom_load(char *fname, uint8_t *dest, uint16_t size);
+static void zx_rom_unshare(zx_machine_t *mach);
 
-uint32_t ram_size,rom_size;
-int has_banksw,bnk_lock48;
-int mem_model;
+/** Memory configuration of a model */
+typedef struct {
+  uint32_t ram_size;
+  uint32_t rom_size;
+  int has_banksw;
+  /** ROM bank size and files, NULL if fewer banks */
+  uint16_t rom_bank;
+  char *rom_file[2];
+} zx_model_t;
 
-uint8_t page_reg; /* last data written to the page select port */
+/** ROM images of a model */
+typedef struct {
+  /** Image, NULL until first loaded */
+  uint8_t *img;
+  /** Translated code of each bank */
+  z80_aot_t *aot[2];
+} zx_rom_t;
 
-static int rom_load(char *fname, int bank, uint16_t banksize);
-static int spec_rom_load(char *fname, int bank);
+/* indexed by ZXM_xxx */
+static const zx_model_t zx_models[ZXM_NUM] = {
+  { 48*1024, 16*1024, 0, 0x4000, { "roms/zx48.rom", NULL } },
+  { 128*1024, 32*1024, 1, 0x4000, { "roms/zx128_0.rom", "roms/zx128_1.rom" } },
+  { 128*1024, 32*1024, 1, 0x4000, { "roms/zxp2_0.rom", "roms/zxp2_1.rom" } },
+  { 128*1024, 64*1024, 1, 0x4000, { "roms/zxp3_0.rom", "roms/zxp3_1.rom" } },
+  { 24*1024, 16*1024, 0, 0x2000, { "roms/zx81.rom", NULL } }
+};
+
+/* shared by all machines */
+static zx_rom_t zx_roms[ZXM_NUM];
 
 /*
-  memory access routines
-  any wraps as MMIOs should be placed here
+  memory access routines (inline in memio.h)
+  any wraps as MMIOs should be placed in the page tables here
 */
-uint8_t zx_memget8(uint16_t addr) {
-  if(mem_model==ZXM_ZX81) {
-    if(addr<=0x7fff)
-      return zxbnk[addr>>14][addr&0x1fff];
-    else return 0xff;
-  } else
-    return zxbnk[addr>>14][addr&0x3fff];
-}
-
-uint8_t zx_imemget8(uint16_t addr) {
-  if(mem_model==ZXM_48K) {
-    if (addr < 16384)
-	return zxrom[addr];
-    else
-        return zxram[addr - 16384];
-  } else
-    return zx_memget8(addr);
-}
-
-void zx_memset8(uint16_t addr, uint8_t val) {
-  if(mem_model==ZXM_ZX81) {
-    if(addr>=8192 && addr<=0x7fff) zxbnk[addr>>14][addr&0x1fff]=val;
-  } else {
-    if(addr>=16384) zxbnk[addr>>14][addr&0x3fff]=val;
-      else {
-  //      printf("%4x: memory protecion error, write to 0x%04x\n",
-  //             cpus.PC, addr);
-      }
-  }
+
+/* switch host memory into a 16K bank, writes to ROM are discarded */
+static void zx_map_bank(zx_machine_t *mach, int bank, uint8_t *mem, int rom) {
+  int pg = bank << (14 - ZX_PAGE_SHIFT);
+
+  mach->bnk[bank]=mem;
+  mach->rpage[pg]  =mem;
+  mach->rpage[pg+1]=mem+ZX_PAGE_SIZE;
+  mach->wpage[pg]  =rom ? mach->discard : mem;
+  mach->wpage[pg+1]=rom ? mach->discard : mem+ZX_PAGE_SIZE;
 }
 
 /** Write byte without ROM protection */
-void zx_memset8f(uint16_t addr, uint8_t val) {
-  zxbnk[addr >> 14][addr & 0x3fff] = val;
+void zx_memset8f(zx_machine_t *mach, uint16_t addr, uint8_t val) {
+  uint8_t *p;
+
+  if(addr < 16384)
+    zx_rom_unshare(mach);
+  p = mach->rpage[addr >> ZX_PAGE_SHIFT] + (addr & ZX_PAGE_MASK);
+  *p = val;
+  if(mach->dirty_on)
+    zx_mem_dirty_mark(mach, p);
+  z80_icache_inval(&mach->cpu, addr);
+  if(addr < 16384 && mach->mem_model != ZXM_ZX81) {
+    /* the ROM no longer matches its translation */
+    mach->rom_aot[(mach->bnk[0] - mach->rom) >> 14] = NULL;
+    z80_aot_map(&mach->cpu, NULL);
+  }
+}
+
+/*
+  RAM write tracking
+
+  While tracking is on, the core does not store directly to RAM pages
+  that are still clean (see zx_z80_remap()). The first store to such a
+  page goes through zx_memset8(), which marks the page dirty and lets the
+  core store to it directly from then on.
+
+  Nothing reads the dirty bits yet, they are there for incremental
+  snapshots and partial screen redraws to build on.
+*/
+
+/* start or stop tracking, all RAM starts out clean */
+void zx_mem_track(zx_machine_t *mach, bool enable) {
+  mach->dirty_on=enable;
+  zx_mem_dirty_clear(mach);
+}
+
+/* mark all RAM clean */
+void zx_mem_dirty_clear(zx_machine_t *mach) {
+  mach->dirty=0;
+  zx_z80_remap(mach);
+}
+
+/* mark RAM pages containing offsets offs to offs+size-1 dirty */
+void zx_mem_dirty_set(zx_machine_t *mach, uint32_t offs, uint32_t size) {
+  uint32_t pg;
+
+  if(!mach->dirty_on || size==0) return;
+  for(pg=offs>>ZX_PAGE_SHIFT;pg<=(offs+size-1)>>ZX_PAGE_SHIFT;pg++)
+    mach->dirty|=(uint32_t)1<<pg;
+  zx_z80_remap(mach);
 }
 
-uint16_t zx_memget16(uint16_t addr) {
-  return (uint16_t)zx_memget8(addr)+(((uint16_t)zx_memget8(addr+1))<<8);
+/* has RAM page been written to since the last zx_mem_dirty_clear()? */
+bool zx_mem_is_dirty(zx_machine_t *mach, unsigned page) {
+  return (mach->dirty>>page)&1;
 }
 
-void zx_memset16(uint16_t addr, uint16_t val) {
-  zx_memset8(addr, val & 0xff);
-  zx_memset8(addr+1, val >> 8);
+/* mark the RAM page containing host address p dirty (if it is RAM) */
+void zx_mem_dirty_mark(zx_machine_t *mach, const uint8_t *p) {
+  uintptr_t offs=(uintptr_t)p-(uintptr_t)mach->ram;
+  uint32_t bit;
+
+  if(offs>=mach->ram_size) return;
+  bit=(uint32_t)1<<(offs>>ZX_PAGE_SHIFT);
+  if(mach->dirty & bit) return;
+  mach->dirty|=bit;
+  zx_z80_remap(mach);
+}
+
+/* must stores to host page p be seen by zx_mem_dirty_mark()? */
+bool zx_mem_wprotect(zx_machine_t *mach, const uint8_t *p) {
+  uintptr_t offs=(uintptr_t)p-(uintptr_t)mach->ram;
+
+  if(!mach->dirty_on || offs>=mach->ram_size) return false;
+  return !zx_mem_is_dirty(mach, offs>>ZX_PAGE_SHIFT);
+}
+
+/*
+  48K mode is on if we're Spectrum 48K (or lower) or if we are Spectrum
+  128K or higher locked in 48K emulation mode. The tape needs to know to
+  handle Stop the tape in 48K mode.
+*/
+static void zx_mode_48k(zx_machine_t *mach, bool mode48k) {
+  if(mach->tape_deck!=NULL)
+    tape_deck_set_48k(mach->tape_deck, mode48k);
 }
 
-void zx_mem_page_select(uint8_t val) {
-  page_reg = val; /* needed for snapshot saving */
+void zx_mem_page_select(zx_machine_t *mach, uint8_t val) {
+  uint8_t *bnk0, *bnk3;
+
+  mach->page_reg = val; /* needed for snapshot saving */
   
-  zxbnk[3]=zxram + ((uint32_t)(val&0x07)<<14);   /* RAM select */
-  zxbnk[0]=zxrom + ((val&0x10)?0x4000:0);        /* ROM select */
-  zxscr   =zxram + ((val&0x08)?0x1c000:0x14000); /* screen select */
+  bnk3=mach->ram + ((uint32_t)(val&0x07)<<14);   /* RAM select */
+  bnk0=mach->rom + ((val&0x10)?0x4000:0);        /* ROM select */
+  if (bnk0 != mach->bnk[0]) {
+    z80_icache_flush_bank(&mach->cpu, 0);
+    z80_aot_map(&mach->cpu, mach->rom_aot[(val&0x10)?1:0]);
+  }
+  if (bnk3 != mach->bnk[3])
+    z80_icache_flush_bank(&mach->cpu, 3);
+  zx_map_bank(mach, 3, bnk3, 0);
+  zx_map_bank(mach, 0, bnk0, 1);
+  mach->scr   =mach->ram + ((val&0x08)?0x1c000:0x14000); /* screen select */
+  zx_z80_remap(mach);
 //  printf("bnk select 0x%02x: ram=%d,rom=%d,scr=%d\n",val,val&7,val&0x10,val&0x08);
   if(val&0x20) { /* 48k lock */
-    bnk_lock48=1;
-    gzx_notify_mode_48k(true);
+    mach->bnk_lock48=1;
+    zx_mode_48k(mach, true);
   }
 }
 
 /*********************************/
 /* 
   IO routines
-  all wraps should be placed here
+  devices are attached to the I/O space in zx_io_init()
 */
 
-uint8_t zx_in8(uint16_t a) {
-//  printf("in 0x%04x\n",a);
-//  z80_printstatus();
-//  getchar();
-  if(a==AY_REG_READ_PORT && ay0_enable) return ay_reg_read(&ay0);
-  if((a&ZX128K_PAGESEL_PORT_MASK) == ZX128K_PAGESEL_PORT_VAL) printf("bnk sw port read!!!!!!\n");
-  switch(a&0xff) {
-    /* ULA */
-    case ULA_PORT:
-      return zx_key_in(&keys, a>>8) | 0xa0 | (ear?0x40:0x00);
-    
-    case KEMPSTON_JOY_A_PORT:
-      if (kjoy0_enable)
-        return kempston_joy_read(&kjoy0);
-    default:
-      break;
+/* no device there, the data bus floats */
+static uint8_t zx_io_none_in8(void *arg, uint16_t a) {
+  zx_machine_t *mach = (zx_machine_t *)arg;
+
+  return mach->ula.idle_bus_byte;
+}
+
+static void zx_io_none_out8(void *arg, uint16_t a, uint8_t val) {
+}
+
+static bool zx_io_stable(void *arg, uint16_t a) {
+  return true;
+}
+
+/* the ULA (keyboard/EAR, border/speaker/mic) */
+static uint8_t zx_io_ula_in8(void *arg, uint16_t a) {
+  zx_machine_t *mach = (zx_machine_t *)arg;
+
+  return zx_key_in(&mach->keys, a>>8) | 0xa0 | (mach->ear?0x40:0x00);
+}
+
+static void zx_io_ula_out8(void *arg, uint16_t a, uint8_t val) {
+  zx_machine_t *mach = (zx_machine_t *)arg;
+
+  mach->border=val&7;
+  mach->spk=(val&0x10)==0;
+  mach->mic=(val&0x18)==0;
+}
+
+/* 128K memory paging */
+static void zx_io_pagesel_out8(void *arg, uint16_t a, uint8_t val) {
+  zx_machine_t *mach = (zx_machine_t *)arg;
+
+  if(mach->has_banksw && !mach->bnk_lock48)
+    zx_mem_page_select(mach, val);
+}
+
+/* AY register select and read */
+static uint8_t zx_io_aysel_in8(void *arg, uint16_t a) {
+  zx_machine_t *mach = (zx_machine_t *)arg;
+
+  if(!mach->ay_enable) return zx_io_none_in8(arg, a);
+  return ay_reg_read(&mach->ay);
+}
+
+static void zx_io_aysel_out8(void *arg, uint16_t a, uint8_t val) {
+  zx_machine_t *mach = (zx_machine_t *)arg;
+
+  if(mach->ay_enable) ay_reg_select(&mach->ay, val);
+}
+
+static bool zx_io_aysel_stable(void *arg, uint16_t a) {
+  zx_machine_t *mach = (zx_machine_t *)arg;
+
+  return mach->ay_enable;
+}
+
+/* AY register write */
+static void zx_io_aywr_out8(void *arg, uint16_t a, uint8_t val) {
+  zx_machine_t *mach = (zx_machine_t *)arg;
+
+  if(mach->ay_enable) ay_reg_write(&mach->ay, val);
+}
+
+/* Kempston joystick */
+static uint8_t zx_io_kjoy_in8(void *arg, uint16_t a) {
+  zx_machine_t *mach = (zx_machine_t *)arg;
+
+  if(!mach->kjoy_enable) return zx_io_none_in8(arg, a);
+  return kempston_joy_read(&mach->kjoy);
+}
+
+static bool zx_io_kjoy_stable(void *arg, uint16_t a) {
+  zx_machine_t *mach = (zx_machine_t *)arg;
+
+  return mach->kjoy_enable;
+}
+
+/* ULAplus */
+static void zx_io_ulaplus_regsel_out8(void *arg, uint16_t a, uint8_t val) {
+  zx_machine_t *mach = (zx_machine_t *)arg;
+
+  if(!mach->ula.plus_enable) return;
+  ulaplus_write_regsel(&mach->ula.plus, val);
+  zx_scr_update_pal(mach);
+}
+
+static void zx_io_ulaplus_data_out8(void *arg, uint16_t a, uint8_t val) {
+  zx_machine_t *mach = (zx_machine_t *)arg;
+
+  if(!mach->ula.plus_enable) return;
+  ulaplus_write_data(&mach->ula.plus, val);
+  zx_scr_update_pal(mach);
+}
+
+/* devices of a machine are copies of these, with arg pointing to it */
+static const iodec_dev_t zx_io_none = {
+  .in8 = zx_io_none_in8, .out8 = zx_io_none_out8
+};
+
+/* in order of precedence */
+static const iodec_dev_t zx_io_devs[] = {
+  { .mask = ULA_PORT_MASK, .val = ULA_PORT,
+    .in8 = zx_io_ula_in8, .out8 = zx_io_ula_out8,
+    .in8_stable = zx_io_stable },
+  { .mask = ZX128K_PAGESEL_PORT_MASK, .val = ZX128K_PAGESEL_PORT_VAL,
+    .out8 = zx_io_pagesel_out8 },
+  { .mask = 0xffff, .val = AY_REG_SEL_PORT,
+    .in8 = zx_io_aysel_in8, .out8 = zx_io_aysel_out8,
+    .in8_stable = zx_io_aysel_stable },
+  { .mask = 0xffff, .val = AY_REG_WRITE_PORT,
+    .out8 = zx_io_aywr_out8 },
+  { .mask = 0x00ff, .val = KEMPSTON_JOY_A_PORT,
+    .in8 = zx_io_kjoy_in8, .in8_stable = zx_io_kjoy_stable },
+  { .mask = 0xffff, .val = ULAPLUS_REGSEL_PORT,
+    .out8 = zx_io_ulaplus_regsel_out8 },
+  { .mask = 0xffff, .val = ULAPLUS_DATA_PORT,
+    .out8 = zx_io_ulaplus_data_out8 }
+};
+
+/* attach the devices to the I/O space */
+int zx_io_init(zx_machine_t *mach) {
+  iodec_dev_t *dev=mach->io_dev;
+  unsigned i;
+
+  dev[0]=zx_io_none;
+  dev[0].arg=mach;
+  iodec_init(&mach->iodec, &dev[0]);
+  for(i=0;i<sizeof(zx_io_devs)/sizeof(zx_io_devs[0]);i++) {
+    dev[i+1]=zx_io_devs[i];
+    dev[i+1].arg=mach;
+    if(iodec_register(&mach->iodec, &dev[i+1])<0) return -1;
   }
+  return 0;
+}
 
-  printf("in 0x%04x\n (no device there)",a);
-  return video_ula.idle_bus_byte;
-}
-
-void zx_out8(uint16_t addr, uint8_t val) {
-//  printf("out (0x%04x),0x%02x\n",addr,val);
-  if (iorec != NULL)
-    iorec_out(iorec, z80_clock, addr, val);
-  val=val;
-  if((addr&ULA_PORT_MASK)==ULA_PORT) {  /* the ULA (border/speaker/mic) */
-    border=val&7;
-    spk=(val&0x10)==0;
-    mic=(val&0x18)==0;
-//    printf("border %d, spk:%d, mic:%d\n",border,(val>>4)&1,(val>>3)&1);
-//    z80_printstatus();
-//    getchar();
-  } else if((addr&ZX128K_PAGESEL_PORT_MASK) == ZX128K_PAGESEL_PORT_VAL && has_banksw && !bnk_lock48)
-    zx_mem_page_select(val);
-  else if(addr==AY_REG_WRITE_PORT && ay0_enable) {
-    ay_reg_write(&ay0, val);
-  } if(addr==AY_REG_SEL_PORT && ay0_enable) {
-    ay_reg_select(&ay0, val);
-  } else if (addr==ULAPLUS_REGSEL_PORT && video_ula.plus_enable) {
-    ulaplus_write_regsel(&video_ula.plus, val);
-    zx_scr_update_pal();
-  } else if (addr==ULAPLUS_DATA_PORT && video_ula.plus_enable) {
-    ulaplus_write_data(&video_ula.plus, val);
-    zx_scr_update_pal();
-  } else {
-//    printf("out (0x%04x),0x%02x (no device there)\n",addr,val);
+uint8_t zx_in8(zx_machine_t *mach, uint16_t a) {
+  return iodec_in8(&mach->iodec, a);
+}
+
+/* does reading port a return the same value until the next event? */
+int zx_in8_stable(zx_machine_t *mach, uint16_t a) {
+  return iodec_in8_stable(&mach->iodec, a);
+}
+
+void zx_out8(zx_machine_t *mach, uint16_t addr, uint8_t val) {
+  if (mach->iorec != NULL)
+    iorec_out(mach->iorec, mach->cpu.iclock, addr, val);
+  iodec_out8(&mach->iodec, addr, val);
+}
+
+/* deterministic power-on RAM contents */
+static void zx_ram_fill(zx_machine_t *mach) {
+  uint32_t x=0x2545f491;
+  uint32_t i;
+
+  for(i=0;i<mach->ram_size;i+=4) {
+    x^=x<<13; x^=x>>17; x^=x<<5;
+    mach->ram[i]  =x;
+    mach->ram[i+1]=x>>8;
+    mach->ram[i+2]=x>>16;
+    mach->ram[i+3]=x>>24;
   }
-  /* no device attached */
+  zx_mem_dirty_set(mach, 0,mach->ram_size);
 }
 
-int zx_select_memmodel(int model) {
-  int i;
+/* ROM images of a model, loaded on first use and never written to */
+static int zx_rom_get(int model, zx_rom_t **rrom) {
+  const zx_model_t *m=&zx_models[model];
+  zx_rom_t *r=&zx_roms[model];
+  uint8_t *img;
   char *cur_dir;
-  
-  mem_model=model;
-  switch(model) {
-    case ZXM_48K:
-      ram_size=48*1024; /* 48K spectrum */
-      rom_size=16*1024;
-      has_banksw=0;
-      break;
-      
-    case ZXM_128K:
-      ram_size=128*1024; /* 128K spectrum */
-      rom_size=32*1024;
-      has_banksw=1;
-      break;
-      
-    case ZXM_PLUS2:
-      ram_size=128*1024; /*  spectrum +2 */
-      rom_size=32*1024;
-      has_banksw=1;
-      break;
-      
-    case ZXM_PLUS3:
-      ram_size=128*1024; /*  spectrum +3 */
-      rom_size=64*1024;
-      has_banksw=1;
-      break;
-      
-    case ZXM_ZX81:
-      ram_size=24*1024; /*  ZX81 */
-      rom_size=16*1024;
-      has_banksw=0;
-      break;
-  }
-  
-  /* reallocate memory */
-  zxram=realloc(zxram,ram_size);
-  zxrom=realloc(zxrom,rom_size);
-  if(!zxram || !zxrom) {
-    printf("malloc failed\n");
-    return -1;
+  int i, rc=0;
+
+  if(r->img==NULL) {
+    img=calloc(1,m->rom_size);
+    if(!img) {
+      printf("malloc failed\n");
+      return -1;
+    }
+
+    cur_dir = sys_getcwd(NULL,0);
+    if(start_dir) sys_chdir(start_dir);
+    for(i=0;i<2 && m->rom_file[i]!=NULL && rc==0;i++)
+      rc=rom_load(m->rom_file[i],img+i*m->rom_bank,m->rom_bank);
+    if(cur_dir) {
+      sys_chdir(cur_dir);
+      free(cur_dir);
+    }
+    if(rc<0) {
+      free(img);
+      return -1;
+    }
+
+    /* use translated code for ROMs we know */
+    if(model!=ZXM_ZX81) {
+      r->aot[0]=z80_aot_find(img);
+      if(m->has_banksw) r->aot[1]=z80_aot_find(img+0x4000);
+    }
+    r->img=img;
   }
-  
-  /* fill RAM with random stuff */
-  srand(time(NULL));
-  for(i=0;i<ram_size;i++)
-    zxram[i]=rand();
-    
-  /* load ROM */
-  cur_dir = sys_getcwd(NULL,0);
-  if(start_dir) sys_chdir(start_dir);
-
-  switch(mem_model) {
-    case ZXM_48K:
-      if(spec_rom_load("roms/zx48.rom",0)<0) return -1;
-      break;
-      
-    case ZXM_128K:
-      if(spec_rom_load("roms/zx128_0.rom",0)<0) return -1;
-      if(spec_rom_load("roms/zx128_1.rom",1)<0) return -1;
-      break;
-      
-    case ZXM_PLUS2:
-      if(spec_rom_load("roms/zxp2_0.rom",0)<0) return -1;
-      if(spec_rom_load("roms/zxp2_1.rom",1)<0) return -1;
-      break;
-      
-    case ZXM_PLUS3:
-      if(spec_rom_load("roms/zxp3_0.rom",0)<0) return -1;
-      if(spec_rom_load("roms/zxp3_1.rom",1)<0) return -1;
-      break;
-      
-    case ZXM_ZX81:
-      if(rom_load("roms/zx81.rom",0,0x2000)<0) return -1;
-      break;
+
+  *rrom=r;
+  return 0;
+}
+
+/* give the machine its own copy of the ROM before writing to it */
+static void zx_rom_unshare(zx_machine_t *mach) {
+  uint32_t offs;
+
+  if(mach->rom==mach->rom_copy) return;
+  memcpy(mach->rom_copy,mach->rom,mach->rom_size);
+  offs=mach->bnk[0]-mach->rom;
+  mach->rom=mach->rom_copy;
+  if(mach->mem_model==ZXM_ZX81) {
+    mach->bnk[0]=mach->rom;
+    mach->rpage[0]=mach->rpage[1]=mach->rom;
+  } else {
+    zx_map_bank(mach, 0,mach->rom+offs,1);
   }
-  if(cur_dir) {
-    sys_chdir(cur_dir);
-    free(cur_dir);
+  zx_z80_remap(mach);
+  z80_icache_flush_bank(&mach->cpu, 0);
+}
+
+/*
+  Switching models does not touch the disk once each model has been used:
+  the ROM comes from the cache and all models share one RAM allocation.
+*/
+int zx_select_memmodel(zx_machine_t *mach, int model) {
+  zx_rom_t *r;
+  int i;
+
+  if(mach->ram==NULL) {
+    mach->ram=malloc(ZX_RAM_MAX);
+    mach->rom_copy=malloc(ZX_ROM_MAX);
+    if(!mach->ram || !mach->rom_copy) {
+      printf("malloc failed\n");
+      return -1;
+    }
   }
-  
+
+  if(zx_rom_get(model,&r)<0) return -1;
+
+  mach->mem_model=model;
+  mach->ram_size=zx_models[model].ram_size;
+  mach->rom_size=zx_models[model].rom_size;
+  mach->has_banksw=zx_models[model].has_banksw;
+  mach->rom=r->img;
+  mach->rom_aot[0]=r->aot[0];
+  mach->rom_aot[1]=r->aot[1];
+
+  zx_ram_fill(mach);
+
   /* setup memory banks */
-  switch(mem_model) {
+  memset(mach->unmapped,0xff,ZX_PAGE_SIZE);
+  switch(mach->mem_model) {
     case ZXM_48K:
-      zxbnk[0]=zxrom;
-      zxbnk[1]=zxram;
-      zxbnk[2]=zxram+16*1024;
-      zxbnk[3]=zxram+32*1024;
-      zxscr   =zxram;
+      zx_map_bank(mach, 0,mach->rom,1);
+      zx_map_bank(mach, 1,mach->ram,0);
+      zx_map_bank(mach, 2,mach->ram+16*1024,0);
+      zx_map_bank(mach, 3,mach->ram+32*1024,0);
+      mach->scr   =mach->ram;
       break;
 
     case ZXM_128K:
     case ZXM_PLUS2:
-      zxbnk[0]=zxrom;
-      zxbnk[1]=zxram+5*0x4000;
-      zxbnk[2]=zxram+2*0x4000;
-      zxbnk[3]=zxram+7*0x4000;
-      zxscr   =zxram+5*0x4000;
+      zx_map_bank(mach, 0,mach->rom,1);
+      zx_map_bank(mach, 1,mach->ram+5*0x4000,0);
+      zx_map_bank(mach, 2,mach->ram+2*0x4000,0);
+      zx_map_bank(mach, 3,mach->ram+7*0x4000,0);
+      mach->scr   =mach->ram+5*0x4000;
       break;
       
     case ZXM_PLUS3:
-      zxbnk[0]=zxrom;
-      zxbnk[1]=zxram+5*0x4000;
-      zxbnk[2]=zxram+2*0x4000;
-      zxbnk[3]=zxram+7*0x4000;
-      zxscr   =zxram+5*0x4000;
+      zx_map_bank(mach, 0,mach->rom,1);
+      zx_map_bank(mach, 1,mach->ram+5*0x4000,0);
+      zx_map_bank(mach, 2,mach->ram+2*0x4000,0);
+      zx_map_bank(mach, 3,mach->ram+7*0x4000,0);
+      mach->scr   =mach->ram+5*0x4000;
       break;
       
-    case ZXM_ZX81: /* 8k pages */
-      zxbnk[0]=zxrom;
-      zxbnk[1]=zxram;
-      zxbnk[2]=zxram+16*1024;
-      zxbnk[3]=zxram+32*1024;
-      zxscr   =zxram;
+    case ZXM_ZX81: /* 8k ROM and RAM, each mirrored once */
+      mach->bnk[0]=mach->rom;
+      mach->bnk[1]=mach->ram;
+      mach->bnk[2]=mach->ram+16*1024;
+      mach->bnk[3]=mach->ram+32*1024;
+      for(i=0;i<ZX_PAGES;i++) {
+        mach->rpage[i]=mach->unmapped;
+        mach->wpage[i]=mach->discard;
+      }
+      mach->rpage[0]=mach->rpage[1]=mach->rom;
+      mach->rpage[2]=mach->rpage[3]=mach->ram;
+      mach->wpage[2]=mach->wpage[3]=mach->ram;
+      mach->scr   =mach->ram;
       break;
   }
+  zx_z80_remap(mach);
 
-  gzx_notify_mode_48k(has_banksw == false);
+  z80_aot_map(&mach->cpu, mach->rom_aot[0]);
+
+  z80_icache_flush(&mach->cpu);
+  zx_mode_48k(mach, mach->has_banksw == false);
   return 0;
 }
 
-static int rom_load(char *fname, int bank, uint16_t banksize) {
+static int rom_load(char *fname, uint8_t *dest, uint16_t size) {
   FILE *f;
 
   f=fopen(fname,"rb");
@@ -312,23 +528,20 @@ static int rom_load(char *fname, int bank, uint16_t banksize) {
     printf("rom_load: cannot open file '%s'\n",fname);
     return -1;
   }
-  if(fread(zxrom+(bank*banksize),1,banksize,f)!=banksize) {
+  if(fread(dest,1,size,f)!=size) {
     printf("rom_load: unexpected end of file\n");
+    fclose(f);
     return -1;
   }
   fclose(f);
   return 0;
 }
 
-static int spec_rom_load(char *fname, int bank) {
-  return rom_load(fname,bank,0x4000);
-}
-
-int gfxrom_load(char *fname, unsigned bank) {
+int gfxrom_load(zx_machine_t *mach, char *fname, unsigned bank) {
   FILE *f;
-  unsigned u,v,w;
+  unsigned u,w;
   uint8_t buf[8];
-  uint8_t b;
+  uint64_t x;
   char *cur_dir;
 
   cur_dir = sys_getcwd(NULL, 0);
@@ -338,20 +551,29 @@ int gfxrom_load(char *fname, unsigned bank) {
   f=fopen(fname,"rb");
   if(!f) {
     printf("gfxrom_load: cannot open file '%s'\n",fname);
-    sys_chdir(cur_dir);
-    return -1;
+    goto error;
   }
   for(u=0;u<16384;u++) {
-    fread(buf,1,8,f);
-    for(v=0;v<8;v++) {
-      b=0;
-      for(w=0;w<8;w++) {
-        if(buf[w]&(1<<v)) b|=(1<<w);
-      }
-      gfxrom[v][bank*0x4000 + u]=b;
+    if(fread(buf,1,8,f)!=8) {
+      printf("gfxrom_load: unexpected end of file '%s'\n",fname);
+      fclose(f);
+      goto error;
     }
+    x=0;
+    for(w=0;w<8;w++)
+      x|=(uint64_t)buf[w]<<(8*w);
+    mach->gpu.mem[bank*0x4000 + u]=gfx_transpose(x);
   }
   fclose(f);
-  sys_chdir(cur_dir);
+  if(cur_dir) {
+    sys_chdir(cur_dir);
+    free(cur_dir);
+  }
   return 0;
+error:
+  if(cur_dir) {
+    sys_chdir(cur_dir);
+    free(cur_dir);
+  }
+  return -1;
 }
@@ -32,7 +32,10 @@
 #ifndef MEMIO_H
 #define MEMIO_H
 
+#include <stdbool.h>
 #include <stdint.h>
+#include "types/memio.h"
+#include "zx.h"
 
 /* memory models */
 #define ZXM_48K   0
@@ -40,30 +43,61 @@
 #define ZXM_PLUS2 2
 #define ZXM_PLUS3 3
 #define ZXM_ZX81  4
+#define ZXM_NUM   5
+
+/* largest RAM and ROM of all models */
+#define ZX_RAM_MAX (128*1024)
+#define ZX_ROM_MAX (64*1024)
 
 /* spectrum memory access */
-uint8_t zx_memget8(uint16_t addr);
-uint8_t zx_imemget8(uint16_t addr);
-void zx_memset8(uint16_t addr, uint8_t val);
-void zx_memset8f(uint16_t addr, uint8_t val);
-uint16_t zx_memget16(uint16_t addr);
-void zx_memset16(uint16_t addr, uint16_t val);
+static inline uint8_t zx_memget8(zx_machine_t *mach, uint16_t addr) {
+  return mach->rpage[addr >> ZX_PAGE_SHIFT][addr & ZX_PAGE_MASK];
+}
 
-/* spectrum i/o port access */
-void zx_out8(uint16_t addr, uint8_t val);
-uint8_t zx_in8(uint16_t addr);
+static inline uint8_t zx_imemget8(zx_machine_t *mach, uint16_t addr) {
+  return zx_memget8(mach, addr);
+}
+
+void zx_mem_dirty_mark(zx_machine_t *mach, const uint8_t *p);
+
+/* the CPU stores straight through its page table and only comes here for
+   screen pages and, while tracking, clean pages */
+static inline void zx_memset8(zx_machine_t *mach, uint16_t addr, uint8_t val) {
+  uint8_t *p = mach->wpage[addr >> ZX_PAGE_SHIFT] + (addr & ZX_PAGE_MASK);
+
+  *p = val;
+  if (mach->dirty_on)
+    zx_mem_dirty_mark(mach, p);
+}
 
-int zx_select_memmodel(int model);
-void zx_mem_page_select(uint8_t val);
-int gfxrom_load(char *fname, unsigned bank);
+static inline uint16_t zx_memget16(zx_machine_t *mach, uint16_t addr) {
+  return (uint16_t)zx_memget8(mach, addr) +
+      (((uint16_t)zx_memget8(mach, addr+1))<<8);
+}
 
-extern uint8_t page_reg;
-extern uint8_t border;
-extern uint8_t spk,mic,ear;
-extern uint8_t *zxram,*zxrom,*zxscr,*zxbnk[4];
-extern int mem_model;
+static inline void zx_memset16(zx_machine_t *mach, uint16_t addr,
+    uint16_t val) {
+  zx_memset8(mach, addr, val & 0xff);
+  zx_memset8(mach, addr+1, val >> 8);
+}
+
+void zx_memset8f(zx_machine_t *mach, uint16_t addr, uint8_t val);
+
+/* RAM write tracking, per 8K page of RAM (page n is RAM offset n*8K) */
+void zx_mem_track(zx_machine_t *mach, bool enable);
+void zx_mem_dirty_clear(zx_machine_t *mach);
+void zx_mem_dirty_set(zx_machine_t *mach, uint32_t offs, uint32_t size);
+bool zx_mem_is_dirty(zx_machine_t *mach, unsigned page);
+bool zx_mem_wprotect(zx_machine_t *mach, const uint8_t *p);
+
+/* spectrum i/o port access */
+int zx_io_init(zx_machine_t *mach);
+void zx_out8(zx_machine_t *mach, uint16_t addr, uint8_t val);
+uint8_t zx_in8(zx_machine_t *mach, uint16_t addr);
+int zx_in8_stable(zx_machine_t *mach, uint16_t addr);
 
-extern int bnk_lock48;
-extern uint32_t ram_size,rom_size;
+int zx_select_memmodel(zx_machine_t *mach, int model);
+void zx_mem_page_select(zx_machine_t *mach, uint8_t val);
+int gfxrom_load(zx_machine_t *mach, char *fname, unsigned bank);
 
 #endif
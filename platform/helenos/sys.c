@@ -48,6 +48,11 @@ unsigned long timer_val(timer *t)
 	return 0;
 }
 
+unsigned long long sys_time_ns(void)
+{
+	return 0;
+}
+
 int sys_chdir(const char *path)
 {
 	int rc;
@@ -33,6 +33,7 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <time.h>
 #include "../../clock.h"
 #include "../../sys_all.h"
 
@@ -63,6 +64,14 @@ unsigned long timer_val(timer *t) {
   return tstates;
 }
 
+/* monotonic host time in nanoseconds */
+unsigned long long sys_time_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
 int sys_chdir(const char *path) {
   return chdir(path);
 }
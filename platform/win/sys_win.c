@@ -83,6 +83,17 @@ unsigned long timer_val(timer *t) {
   return tstates;
 }
 
+/* monotonic host time in nanoseconds */
+unsigned long long sys_time_ns(void) {
+  LARGE_INTEGER cnt, freq;
+
+  QueryPerformanceCounter(&cnt);
+  QueryPerformanceFrequency(&freq);
+  return (unsigned long long)cnt.QuadPart / freq.QuadPart * 1000000000ULL +
+    (unsigned long long)cnt.QuadPart % freq.QuadPart * 1000000000ULL /
+    freq.QuadPart;
+}
+
 unsigned long win_enumdrives(void) {
   return GetLogicalDrives();
 }
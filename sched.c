@@ -0,0 +1,178 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * Event scheduler
+ *
+ * Copyright (c) 1999-2017 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file Event scheduler.
+ *
+ * Events are kept in a list ordered by the time when they are due and,
+ * among events due at the same time, by priority.
+ * The scheduler is driven by the emulated clock (T-states), which wraps
+ * around, so clock values are compared using CLOCK_LT.
+ */
+
+#include <stdbool.h>
+#include "adt/list.h"
+#include "clock.h"
+#include "sched.h"
+
+/** Initialize event scheduler.
+ *
+ * @param sched Event scheduler
+ */
+void sched_init(sched_t *sched)
+{
+	list_initialize(&sched->events);
+}
+
+/** Initialize scheduled event.
+ *
+ * @param event Event
+ * @param prio Priority among events that are due at the same time
+ * @param fire Function called when event is due
+ * @param arg Argument to @a fire
+ */
+void sched_event_init(sched_event_t *event, int prio, void (*fire)(void *),
+    void *arg)
+{
+	link_initialize(&event->levents);
+	event->when = 0;
+	event->prio = prio;
+	event->fire = fire;
+	event->arg = arg;
+}
+
+/** Schedule event.
+ *
+ * If the event is already scheduled, it is rescheduled.
+ *
+ * @param sched Event scheduler
+ * @param event Event
+ * @param when Clock value when the event is due
+ */
+void sched_add(sched_t *sched, sched_event_t *event, unsigned long when)
+{
+	link_t *link;
+	sched_event_t *e;
+
+	if (link_used(&event->levents))
+		list_remove(&event->levents);
+
+	event->when = when;
+
+	/*
+	 * Insert after all events that are due earlier and those due at the
+	 * same time with no lower priority
+	 */
+	link = list_last(&sched->events);
+	while (link != NULL) {
+		e = list_get_instance(link, sched_event_t, levents);
+		if (CLOCK_LT(e->when, when) ||
+		    (e->when == when && e->prio <= event->prio))
+			break;
+		link = list_prev(link, &sched->events);
+	}
+
+	if (link != NULL)
+		list_insert_after(&event->levents, link);
+	else
+		list_prepend(&event->levents, &sched->events);
+}
+
+/** Cancel scheduled event.
+ *
+ * @param event Event
+ */
+void sched_remove(sched_event_t *event)
+{
+	if (link_used(&event->levents))
+		list_remove(&event->levents);
+}
+
+/** Determine if no events are scheduled.
+ *
+ * @param sched Event scheduler
+ * @return @c true if no events are scheduled
+ */
+bool sched_empty(sched_t *sched)
+{
+	return list_empty(&sched->events);
+}
+
+/** Get time when the next event is due.
+ *
+ * @param sched Event scheduler (must not be empty)
+ * @return Clock value when the first event is due
+ */
+unsigned long sched_next(sched_t *sched)
+{
+	sched_event_t *e;
+
+	e = list_get_instance(list_first(&sched->events), sched_event_t,
+	    levents);
+	return e->when;
+}
+
+/** Fire all events that are due.
+ *
+ * Each event that is due is removed from the schedule and fired exactly
+ * once, in order of the time when it was due and, for events due at the
+ * same time, of priority. An event can reschedule itself from its
+ * callback, but it will not fire again before the next call.
+ *
+ * @param sched Event scheduler
+ * @param now Current clock value
+ */
+void sched_run(sched_t *sched, unsigned long now)
+{
+	list_t due;
+	link_t *link;
+	sched_event_t *e;
+
+	list_initialize(&due);
+
+	/* Move due events to a separate list, keeping their order */
+	while (!list_empty(&sched->events)) {
+		link = list_first(&sched->events);
+		e = list_get_instance(link, sched_event_t, levents);
+		if (CLOCK_LT(now, e->when))
+			break;
+
+		list_remove(link);
+		list_append(link, &due);
+	}
+
+	while (!list_empty(&due)) {
+		link = list_first(&due);
+		e = list_get_instance(link, sched_event_t, levents);
+		list_remove(link);
+		e->fire(e->arg);
+	}
+}
@@ -46,7 +46,7 @@
 #include "z80g.h"
 #include "zx_scr.h"
 
-static int gfxram_load(char *);
+static int gfxram_load(zx_machine_t *, char *);
 
 /*
   Translate 48k page numbers (8,4,5) to our numbering system (0,1,2)
@@ -64,11 +64,11 @@ static int map48k(int page_n) {
   We need to get the CPU to a state representable in others' snapshot
   formats.
 */
-static void prepare_cpu(void) {
-  if(cpus.modifier) /* DD/FD prefix - go back */
-    cpus.PC--;
-  /* cpus.halted .. too bad, there's just nothing we can do */
-  /* cpus.int_lock .. XXX we should advance to the first instruction
+static void prepare_cpu(zx_machine_t *mach) {
+  if(mach->cpu.cpus.modifier) /* DD/FD prefix - go back */
+    mach->cpu.cpus.PC--;
+  /* mach->cpu.cpus.halted .. too bad, there's just nothing we can do */
+  /* mach->cpu.cpus.int_lock .. XXX we should advance to the first instruction
    * that does not enable int_lock. But that could theoretically take
    * a long time. So just forget it. */
 }
@@ -99,22 +99,26 @@ static void snap_z80_read_mem_page(FILE *f, uint8_t *b0, unsigned page_bytes) {
   }
 }
 
-static void snap_z80_read_48k_page(FILE *f, int page_n) {
+static void snap_z80_read_48k_page(zx_machine_t *mach, FILE *f, int page_n) {
   int page_i;
   
   page_i = map48k(page_n);
   if(page_i<0) printf("page type %d - ignoring\n",page_n);
-    else snap_z80_read_mem_page(f,zxram+0x4000*page_i,0x4000);
+    else {
+      snap_z80_read_mem_page(f,mach->ram+0x4000*page_i,0x4000);
+      zx_mem_dirty_set(mach,0x4000*page_i,0x4000);
+    }
 }
 
-static void snap_z80_read_128k_page(FILE *f, int page_n) {
-  if(page_n>=3 && page_n<=10)
-    snap_z80_read_mem_page(f,zxram+(page_n-3)*0x4000,0x4000);
-      else printf("page type %d - ignoring\n",page_n);
+static void snap_z80_read_128k_page(zx_machine_t *mach, FILE *f, int page_n) {
+  if(page_n>=3 && page_n<=10) {
+    snap_z80_read_mem_page(f,mach->ram+(page_n-3)*0x4000,0x4000);
+    zx_mem_dirty_set(mach,(page_n-3)*0x4000,0x4000);
+  } else printf("page type %d - ignoring\n",page_n);
 }
 
 /* returns 0 when ok, -1 on error -> reset ZX */
-int zx_load_snap_z80(char *name) {
+int zx_load_snap_z80(zx_machine_t *mach, char *name) {
   FILE *f;
   uint8_t flags1,flags2,flags3,hw,i1rp;
   uint8_t page,ay_r;
@@ -133,68 +137,68 @@ int zx_load_snap_z80(char *name) {
     return -1;
   }
   
-  zx_reset();
-  
-  cpus.r[rA]=fgetu8(f);
-  cpus.F=fgetu8(f);
-  cpus.r[rC]=fgetu8(f);
-  cpus.r[rB]=fgetu8(f);
-  cpus.r[rL]=fgetu8(f);
-  cpus.r[rH]=fgetu8(f);
-  cpus.PC=fgetu16le(f);
-  cpus.SP=fgetu16le(f);
-  cpus.I=fgetu8(f);
-  cpus.R=fgetu8(f)&0x7f;
+  zx_reset(mach);
+  
+  mach->cpu.cpus.r[rA]=fgetu8(f);
+  mach->cpu.cpus.F=fgetu8(f);
+  mach->cpu.cpus.r[rC]=fgetu8(f);
+  mach->cpu.cpus.r[rB]=fgetu8(f);
+  mach->cpu.cpus.r[rL]=fgetu8(f);
+  mach->cpu.cpus.r[rH]=fgetu8(f);
+  mach->cpu.cpus.PC=fgetu16le(f);
+  mach->cpu.cpus.SP=fgetu16le(f);
+  mach->cpu.cpus.I=fgetu8(f);
+  mach->cpu.cpus.R=fgetu8(f)&0x7f;
   flags1=fgetu8(f);
   if(flags1==0xff) flags1=0x01; /* Do I deserve this?
 				   Did I say anything bad about G.A.Lunter? */
-  cpus.R = cpus.R | ((flags1&1)<<7);  /* what the... */
-  border=(flags1>>1)&0x07;
+  mach->cpu.cpus.R = mach->cpu.cpus.R | ((flags1&1)<<7);  /* what the... */
+  mach->border=(flags1>>1)&0x07;
   /* bit4 = samrom?! igroring for now.. */
   compressed=(flags1&0x20)!=0;
 				   
-  cpus.r[rE]=fgetu8(f);
-  cpus.r[rD]=fgetu8(f);
+  mach->cpu.cpus.r[rE]=fgetu8(f);
+  mach->cpu.cpus.r[rD]=fgetu8(f);
   
-  cpus.r_[rC]=fgetu8(f);
-  cpus.r_[rB]=fgetu8(f);
-  cpus.r_[rE]=fgetu8(f);
-  cpus.r_[rD]=fgetu8(f);
-  cpus.r_[rL]=fgetu8(f);
-  cpus.r_[rH]=fgetu8(f);
-  cpus.r_[rA]=fgetu8(f);
-  cpus.F_=fgetu8(f);
+  mach->cpu.cpus.r_[rC]=fgetu8(f);
+  mach->cpu.cpus.r_[rB]=fgetu8(f);
+  mach->cpu.cpus.r_[rE]=fgetu8(f);
+  mach->cpu.cpus.r_[rD]=fgetu8(f);
+  mach->cpu.cpus.r_[rL]=fgetu8(f);
+  mach->cpu.cpus.r_[rH]=fgetu8(f);
+  mach->cpu.cpus.r_[rA]=fgetu8(f);
+  mach->cpu.cpus.F_=fgetu8(f);
   
-  cpus.IY=fgetu16le(f);
-  cpus.IX=fgetu16le(f);
+  mach->cpu.cpus.IY=fgetu16le(f);
+  mach->cpu.cpus.IX=fgetu16le(f);
   
-  cpus.IFF1=fgetu8(f)?1:0;
-  cpus.IFF2=fgetu8(f)?1:0;
+  mach->cpu.cpus.IFF1=fgetu8(f)?1:0;
+  mach->cpu.cpus.IFF2=fgetu8(f)?1:0;
   
   /* Z80 does not implement or save this */
-  cpus.int_lock=0;
-  cpus.modifier=0;
-  cpus.halted=0;
+  mach->cpu.cpus.int_lock=0;
+  mach->cpu.cpus.modifier=0;
+  mach->cpu.cpus.halted=0;
   
   flags2=fgetu8(f);
-  cpus.int_mode=flags2&0x03;
-  if(cpus.int_mode==3) {
+  mach->cpu.cpus.int_mode=flags2&0x03;
+  if(mach->cpu.cpus.int_mode==3) {
     printf("error in Z80 snapshot: int_mode==3\n");
     return -1;
   }
   /* other bits of flags2 just make no sense to this emulator... */
   
-  if(cpus.PC==0) { /* version >=2.0 */
+  if(mach->cpu.cpus.PC==0) { /* version >=2.0 */
     hdr_len=fgetu16le(f);
     hdr_end=ftell(f)+hdr_len; /* to handle any possible new version */
     
-    cpus.PC=fgetu16le(f);
+    mach->cpu.cpus.PC=fgetu16le(f);
     hw=fgetu8(f);
     page=fgetu8(f); /* 128k:last out to 7ffd, samram:something else */
     switch(hw) {
       case 0:
       case 1:
-        zx_select_memmodel(ZXM_48K);
+        zx_select_memmodel(mach, ZXM_48K);
 	pages=3;
 	break;
 	
@@ -204,8 +208,8 @@ int zx_load_snap_z80(char *name) {
 
       case 3:
       case 4:
-        zx_select_memmodel(ZXM_128K);
-	zx_mem_page_select(page);
+        zx_select_memmodel(mach, ZXM_128K);
+	zx_mem_page_select(mach, page);
 	pages=8;
 	break;
 	
@@ -219,13 +223,13 @@ int zx_load_snap_z80(char *name) {
     flags3=fgetu8(f); /* totally useless */
     (void) flags3;
     ay_r=fgetu8(f); /* sound chip register number */
-    ay_reg_select(&ay0, ay_r);
+    ay_reg_select(&mach->ay, ay_r);
     /* contents of sound registers */
     for(i=0;i<16;i++) {
-      ay_reg_select(&ay0, i);
-      ay_reg_write(&ay0, fgetu8(f));
+      ay_reg_select(&mach->ay, i);
+      ay_reg_write(&mach->ay, fgetu8(f));
     }
-    ay_reg_select(&ay0, ay_r);
+    ay_reg_select(&mach->ay, ay_r);
     
     fseek(f,hdr_end,SEEK_SET); /* just to be sure .. */
     
@@ -243,12 +247,12 @@ int zx_load_snap_z80(char *name) {
       switch(hw) {
 	case 0:
         case 1:
-	  snap_z80_read_48k_page(f,page_n);
+	  snap_z80_read_48k_page(mach,f,page_n);
           break;
 	
         case 3:
         case 4:
-	  snap_z80_read_128k_page(f,page_n);
+	  snap_z80_read_128k_page(mach,f,page_n);
           break;
       }
       fseek(f,page_end,SEEK_SET);
@@ -257,15 +261,16 @@ int zx_load_snap_z80(char *name) {
   } else {
     printf("Z80 OLD version snapshot\n");
     printf("page data starts at offset %ld\n",ftell(f));
-    zx_select_memmodel(ZXM_48K); /* always ZX-48k */
+    zx_select_memmodel(mach, ZXM_48K); /* always ZX-48k */
     
     if(compressed) {
       printf("compressed\n");
-      snap_z80_read_mem_page(f,zxram,48*1024);
+      snap_z80_read_mem_page(f,mach->ram,48*1024);
     } else {
       printf("uncompressed\n");
-      fread(zxram,1,48*1024,f);
+      fread(mach->ram,1,48*1024,f);
     }
+    zx_mem_dirty_set(mach,0,48*1024);
   }
   
   fclose(f);
@@ -310,7 +315,8 @@ static void z80_write_page_data(FILE *f, uint8_t *b0) {
   }
 }
 
-static void z80_write_page(FILE *f, int page_i, int page_n) {    
+static void z80_write_page(zx_machine_t *mach, FILE *f, int page_i,
+    int page_n) {
   uint16_t page_len;
   long page_end,page_start;
   
@@ -318,7 +324,7 @@ static void z80_write_page(FILE *f, int page_i, int page_n) {
   fputu8(f,page_n);
   page_start = ftell(f);
 
-  z80_write_page_data(f,zxram+0x4000*page_i);
+  z80_write_page_data(f,mach->ram+0x4000*page_i);
     
   page_end = ftell(f);
   page_len = page_end-page_start;
@@ -330,14 +336,14 @@ static void z80_write_page(FILE *f, int page_i, int page_n) {
 }
 
 /* returns 0 when ok, -1 on error */
-static int zx_save_snap_z80(char *name) {
+static int zx_save_snap_z80(zx_machine_t *mach, char *name) {
   FILE *f;
   uint8_t flags1,flags2,flags3,hw,i1rp;
   uint16_t hdr_len;
   long hdr_end;
   int i;
   
-  prepare_cpu();
+  prepare_cpu(mach);
   
   f=fopen(name,"wb");
   if(!f) {
@@ -345,70 +351,70 @@ static int zx_save_snap_z80(char *name) {
     return -1;
   }
   
-  fputu8(f,cpus.r[rA]);
-  fputu8(f,cpus.F);
-  fputu8(f,cpus.r[rC]);
-  fputu8(f,cpus.r[rB]);
-  fputu8(f,cpus.r[rL]);
-  fputu8(f,cpus.r[rH]);
+  fputu8(f,mach->cpu.cpus.r[rA]);
+  fputu8(f,mach->cpu.cpus.F);
+  fputu8(f,mach->cpu.cpus.r[rC]);
+  fputu8(f,mach->cpu.cpus.r[rB]);
+  fputu8(f,mach->cpu.cpus.r[rL]);
+  fputu8(f,mach->cpu.cpus.r[rH]);
   fputu16le(f,0); /* would be PC in version < 2.0 of Z80 */
-  fputu16le(f,cpus.SP);
-  fputu8(f,cpus.I);
-  fputu8(f,cpus.R);
-  flags1 = (cpus.R>>7)|(border<<1)|0x20;
+  fputu16le(f,mach->cpu.cpus.SP);
+  fputu8(f,mach->cpu.cpus.I);
+  fputu8(f,mach->cpu.cpus.R);
+  flags1 = (mach->cpu.cpus.R>>7)|(mach->border<<1)|0x20;
     /* Samrom not switched in, data is compressed */
   fputu8(f,flags1);
 
-  fputu8(f,cpus.r[rE]);
-  fputu8(f,cpus.r[rD]);
+  fputu8(f,mach->cpu.cpus.r[rE]);
+  fputu8(f,mach->cpu.cpus.r[rD]);
   
-  fputu8(f,cpus.r_[rC]);
-  fputu8(f,cpus.r_[rB]);
-  fputu8(f,cpus.r_[rE]);
-  fputu8(f,cpus.r_[rD]);
-  fputu8(f,cpus.r_[rL]);
-  fputu8(f,cpus.r_[rH]);
-  fputu8(f,cpus.r_[rA]);
-  fputu8(f,cpus.F_);
+  fputu8(f,mach->cpu.cpus.r_[rC]);
+  fputu8(f,mach->cpu.cpus.r_[rB]);
+  fputu8(f,mach->cpu.cpus.r_[rE]);
+  fputu8(f,mach->cpu.cpus.r_[rD]);
+  fputu8(f,mach->cpu.cpus.r_[rL]);
+  fputu8(f,mach->cpu.cpus.r_[rH]);
+  fputu8(f,mach->cpu.cpus.r_[rA]);
+  fputu8(f,mach->cpu.cpus.F_);
   
-  fputu16le(f,cpus.IY);
-  fputu16le(f,cpus.IX);
+  fputu16le(f,mach->cpu.cpus.IY);
+  fputu16le(f,mach->cpu.cpus.IX);
   
-  fputu8(f,cpus.IFF1);
-  fputu8(f,cpus.IFF2);
+  fputu8(f,mach->cpu.cpus.IFF1);
+  fputu8(f,mach->cpu.cpus.IFF2);
   
   /* Z80 does not implement or save this */
-/*  cpus.int_lock=0; better watch out for these!!
-  cpus.modifier=0;
-  cpus.halted=0;*/
+/*  mach->cpu.cpus.int_lock=0; better watch out for these!!
+  mach->cpu.cpus.modifier=0;
+  mach->cpu.cpus.halted=0;*/
   
-  flags2 = cpus.int_mode; /* Normal sync, no double int. freq, no Issue 2 */
+  flags2 = mach->cpu.cpus.int_mode; /* Normal sync, no double int. freq, no Issue 2 */
   fputu8(f,flags2);
   
   hdr_len=23; /* additional header length in bytes */
   fputu16le(f,hdr_len);
   hdr_end=ftell(f)+hdr_len;
     
-  fputu16le(f,cpus.PC);
+  fputu16le(f,mach->cpu.cpus.PC);
   
-  switch(mem_model) {
+  switch(mach->mem_model) {
     case ZXM_48K: hw=0; break;
     case ZXM_128K: hw=3; break;
     default: printf("HW mode not supported\n"); return -1;
   }
   fputu8(f,hw);
-  fputu8(f,page_reg); /* 128k:last out to 7ffd, samram:something else */
+  fputu8(f,mach->page_reg); /* 128k:last out to 7ffd, samram:something else */
     
   i1rp=0x00; /* Interface 1 not paged in */
   fputu8(f,i1rp);
   flags3 = 0x07; /* R-reg & LDIR emulation on, AY always */
   fputu8(f,flags3);
   
-  fputu8(f,ay_get_sel_regn(&ay0)); /* sound chip register number */
+  fputu8(f,ay_get_sel_regn(&mach->ay)); /* sound chip register number */
   
   /* contents of sound registers */
   for(i=0;i<16;i++) {
-    fputu8(f,ay_get_reg_contents(&ay0, i));
+    fputu8(f,ay_get_reg_contents(&mach->ay, i));
   }
     
   fseek(f,hdr_end,SEEK_SET); /* just to be sure .. */
@@ -416,16 +422,16 @@ static int zx_save_snap_z80(char *name) {
   printf("save Z80 NEW version snapshot\n");
   printf("page data starts at offset %ld\n",ftell(f));
 
-  switch(mem_model) {
+  switch(mach->mem_model) {
     case ZXM_48K:
-      z80_write_page(f,1,4);
-      z80_write_page(f,2,5);
-      z80_write_page(f,0,8);
+      z80_write_page(mach,f,1,4);
+      z80_write_page(mach,f,2,5);
+      z80_write_page(mach,f,0,8);
       break;
       
     case ZXM_128K:
       for(i=0;i<8;i++)
-        z80_write_page(f,i,3+i);
+        z80_write_page(mach,f,i,3+i);
       break;
 
     default:
@@ -437,17 +443,18 @@ static int zx_save_snap_z80(char *name) {
 }
 
 
-static void snap_sna_read_128k_page(FILE *f, int page_n) {
-  fread(zxram+page_n*0x4000,1,0x4000,f);
+static void snap_sna_read_128k_page(zx_machine_t *mach, FILE *f, int page_n) {
+  fread(mach->ram+page_n*0x4000,1,0x4000,f);
+  zx_mem_dirty_set(mach,page_n*0x4000,0x4000);
 }
 
-static void snap_sna_write_128k_page(FILE *f, int page_n) {
-  fwrite(zxram+page_n*0x4000,1,0x4000,f);
+static void snap_sna_write_128k_page(zx_machine_t *mach, FILE *f, int page_n) {
+  fwrite(mach->ram+page_n*0x4000,1,0x4000,f);
 }
 
 
 /* returns 0 when ok, -1 on error -> reset ZX */
-int zx_load_snap_sna(char *name) {
+int zx_load_snap_sna(zx_machine_t *mach, char *name) {
   FILE *f;
   uint8_t inter;
   long size;
@@ -472,86 +479,87 @@ int zx_load_snap_sna(char *name) {
       return -1;
   }
    
-  zx_reset();
-  
-  cpus.I=fgetu8(f);
-  
-  cpus.r_[rL]=fgetu8(f);
-  cpus.r_[rH]=fgetu8(f);
-  cpus.r_[rE]=fgetu8(f);
-  cpus.r_[rD]=fgetu8(f);
-  cpus.r_[rC]=fgetu8(f);
-  cpus.r_[rB]=fgetu8(f);
-  cpus.F_=fgetu8(f);
-  cpus.r_[rA]=fgetu8(f);
-  
-  cpus.r[rL]=fgetu8(f);
-  cpus.r[rH]=fgetu8(f);
-  cpus.r[rE]=fgetu8(f);
-  cpus.r[rD]=fgetu8(f);
-  cpus.r[rC]=fgetu8(f);
-  cpus.r[rB]=fgetu8(f);
-  cpus.IY=fgetu16le(f);
-  cpus.IX=fgetu16le(f);
+  zx_reset(mach);
+  
+  mach->cpu.cpus.I=fgetu8(f);
+  
+  mach->cpu.cpus.r_[rL]=fgetu8(f);
+  mach->cpu.cpus.r_[rH]=fgetu8(f);
+  mach->cpu.cpus.r_[rE]=fgetu8(f);
+  mach->cpu.cpus.r_[rD]=fgetu8(f);
+  mach->cpu.cpus.r_[rC]=fgetu8(f);
+  mach->cpu.cpus.r_[rB]=fgetu8(f);
+  mach->cpu.cpus.F_=fgetu8(f);
+  mach->cpu.cpus.r_[rA]=fgetu8(f);
+  
+  mach->cpu.cpus.r[rL]=fgetu8(f);
+  mach->cpu.cpus.r[rH]=fgetu8(f);
+  mach->cpu.cpus.r[rE]=fgetu8(f);
+  mach->cpu.cpus.r[rD]=fgetu8(f);
+  mach->cpu.cpus.r[rC]=fgetu8(f);
+  mach->cpu.cpus.r[rB]=fgetu8(f);
+  mach->cpu.cpus.IY=fgetu16le(f);
+  mach->cpu.cpus.IX=fgetu16le(f);
   
   inter=fgetu8(f);
   
-  cpus.IFF2=inter ? 1:0;
-  cpus.IFF1=cpus.IFF2;		/* don't know if this is stored anywhere */
+  mach->cpu.cpus.IFF2=inter ? 1:0;
+  mach->cpu.cpus.IFF1=mach->cpu.cpus.IFF2;		/* don't know if this is stored anywhere */
   
-  cpus.R=fgetu8(f);
+  mach->cpu.cpus.R=fgetu8(f);
   
-  cpus.F=fgetu8(f);
-  cpus.r[rA]=fgetu8(f);
-  cpus.SP=fgetu16le(f);
+  mach->cpu.cpus.F=fgetu8(f);
+  mach->cpu.cpus.r[rA]=fgetu8(f);
+  mach->cpu.cpus.SP=fgetu16le(f);
   
-  cpus.int_mode=fgetu8(f);
-  if(cpus.int_mode>2) {
+  mach->cpu.cpus.int_mode=fgetu8(f);
+  if(mach->cpu.cpus.int_mode>2) {
     printf("error in SNA snapshot: int_mode>2\n");
     return -1;
   }
   
-  border=fgetu8(f)&0x07;
+  mach->border=fgetu8(f)&0x07;
   				   
   /* not supported by SNA */  
-  cpus.int_lock=0;
-  cpus.modifier=0;
-  cpus.halted=0;
+  mach->cpu.cpus.int_lock=0;
+  mach->cpu.cpus.modifier=0;
+  mach->cpu.cpus.halted=0;
  
   if(type==0) {  /* 48k SNA */
-    zx_select_memmodel(ZXM_48K);
+    zx_select_memmodel(mach, ZXM_48K);
 
     /* read memory dump */
     fseek(f,27,SEEK_SET);  
-    fread(zxram,1,48*1024,f);
+    fread(mach->ram,1,48*1024,f);
+    zx_mem_dirty_set(mach,0,48*1024);
   
     /* pop PC (yuck!)*/
-    cpus.PC=zx_memget16(cpus.SP);
-    zx_memset16(cpus.SP,0);	/* this is supposed to help sometimes */
-    cpus.SP+=2;
+    mach->cpu.cpus.PC=zx_memget16(mach,mach->cpu.cpus.SP);
+    zx_memset16(mach,mach->cpu.cpus.SP,0);	/* this is supposed to help sometimes */
+    mach->cpu.cpus.SP+=2;
   } else { /* 128k SNA */
-    zx_select_memmodel(ZXM_128K);
+    zx_select_memmodel(mach, ZXM_128K);
     
     /* read PC and paging info */
     fseek(f,49179,SEEK_SET);
-    cpus.PC=fgetu16le(f);
+    mach->cpu.cpus.PC=fgetu16le(f);
     pageout=fgetu8(f);
-    zx_mem_page_select(pageout);
+    zx_mem_page_select(mach, pageout);
     fgetu8(f); /* ??? I thought 128k didn't have TR-DOS? */
     
     curpaged=pageout & 0x07;
     
     /* read "48k" banks */
     fseek(f,27,SEEK_SET);
-    snap_sna_read_128k_page(f,5);
-    snap_sna_read_128k_page(f,2);
-    snap_sna_read_128k_page(f,curpaged);
+    snap_sna_read_128k_page(mach,f,5);
+    snap_sna_read_128k_page(mach,f,2);
+    snap_sna_read_128k_page(mach,f,curpaged);
     
     /* read other banks */
     fseek(f,49183,SEEK_SET);
     for(i=0;i<8;i++) {
       if((i!=2) && (i!=5) && (i!=curpaged)) {
-        snap_sna_read_128k_page(f,i);
+        snap_sna_read_128k_page(mach,f,i);
       }
     }
   }
@@ -563,7 +571,7 @@ int zx_load_snap_sna(char *name) {
 
 
 /* returns 0 when ok, -1 on error */
-static int zx_save_snap_sna(char *name) {
+static int zx_save_snap_sna(zx_machine_t *mach, char *name) {
   FILE *f;
   uint8_t inter;
   uint8_t curpaged;
@@ -575,82 +583,82 @@ static int zx_save_snap_sna(char *name) {
     return -1;
   }
   
-  prepare_cpu();
+  prepare_cpu(mach);
 
-  if(mem_model == ZXM_48K) {
+  if(mach->mem_model == ZXM_48K) {
     /* ah! the horror! */
-    cpus.SP-=2;
-    zx_memset16(cpus.SP,cpus.PC);
+    mach->cpu.cpus.SP-=2;
+    zx_memset16(mach,mach->cpu.cpus.SP,mach->cpu.cpus.PC);
   }
   
-  fputu8(f,cpus.I);
-  
-  fputu8(f,cpus.r_[rL]);
-  fputu8(f,cpus.r_[rH]);
-  fputu8(f,cpus.r_[rE]);
-  fputu8(f,cpus.r_[rD]);
-  fputu8(f,cpus.r_[rC]);
-  fputu8(f,cpus.r_[rB]);
-  fputu8(f,cpus.F_);
-  fputu8(f,cpus.r_[rA]);
-  
-  fputu8(f,cpus.r[rL]);
-  fputu8(f,cpus.r[rH]);
-  fputu8(f,cpus.r[rE]);
-  fputu8(f,cpus.r[rD]);
-  fputu8(f,cpus.r[rC]);
-  fputu8(f,cpus.r[rB]);
-  fputu16le(f,cpus.IY);
-  fputu16le(f,cpus.IX);
+  fputu8(f,mach->cpu.cpus.I);
+  
+  fputu8(f,mach->cpu.cpus.r_[rL]);
+  fputu8(f,mach->cpu.cpus.r_[rH]);
+  fputu8(f,mach->cpu.cpus.r_[rE]);
+  fputu8(f,mach->cpu.cpus.r_[rD]);
+  fputu8(f,mach->cpu.cpus.r_[rC]);
+  fputu8(f,mach->cpu.cpus.r_[rB]);
+  fputu8(f,mach->cpu.cpus.F_);
+  fputu8(f,mach->cpu.cpus.r_[rA]);
+  
+  fputu8(f,mach->cpu.cpus.r[rL]);
+  fputu8(f,mach->cpu.cpus.r[rH]);
+  fputu8(f,mach->cpu.cpus.r[rE]);
+  fputu8(f,mach->cpu.cpus.r[rD]);
+  fputu8(f,mach->cpu.cpus.r[rC]);
+  fputu8(f,mach->cpu.cpus.r[rB]);
+  fputu16le(f,mach->cpu.cpus.IY);
+  fputu16le(f,mach->cpu.cpus.IX);
   
   /* The docs say IFF2 goes here. But, IFF1 is what's important.
    * Nobody cares aobut IFF2 except the NMI handler! */
-  inter=cpus.IFF1 ? 0x04 : 0x00;
+  inter=mach->cpu.cpus.IFF1 ? 0x04 : 0x00;
   
   fputu8(f,inter);
   
-  fputu8(f,cpus.R);
+  fputu8(f,mach->cpu.cpus.R);
   
-  fputu8(f,cpus.F);
-  fputu8(f,cpus.r[rA]);
-  fputu16le(f,cpus.SP);
+  fputu8(f,mach->cpu.cpus.F);
+  fputu8(f,mach->cpu.cpus.r[rA]);
+  fputu16le(f,mach->cpu.cpus.SP);
   
-  fputu8(f,cpus.int_mode);
+  fputu8(f,mach->cpu.cpus.int_mode);
   
   /* XXX I think this should really be the last byte written to the ULA port */
-  fputu8(f,border);
+  fputu8(f,mach->border);
   
   /* filepos: 27 bytes */
   				   
   /* better watch out for these! */
-/*  cpus.int_lock;
-  cpus.modifier;
-  cpus.halted; */
+/*  mach->cpu.cpus.int_lock;
+  mach->cpu.cpus.modifier;
+  mach->cpu.cpus.halted; */
   
-  switch(mem_model) {
+  switch(mach->mem_model) {
     case ZXM_48K:      
       /* write memory dump */
-      fwrite(zxram,1,48*1024,f);
+      fwrite(mach->ram,1,48*1024,f);
       
       break;
     case ZXM_128K:
-      curpaged = page_reg & 7;
+      curpaged = mach->page_reg & 7;
       
       /* write "48k" banks */
-      snap_sna_write_128k_page(f,5);
-      snap_sna_write_128k_page(f,2);
-      snap_sna_write_128k_page(f,curpaged);
+      snap_sna_write_128k_page(mach,f,5);
+      snap_sna_write_128k_page(mach,f,2);
+      snap_sna_write_128k_page(mach,f,curpaged);
         
       /* write other banks */
       for(i=0;i<8;i++) {
         if((i!=2) && (i!=5) && (i!=curpaged)) {
-          snap_sna_write_128k_page(f,i);
+          snap_sna_write_128k_page(mach,f,i);
         }
       }
       
       /* read PC and paging info */
-      fputu16le(f,cpus.PC);
-      fputu8(f,page_reg);
+      fputu16le(f,mach->cpu.cpus.PC);
+      fputu8(f,mach->page_reg);
       fputu8(f,0); /* TR-DOS not paged in */
 
       break;
@@ -659,11 +667,11 @@ static int zx_save_snap_sna(char *name) {
       break;
   }
   
-  if(mem_model == ZXM_48K) {
+  if(mach->mem_model == ZXM_48K) {
     /* XXX The idea here is that if the snapshot is broken due to 
      * the stack being clobbered, we'd better find out immediately. */
-    zx_memset16(cpus.SP,0);
-    cpus.SP+=2;
+    zx_memset16(mach,mach->cpu.cpus.SP,0);
+    mach->cpu.cpus.SP+=2;
   }
 
   fclose(f);
@@ -674,7 +682,7 @@ static int zx_save_snap_sna(char *name) {
 
 /* returns 0 when ok, -1 on error -> reset ZX */
 /* determines snapshot type by extension */
-int zx_load_snap(char *name) {
+int zx_load_snap(zx_machine_t *mach, char *name) {
   char *ext;
   char *gext;
   char *gfxname;
@@ -688,11 +696,11 @@ int zx_load_snap(char *name) {
   }
   
   if(!strcmpci(ext,".z80"))
-    rc = zx_load_snap_z80(name);
+    rc = zx_load_snap_z80(mach, name);
   else if(!strcmpci(ext,".sna"))
-    rc = zx_load_snap_sna(name);
+    rc = zx_load_snap_sna(mach, name);
   else if(!strcmpci(ext,".ay"))
-    rc = zx_load_snap_ay(name);
+    rc = zx_load_snap_ay(mach, name);
   else {
     printf("unknown extension\n");
     rc = -1;
@@ -710,15 +718,15 @@ int zx_load_snap(char *name) {
     assert(gext != 0);
     memcpy(gext + 1, "gfx", strlen("gfx"));
 
-    if (gpu_allow && gfxram_load(gfxname)) {
+    if (mach->gpu.allow && gfxram_load(mach, gfxname)) {
       memcpy(gext + 1, "GFX", strlen("GFX"));
-      if (gfxram_load(gfxname)) {
+      if (gfxram_load(mach, gfxname)) {
         free(gfxname);
         return 0;
       }
     }
 
-    zx_scr_clear_bg();
+    zx_scr_clear_bg(mach);
 
     i = 0;
     while (i < 100) {
@@ -728,10 +736,10 @@ int zx_load_snap(char *name) {
       gext[3] = '0' + i % 10;
 
       printf("try loading '%s'\n", gfxname);
-      if (zx_scr_load_bg(gfxname, i)) {
+      if (zx_scr_load_bg(mach, gfxname, i)) {
         /* Try 'BNN' extension */
         gext[1] = 'B';
-        if (zx_scr_load_bg(gfxname, 0)) {
+        if (zx_scr_load_bg(mach, gfxname, 0)) {
           /* Not found, assuming there are no more backgrounds */
           break;
         }
@@ -741,12 +749,9 @@ int zx_load_snap(char *name) {
 
     free(gfxname);
 
-    { int i;
-       for(i=0;i<NGP;i++)
-         gpus[i]=cpus;
-    }
+    gpu_set_regs(mach, &mach->cpu.cpus);
     printf("Setting screen mode 1\n");
-    zx_scr_mode(1);
+    zx_scr_mode(mach, 1);
   }
 
   return 0;
@@ -754,7 +759,7 @@ int zx_load_snap(char *name) {
 
 /* returns 0 when ok, -1 on error */
 /* determines snapshot type by extension */
-int zx_save_snap(char *name) {
+int zx_save_snap(zx_machine_t *mach, char *name) {
   char *ext;
   
   ext=strrchr(name,'.');
@@ -763,18 +768,18 @@ int zx_save_snap(char *name) {
     return -1;
   }
   
-  if(!strcmpci(ext,".z80")) return zx_save_snap_z80(name);
-  if(!strcmpci(ext,".sna")) return zx_save_snap_sna(name);
+  if(!strcmpci(ext,".z80")) return zx_save_snap_z80(mach, name);
+  if(!strcmpci(ext,".sna")) return zx_save_snap_sna(mach, name);
   
   printf("unknown extension\n");
   return -1;
 }
 
-static int gfxram_load(char *fname) {
+static int gfxram_load(zx_machine_t *mach, char *fname) {
   FILE *f;
-  unsigned u,v,w;
+  unsigned u,w;
   uint8_t buf[8];
-  uint8_t b;
+  uint64_t x;
 
   f=fopen(fname,"rb");
   if(!f) {
@@ -782,20 +787,17 @@ static int gfxram_load(char *fname) {
     return -1;
   }
 
-  if (gpu_enable() < 0) {
+  if (gpu_enable(mach) < 0) {
     fclose(f);
     return -1;
   }
  
   for(u=0;u<3*16384U;u++) {
     fread(buf,1,8,f);
-    for(v=0;v<8;v++) {
-      b=0;
-      for(w=0;w<8;w++) {
-        if(buf[w]&(1<<v)) b|=(1<<w);
-      }
-      gfxram[v][u]=b;
-    }
+    x=0;
+    for(w=0;w<8;w++)
+      x|=(uint64_t)buf[w]<<(8*w);
+    mach->gpu.mem[0x4000 + u]=gfx_transpose(x);
   }
   fclose(f);
   return 0;
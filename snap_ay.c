@@ -42,6 +42,7 @@
 #include "fileutil.h"
 #include "memio.h"
 #include "snap_ay.h"
+#include "zx.h"
 
 /** Get absolutized value of AY relative pointer or 0 if pointer is 0. */
 static long fgetayrp(FILE *f)
@@ -94,8 +95,8 @@ static char *fgetntstr(FILE *f, long pos)
 	return buf;
 }
 
-static int zx_load_snap_ay_block(FILE *f, uint16_t baddr, uint16_t blen,
-    long pblock)
+static int zx_load_snap_ay_block(zx_machine_t *mach, FILE *f, uint16_t baddr,
+    uint16_t blen, long pblock)
 {
   size_t i;
 
@@ -108,12 +109,12 @@ static int zx_load_snap_ay_block(FILE *f, uint16_t baddr, uint16_t blen,
     blen = 65536 - baddr;
 
   for (i = 0; i < blen; i++)
-    zx_memset8f(baddr + i, fgetu8(f));
+    zx_memset8f(mach, baddr + i, fgetu8(f));
 
   return 0;
 }
 
-static int zx_load_snap_ay_song(FILE *f)
+static int zx_load_snap_ay_song(zx_machine_t *mach, FILE *f)
 {
   long psong_name;
   long psong_data;
@@ -182,47 +183,47 @@ static int zx_load_snap_ay_song(FILE *f)
     return -1;
   }
 
-  zx_select_memmodel(ZXM_48K);
+  zx_select_memmodel(mach, ZXM_48K);
 
   for (p = 0x0000; p < 0x0100; p++)
-    zx_memset8f(p, 0xc9);
+    zx_memset8f(mach, p, 0xc9);
   for (p = 0x0100; p < 0x4000; p++)
-    zx_memset8f(p, 0xff);
+    zx_memset8f(mach, p, 0xff);
   for (p = 0x4000; p < 0x10000; p++)
-    zx_memset8f(p, 0x00);
-  zx_memset8f(0x0038, 0xfb);
+    zx_memset8f(mach, p, 0x00);
+  zx_memset8f(mach, 0x0038, 0xfb);
 
   if (inter == 0) {
     p = 0x0000;
-    zx_memset8f(p++, 0xf3); /* di */
-    zx_memset8f(p++, 0xcd); /* call init */
-    zx_memset8f(p++, init & 0xff);
-    zx_memset8f(p++, init >> 8);
+    zx_memset8f(mach, p++, 0xf3); /* di */
+    zx_memset8f(mach, p++, 0xcd); /* call init */
+    zx_memset8f(mach, p++, init & 0xff);
+    zx_memset8f(mach, p++, init >> 8);
     ploop = p;              /* loop: */
-    zx_memset8f(p++, 0xed); /* im 2 */
-    zx_memset8f(p++, 0x5e);
-    zx_memset8f(p++, 0xfb); /* ei */
-    zx_memset8f(p++, 0x76); /* halt */
+    zx_memset8f(mach, p++, 0xed); /* im 2 */
+    zx_memset8f(mach, p++, 0x5e);
+    zx_memset8f(mach, p++, 0xfb); /* ei */
+    zx_memset8f(mach, p++, 0x76); /* halt */
     pjr = p;
-    zx_memset8f(p++, 0x18); /* jr loop */
-    zx_memset8f(p++, ploop - (pjr + 2));
+    zx_memset8f(mach, p++, 0x18); /* jr loop */
+    zx_memset8f(mach, p++, ploop - (pjr + 2));
   } else {
     p = 0x0000;
-    zx_memset8f(p++, 0xf3); /* di */
-    zx_memset8f(p++, 0xcd); /* call init */
-    zx_memset8f(p++, init & 0xff);
-    zx_memset8f(p++, init >> 8);
+    zx_memset8f(mach, p++, 0xf3); /* di */
+    zx_memset8f(mach, p++, 0xcd); /* call init */
+    zx_memset8f(mach, p++, init & 0xff);
+    zx_memset8f(mach, p++, init >> 8);
     ploop = p;              /* loop: */
-    zx_memset8f(p++, 0xed); /* im 1 */
-    zx_memset8f(p++, 0x56);
-    zx_memset8f(p++, 0xfb); /* ei */
-    zx_memset8f(p++, 0x76); /* halt */
-    zx_memset8f(p++, 0xcd); /* call interrupt */
-    zx_memset8f(p++, inter & 0xff);
-    zx_memset8f(p++, inter >> 8);
+    zx_memset8f(mach, p++, 0xed); /* im 1 */
+    zx_memset8f(mach, p++, 0x56);
+    zx_memset8f(mach, p++, 0xfb); /* ei */
+    zx_memset8f(mach, p++, 0x76); /* halt */
+    zx_memset8f(mach, p++, 0xcd); /* call interrupt */
+    zx_memset8f(mach, p++, inter & 0xff);
+    zx_memset8f(mach, p++, inter >> 8);
     pjr = p;
-    zx_memset8f(p++, 0x18); /* jr loop */
-    zx_memset8f(p++, ploop - (pjr + 2));
+    zx_memset8f(mach, p++, 0x18); /* jr loop */
+    zx_memset8f(mach, p++, ploop - (pjr + 2));
   }
 
   baddr = fgetu16be(f);
@@ -234,7 +235,7 @@ static int zx_load_snap_ay_song(FILE *f)
     if (cur_pos < 0)
       return -1;
 
-    if (zx_load_snap_ay_block(f, baddr, blen, pblock) != 0)
+    if (zx_load_snap_ay_block(mach, f, baddr, blen, pblock) != 0)
       return -1;
 
     if (fseek(f, cur_pos, SEEK_SET) != 0) {
@@ -246,39 +247,39 @@ static int zx_load_snap_ay_song(FILE *f)
   }
   printf("End of blocks.\n");
 
-  cpus.r[rA] = cpus.r_[rA] = hireg;
-  cpus.F = cpus.F_ = loreg;
+  mach->cpu.cpus.r[rA] = mach->cpu.cpus.r_[rA] = hireg;
+  mach->cpu.cpus.F = mach->cpu.cpus.F_ = loreg;
 
-  cpus.r[rH] = cpus.r_[rH] = hireg;
-  cpus.r[rL] = cpus.r_[rL] = loreg;
+  mach->cpu.cpus.r[rH] = mach->cpu.cpus.r_[rH] = hireg;
+  mach->cpu.cpus.r[rL] = mach->cpu.cpus.r_[rL] = loreg;
 
-  cpus.r[rD] = cpus.r_[rD] = hireg;
-  cpus.r[rE] = cpus.r_[rE] = loreg;
+  mach->cpu.cpus.r[rD] = mach->cpu.cpus.r_[rD] = hireg;
+  mach->cpu.cpus.r[rE] = mach->cpu.cpus.r_[rE] = loreg;
 
-  cpus.r[rD] = cpus.r_[rD] = hireg;
-  cpus.r[rE] = cpus.r_[rE] = loreg;
+  mach->cpu.cpus.r[rD] = mach->cpu.cpus.r_[rD] = hireg;
+  mach->cpu.cpus.r[rE] = mach->cpu.cpus.r_[rE] = loreg;
 
-  cpus.r[rB] = cpus.r_[rB] = hireg;
-  cpus.r[rC] = cpus.r_[rC] = loreg;
+  mach->cpu.cpus.r[rB] = mach->cpu.cpus.r_[rB] = hireg;
+  mach->cpu.cpus.r[rC] = mach->cpu.cpus.r_[rC] = loreg;
 
-  cpus.IX = ((uint16_t)hireg << 8) | loreg;
-  cpus.IY = ((uint16_t)hireg << 8) | loreg;
+  mach->cpu.cpus.IX = ((uint16_t)hireg << 8) | loreg;
+  mach->cpu.cpus.IY = ((uint16_t)hireg << 8) | loreg;
 
-  cpus.I = 3;
-  cpus.SP = stack;
-  cpus.PC = 0;
+  mach->cpu.cpus.I = 3;
+  mach->cpu.cpus.SP = stack;
+  mach->cpu.cpus.PC = 0;
 
   /* Disable interrupts */
-  cpus.IFF1 = cpus.IFF2 = 0;
-  cpus.int_lock = 1;
+  mach->cpu.cpus.IFF1 = mach->cpu.cpus.IFF2 = 0;
+  mach->cpu.cpus.int_lock = 1;
   /* IM 0 */
-  cpus.int_mode = 0;
+  mach->cpu.cpus.int_mode = 0;
 
   return 0;
 }
 
 /* returns 0 when ok, -1 on error -> reset ZX */
-int zx_load_snap_ay(char *name) {
+int zx_load_snap_ay(zx_machine_t *mach, char *name) {
   FILE *f;
   char fileid[5];
   char typeid[5];
@@ -348,7 +349,7 @@ int zx_load_snap_ay(char *name) {
     return -1;
   }
 
-  if (zx_load_snap_ay_song(f) != 0) {
+  if (zx_load_snap_ay_song(mach, f) != 0) {
     fclose(f);
     return -1;
   }
@@ -40,6 +40,7 @@ typedef struct {
 
 void timer_reset(timer *t);
 unsigned long timer_val(timer *t);
+unsigned long long sys_time_ns(void);
 
 int sys_chdir(const char *path);
 char *sys_getcwd(char *buf, int buflen);
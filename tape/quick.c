@@ -37,6 +37,7 @@
 #include "../gzx.h"
 #include "../memio.h"
 #include "../z80.h"
+#include "../zx.h"
 #include "deck.h"
 #include "defs.h"
 #include "quick.h"
@@ -47,10 +48,11 @@
  * Emulate (most of) the ROM LD-BYTES routine using a virtual tape deck.
  * This can only load a standard speed data block.
  *
- * @param deck Source tape deck
+ * @param mach Machine, loads from its tape deck
  */
-void tape_quick_ldbytes(tape_deck_t *deck)
+void tape_quick_ldbytes(zx_machine_t *mach)
 {
+	tape_deck_t *deck = mach->tape_deck;
 	bool verify;
 	uint8_t req_flag;
 	uint16_t toload, addr;
@@ -80,10 +82,10 @@ void tape_quick_ldbytes(tape_deck_t *deck)
 	data = (tblock_data_t *)tblock->ext;
 
 	fprintf(logfi, "...\n");
-	req_flag = cpus.r_[rA];
-	toload = ((uint16_t)cpus.r[rD] << 8) | (uint16_t)cpus.r[rE];
-	addr = cpus.IX;
-	verify = (cpus.F_ & fC) == 0;
+	req_flag = mach->cpu.cpus.r_[rA];
+	toload = ((uint16_t)mach->cpu.cpus.r[rD] << 8) | (uint16_t)mach->cpu.cpus.r[rE];
+	addr = mach->cpu.cpus.IX;
+	verify = (mach->cpu.cpus.F_ & fC) == 0;
 
 	if (data->data_len < 1) {
 		printf("Data block too short.\n");
@@ -96,7 +98,7 @@ void tape_quick_ldbytes(tape_deck_t *deck)
 	    toload, req_flag, addr, verify);
 	fprintf(logfi, "block len %u, block flag:0x%02x\n", data->data_len,
 	    flag);
-	fprintf(logfi, "z80 F:%02x\n", cpus.F_);
+	fprintf(logfi, "z80 F:%02x\n", mach->cpu.cpus.F_);
 
 	if (flag != req_flag)
 		goto error;
@@ -114,8 +116,10 @@ void tape_quick_ldbytes(tape_deck_t *deck)
 		}
 
 		b = data->data[1 + u];
-		if (!verify)
-			zx_memset8(addr + u, b);
+		if (!verify) {
+			zx_memset8(mach, addr + u, b);
+			z80_icache_inval(&mach->cpu, addr + u);
+		}
 		x ^= b;
 	}
 
@@ -132,19 +136,19 @@ void tape_quick_ldbytes(tape_deck_t *deck)
 		goto error;
 	}
 
-	cpus.F |= fC;
+	mach->cpu.cpus.F |= fC;
 	fprintf(logfi, "load ok\n");
 	goto common;
 error:
-	cpus.F &= ~fC;
+	mach->cpu.cpus.F &= ~fC;
 	fprintf(logfi, "load error\n");
 common:
 	tape_deck_next(deck);
 
 	/* RET */
 	fprintf(logfi, "returning\n");
-	cpus.PC = zx_memget16(cpus.SP);
-	cpus.SP += 2;
+	mach->cpu.cpus.PC = zx_memget16(mach, mach->cpu.cpus.SP);
+	mach->cpu.cpus.SP += 2;
 }
 
 /** Quick save.
@@ -152,10 +156,11 @@ common:
  * Emulate (most of) the ROM SA-BYTES routine using a virtual tape deck.
  * This produces a standard speed data block.
  *
- * @param deck Destination tape deck
+ * @param mach Machine, saves to its tape deck
  */
-void tape_quick_sabytes(tape_deck_t *deck)
+void tape_quick_sabytes(zx_machine_t *mach)
 {
+	tape_deck_t *deck = mach->tape_deck;
 	uint8_t flag;
 	uint16_t tosave;
 	uint16_t addr;
@@ -173,9 +178,9 @@ void tape_quick_sabytes(tape_deck_t *deck)
 		goto done;
 	}
 
-	flag = cpus.r_[rA];
-	tosave = ((uint16_t)cpus.r[rD] << 8) | (uint16_t)cpus.r[rE];
-	addr = cpus.IX;
+	flag = mach->cpu.cpus.r_[rA];
+	tosave = ((uint16_t)mach->cpu.cpus.r[rD] << 8) | (uint16_t)mach->cpu.cpus.r[rE];
+	addr = mach->cpu.cpus.IX;
 
 	data->data_len = (size_t)tosave + 2;
 	data->data = malloc(data->data_len);
@@ -197,7 +202,7 @@ void tape_quick_sabytes(tape_deck_t *deck)
 	fprintf(logfi, "writing\n");
 	x = flag;
 	for (u = 0; u < tosave; u++) {
-		b = zx_memget8(addr + u);
+		b = zx_memget8(mach, addr + u);
 		data->data[1 + u] = b;
 		x ^= b;
 	}
@@ -206,13 +211,13 @@ void tape_quick_sabytes(tape_deck_t *deck)
 	data->data[1 + (size_t)tosave] = x;
 
 done:
-	cpus.F = error ? (cpus.F & (~fC)) : (cpus.F | fC);
+	mach->cpu.cpus.F = error ? (mach->cpu.cpus.F & (~fC)) : (mach->cpu.cpus.F | fC);
 	if (!error)
 		fprintf(logfi, "write ok\n");
 
 	/* RET */
-	cpus.PC = zx_memget16(cpus.SP);
-	cpus.SP += 2;
+	mach->cpu.cpus.PC = zx_memget16(mach, mach->cpu.cpus.SP);
+	mach->cpu.cpus.SP += 2;
 
 	if (data != NULL) {
 		data->pause_after = ROM_PAUSE_LEN_MS;
@@ -0,0 +1,829 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * Z80 CPU benchmark
+ *
+ * Copyright (c) 1999-2019 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file Z80 CPU benchmark.
+ *
+ * Runs the Z80 core headless on a set of workloads: the 48K ROM booting
+ * and computing with its calculator, and generated programs each made of
+ * one class of instructions. For each workload it reports the emulated
+ * clock rate and host time per instruction, and checks the final CPU and
+ * memory state against golden values, so that a change to the core which
+ * alters its behavior is caught along with its effect on speed.
+ *
+ * Optionally a CP/M instruction exerciser (such as zexdoc.com) can be run
+ * as well, with just enough of BDOS to print its output.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../sys_all.h"
+#include "../z80.h"
+
+/** Length of a frame in T-states, the unit in which workloads run */
+#define BENCH_FRAME 69888
+
+/** Generated code occupies 0000h up to here */
+#define BENCH_CODE_END 0xd000
+/** Data accessed by generated code */
+#define BENCH_DATA 0xe000
+/** IX and IY point here in generated code */
+#define BENCH_INDEX 0xf000
+/** Initial stack pointer in generated code */
+#define BENCH_STACK 0xff00
+
+/** Benchmark machine with flat 64K memory */
+typedef struct {
+	/** CPU */
+	z80_t cpu;
+	/** Memory */
+	uint8_t mem[65536];
+	/** Writes below this address are ignored */
+	uint16_t rom_end;
+} bench_mach_t;
+
+/** Code generator state */
+typedef struct {
+	/** Memory to generate code into */
+	uint8_t *mem;
+	/** Address of the next instruction */
+	uint16_t pc;
+	/** Random number generator state */
+	uint32_t seed;
+} bench_gen_t;
+
+/** Benchmark workload */
+typedef struct {
+	/** Name */
+	const char *name;
+	/** Set up machine, return zero on success */
+	int (*setup)(bench_mach_t *);
+	/** Called at the start of each frame, NULL if none */
+	void (*frame)(bench_mach_t *, unsigned long);
+	/** Number of frames to run */
+	unsigned long frames;
+	/** An interrupt arrives at the start of each frame */
+	bool ints;
+	/** Expected CRC of the final CPU state */
+	uint32_t golden_cpu;
+	/** Expected CRC of the final memory contents */
+	uint32_t golden_mem;
+} bench_wl_t;
+
+static uint8_t bench_memget8(void *arg, uint16_t addr)
+{
+	bench_mach_t *mach = (bench_mach_t *)arg;
+
+	return mach->mem[addr];
+}
+
+static void bench_memset8(void *arg, uint16_t addr, uint8_t val)
+{
+	bench_mach_t *mach = (bench_mach_t *)arg;
+
+	if (addr >= mach->rom_end)
+		mach->mem[addr] = val;
+}
+
+static void bench_out8(void *arg, uint16_t addr, uint8_t val)
+{
+}
+
+static uint8_t bench_in8(void *arg, uint16_t addr)
+{
+	return 0xff;
+}
+
+static uint8_t bench_snoop8(void *arg)
+{
+	return 0xff;
+}
+
+static const uint8_t *bench_imemptr(void *arg, uint16_t addr)
+{
+	bench_mach_t *mach = (bench_mach_t *)arg;
+
+	return mach->mem + (addr & 0xc000);
+}
+
+static const z80_dep_t bench_dep = {
+	.memget8 = bench_memget8,
+	.imemget8 = bench_memget8,
+	.memset8 = bench_memset8,
+	.out8 = bench_out8,
+	.in8 = bench_in8,
+	.snoop8 = bench_snoop8,
+	.imemptr = bench_imemptr
+};
+
+/** Compute CRC-32 of a buffer.
+ *
+ * @param crc CRC of the preceding data (0 to start)
+ * @param data Data
+ * @param size Size of data in bytes
+ * @return CRC of the preceding data followed by @a data
+ */
+static uint32_t bench_crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+	size_t i;
+	int j;
+
+	crc = ~crc;
+	for (i = 0; i < size; i++) {
+		crc ^= data[i];
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+	}
+
+	return ~crc;
+}
+
+/** Compute CRC-32 of CPU state.
+ *
+ * @param cpu CPU
+ * @return CRC of registers, interrupt state and clock
+ */
+static uint32_t bench_cpu_crc(z80_t *cpu)
+{
+	z80s *s = &cpu->cpus;
+	uint8_t buf[40];
+	size_t n = 0;
+	int i;
+
+	/* in opcode order (6 is F), independent of host byte order */
+	for (i = 0; i < 8; i++) {
+		buf[n++] = s->r[Z80_REG8(i)];
+		buf[n++] = s->r_[Z80_REG8(i)];
+	}
+
+	buf[n++] = s->I;
+	buf[n++] = s->R;
+	buf[n++] = s->IX & 0xff;
+	buf[n++] = s->IX >> 8;
+	buf[n++] = s->IY & 0xff;
+	buf[n++] = s->IY >> 8;
+	buf[n++] = s->PC & 0xff;
+	buf[n++] = s->PC >> 8;
+	buf[n++] = s->SP & 0xff;
+	buf[n++] = s->SP >> 8;
+	buf[n++] = s->IFF1;
+	buf[n++] = s->IFF2;
+	buf[n++] = s->int_mode;
+	buf[n++] = s->halted;
+	for (i = 0; i < 4; i++)
+		buf[n++] = (cpu->clock >> (8 * i)) & 0xff;
+
+	return bench_crc32(0, buf, n);
+}
+
+/** Load ROM image.
+ *
+ * @param mach Machine
+ * @param fname ROM file name
+ * @return Zero on success, non-zero on failure
+ */
+static int bench_load_rom(bench_mach_t *mach, const char *fname)
+{
+	FILE *f;
+	size_t nr;
+
+	f = fopen(fname, "rb");
+	if (f == NULL) {
+		printf("Cannot open %s.\n", fname);
+		return 1;
+	}
+
+	nr = fread(mach->mem, 1, 0x4000, f);
+	fclose(f);
+	if (nr != 0x4000) {
+		printf("Error reading %s.\n", fname);
+		return 1;
+	}
+
+	mach->rom_end = 0x4000;
+	z80_aot_map(&mach->cpu, z80_aot_find(mach->mem));
+	return 0;
+}
+
+/*
+ * Program for the 48K ROM, loaded at 8000h (as in the unit tests):
+ * ld a,2; call CHAN-OPEN; l: ld bc,(9000h); inc bc; ld (9000h),bc;
+ * call STACK-BC; rst 28h; defb sin, end-calc; call PRINT-FP;
+ * ld a,0dh; rst 10h; ld a,0ffh; ld (SCR-CT),a; jr l
+ */
+static const uint8_t bench_sin_prog[] = {
+	0x3e, 0x02, 0xcd, 0x01, 0x16, 0xed, 0x4b, 0x00, 0x90, 0x03,
+	0xed, 0x43, 0x00, 0x90, 0xcd, 0x2b, 0x2d, 0xef, 0x1f, 0x38,
+	0xcd, 0xe3, 0x2d, 0x3e, 0x0d, 0xd7, 0x3e, 0xff, 0x32, 0x8c,
+	0x5c, 0x18, 0xe4
+};
+
+/** Set up the 48K ROM workload. */
+static int bench_rom48_setup(bench_mach_t *mach)
+{
+	return bench_load_rom(mach, "roms/zx48.rom");
+}
+
+/** Start the sine program once the 48K ROM has booted. */
+static void bench_rom48_frame(bench_mach_t *mach, unsigned long frame)
+{
+	if (frame != 100)
+		return;
+
+	memcpy(mach->mem + 0x8000, bench_sin_prog, sizeof(bench_sin_prog));
+	mach->cpu.cpus.PC = 0x8000;
+}
+
+/** Get next pseudo-random byte. */
+static uint8_t bench_rand(bench_gen_t *gen)
+{
+	gen->seed ^= gen->seed << 13;
+	gen->seed ^= gen->seed >> 17;
+	gen->seed ^= gen->seed << 5;
+	return gen->seed >> 24;
+}
+
+/** Emit byte of code. */
+static void bench_emit(bench_gen_t *gen, uint8_t b)
+{
+	gen->mem[gen->pc++] = b;
+}
+
+/** Emit 16-bit operand. */
+static void bench_emit16(bench_gen_t *gen, uint16_t w)
+{
+	bench_emit(gen, w & 0xff);
+	bench_emit(gen, w >> 8);
+}
+
+/** Emit 8-bit loads: ld r,r'; ld r,(hl); ld r,n. */
+static void bench_gen_ld8(bench_gen_t *gen)
+{
+	uint8_t op;
+
+	if ((bench_rand(gen) & 3) == 0) {
+		bench_emit(gen, 0x06 | (bench_rand(gen) & 0x38));
+		if (gen->mem[gen->pc - 1] == 0x36) /* ld (hl),n */
+			gen->mem[gen->pc - 1] = 0x3e;
+		bench_emit(gen, bench_rand(gen));
+		return;
+	}
+
+	do {
+		op = 0x40 | (bench_rand(gen) & 0x3f);
+	} while (op >= 0x70 && op <= 0x77);
+	bench_emit(gen, op);
+}
+
+/** Emit 8-bit arithmetic and logic. */
+static void bench_gen_alu8(bench_gen_t *gen)
+{
+	static const uint8_t misc[] = {
+		0x07, 0x0f, 0x17, 0x1f, 0x27, 0x2f, 0x37, 0x3f
+	};
+	uint8_t r = bench_rand(gen);
+	uint8_t y = bench_rand(gen) & 0x38;
+
+	switch (r & 7) {
+	case 0:
+	case 1:
+	case 2:
+	case 3:
+		/* alu a,r and alu a,(hl) */
+		bench_emit(gen, 0x80 | (bench_rand(gen) & 0x3f));
+		break;
+	case 4:
+		/* alu a,n */
+		bench_emit(gen, 0xc6 | y);
+		bench_emit(gen, bench_rand(gen));
+		break;
+	case 5:
+		/* inc r, dec r */
+		if (y == 0x30)
+			y = 0x38;
+		bench_emit(gen, 0x04 | y | ((r >> 3) & 1));
+		break;
+	default:
+		bench_emit(gen, misc[y >> 3]);
+		break;
+	}
+}
+
+/** Emit 16-bit arithmetic, 16-bit loads and exchanges. */
+static void bench_gen_alu16(bench_gen_t *gen)
+{
+	static const uint8_t simple[] = {
+		0x09, 0x19, 0x29, 0x39, 0x03, 0x13, 0x23, 0x0b, 0x1b, 0x2b,
+		0xeb, 0xd9, 0x08, 0x08, 0xeb, 0xd9
+	};
+	static const uint8_t ed[] = {
+		0x42, 0x52, 0x62, 0x72, 0x4a, 0x5a, 0x6a, 0x7a
+	};
+	static const uint8_t ednn[] = {
+		0x43, 0x53, 0x63, 0x73, 0x4b, 0x5b, 0x6b, 0x4b
+	};
+	uint8_t r = bench_rand(gen);
+	uint16_t nn = BENCH_DATA + (bench_rand(gen) & 0xfe);
+
+	switch (r & 3) {
+	case 0:
+	case 1:
+		bench_emit(gen, simple[(r >> 2) & 15]);
+		break;
+	case 2:
+		/* sbc hl,rr; adc hl,rr; neg */
+		bench_emit(gen, 0xed);
+		bench_emit(gen, (r & 0x80) ? 0x44 : ed[(r >> 2) & 7]);
+		break;
+	default:
+		/* ld (nn),rr; ld rr,(nn); ld (nn),hl; ld hl,(nn) */
+		if (r & 0x80) {
+			bench_emit(gen, (r & 0x40) ? 0x22 : 0x2a);
+		} else {
+			bench_emit(gen, 0xed);
+			bench_emit(gen, ednn[(r >> 2) & 7]);
+		}
+		bench_emit16(gen, nn);
+		break;
+	}
+}
+
+/** Emit CB-prefixed instructions: rotations, shifts, bit operations. */
+static void bench_gen_cb(bench_gen_t *gen)
+{
+	uint8_t op;
+
+	/* of the (hl) forms only bit n,(hl) */
+	do {
+		op = bench_rand(gen);
+	} while ((op & 7) == 6 && (op & 0xc0) != 0x40);
+
+	bench_emit(gen, 0xcb);
+	bench_emit(gen, op);
+}
+
+/** Emit DD/FD-prefixed instructions with an (ix+d)/(iy+d) operand. */
+static void bench_gen_index(bench_gen_t *gen)
+{
+	uint8_t r = bench_rand(gen);
+	uint8_t y = bench_rand(gen) & 0x38;
+	uint8_t op;
+
+	bench_emit(gen, (r & 0x80) ? 0xdd : 0xfd);
+	switch (r & 7) {
+	case 0:
+	case 1:
+		/* ld r,(ix+d) */
+		if (y == 0x30)
+			y = 0x38;
+		bench_emit(gen, 0x46 | y);
+		bench_emit(gen, bench_rand(gen));
+		break;
+	case 2:
+		/* ld (ix+d),r */
+		if (y == 0x30)
+			y = 0x38;
+		bench_emit(gen, 0x70 | (y >> 3));
+		bench_emit(gen, bench_rand(gen));
+		break;
+	case 3:
+	case 4:
+		/* alu a,(ix+d) */
+		bench_emit(gen, 0x86 | y);
+		bench_emit(gen, bench_rand(gen));
+		break;
+	case 5:
+		/* inc (ix+d), dec (ix+d), ld (ix+d),n */
+		op = 0x34 + (y >> 3) % 3;
+		bench_emit(gen, op);
+		bench_emit(gen, bench_rand(gen));
+		if (op == 0x36)
+			bench_emit(gen, bench_rand(gen));
+		break;
+	default:
+		/* rotations, shifts and bit operations on (ix+d) */
+		bench_emit(gen, 0xcb);
+		bench_emit(gen, bench_rand(gen));
+		bench_emit(gen, (bench_rand(gen) & 0xf8) | 6);
+		break;
+	}
+}
+
+/** Emit block transfers and searches, each with its setup. */
+static void bench_gen_block(bench_gen_t *gen)
+{
+	static const uint8_t ops[] = {
+		0xa0, 0xa8, 0xb0, 0xb8, 0xa1, 0xa9, 0xb1, 0xb9
+	};
+
+	bench_emit(gen, 0x21);
+	bench_emit16(gen, BENCH_DATA + bench_rand(gen));
+	bench_emit(gen, 0x11);
+	bench_emit16(gen, BENCH_DATA + 0x800 + bench_rand(gen));
+	bench_emit(gen, 0x01);
+	bench_emit16(gen, 1 + (bench_rand(gen) & 0x3f));
+	bench_emit(gen, 0xed);
+	bench_emit(gen, ops[bench_rand(gen) & 7]);
+}
+
+/** Emit jumps, calls and returns (each falling through to the next). */
+static void bench_gen_branch(bench_gen_t *gen)
+{
+	static const uint8_t flag_ops[] = {
+		0x3c, 0x3d, 0x37, 0x3f, 0xa7, 0xb7, 0x87, 0x8f
+	};
+	static const uint8_t jr_ops[] = {
+		0x10, 0x18, 0x20, 0x28, 0x30, 0x38, 0x18, 0x10
+	};
+	uint8_t r = bench_rand(gen);
+	uint8_t cc = bench_rand(gen) & 0x38;
+
+	switch (r & 7) {
+	case 0:
+		/* flags for the conditions */
+		bench_emit(gen, flag_ops[(r >> 3) & 7]);
+		break;
+	case 1:
+		/* jr +0; jr cc,+0; djnz +0 */
+		bench_emit(gen, jr_ops[cc >> 3]);
+		bench_emit(gen, 0);
+		break;
+	case 2:
+		/* jp nn; jp cc,nn */
+		bench_emit(gen, (r & 0x08) ? 0xc3 : 0xc2 | cc);
+		bench_emit16(gen, gen->pc + 2);
+		break;
+	case 3:
+	case 4:
+		/* call l; jr m; l: ret; m: */
+		bench_emit(gen, 0xcd);
+		bench_emit16(gen, gen->pc + 4);
+		bench_emit(gen, 0x18);
+		bench_emit(gen, 0x01);
+		bench_emit(gen, 0xc9);
+		break;
+	case 5:
+		/* call cc,l; jr m; l: ret cc; ret; m: */
+		bench_emit(gen, 0xc4 | cc);
+		bench_emit16(gen, gen->pc + 4);
+		bench_emit(gen, 0x18);
+		bench_emit(gen, 0x02);
+		bench_emit(gen, 0xc0 | (bench_rand(gen) & 0x38));
+		bench_emit(gen, 0xc9);
+		break;
+	default:
+		/* push rr; pop rr' */
+		bench_emit(gen, 0xc5 | (r & 0x30));
+		bench_emit(gen, 0xc1 | (cc & 0x30));
+		break;
+	}
+}
+
+/** Generate program of one instruction class followed by jp 0000h.
+ *
+ * @param mach Machine
+ * @param emit Function emitting one instruction (or a short sequence)
+ * @param seed Random seed
+ */
+static void bench_gen(bench_mach_t *mach, void (*emit)(bench_gen_t *),
+    uint32_t seed)
+{
+	bench_gen_t gen;
+	uint32_t i;
+	z80s *s = &mach->cpu.cpus;
+
+	gen.mem = mach->mem;
+	gen.pc = 0;
+	gen.seed = seed;
+
+	for (i = 0; i < 0x10000; i++)
+		mach->mem[i] = bench_rand(&gen);
+
+	while (gen.pc < BENCH_CODE_END - 16)
+		emit(&gen);
+
+	bench_emit(&gen, 0xc3);
+	bench_emit16(&gen, 0x0000);
+
+	/* B, C, D, E, H, L, F, A and the alternate registers */
+	for (i = 0; i < 8; i++) {
+		s->r[Z80_REG8(i)] = bench_rand(&gen);
+		s->r_[Z80_REG8(i)] = bench_rand(&gen);
+	}
+
+	s->IX = s->IY = BENCH_INDEX;
+	s->SP = BENCH_STACK;
+}
+
+static int bench_ld8_setup(bench_mach_t *mach)
+{
+	bench_gen(mach, bench_gen_ld8, 1);
+	return 0;
+}
+
+static int bench_alu8_setup(bench_mach_t *mach)
+{
+	bench_gen(mach, bench_gen_alu8, 2);
+	return 0;
+}
+
+static int bench_alu16_setup(bench_mach_t *mach)
+{
+	bench_gen(mach, bench_gen_alu16, 3);
+	return 0;
+}
+
+static int bench_cb_setup(bench_mach_t *mach)
+{
+	bench_gen(mach, bench_gen_cb, 4);
+	return 0;
+}
+
+static int bench_index_setup(bench_mach_t *mach)
+{
+	bench_gen(mach, bench_gen_index, 5);
+	return 0;
+}
+
+static int bench_block_setup(bench_mach_t *mach)
+{
+	bench_gen(mach, bench_gen_block, 6);
+	return 0;
+}
+
+static int bench_branch_setup(bench_mach_t *mach)
+{
+	bench_gen(mach, bench_gen_branch, 7);
+	return 0;
+}
+
+static const bench_wl_t bench_wls[] = {
+	{ "rom48", bench_rom48_setup, bench_rom48_frame, 400, true,
+	    0x733d4356, 0x12b28bf7 },
+	{ "ld8", bench_ld8_setup, NULL, 400, false, 0x729c7817, 0xce1369b7 },
+	{ "alu8", bench_alu8_setup, NULL, 400, false, 0x45f5bcc1, 0x717a62df },
+	{ "alu16", bench_alu16_setup, NULL, 400, false,
+	    0x6e984192, 0xca912a06 },
+	{ "cb", bench_cb_setup, NULL, 400, false, 0xd5280a6e, 0xee3f2c5c },
+	{ "index", bench_index_setup, NULL, 400, false,
+	    0x3a5d9649, 0x11509d51 },
+	{ "block", bench_block_setup, NULL, 400, false,
+	    0x81d39109, 0x3c6226c1 },
+	{ "branch", bench_branch_setup, NULL, 400, false,
+	    0xd2f69b54, 0x92285c95 }
+};
+
+/** Count instructions executed by CPU. */
+static unsigned long bench_instrs(z80_t *cpu)
+{
+	unsigned long n = 0;
+	int i, j;
+
+	for (i = 0; i < 7; i++)
+		for (j = 0; j < 256; j++)
+			n += z80_getstat(cpu, i, j);
+
+	return n;
+}
+
+/** Run workload.
+ *
+ * Timed runs leave statistics off, they would slow the core down.
+ *
+ * @param mach Machine
+ * @param wl Workload
+ * @param stat Collect statistics (to count instructions)
+ * @param ns Place to store host nanoseconds spent
+ * @return Zero on success, non-zero on failure
+ */
+static int bench_run(bench_mach_t *mach, const bench_wl_t *wl, bool stat,
+    unsigned long long *ns)
+{
+	unsigned long long t0;
+	unsigned long f, end;
+
+	memset(mach->mem, 0, sizeof(mach->mem));
+	mach->rom_end = 0;
+	z80_init(&mach->cpu, &bench_dep, mach);
+	z80_stat_enable(&mach->cpu, stat);
+	if (wl->setup(mach) != 0)
+		return 1;
+
+	t0 = sys_time_ns();
+	for (f = 0; f < wl->frames; f++) {
+		if (wl->frame != NULL)
+			wl->frame(mach, f);
+		if (wl->ints)
+			z80_int(&mach->cpu);
+
+		end = (f + 1) * BENCH_FRAME;
+		while ((long)(mach->cpu.clock - end) < 0)
+			z80_run_until(&mach->cpu, end);
+	}
+
+	*ns = sys_time_ns() - t0;
+	return 0;
+}
+
+/** Run CP/M program, such as an instruction exerciser.
+ *
+ * The program is loaded at 0100h. A BDOS call (call 0005h) is serviced
+ * for functions 2 (print character) and 9 (print string), a jump to
+ * 0000h ends the program.
+ *
+ * @param mach Machine
+ * @param fname File name
+ * @return Zero on success, non-zero on failure or if the program
+ *         printed a line containing "ERROR"
+ */
+static int bench_cpm(bench_mach_t *mach, const char *fname)
+{
+	FILE *f;
+	size_t nr;
+	unsigned long long t0, ns;
+	char line[128];
+	size_t ll = 0;
+	unsigned errors = 0;
+	uint16_t addr;
+	char c;
+	int n;
+
+	memset(mach->mem, 0, sizeof(mach->mem));
+	mach->rom_end = 0;
+	z80_init(&mach->cpu, &bench_dep, mach);
+
+	f = fopen(fname, "rb");
+	if (f == NULL) {
+		printf("Cannot open %s.\n", fname);
+		return 1;
+	}
+
+	nr = fread(mach->mem + 0x100, 1, 0x10000 - 0x200, f);
+	fclose(f);
+	if (nr == 0) {
+		printf("Error reading %s.\n", fname);
+		return 1;
+	}
+
+	/* ret at BDOS entry, the word after it gives the top of memory */
+	mach->mem[0x0005] = 0xc9;
+	mach->mem[0x0006] = 0x00;
+	mach->mem[0x0007] = 0xf0;
+	mach->cpu.cpus.PC = 0x0100;
+	mach->cpu.cpus.SP = 0xf000;
+	z80_set_brk(&mach->cpu, 0x0000, 1);
+	z80_set_brk(&mach->cpu, 0x0005, 1);
+
+	t0 = sys_time_ns();
+	for (;;) {
+		z80_run_until(&mach->cpu, mach->cpu.clock + BENCH_FRAME);
+		if (mach->cpu.cpus.PC == 0x0000)
+			break;
+		if (mach->cpu.cpus.PC != 0x0005)
+			continue;
+
+		addr = z80_getDE(&mach->cpu);
+		n = mach->cpu.cpus.r[rC] == 9 ? 0x10000 :
+		    mach->cpu.cpus.r[rC] == 2 ? 1 : 0;
+		while (n-- > 0) {
+			c = mach->cpu.cpus.r[rC] == 9 ? mach->mem[addr++] :
+			    mach->cpu.cpus.r[rE];
+			if (c == '$' && mach->cpu.cpus.r[rC] == 9)
+				break;
+
+			putchar(c);
+			if (c == '\n') {
+				line[ll] = '\0';
+				if (strstr(line, "ERROR") != NULL)
+					++errors;
+				ll = 0;
+			} else if (ll < sizeof(line) - 1) {
+				line[ll++] = c;
+			}
+		}
+
+		fflush(stdout);
+	}
+
+	ns = sys_time_ns() - t0;
+	printf("\n%s: %.1f MHz, %u errors\n", fname,
+	    mach->cpu.clock * 1000.0 / ns, errors);
+
+	return errors != 0 ? 1 : 0;
+}
+
+static void print_syntax(void)
+{
+	printf("Z80 CPU benchmark\n");
+	printf("syntax: z80bench [-r <repeat>] [-cpm <file.com>]\n");
+	printf("  -r <repeat>     Run each workload <repeat> times, "
+	    "report the fastest run\n");
+	printf("  -cpm <file.com> Also run CP/M instruction exerciser "
+	    "(such as zexdoc.com)\n");
+}
+
+int main(int argc, char *argv[])
+{
+	static bench_mach_t mach;
+	const char *cpm = NULL;
+	unsigned long repeat = 1;
+	unsigned long long ns, best;
+	unsigned long instrs, r;
+	uint32_t ccrc, mcrc;
+	size_t i;
+	int argi;
+	int rc = 0;
+
+	argi = 1;
+	while (argc > argi && argv[argi][0] == '-') {
+		if (!strcmp(argv[argi], "-r") && argc > argi + 1) {
+			repeat = strtoul(argv[argi + 1], NULL, 10);
+			if (repeat == 0)
+				repeat = 1;
+			argi += 2;
+		} else if (!strcmp(argv[argi], "-cpm") && argc > argi + 1) {
+			cpm = argv[argi + 1];
+			argi += 2;
+		} else {
+			print_syntax();
+			return 1;
+		}
+	}
+
+	if (argc > argi) {
+		print_syntax();
+		return 1;
+	}
+
+	z80_init_tables();
+
+	printf("workload     MHz  ns/instr  state\n");
+	for (i = 0; i < sizeof(bench_wls) / sizeof(bench_wls[0]); i++) {
+		best = 0;
+		for (r = 0; r < repeat; r++) {
+			if (bench_run(&mach, &bench_wls[i], false, &ns) != 0)
+				return 1;
+			if (r == 0 || ns < best)
+				best = ns;
+		}
+
+		if (best == 0)
+			best = 1;
+
+		/* the same run again, untimed, to count instructions */
+		if (bench_run(&mach, &bench_wls[i], true, &ns) != 0)
+			return 1;
+
+		instrs = bench_instrs(&mach.cpu);
+		ccrc = bench_cpu_crc(&mach.cpu);
+		mcrc = bench_crc32(0, mach.mem, sizeof(mach.mem));
+
+		printf("%-8s %7.1f  %8.2f  ", bench_wls[i].name,
+		    mach.cpu.clock * 1000.0 / best,
+		    instrs != 0 ? (double)best / instrs : 0.0);
+		if (ccrc == bench_wls[i].golden_cpu &&
+		    mcrc == bench_wls[i].golden_mem) {
+			printf("ok\n");
+		} else {
+			printf("MISMATCH (cpu %08x, memory %08x)\n",
+			    (unsigned)ccrc, (unsigned)mcrc);
+			rc = 1;
+		}
+	}
+
+	if (cpm != NULL && bench_cpm(&mach, cpm) != 0)
+		rc = 1;
+
+	return rc;
+}
@@ -0,0 +1,173 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * I/O port decoder unit tests
+ *
+ * Copyright (c) 1999-2017 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file I/O port decoder unit tests.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../iodec.h"
+#include "iodec.h"
+
+/** Test device */
+typedef struct {
+	/** Value returned by reads */
+	uint8_t in_val;
+	/** Last port written */
+	uint16_t out_addr;
+	/** Last value written */
+	uint8_t out_val;
+	/** Number of writes */
+	int nout;
+} test_iodec_dev_t;
+
+static uint8_t test_iodec_in8(void *arg, uint16_t addr)
+{
+	test_iodec_dev_t *tdev = (test_iodec_dev_t *)arg;
+
+	return tdev->in_val;
+}
+
+static void test_iodec_out8(void *arg, uint16_t addr, uint8_t val)
+{
+	test_iodec_dev_t *tdev = (test_iodec_dev_t *)arg;
+
+	tdev->out_addr = addr;
+	tdev->out_val = val;
+	++tdev->nout;
+}
+
+static bool test_iodec_stable(void *arg, uint16_t addr)
+{
+	return true;
+}
+
+/** Test decoding ports to devices.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_iodec_decode(void)
+{
+	static iodec_t iodec;
+	test_iodec_dev_t tnone = { .in_val = 0xff };
+	test_iodec_dev_t tula = { .in_val = 0x1f };
+	test_iodec_dev_t tpage = { .in_val = 0 };
+	test_iodec_dev_t tay = { .in_val = 0x42 };
+	iodec_dev_t none = {
+		.in8 = test_iodec_in8, .out8 = test_iodec_out8, .arg = &tnone
+	};
+	/* Partially decoded, claims ports before the devices below */
+	iodec_dev_t ula = {
+		.mask = 0x0001, .val = 0x0000,
+		.in8 = test_iodec_in8, .out8 = test_iodec_out8,
+		.in8_stable = test_iodec_stable, .arg = &tula
+	};
+	/* Write-only, overlaps the ULA */
+	iodec_dev_t page = {
+		.mask = 0x8002, .val = 0x0000,
+		.out8 = test_iodec_out8, .arg = &tpage
+	};
+	iodec_dev_t ay = {
+		.mask = 0xffff, .val = 0xfffd,
+		.in8 = test_iodec_in8, .out8 = test_iodec_out8, .arg = &tay
+	};
+
+	printf("Test I/O port decoding...\n");
+
+	iodec_init(&iodec, &none);
+	if (iodec_register(&iodec, &ula) != 0 ||
+	    iodec_register(&iodec, &page) != 0 ||
+	    iodec_register(&iodec, &ay) != 0) {
+		printf("Registering device failed.\n");
+		return 1;
+	}
+
+	if (iodec_in8(&iodec, 0xbffe) != 0x1f ||
+	    iodec_in8(&iodec, 0xfffd) != 0x42 ||
+	    iodec_in8(&iodec, 0x7ffd) != 0xff) {
+		printf("Read from wrong device.\n");
+		return 1;
+	}
+
+	if (!iodec_in8_stable(&iodec, 0x00fe) ||
+	    iodec_in8_stable(&iodec, 0xfffd) ||
+	    iodec_in8_stable(&iodec, 0x00ff)) {
+		printf("Incorrect port stability.\n");
+		return 1;
+	}
+
+	/* The ULA takes precedence on even ports */
+	iodec_out8(&iodec, 0x7ffc, 0x10);
+	iodec_out8(&iodec, 0x7ffd, 0x07);
+	iodec_out8(&iodec, 0xfffd, 0x0e);
+	iodec_out8(&iodec, 0xbffd, 0x55);
+
+	if (tula.nout != 1 || tula.out_addr != 0x7ffc ||
+	    tula.out_val != 0x10) {
+		printf("Incorrect writes to ULA.\n");
+		return 1;
+	}
+
+	if (tpage.nout != 1 || tpage.out_addr != 0x7ffd ||
+	    tpage.out_val != 0x07) {
+		printf("Incorrect writes to page select port.\n");
+		return 1;
+	}
+
+	if (tay.nout != 1 || tay.out_val != 0x0e) {
+		printf("Incorrect writes to AY.\n");
+		return 1;
+	}
+
+	if (tnone.nout != 1 || tnone.out_addr != 0xbffd) {
+		printf("Write to unclaimed port not passed on.\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+/** Run I/O port decoder unit tests.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+int test_iodec(void)
+{
+	int rc;
+
+	rc = test_iodec_decode();
+	if (rc != 0)
+		return 1;
+
+	return 0;
+}
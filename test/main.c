@@ -34,11 +34,17 @@
  */
 
 #include <stdio.h>
+#include "iodec.h"
+#include "memio.h"
 #include "tape/player.h"
 #include "tape/tonegen.h"
 #include "tape/tap.h"
 #include "tape/tzx.h"
 #include "tape/wav.h"
+#include "sched.h"
+#include "z80.h"
+#include "z80g.h"
+#include "zx_run.h"
 
 int main(void)
 {
@@ -64,6 +70,30 @@ int main(void)
 	if (rc != 0)
 		goto error;
 
+	rc = test_iodec();
+	if (rc != 0)
+		goto error;
+
+	rc = test_memio();
+	if (rc != 0)
+		goto error;
+
+	rc = test_sched();
+	if (rc != 0)
+		goto error;
+
+	rc = test_z80();
+	if (rc != 0)
+		goto error;
+
+	rc = test_z80g();
+	if (rc != 0)
+		goto error;
+
+	rc = test_zx_run();
+	if (rc != 0)
+		goto error;
+
 	printf("All tests passed.\n");
 
 	return 0;
@@ -0,0 +1,414 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * Memory unit tests
+ *
+ * Copyright (c) 1999-2019 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file Memory unit tests.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../memio.h"
+#include "../snap.h"
+#include "../sys_all.h"
+#include "../zx.h"
+#include "../zx_scr.h"
+#include "../z80g.h"
+#include "memio.h"
+
+/** Compare ROM image with the ROM file.
+ *
+ * @param img ROM image
+ * @param fname ROM file name
+ * @return Zero if they match, non-zero otherwise
+ */
+static int test_memio_rom_cmp(const uint8_t *img, const char *fname)
+{
+	static uint8_t buf[0x4000];
+	FILE *f;
+	size_t nread;
+
+	f = fopen(fname, "rb");
+	if (f == NULL) {
+		printf("Cannot open '%s'.\n", fname);
+		return 1;
+	}
+
+	nread = fread(buf, 1, sizeof(buf), f);
+	fclose(f);
+	if (nread != sizeof(buf)) {
+		printf("Cannot read '%s'.\n", fname);
+		return 1;
+	}
+
+	if (memcmp(img, buf, sizeof(buf)) != 0) {
+		printf("ROM image differs from '%s'.\n", fname);
+		return 1;
+	}
+
+	return 0;
+}
+
+/** Test that ROM images are shared and copied before they are written.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_memio_rom_cache(void)
+{
+	zx_machine_t *mach;
+	zx_machine_t *mach2 = NULL;
+	uint8_t *rom48;
+	uint8_t *rom128;
+	char *cur_dir = NULL;
+	int rc = 1;
+
+	printf("Test ROM image cache...\n");
+
+	if (zx_machine_create(&video_out, &mach) != 0) {
+		printf("Cannot create machine.\n");
+		return 1;
+	}
+
+	rom48 = mach->rom;
+	if (rom48 == mach->rom_copy) {
+		printf("48K machine starts with a private ROM copy.\n");
+		goto out;
+	}
+
+	if (zx_select_memmodel(mach, ZXM_128K) != 0) {
+		printf("Cannot switch to 128K.\n");
+		goto out;
+	}
+
+	rom128 = mach->rom;
+	if (rom128 == rom48 || rom128 == mach->rom_copy) {
+		printf("128K machine does not use its own ROM image.\n");
+		goto out;
+	}
+
+	if (test_memio_rom_cmp(rom128, "roms/zx128_0.rom") != 0 ||
+	    test_memio_rom_cmp(rom128 + 0x4000, "roms/zx128_1.rom") != 0)
+		goto out;
+
+	/* With the ROM files out of reach, only the cache can supply them */
+	cur_dir = sys_getcwd(NULL, 0);
+	if (cur_dir == NULL || sys_chdir("test") != 0) {
+		printf("Cannot change directory.\n");
+		goto out;
+	}
+
+	if (zx_select_memmodel(mach, ZXM_48K) != 0 || mach->rom != rom48) {
+		printf("48K ROM not taken from the cache.\n");
+		goto out;
+	}
+
+	if (zx_select_memmodel(mach, ZXM_128K) != 0 || mach->rom != rom128) {
+		printf("128K ROM not taken from the cache.\n");
+		goto out;
+	}
+
+	if (zx_machine_create(&video_out, &mach2) != 0) {
+		printf("Cannot create second machine.\n");
+		goto out;
+	}
+
+	if (mach2->rom != rom48) {
+		printf("48K ROM image not shared between machines.\n");
+		goto out;
+	}
+
+	(void) sys_chdir(cur_dir);
+
+	/* Write to ROM 1 of the 128K machine */
+	zx_out8(mach, 0x7ffd, 0x10);
+	zx_memset8f(mach, 0x0010, rom128[0x4010] ^ 0xff);
+	if (mach->rom != mach->rom_copy ||
+	    mach->bnk[0] != mach->rom_copy + 0x4000) {
+		printf("ROM not copied before writing to it.\n");
+		goto out;
+	}
+
+	if (zx_memget8(mach, 0x0010) != (rom128[0x4010] ^ 0xff)) {
+		printf("Write to ROM copy lost.\n");
+		goto out;
+	}
+
+	if (test_memio_rom_cmp(rom128 + 0x4000, "roms/zx128_1.rom") != 0)
+		goto out;
+
+	/* Write to the ROM of the 48K machine */
+	zx_memset8f(mach2, 0x0000, rom48[0] ^ 0xff);
+	if (mach2->rom != mach2->rom_copy ||
+	    zx_memget8(mach2, 0x0000) != (rom48[0] ^ 0xff)) {
+		printf("ROM not copied before writing to it.\n");
+		goto out;
+	}
+
+	if (test_memio_rom_cmp(rom48, "roms/zx48.rom") != 0)
+		goto out;
+
+	/* Switching back gives the unmodified shared image */
+	if (zx_select_memmodel(mach, ZXM_48K) != 0 || mach->rom != rom48 ||
+	    zx_memget8(mach, 0x0000) != rom48[0]) {
+		printf("Shared ROM image not restored after switching.\n");
+		goto out;
+	}
+
+	rc = 0;
+	printf(" ... passed\n");
+out:
+	if (cur_dir != NULL) {
+		(void) sys_chdir(cur_dir);
+		free(cur_dir);
+	}
+	if (mach2 != NULL)
+		zx_machine_destroy(mach2);
+	zx_machine_destroy(mach);
+	return rc;
+}
+
+/** Check which RAM pages are dirty.
+ *
+ * @param mach Machine
+ * @param expect Bitmap of the pages that should be dirty
+ * @param what What was written, for the error message
+ * @return Zero if the pages match, non-zero otherwise
+ */
+static int test_memio_dirty_expect(zx_machine_t *mach, uint32_t expect,
+    const char *what)
+{
+	unsigned pg;
+
+	for (pg = 0; pg < mach->ram_size >> ZX_PAGE_SHIFT; pg++) {
+		if (zx_mem_is_dirty(mach, pg) != ((expect >> pg) & 1)) {
+			printf("RAM page %u %s after %s.\n", pg,
+			    zx_mem_is_dirty(mach, pg) ? "dirty" : "clean", what);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/** Test program: ld a,55h; ld (0c000h),a; ld (0c001h),a; halt */
+static const uint8_t test_memio_prog[] = {
+	0x3e, 0x55, 0x32, 0x00, 0xc0, 0x32, 0x01, 0xc0, 0x76
+};
+
+/** Test that writes to RAM are tracked.
+ *
+ * 48K RAM page n is at address 0x4000 + n * 8K.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_memio_dirty(void)
+{
+	zx_machine_t *mach;
+	char fname[L_tmpnam + 4];
+	unsigned i;
+	int rc = 1;
+
+	printf("Test RAM write tracking...\n");
+
+	if (zx_machine_create(&video_out, &mach) != 0) {
+		printf("Cannot create machine.\n");
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(test_memio_prog); i++)
+		zx_memset8(mach, 0x8000 + i, test_memio_prog[i]);
+
+	zx_mem_track(mach, true);
+	if (test_memio_dirty_expect(mach, 0, "starting to track") != 0)
+		goto out;
+
+	/* CPU stores */
+	mach->cpu.cpus.PC = 0x8000;
+	for (i = 0; i < 4 && !mach->cpu.cpus.halted; i++)
+		z80_execinstr(&mach->cpu);
+	if (!mach->cpu.cpus.halted || zx_memget8(mach, 0xc001) != 0x55) {
+		printf("Program did not run.\n");
+		goto out;
+	}
+
+	if (test_memio_dirty_expect(mach, 1 << 4, "CPU stores") != 0)
+		goto out;
+
+	if (mach->z80_wpage[0xc000 >> ZX_PAGE_SHIFT] == NULL ||
+	    mach->z80_wpage[0x8000 >> ZX_PAGE_SHIFT] != NULL) {
+		printf("CPU page table does not follow dirty pages.\n");
+		goto out;
+	}
+
+	/* Host writes, the one to ROM is discarded */
+	zx_mem_dirty_clear(mach);
+	zx_memset8(mach, 0x6000, 0x01);
+	zx_memset8(mach, 0x0000, 0x01);
+	zx_memset8f(mach, 0xffff, 0x01);
+	zx_mem_dirty_set(mach, 0x3fff, 2);
+	if (test_memio_dirty_expect(mach, (1 << 1) | (1 << 2) | (1 << 5),
+	    "host writes") != 0)
+		goto out;
+
+	/* Snapshot load */
+	if (tmpnam(fname) == NULL) {
+		printf("tmpnam failed.\n");
+		goto out;
+	}
+	strcat(fname, ".sna");
+
+	mach->cpu.cpus.SP = 0xff00;
+	if (zx_save_snap(mach, fname) != 0) {
+		printf("Cannot save snapshot.\n");
+		goto out;
+	}
+
+	zx_mem_dirty_clear(mach);
+	if (zx_load_snap_sna(mach, fname) != 0) {
+		printf("Cannot load snapshot.\n");
+		(void) remove(fname);
+		goto out;
+	}
+
+	(void) remove(fname);
+	if (test_memio_dirty_expect(mach, 0x3f, "snapshot load") != 0)
+		goto out;
+
+	/* Without tracking nothing is marked */
+	zx_mem_track(mach, false);
+	zx_memset8(mach, 0x6000, 0x02);
+	if (test_memio_dirty_expect(mach, 0, "tracking off") != 0)
+		goto out;
+
+	if (mach->z80_wpage[0x8000 >> ZX_PAGE_SHIFT] == NULL) {
+		printf("CPU page table not restored.\n");
+		goto out;
+	}
+
+	rc = 0;
+	printf(" ... passed\n");
+out:
+	zx_machine_destroy(mach);
+	return rc;
+}
+
+/** Test that a truncated Spec256 graphics ROM is rejected.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_memio_gfxrom_short(void)
+{
+	zx_machine_t *mach;
+	char fname[L_tmpnam];
+	uint8_t buf[100];
+	char *dir0, *dir1;
+	FILE *f;
+	int rc = 1;
+
+	printf("Test loading truncated graphics ROM...\n");
+
+	if (zx_machine_create(&video_out, &mach) != 0) {
+		printf("Cannot create machine.\n");
+		return 1;
+	}
+
+	if (gpu_enable(mach) != 0) {
+		printf("Cannot enable GPU.\n");
+		goto out;
+	}
+
+	if (tmpnam(fname) == NULL) {
+		printf("tmpnam failed.\n");
+		goto out;
+	}
+
+	f = fopen(fname, "wb");
+	if (f == NULL) {
+		printf("Cannot create '%s'.\n", fname);
+		goto out;
+	}
+
+	memset(buf, 0, sizeof(buf));
+	if (fwrite(buf, 1, sizeof(buf), f) != sizeof(buf)) {
+		printf("Cannot write '%s'.\n", fname);
+		fclose(f);
+		(void) remove(fname);
+		goto out;
+	}
+	fclose(f);
+
+	dir0 = sys_getcwd(NULL, 0);
+	if (gfxrom_load(mach, fname, 0) == 0) {
+		printf("Truncated graphics ROM accepted.\n");
+		(void) remove(fname);
+		free(dir0);
+		goto out;
+	}
+
+	(void) remove(fname);
+	dir1 = sys_getcwd(NULL, 0);
+	if (dir0 == NULL || dir1 == NULL || strcmp(dir0, dir1) != 0) {
+		printf("Working directory not restored.\n");
+		free(dir0);
+		free(dir1);
+		goto out;
+	}
+
+	free(dir0);
+	free(dir1);
+	rc = 0;
+	printf(" ... passed\n");
+out:
+	gpu_disable(mach);
+	zx_machine_destroy(mach);
+	return rc;
+}
+
+/** Run memory unit tests.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+int test_memio(void)
+{
+	int rc;
+
+	rc = test_memio_rom_cache();
+	if (rc != 0)
+		return rc;
+
+	rc = test_memio_dirty();
+	if (rc != 0)
+		return rc;
+
+	return test_memio_gfxrom_short();
+}
@@ -0,0 +1,187 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * Event scheduler unit tests
+ *
+ * Copyright (c) 1999-2019 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file Event scheduler unit tests.
+ */
+
+#include <stdio.h>
+#include "../sched.h"
+#include "sched.h"
+
+enum {
+	test_nev = 4
+};
+
+/** Order in which events fired */
+static int fired[test_nev];
+/** Number of events fired */
+static int nfired;
+
+static void test_sched_fire(void *arg)
+{
+	if (nfired < test_nev)
+		fired[nfired] = *(int *)arg;
+	++nfired;
+}
+
+/** Test that events fire when due, in order of due time and priority.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_sched_order(void)
+{
+	sched_t sched;
+	sched_event_t ev[test_nev];
+	int id[test_nev] = { 0, 1, 2, 3 };
+	/* Due times, event 1 and 3 are due at the same time */
+	unsigned long when[test_nev] = { 300, 100, 200, 100 };
+	int prio[test_nev] = { 0, 2, 0, 1 };
+	/*
+	 * Events due at the same call fire in order of due time, those due
+	 * at the same time in order of priority
+	 */
+	int expect[test_nev] = { 3, 1, 2, 0 };
+	int i;
+
+	printf("Test scheduler event order...\n");
+
+	sched_init(&sched);
+	for (i = 0; i < test_nev; i++) {
+		sched_event_init(&ev[i], prio[i], test_sched_fire, &id[i]);
+		sched_add(&sched, &ev[i], when[i]);
+	}
+
+	if (sched_next(&sched) != 100) {
+		printf("Incorrect next event time.\n");
+		return 1;
+	}
+
+	nfired = 0;
+	sched_run(&sched, 99);
+	if (nfired != 0) {
+		printf("Event fired prematurely.\n");
+		return 1;
+	}
+
+	/* Run well past some events to check they only fire once */
+	sched_run(&sched, 250);
+	if (nfired != 3) {
+		printf("Expected 3 events to fire, got %d.\n", nfired);
+		return 1;
+	}
+
+	if (sched_next(&sched) != 300) {
+		printf("Incorrect next event time.\n");
+		return 1;
+	}
+
+	/* Reschedule a pending event */
+	sched_add(&sched, &ev[0], 400);
+	sched_run(&sched, 399);
+	if (nfired != 3) {
+		printf("Rescheduled event fired prematurely.\n");
+		return 1;
+	}
+
+	sched_run(&sched, 400);
+	if (nfired != test_nev || !sched_empty(&sched)) {
+		printf("Expected all events to fire.\n");
+		return 1;
+	}
+
+	for (i = 0; i < test_nev; i++) {
+		if (fired[i] != expect[i]) {
+			printf("Events fired in wrong order.\n");
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/** Test that the scheduler copes with the clock wrapping around.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_sched_wrap(void)
+{
+	sched_t sched;
+	sched_event_t ev[2];
+	int id[2] = { 0, 1 };
+
+	printf("Test scheduler with clock wrap-around...\n");
+
+	sched_init(&sched);
+	sched_event_init(&ev[0], 0, test_sched_fire, &id[0]);
+	sched_event_init(&ev[1], 0, test_sched_fire, &id[1]);
+	sched_add(&sched, &ev[0], 10);
+	sched_add(&sched, &ev[1], (unsigned long)-10);
+
+	if (sched_next(&sched) != (unsigned long)-10) {
+		printf("Incorrect next event time.\n");
+		return 1;
+	}
+
+	nfired = 0;
+	sched_run(&sched, (unsigned long)-5);
+	if (nfired != 1 || fired[0] != 1) {
+		printf("Expected event 1 to fire.\n");
+		return 1;
+	}
+
+	sched_run(&sched, 10);
+	if (nfired != 2 || fired[1] != 0) {
+		printf("Expected event 0 to fire.\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+/** Run event scheduler unit tests.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+int test_sched(void)
+{
+	int rc;
+
+	rc = test_sched_order();
+	if (rc != 0)
+		return 1;
+
+	rc = test_sched_wrap();
+	if (rc != 0)
+		return 1;
+
+	return 0;
+}
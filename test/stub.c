@@ -0,0 +1,95 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * Front end and platform stand-ins for unit tests
+ *
+ * Copyright (c) 1999-2019 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/**
+ * @file Front end and platform stand-ins for unit tests.
+ *
+ * The emulator core calls back into the front end (gzx.c) and into the
+ * graphics and sound layer of the platform. The unit tests link the core
+ * without either, so this provides the few symbols involved. Nothing is
+ * displayed or played.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../gzx.h"
+#include "../mgfx.h"
+#include "../sndw.h"
+#include "../zx.h"
+
+char *start_dir;
+FILE *logfi;
+int slow_load;
+
+void zx_reset(zx_machine_t *mach)
+{
+	zx_machine_reset(mach);
+}
+
+int mgfx_init(int w, int h)
+{
+	/* clip everything, there is no frame buffer */
+	clip_x0 = clip_y0 = 0;
+	clip_x1 = clip_y1 = -1;
+	return 0;
+}
+
+void mgfx_updscr(void)
+{
+}
+
+void mgfx_setpal(int base, int cnt, int *pal)
+{
+}
+
+int mgfx_set_disp_size(int w, int h)
+{
+	return 0;
+}
+
+void mgfx_input_update(void)
+{
+}
+
+int sndw_init(int bufs)
+{
+	return 0;
+}
+
+void sndw_done(void)
+{
+}
+
+void sndw_write(uint8_t *buf)
+{
+}
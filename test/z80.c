@@ -0,0 +1,1209 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * Z80 CPU unit tests
+ *
+ * Copyright (c) 1999-2019 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/**
+ * @file Z80 CPU unit tests.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../z80.h"
+#include "z80.h"
+
+/** Test machine with flat 64K RAM */
+typedef struct {
+	/** CPU */
+	z80_t cpu;
+	/** Memory */
+	uint8_t mem[65536];
+	/** Last written I/O port */
+	uint16_t out_port;
+	/** Last value written to I/O port */
+	uint8_t out_val;
+} test_z80_mach_t;
+
+static uint8_t test_z80_memget8(void *arg, uint16_t addr)
+{
+	test_z80_mach_t *mach = (test_z80_mach_t *)arg;
+
+	return mach->mem[addr];
+}
+
+static void test_z80_memset8(void *arg, uint16_t addr, uint8_t val)
+{
+	test_z80_mach_t *mach = (test_z80_mach_t *)arg;
+
+	mach->mem[addr] = val;
+}
+
+static void test_z80_out8(void *arg, uint16_t addr, uint8_t val)
+{
+	test_z80_mach_t *mach = (test_z80_mach_t *)arg;
+
+	mach->out_port = addr;
+	mach->out_val = val;
+}
+
+static uint8_t test_z80_in8(void *arg, uint16_t addr)
+{
+	return 0xff;
+}
+
+static uint8_t test_z80_snoop8(void *arg)
+{
+	return 0xff;
+}
+
+static const uint8_t *test_z80_imemptr(void *arg, uint16_t addr)
+{
+	test_z80_mach_t *mach = (test_z80_mach_t *)arg;
+
+	return mach->mem + (addr & 0xc000);
+}
+
+static const z80_dep_t test_z80_dep = {
+	.memget8 = test_z80_memget8,
+	.imemget8 = test_z80_memget8,
+	.memset8 = test_z80_memset8,
+	.out8 = test_z80_out8,
+	.in8 = test_z80_in8,
+	.snoop8 = test_z80_snoop8,
+	.imemptr = test_z80_imemptr
+};
+
+/** Set up test machine and load program at address 0.
+ *
+ * @param mach Test machine
+ * @param prog Program
+ * @param size Program size in bytes
+ */
+static void test_z80_mach_init(test_z80_mach_t *mach, const uint8_t *prog,
+    size_t size)
+{
+	memset(mach->mem, 0, sizeof(mach->mem));
+	memcpy(mach->mem, prog, size);
+	mach->out_port = 0;
+	mach->out_val = 0;
+	z80_init(&mach->cpu, &test_z80_dep, mach);
+}
+
+/** Test two independent CPU contexts executing interleaved.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_two_ctx(void)
+{
+	static test_z80_mach_t ma, mb;
+	int i;
+	/* ld a,12h; add a,a; ld (8000h),a; halt */
+	const uint8_t prog_a[] = {
+		0x3e, 0x12, 0x87, 0x32, 0x00, 0x80, 0x76
+	};
+	/* ld a,40h; add a,a; ld (8000h),a; out (0feh),a; halt */
+	const uint8_t prog_b[] = {
+		0x3e, 0x40, 0x87, 0x32, 0x00, 0x80, 0xd3, 0xfe, 0x76
+	};
+
+	printf("Test two independent Z80 contexts...\n");
+
+	z80_init_tables();
+	test_z80_mach_init(&ma, prog_a, sizeof(prog_a));
+	test_z80_mach_init(&mb, prog_b, sizeof(prog_b));
+
+	for (i = 0; i < 5; i++) {
+		if (i < 4)
+			z80_execinstr(&ma.cpu);
+		z80_execinstr(&mb.cpu);
+	}
+
+	if (ma.mem[0x8000] != 0x24 || mb.mem[0x8000] != 0x80) {
+		printf("Incorrect memory contents %02x, %02x.\n",
+		    ma.mem[0x8000], mb.mem[0x8000]);
+		return 1;
+	}
+
+	if (ma.cpu.clock != 28 || mb.cpu.clock != 39) {
+		printf("Incorrect clock %lu, %lu.\n",
+		    (unsigned long)ma.cpu.clock, (unsigned long)mb.cpu.clock);
+		return 1;
+	}
+
+	if (!ma.cpu.cpus.halted || !mb.cpu.cpus.halted) {
+		printf("CPU not halted.\n");
+		return 1;
+	}
+
+	if (ma.out_val != 0 || (mb.out_port & 0xff) != 0xfe ||
+	    mb.out_val != 0x80) {
+		printf("Incorrect I/O write.\n");
+		return 1;
+	}
+
+	if (z80_getAF(&ma.cpu) >> 8 != 0x24 ||
+	    z80_getAF(&mb.cpu) >> 8 != 0x80) {
+		printf("Incorrect register A.\n");
+		return 1;
+	}
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Test that modified code is not executed from the decoded instruction cache.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_smc(void)
+{
+	static test_z80_mach_t m;
+	int i;
+	/*
+	 * ld b,2; l: nop; ld a,0ch; ld (l),a; djnz l; halt
+	 * The second pass executes inc c instead of nop.
+	 */
+	const uint8_t prog[] = {
+		0x06, 0x02, 0x00, 0x3e, 0x0c, 0x32, 0x02, 0x00, 0x10, 0xf8,
+		0x76
+	};
+
+	printf("Test Z80 self-modifying code...\n");
+
+	z80_init_tables();
+	test_z80_mach_init(&m, prog, sizeof(prog));
+
+	for (i = 0; i < 100 && !m.cpu.cpus.halted; i++)
+		z80_execinstr(&m.cpu);
+
+	if (!m.cpu.cpus.halted) {
+		printf("CPU not halted.\n");
+		return 1;
+	}
+
+	if (z80_getBC(&m.cpu) != 0x0001) {
+		printf("Incorrect BC %04x.\n", z80_getBC(&m.cpu));
+		return 1;
+	}
+
+	/* Modify code behind the CPU's back: dec c */
+	m.mem[0x0002] = 0x0d;
+	z80_icache_inval(&m.cpu, 0x0002);
+
+	m.cpu.cpus.halted = 0;
+	m.cpu.cpus.PC = 0x0002;
+	z80_execinstr(&m.cpu);
+
+	if (z80_getBC(&m.cpu) != 0x0000) {
+		printf("Incorrect BC %04x after external write.\n",
+		    z80_getBC(&m.cpu));
+		return 1;
+	}
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Test running block instruction until the deadline.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_block(void)
+{
+	static test_z80_mach_t m;
+	int i;
+	/* ld hl,8000h; ld de,9000h; ld bc,10; ldir; halt */
+	const uint8_t prog[] = {
+		0x21, 0x00, 0x80, 0x11, 0x00, 0x90, 0x01, 0x0a, 0x00,
+		0xed, 0xb0, 0x76
+	};
+
+	printf("Test Z80 block instruction up to deadline...\n");
+
+	z80_init_tables();
+	test_z80_mach_init(&m, prog, sizeof(prog));
+	for (i = 0; i < 10; i++)
+		m.mem[0x8000 + i] = i + 1;
+
+	for (i = 0; i < 3; i++)
+		z80_execinstr(&m.cpu);
+
+	/* Allow four iterations in one go */
+	m.cpu.deadline = m.cpu.clock + 4 * 21;
+	z80_execinstr(&m.cpu);
+
+	if (z80_getBC(&m.cpu) != 6 || m.cpu.cpus.PC != 0x0009 ||
+	    m.cpu.clock != 30 + 4 * 21 || m.cpu.cpus.R != 3 + 4 * 2) {
+		printf("Incorrect state after first run BC=%04x PC=%04x.\n",
+		    z80_getBC(&m.cpu), m.cpu.cpus.PC);
+		return 1;
+	}
+
+	/* Run the rest */
+	m.cpu.deadline = m.cpu.clock + 1000;
+	z80_execinstr(&m.cpu);
+
+	if (z80_getBC(&m.cpu) != 0 || m.cpu.cpus.PC != 0x000b ||
+	    m.cpu.clock != 30 + 9 * 21 + 16 || m.cpu.cpus.R != 3 + 10 * 2) {
+		printf("Incorrect state after second run BC=%04x PC=%04x.\n",
+		    z80_getBC(&m.cpu), m.cpu.cpus.PC);
+		return 1;
+	}
+
+	if (memcmp(&m.mem[0x8000], &m.mem[0x9000], 10) != 0) {
+		printf("Incorrect memory contents.\n");
+		return 1;
+	}
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Test that 8-bit registers and register pairs agree.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_regs(void)
+{
+	static test_z80_mach_t m;
+	int i;
+	/*
+	 * ld bc,1234h; ld b,81h; rlc b; ld d,56h; ld e,78h; ld h,c; ld l,d;
+	 * ld a,9ah; scf; push af; pop de; exx; ex af,af'
+	 */
+	const uint8_t prog[] = {
+		0x01, 0x34, 0x12, 0x06, 0x81, 0xcb, 0x00, 0x16, 0x56,
+		0x1e, 0x78, 0x61, 0x6a, 0x3e, 0x9a, 0x37, 0xf5, 0xd1,
+		0xd9, 0x08
+	};
+
+	printf("Test Z80 registers and register pairs...\n");
+
+	z80_init_tables();
+	test_z80_mach_init(&m, prog, sizeof(prog));
+
+	for (i = 0; i < 13; i++)
+		z80_execinstr(&m.cpu);
+
+	if (z80_getBC_(&m.cpu) != 0x0334 || m.cpu.cpus.r_[rB] != 0x03 ||
+	    m.cpu.cpus.r_[rC] != 0x34 || z80_getHL_(&m.cpu) != 0x3456 ||
+	    m.cpu.cpus.r_[rH] != 0x34 || m.cpu.cpus.r_[rL] != 0x56) {
+		printf("Incorrect BC'=%04x HL'=%04x.\n", z80_getBC_(&m.cpu),
+		    z80_getHL_(&m.cpu));
+		return 1;
+	}
+
+	if (z80_getDE_(&m.cpu) != z80_getAF_(&m.cpu) ||
+	    m.cpu.cpus.r_[rA] != 0x9a || (m.cpu.cpus.F_ & fC) == 0 ||
+	    m.cpu.cpus.r_[rE] != m.cpu.cpus.F_) {
+		printf("Incorrect DE'=%04x AF'=%04x.\n", z80_getDE_(&m.cpu),
+		    z80_getAF_(&m.cpu));
+		return 1;
+	}
+
+	if (z80_getAF(&m.cpu) != 0 || z80_getBC(&m.cpu) != 0 ||
+	    z80_getDE(&m.cpu) != 0 || z80_getHL(&m.cpu) != 0) {
+		printf("Incorrect main register set.\n");
+		return 1;
+	}
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/*
+ * ld sp,9000h; ld a,7fh; inc a; push af; ld b,80h; add a,b; push af;
+ * jr nz,f; ld a,10h; sub 20h; push af; jr nc,f; jp p,f;
+ * scf; ld a,0feh; adc a,1; push af; cp 1; push af; dec a; push af;
+ * ld a,r; ld (8000h),a; halt; f: ld a,0eeh; ld (8001h),a; halt
+ */
+static const uint8_t test_z80_flags_prog[] = {
+	0x31, 0x00, 0x90, 0x3e, 0x7f, 0x3c, 0xf5, 0x06, 0x80, 0x80,
+	0xf5, 0x20, 0x1b, 0x3e, 0x10, 0xd6, 0x20, 0xf5, 0x30, 0x14,
+	0xf2, 0x28, 0x00, 0x37, 0x3e, 0xfe, 0xce, 0x01, 0xf5, 0xfe,
+	0x01, 0xf5, 0x3d, 0xf5, 0xed, 0x5f, 0x32, 0x00, 0x80, 0x76,
+	0x3e, 0xee, 0x32, 0x01, 0x80, 0x76
+};
+
+/** Stack after running test_z80_flags_prog (AF of each push) */
+static const uint8_t test_z80_flags_stack[] = {
+	0xbb, 0xff, 0x93, 0x00, 0x51, 0x00, 0xa3, 0xf0, 0x45, 0x00,
+	0x94, 0x80
+};
+
+/** Check the result of running test_z80_flags_prog.
+ *
+ * F and R must be up to date as soon as the core returns.
+ *
+ * @param m Test machine
+ * @param r Expected R (it keeps counting while halted)
+ * @param how How the program was run, for the error message
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_flags_check(test_z80_mach_t *m, uint8_t r,
+    const char *how)
+{
+	if (!m->cpu.cpus.halted || m->mem[0x8001] != 0) {
+		printf("Wrong branch taken (%s).\n", how);
+		return 1;
+	}
+
+	if (memcmp(m->mem + 0x9000 - sizeof(test_z80_flags_stack),
+	    test_z80_flags_stack, sizeof(test_z80_flags_stack)) != 0) {
+		printf("Incorrect flags pushed (%s).\n", how);
+		return 1;
+	}
+
+	if (m->cpu.cpus.F != 0x01 || m->cpu.cpus.R != r) {
+		printf("Incorrect F=%02x R=%02x (%s).\n", m->cpu.cpus.F,
+		    m->cpu.cpus.R, how);
+		return 1;
+	}
+
+	return 0;
+}
+
+/** Test flags of arithmetic operations, conditions and R.
+ *
+ * With -DZ80_LAZY this checks that deferred evaluation gives the same
+ * results as eager evaluation.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_flags(void)
+{
+	static test_z80_mach_t m;
+	int i;
+
+	printf("Test Z80 arithmetic flags and R...\n");
+
+	z80_init_tables();
+	test_z80_mach_init(&m, test_z80_flags_prog,
+	    sizeof(test_z80_flags_prog));
+
+	for (i = 0; i < 100 && !m.cpu.cpus.halted; i++)
+		z80_execinstr(&m.cpu);
+
+	if (test_z80_flags_check(&m, 0x19, "single steps") != 0)
+		return 1;
+
+	test_z80_mach_init(&m, test_z80_flags_prog,
+	    sizeof(test_z80_flags_prog));
+	z80_run_until(&m.cpu, 1000);
+
+	if (test_z80_flags_check(&m, 0x64, "run until") != 0)
+		return 1;
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Number of stores that reached test_z80_pg_memset8() */
+static unsigned test_z80_pg_stores;
+
+static void test_z80_pg_memset8(void *arg, uint16_t addr, uint8_t val)
+{
+	test_z80_pg_stores++;
+	test_z80_memset8(arg, addr, val);
+}
+
+/** Test data access through page tables.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_pagemap(void)
+{
+	static test_z80_mach_t m;
+	static uint8_t discard[1 << Z80_PAGE_SHIFT];
+	static uint8_t other[1 << Z80_PAGE_SHIFT];
+	static uint8_t *rpage[8], *wpage[8];
+	z80_dep_t dep = test_z80_dep;
+	unsigned i;
+	/*
+	 * ld a,0aah; ld (1000h),a; ld (2000h),a; ld (4000h),a;
+	 * ld a,(6000h); ld b,a; ld a,(2000h)
+	 */
+	const uint8_t prog[] = {
+		0x3e, 0xaa, 0x32, 0x00, 0x10, 0x32, 0x00, 0x20, 0x32, 0x00,
+		0x40, 0x3a, 0x00, 0x60, 0x47, 0x3a, 0x00, 0x20
+	};
+
+	printf("Test Z80 data access through page tables...\n");
+
+	/* page 0 is ROM, page 1 goes through memset8, page 3 reads other */
+	for (i = 0; i < 8; i++) {
+		rpage[i] = m.mem + (i << Z80_PAGE_SHIFT);
+		wpage[i] = rpage[i];
+	}
+	wpage[0] = discard;
+	wpage[1] = NULL;
+	rpage[3] = other;
+	other[0] = 0x5a;
+
+	dep.memset8 = test_z80_pg_memset8;
+	dep.rpage = rpage;
+	dep.wpage = wpage;
+
+	z80_init_tables();
+	test_z80_mach_init(&m, prog, sizeof(prog));
+	m.cpu.dep = &dep;
+	test_z80_pg_stores = 0;
+
+	for (i = 0; i < 7; i++)
+		z80_execinstr(&m.cpu);
+
+#ifndef NO_Z80PAGEMAP
+	if (m.mem[0x1000] != 0 || discard[0x1000 & Z80_PAGE_MASK] != 0xaa) {
+		printf("Store to ROM page not discarded.\n");
+		return 1;
+	}
+
+	if (m.mem[0x2000] != 0xaa || m.mem[0x4000] != 0xaa ||
+	    test_z80_pg_stores != 1) {
+		printf("Incorrect stores (%u through memset8).\n",
+		    test_z80_pg_stores);
+		return 1;
+	}
+
+	if (m.cpu.cpus.r[rB] != 0x5a || m.cpu.cpus.r[rA] != 0xaa) {
+		printf("Incorrect loads A=%02x B=%02x.\n", m.cpu.cpus.r[rA],
+		    m.cpu.cpus.r[rB]);
+		return 1;
+	}
+#endif
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Test instruction timing.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_tstates(void)
+{
+	static test_z80_mach_t m;
+	unsigned long clock;
+	unsigned i;
+	/*
+	 * ld b,2; ld hl,8000h; xor a; jr nz,$+2; jr z,$+2; djnz $+2;
+	 * djnz $+2; ld bc,02feh; otir; ld ix,0; rlc (ix+0)
+	 */
+	const uint8_t prog[] = {
+		0x06, 0x02, 0x21, 0x00, 0x80, 0xaf, 0x20, 0x00, 0x28, 0x00,
+		0x10, 0x00, 0x10, 0x00, 0x01, 0xfe, 0x02, 0xed, 0xb3, 0xdd,
+		0x21, 0x00, 0x00, 0xdd, 0xcb, 0x00, 0x06
+	};
+	/* T-states of each step (DD prefix is a step of its own) */
+	const unsigned ts[] = {
+		7, 10, 4, 7, 12, 13, 8, 10, 21, 16, 4, 10, 4, 23 - 4
+	};
+
+	printf("Test Z80 instruction timing...\n");
+
+	if (z80_op_tstates(0, 0x20) != 7 || z80_op_tstates(6, 0xb3) != 16 ||
+	    z80_op_tstates(4, 0x06) != 19) {
+		printf("Incorrect base T-states.\n");
+		return 1;
+	}
+
+	z80_init_tables();
+	test_z80_mach_init(&m, prog, sizeof(prog));
+
+	for (i = 0; i < sizeof(ts) / sizeof(ts[0]); i++) {
+		clock = m.cpu.clock;
+		m.cpu.deadline = clock; /* one iteration/prefix at a time */
+		z80_execinstr(&m.cpu);
+		if (m.cpu.clock - clock != ts[i]) {
+			printf("Step %u took %lu T-states instead of %u.\n",
+			    i, m.cpu.clock - clock, ts[i]);
+			return 1;
+		}
+	}
+
+	if (m.cpu.cpus.PC != sizeof(prog)) {
+		printf("Incorrect PC %04x.\n", m.cpu.cpus.PC);
+		return 1;
+	}
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Test accepting interrupts and NMI.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_int(void)
+{
+	static test_z80_mach_t m;
+	unsigned i;
+	/* im 1; ld sp,0; ei; nop; ld ix,0; di; nop; nop */
+	const uint8_t prog[] = {
+		0xed, 0x56, 0x31, 0x00, 0x00, 0xfb, 0x00, 0xdd, 0x21, 0x00,
+		0x00, 0xf3, 0x00, 0x00
+	};
+
+	printf("Test Z80 interrupts...\n");
+
+	z80_init_tables();
+	test_z80_mach_init(&m, prog, sizeof(prog));
+	m.mem[0x38] = 0xfb; /* ei */
+	m.mem[0x39] = 0xc9; /* ret */
+	m.mem[0x66] = 0x00; /* nop */
+	m.mem[0x67] = 0xed; /* retn */
+	m.mem[0x68] = 0x45;
+
+	/* im 1; ld sp,0; ei */
+	for (i = 0; i < 3; i++)
+		z80_execinstr(&m.cpu);
+
+	/* Not accepted right after EI */
+	z80_int(&m.cpu);
+	z80_execinstr(&m.cpu);
+	if (m.cpu.cpus.PC != 0x0007) {
+		printf("Interrupt accepted after EI (PC=%04x).\n",
+		    m.cpu.cpus.PC);
+		return 1;
+	}
+
+	/* Accepted before the next instruction, which is the handler's EI */
+	z80_execinstr(&m.cpu);
+	if (m.cpu.cpus.PC != 0x0039 || m.cpu.cpus.SP != 0xfffe ||
+	    m.mem[0xfffe] != 0x07) {
+		printf("Interrupt not accepted (PC=%04x).\n", m.cpu.cpus.PC);
+		return 1;
+	}
+
+	/* ret; then the DD prefix on its own */
+	z80_execinstr(&m.cpu);
+	m.cpu.deadline = m.cpu.clock;
+	z80_execinstr(&m.cpu);
+	if (m.cpu.cpus.PC != 0x0008) {
+		printf("Incorrect PC %04x after DD prefix.\n", m.cpu.cpus.PC);
+		return 1;
+	}
+
+	/* Not accepted between a DD prefix and the instruction */
+	z80_int(&m.cpu);
+	z80_execinstr(&m.cpu);
+	if (m.cpu.cpus.PC != 0x000b) {
+		printf("Interrupt accepted after prefix (PC=%04x).\n",
+		    m.cpu.cpus.PC);
+		return 1;
+	}
+
+	/* Accepted now, execute the handler's EI; ret */
+	z80_execinstr(&m.cpu);
+	z80_execinstr(&m.cpu);
+	if (m.cpu.cpus.PC != 0x000b || m.cpu.cpus.IFF1 != 1) {
+		printf("Interrupt not accepted after prefixed instruction "
+		    "(PC=%04x).\n", m.cpu.cpus.PC);
+		return 1;
+	}
+
+	/* di; nop; NMI is still accepted, the next interrupt is not */
+	z80_execinstr(&m.cpu);
+	z80_execinstr(&m.cpu);
+	z80_nmi(&m.cpu);
+	z80_int(&m.cpu);
+	z80_execinstr(&m.cpu);
+	if (m.cpu.cpus.PC != 0x0067 || m.cpu.cpus.int_pending) {
+		printf("Incorrect state after NMI (PC=%04x).\n",
+		    m.cpu.cpus.PC);
+		return 1;
+	}
+
+	z80_execinstr(&m.cpu);
+	if (m.cpu.cpus.PC != 0x000d) {
+		printf("Incorrect PC %04x after RETN.\n", m.cpu.cpus.PC);
+		return 1;
+	}
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Test skipping to the deadline while halted.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_halt(void)
+{
+	static test_z80_mach_t m;
+	/* halt */
+	const uint8_t prog[] = { 0x76 };
+
+	printf("Test Z80 halt up to deadline...\n");
+
+	z80_init_tables();
+	test_z80_mach_init(&m, prog, sizeof(prog));
+
+	z80_execinstr(&m.cpu);
+
+	/* 251 NOPs, the last one starts just before the deadline */
+	m.cpu.deadline = 4 + 1000 + 1;
+	z80_execinstr(&m.cpu);
+
+	if (m.cpu.clock != 4 + 251 * 4 || m.cpu.cpus.R != (1 + 251) % 128 ||
+	    m.cpu.cpus.PC != 0x0001) {
+		printf("Incorrect state clock=%lu R=%u.\n", m.cpu.clock,
+		    m.cpu.cpus.R);
+		return 1;
+	}
+
+	/* Interrupt ends the halt, then NOP at 0038h executes */
+	m.cpu.cpus.IFF1 = m.cpu.cpus.IFF2 = 1;
+	m.cpu.cpus.int_mode = 1;
+	z80_int(&m.cpu);
+	z80_execinstr(&m.cpu);
+
+	if (m.cpu.cpus.halted || m.cpu.cpus.PC != 0x0039) {
+		printf("Interrupt not accepted.\n");
+		return 1;
+	}
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Test executing DD/FD prefixed instructions.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_prefix(void)
+{
+	static test_z80_mach_t m;
+	/* ld ix,1234h; halt */
+	const uint8_t prog[] = { 0xdd, 0x21, 0x34, 0x12, 0x76 };
+
+	printf("Test Z80 prefixed instructions...\n");
+
+	z80_init_tables();
+
+	/* Prefix and instruction execute in one go */
+	test_z80_mach_init(&m, prog, sizeof(prog));
+	m.cpu.deadline = 1000;
+	z80_execinstr(&m.cpu);
+
+	if (m.cpu.cpus.IX != 0x1234 || m.cpu.cpus.PC != 0x0004 ||
+	    m.cpu.clock != 14 || m.cpu.cpus.R != 2 ||
+	    m.cpu.cpus.modifier != 0) {
+		printf("Incorrect state after prefixed instruction.\n");
+		return 1;
+	}
+
+	/* Stop after the prefix when the deadline is reached */
+	test_z80_mach_init(&m, prog, sizeof(prog));
+	m.cpu.deadline = 0;
+	z80_execinstr(&m.cpu);
+
+	if (m.cpu.cpus.PC != 0x0001 || m.cpu.clock != 4 ||
+	    m.cpu.cpus.modifier == 0) {
+		printf("Did not stop after prefix.\n");
+		return 1;
+	}
+
+	/* No interrupt between the prefix and the instruction */
+	m.cpu.cpus.IFF1 = m.cpu.cpus.IFF2 = 1;
+	m.cpu.cpus.int_mode = 1;
+	z80_int(&m.cpu);
+	z80_execinstr(&m.cpu);
+
+	if (m.cpu.cpus.IX != 0x1234 || m.cpu.cpus.PC != 0x0004 ||
+	    m.cpu.clock != 14) {
+		printf("Prefixed instruction was interrupted.\n");
+		return 1;
+	}
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Run test machine until the end of a 69888 T-state frame.
+ *
+ * @param mach Test machine
+ * @param frame Frame number
+ */
+static void test_z80_frame(test_z80_mach_t *mach, unsigned long frame)
+{
+	unsigned long end = (frame + 1) * 69888;
+
+	z80_int(&mach->cpu);
+	while ((long)(mach->cpu.clock - end) < 0)
+		z80_run_until(&mach->cpu, end);
+}
+
+/*
+ * Program for the 48K ROM, loaded at 8000h:
+ * ld a,2; call CHAN-OPEN; l: ld bc,(9000h); inc bc; ld (9000h),bc;
+ * call STACK-BC; rst 28h; defb sin, end-calc; call PRINT-FP;
+ * ld a,0dh; rst 10h; ld a,0ffh; ld (SCR-CT),a; jr l
+ */
+static const uint8_t test_z80_sin_prog[] = {
+	0x3e, 0x02, 0xcd, 0x01, 0x16, 0xed, 0x4b, 0x00, 0x90, 0x03,
+	0xed, 0x43, 0x00, 0x90, 0xcd, 0x2b, 0x2d, 0xef, 0x1f, 0x38,
+	0xcd, 0xe3, 0x2d, 0x3e, 0x0d, 0xd7, 0x3e, 0xff, 0x32, 0x8c,
+	0x5c, 0x18, 0xe4
+};
+
+/** Load the 48K ROM image.
+ *
+ * @param rom Buffer for the 16K image
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_load_rom(uint8_t *rom)
+{
+	FILE *f;
+	size_t nr;
+
+	f = fopen("roms/zx48.rom", "rb");
+	if (f == NULL) {
+		printf("Cannot open roms/zx48.rom.\n");
+		return 1;
+	}
+
+	nr = fread(rom, 1, 0x4000, f);
+	fclose(f);
+	if (nr != 0x4000) {
+		printf("Error reading roms/zx48.rom.\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+/** Test skipping of idle loops.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_idle(void)
+{
+	static test_z80_mach_t ma, mb;
+	z80_idle_stat_t stat;
+	unsigned long t;
+	/* l: ld a,(9000h); cp 1; jr nz,l; halt */
+	const uint8_t prog_mem[] = {
+		0x3a, 0x00, 0x90, 0xfe, 0x01, 0x20, 0xf9, 0x76
+	};
+	/* l: in a,(0feh); cp 0; jr nz,l; halt */
+	const uint8_t prog_io[] = {
+		0xdb, 0xfe, 0xfe, 0x00, 0x20, 0xfa, 0x76
+	};
+
+	printf("Test Z80 idle loop skipping...\n");
+
+	z80_init_tables();
+	test_z80_mach_init(&ma, prog_mem, sizeof(prog_mem));
+	test_z80_mach_init(&mb, prog_mem, sizeof(prog_mem));
+	z80_idle_enable(&ma.cpu, 1);
+
+	/* Skipping must not change the outcome */
+	for (t = 10000; t <= 200000; t += 10000) {
+		if (t == 150000) {
+			ma.mem[0x9000] = 1;
+			mb.mem[0x9000] = 1;
+		}
+
+		z80_run_until(&ma.cpu, t);
+		z80_run_until(&mb.cpu, t);
+
+		if (memcmp(&ma.cpu.cpus, &mb.cpu.cpus, sizeof(z80s)) != 0 ||
+		    ma.cpu.clock != mb.cpu.clock) {
+			printf("State differs at T-state %lu.\n", t);
+			return 1;
+		}
+	}
+
+	if (!ma.cpu.cpus.halted) {
+		printf("Loop did not end.\n");
+		return 1;
+	}
+
+	z80_idle_getstat(&ma.cpu, &stat);
+#ifndef NO_Z80IDLE
+	if (stat.skips == 0 || stat.nloops != 1 || stat.loop[0].pc != 0 ||
+	    stat.loop[0].period != 32) {
+		printf("Idle loop not detected.\n");
+		return 1;
+	}
+#endif
+
+	/* Skipping is off unless enabled */
+	z80_idle_getstat(&mb.cpu, &stat);
+	if (stat.skips != 0) {
+		printf("Idle loop skipped while disabled.\n");
+		return 1;
+	}
+
+	/* Port reads not declared stable are not skipped */
+	test_z80_mach_init(&ma, prog_io, sizeof(prog_io));
+	z80_idle_enable(&ma.cpu, 1);
+	z80_run_until(&ma.cpu, 100000);
+
+	z80_idle_getstat(&ma.cpu, &stat);
+	if (stat.skips != 0) {
+		printf("Loop reading unstable port skipped.\n");
+		return 1;
+	}
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Test that translated ROM code gives the same results as the interpreter.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_aot(void)
+{
+	static test_z80_mach_t ma, mb;
+	static uint8_t rom[0x4000];
+	z80_aot_t *aot;
+	unsigned long i;
+
+	printf("Test Z80 translated ROM code...\n");
+
+	if (test_z80_load_rom(rom) != 0)
+		return 1;
+
+	z80_init_tables();
+	test_z80_mach_init(&ma, rom, sizeof(rom));
+	test_z80_mach_init(&mb, rom, sizeof(rom));
+
+	aot = z80_aot_find(rom);
+#ifndef NO_Z80AOT
+	if (aot == NULL) {
+		printf("No translated code for 48K ROM.\n");
+		return 1;
+	}
+#endif
+	z80_aot_map(&mb.cpu, aot);
+
+	/* Boot, then keep printing and computing sines */
+	for (i = 0; i < 200; i++) {
+		if (i == 100) {
+			memcpy(ma.mem + 0x8000, test_z80_sin_prog,
+			    sizeof(test_z80_sin_prog));
+			memcpy(mb.mem + 0x8000, test_z80_sin_prog,
+			    sizeof(test_z80_sin_prog));
+			ma.cpu.cpus.PC = mb.cpu.cpus.PC = 0x8000;
+		}
+
+		test_z80_frame(&ma, i);
+		test_z80_frame(&mb, i);
+
+		if (memcmp(&ma.cpu.cpus, &mb.cpu.cpus, sizeof(z80s)) != 0 ||
+		    ma.cpu.clock != mb.cpu.clock ||
+		    memcmp(ma.mem, mb.mem, sizeof(ma.mem)) != 0) {
+			printf("State differs after frame %lu.\n", i);
+			return 1;
+		}
+	}
+
+	/* Modified ROM has no translated code */
+	rom[0x1234] ^= 0xff;
+	if (z80_aot_find(rom) != NULL) {
+		printf("Translated code found for modified ROM.\n");
+		return 1;
+	}
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Test that JIT-translated code gives the same results as the interpreter.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_jit(void)
+{
+	static test_z80_mach_t m[3];
+	static uint8_t rom[0x4000];
+	z80_jit_stat_t stat;
+	unsigned long i;
+	int j;
+	/* l: ld a,0; inc a; ld (l+1),a; ld (9000h),a; jr l */
+	const uint8_t smc_prog[] = {
+		0x3e, 0x00, 0x3c, 0x32, 0x01, 0x81, 0x32, 0x00, 0x90, 0x18,
+		0xf5
+	};
+	/*
+	 * l: inc a; ld (m+1),a; ld (9000h),a; nop; m: ld b,0; jr l
+	 * (at 82fch, the write lands in the page after the block start)
+	 */
+	const uint8_t smc_page_prog[] = {
+		0x3c, 0x32, 0x05, 0x83, 0x32, 0x00, 0x90, 0x00, 0x06, 0x00,
+		0x18, 0xf4
+	};
+
+	printf("Test Z80 JIT...\n");
+
+	if (test_z80_load_rom(rom) != 0)
+		return 1;
+
+	z80_init_tables();
+	for (j = 0; j < 3; j++)
+		test_z80_mach_init(&m[j], rom, sizeof(rom));
+
+	/* m[0] interprets, m[1] uses the JIT, m[2] verifies it */
+	if (z80_jit_enable(&m[1].cpu, Z80_JIT_ON) != 0 ||
+	    z80_jit_enable(&m[2].cpu, Z80_JIT_CHECK) != 0) {
+#ifdef Z80_JIT
+		printf("Cannot enable JIT.\n");
+		return 1;
+#else
+		printf(" ... skipped (JIT not compiled in)\n");
+		return 0;
+#endif
+	}
+
+	/*
+	 * Boot, print and compute sines, then modify code that has
+	 * been translated, over and over, also across a page boundary
+	 */
+	for (i = 0; i < 200; i++) {
+		for (j = 0; j < 3; j++) {
+			if (i == 100) {
+				memcpy(m[j].mem + 0x8000, test_z80_sin_prog,
+				    sizeof(test_z80_sin_prog));
+				m[j].cpu.cpus.PC = 0x8000;
+			}
+			if (i == 150) {
+				memcpy(m[j].mem + 0x8100, smc_prog,
+				    sizeof(smc_prog));
+				m[j].cpu.cpus.PC = 0x8100;
+			}
+			if (i == 175) {
+				memcpy(m[j].mem + 0x82fc, smc_page_prog,
+				    sizeof(smc_page_prog));
+				m[j].cpu.cpus.PC = 0x82fc;
+			}
+
+			test_z80_frame(&m[j], i);
+		}
+
+		for (j = 1; j < 3; j++) {
+			if (memcmp(&m[0].cpu.cpus, &m[j].cpu.cpus,
+			    sizeof(z80s)) != 0 ||
+			    m[0].cpu.clock != m[j].cpu.clock ||
+			    memcmp(m[0].mem, m[j].mem, sizeof(m[0].mem)) != 0) {
+				printf("State differs after frame %lu.\n", i);
+				return 1;
+			}
+		}
+	}
+
+	z80_jit_getstat(&m[1].cpu, &stat);
+	if (stat.blocks == 0 || stat.chains == 0 || stat.invals == 0) {
+		printf("JIT did not translate, chain or invalidate blocks.\n");
+		return 1;
+	}
+
+	z80_jit_getstat(&m[2].cpu, &stat);
+	if (stat.checked == 0 || stat.mismatch != 0) {
+		printf("JIT verification failed (%lu of %lu runs).\n",
+		    stat.mismatch, stat.checked);
+		return 1;
+	}
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Fake host clock advancing by 100 ns on every reading */
+static unsigned long long test_z80_prof_ns;
+
+static unsigned long long test_z80_prof_clock(void)
+{
+	test_z80_prof_ns += 100;
+	return test_z80_prof_ns;
+}
+
+/** Test per-opcode profiling.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80_prof(void)
+{
+	static test_z80_mach_t m;
+	z80_prof_t prof;
+	FILE *f;
+	char buf[128];
+	/* ld b,3; l: djnz l; ld bc,4; ldir; halt */
+	const uint8_t prog[] = {
+		0x06, 0x03, 0x10, 0xfe, 0x01, 0x04, 0x00, 0xed, 0xb0, 0x76
+	};
+
+	printf("Test Z80 profiling...\n");
+
+	z80_init_tables();
+	test_z80_mach_init(&m, prog, sizeof(prog));
+	z80_prof_enable(&m.cpu, 1, 1, test_z80_prof_clock);
+	z80_run_until(&m.cpu, 1000);
+	z80_prof_enable(&m.cpu, 0, 0, NULL);
+
+#ifndef NO_Z80PROF
+	z80_prof_get(&m.cpu, 0, 0x10, &prof);
+	if (prof.count != 3 || prof.tstates != 2 * 13 + 8 ||
+	    prof.samples != 3 || prof.ns != 3 * 100) {
+		printf("Incorrect profile of DJNZ (%lu, %lu).\n", prof.count,
+		    prof.tstates);
+		return 1;
+	}
+
+	/* All iterations of LDIR execute in one go */
+	z80_prof_get(&m.cpu, 6, 0xb0, &prof);
+	if (prof.count != 4 || prof.tstates != 3 * 21 + 16 ||
+	    prof.samples != 4 || prof.ns != 100) {
+		printf("Incorrect profile of LDIR (%lu, %lu).\n", prof.count,
+		    prof.tstates);
+		return 1;
+	}
+#else
+	(void)prof;
+#endif
+
+	f = tmpfile();
+	if (f == NULL) {
+		printf("Cannot create temporary file.\n");
+		return 1;
+	}
+
+	if (z80_prof_write_csv(&m.cpu, f) != 0) {
+		printf("Error writing CSV.\n");
+		fclose(f);
+		return 1;
+	}
+
+	rewind(f);
+	if (fgets(buf, sizeof(buf), f) == NULL ||
+	    strcmp(buf, "table,opcode,handler,count,tstates,samples,ns\n") != 0) {
+		printf("Incorrect CSV header.\n");
+		fclose(f);
+		return 1;
+	}
+
+#ifndef NO_Z80PROF
+	if (fgets(buf, sizeof(buf), f) == NULL ||
+	    strcmp(buf, "op,0x01,ei_ld_BC_NN,1,10,1,100\n") != 0) {
+		printf("Incorrect CSV line '%s'.\n", buf);
+		fclose(f);
+		return 1;
+	}
+#endif
+
+	fclose(f);
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Run Z80 CPU unit tests.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+int test_z80(void)
+{
+	int rc;
+
+	rc = test_z80_two_ctx();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_smc();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_block();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_regs();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_flags();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_pagemap();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_tstates();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_int();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_halt();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_prefix();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_idle();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_aot();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_jit();
+	if (rc != 0)
+		return 1;
+
+	rc = test_z80_prof();
+	if (rc != 0)
+		return 1;
+
+	return 0;
+}
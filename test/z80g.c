@@ -0,0 +1,190 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * Z80 GPU (Spec256) unit tests
+ *
+ * Copyright (c) 1999-2019 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/**
+ * @file Z80 GPU (Spec256) unit tests.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../memio.h"
+#include "../video/out.h"
+#include "../z80g.h"
+#include "../zx.h"
+#include "../zx_scr.h"
+#include "z80g.h"
+
+enum {
+	/** Instructions to execute at most */
+	test_z80g_ninstr = 10000,
+	/** Where the program is loaded */
+	test_z80g_org = 0x8000
+};
+
+/*
+ *	ld hl,9000h; ld ix,9100h; ld iy,9200h; ld b,16
+ * l:	ld a,(hl); add a,(ix+1); adc a,(iy+2); ld c,a; sub (hl); sbc a,c
+ *	xor (ix+3); and 7fh; or (iy+4); cp c; daa; ld (hl),a; rla; rrca
+ *	ld d,a; ld e,(ix+5); rl e; srl d; set 3,(hl); res 1,(ix+6)
+ *	rlc (iy+7); push de; ex af,af'; ld a,e; ex af,af'
+ *	exx; ld hl,(9010h); ld de,(9012h); adc hl,de; sbc hl,bc
+ *	ld (9020h),hl; exx; neg; ld (ix+8),a; pop de; rld
+ *	inc hl; inc ix; dec iy; ld (iy+9),d; djnz l; halt
+ */
+static const uint8_t test_z80g_prog[] = {
+	0x21, 0x00, 0x90, 0xdd, 0x21, 0x00, 0x91, 0xfd, 0x21, 0x00, 0x92,
+	0x06, 0x10,
+	0x7e, 0xdd, 0x86, 0x01, 0xfd, 0x8e, 0x02, 0x4f, 0x96, 0x99,
+	0xdd, 0xae, 0x03, 0xe6, 0x7f, 0xfd, 0xb6, 0x04, 0xb9, 0x27, 0x77,
+	0x17, 0x0f, 0x57, 0xdd, 0x5e, 0x05, 0xcb, 0x13, 0xcb, 0x3a, 0xcb,
+	0xde, 0xdd, 0xcb, 0x06, 0x8e, 0xfd, 0xcb, 0x07, 0x06, 0xd5, 0x08,
+	0x7b, 0x08, 0xd9, 0x2a, 0x10, 0x90, 0xed, 0x5b, 0x12, 0x90, 0xed,
+	0x5a, 0xed, 0x42, 0x22, 0x20, 0x90, 0xd9, 0xed, 0x44, 0xdd, 0x77,
+	0x08, 0xd1, 0xed, 0x6f, 0x23, 0xdd, 0x23, 0xfd, 0x2b, 0xfd, 0x72,
+	0x09, 0x10, 0xb1, 0x76
+};
+
+/** Result of running the program */
+typedef struct {
+	/** Registers of each plane */
+	z80s regs[NGP];
+	/** GPU memory */
+	uint64_t mem[0x10000];
+} test_z80g_res_t;
+
+/** Run the test program on the CPU and the GPU.
+ *
+ * @param lanes Execute in lanes where possible (or plane by plane)
+ * @param res Place to store the result
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80g_run(bool lanes, test_z80g_res_t *res)
+{
+	zx_machine_t *mach;
+	unsigned i;
+	int rc = 1;
+
+	if (zx_machine_create(&video_out, &mach) != 0) {
+		printf("Cannot create machine.\n");
+		return 1;
+	}
+
+	/* the same plane contents for both runs */
+	srand(1);
+	if (gpu_enable(mach) != 0) {
+		printf("Cannot enable GPU.\n");
+		goto out;
+	}
+	gpu_set_lanes(mach, lanes);
+
+	for (i = 0; i < sizeof(test_z80g_prog); i++)
+		zx_memset8(mach, test_z80g_org + i, test_z80g_prog[i]);
+	mach->cpu.cpus.PC = test_z80g_org;
+	mach->cpu.cpus.SP = 0xff00;
+	gpu_set_regs(mach, &mach->cpu.cpus);
+
+	/* step by single instructions like the emulator does */
+	for (i = 0; i < test_z80g_ninstr && !mach->cpu.cpus.halted; i++) {
+		mach->cpu.deadline = mach->cpu.clock;
+		z80_g_execinstr(mach);
+	}
+
+	if (!mach->cpu.cpus.halted) {
+		printf("Program did not finish.\n");
+		goto out;
+	}
+
+	for (i = 0; i < NGP; i++) {
+		gpu_get_regs(mach, i, &res->regs[i]);
+		/* only carry is kept for each plane */
+		res->regs[i].F &= fC;
+		res->regs[i].F_ &= fC;
+	}
+	memcpy(res->mem, mach->gpu.mem, sizeof(res->mem));
+	rc = 0;
+out:
+	gpu_disable(mach);
+	zx_machine_destroy(mach);
+	return rc;
+}
+
+/** Test that executing in lanes gives the same results as executing
+ * plane by plane on the Z80 core.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_z80g_lanes(void)
+{
+	static test_z80g_res_t rl, rp;
+	int i;
+
+	printf("Test Z80 GPU lanes against planes...\n");
+
+	if (test_z80g_run(true, &rl) != 0)
+		return 1;
+	if (test_z80g_run(false, &rp) != 0)
+		return 1;
+
+	for (i = 0; i < NGP; i++) {
+		if (memcmp(&rl.regs[i], &rp.regs[i], sizeof(z80s)) != 0) {
+			printf("Registers of plane %d differ.\n", i);
+			return 1;
+		}
+	}
+
+	if (memcmp(rl.mem, rp.mem, sizeof(rl.mem)) != 0) {
+		printf("GPU memory differs.\n");
+		return 1;
+	}
+
+	/* planes start with different memory contents */
+	if (rl.regs[0].r[rA] == rl.regs[1].r[rA] &&
+	    rl.regs[0].r[rA] == rl.regs[2].r[rA]) {
+		printf("Planes did not diverge.\n");
+		return 1;
+	}
+
+	printf(" ... passed\n");
+
+	return 0;
+}
+
+/** Run Z80 GPU unit tests.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+int test_z80g(void)
+{
+	return test_z80g_lanes();
+}
@@ -0,0 +1,247 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * Run loop selection unit tests
+ *
+ * Copyright (c) 1999-2019 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/**
+ * @file Run loop selection unit tests.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "../clock.h"
+#include "../debug.h"
+#include "../gzx.h"
+#include "../sched.h"
+#include "../tape/quick.h"
+#include "../video/out.h"
+#include "../xmap.h"
+#include "../xtrace.h"
+#include "../z80g.h"
+#include "../zx.h"
+#include "../zx_run.h"
+#include "../zx_scr.h"
+#include "../zx_sound.h"
+#include "zx_run.h"
+
+/** Select run loop and check the choice.
+ *
+ * @param mach Machine
+ * @param run Expected run loop
+ * @param what Configuration, for the error message
+ * @return Zero on success, non-zero on failure
+ */
+static int test_zx_run_expect(zx_machine_t *mach,
+    void (*run)(zx_machine_t *), const char *what)
+{
+	zx_run_select(mach);
+	if (mach->run != run) {
+		printf("Wrong run loop selected (%s).\n", what);
+		return 1;
+	}
+
+	return 0;
+}
+
+/** Test that the run loop and breakpoints follow the configuration.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_zx_run_select(void)
+{
+	zx_machine_t *mach;
+	int rc = 1;
+
+	printf("Test run loop selection...\n");
+
+	if (zx_machine_create(&video_out, &mach) != 0) {
+		printf("Cannot create machine.\n");
+		return 1;
+	}
+
+	if (test_zx_run_expect(mach, zx_run_plain, "default") != 0)
+		goto out;
+
+	/* Tape traps */
+	if (mach->nbrk != 2 || mach->brk_addr[0] != TAPE_LDBYTES_TRAP ||
+	    mach->brk_addr[1] != TAPE_SABYTES_TRAP) {
+		printf("Tape trap breakpoints not set.\n");
+		goto out;
+	}
+
+	slow_load = 1;
+	zx_run_select(mach);
+	slow_load = 0;
+	if (mach->nbrk != 0) {
+		printf("Tape trap breakpoints set with slow loading.\n");
+		goto out;
+	}
+
+	/* Debugger stop address */
+	dbg_stop_enabled = true;
+	dbg_stop_addr = 0x1234;
+	zx_run_select(mach);
+	dbg_stop_enabled = false;
+	if (mach->nbrk != 3 || mach->brk_addr[2] != 0x1234) {
+		printf("Debugger stop breakpoint not set.\n");
+		goto out;
+	}
+
+	xmap_enabled = true;
+	if (test_zx_run_expect(mach, zx_run_trace, "xmap") != 0)
+		goto out;
+	xmap_enabled = false;
+
+	/* Video event lapsed while stepping, re-armed for plain runs */
+	xtrace_enabled = true;
+	if (test_zx_run_expect(mach, zx_run_trace, "xtrace") != 0)
+		goto out;
+	xtrace_enabled = false;
+	sched_add(&mach->sched, &mach->ev_video, 0);
+	if (test_zx_run_expect(mach, zx_run_plain, "default") != 0)
+		goto out;
+	if (mach->ev_video.when != zx_scr_next_event(mach)) {
+		printf("Video event not rescheduled.\n");
+		goto out;
+	}
+
+	if (gpu_enable(mach) != 0) {
+		printf("Cannot enable GPU.\n");
+		goto out;
+	}
+	if (test_zx_run_expect(mach, zx_run_gpu, "gpu") != 0)
+		goto out;
+
+	/* Tracing and the debugger take precedence */
+	xtrace_enabled = true;
+	if (test_zx_run_expect(mach, zx_run_trace, "gpu, xtrace") != 0)
+		goto out;
+	dbg_itrap_enabled = true;
+	if (test_zx_run_expect(mach, zx_run_debug, "gpu, xtrace, itrap") != 0)
+		goto out;
+
+	rc = 0;
+	printf(" ... passed\n");
+out:
+	dbg_itrap_enabled = false;
+	xtrace_enabled = false;
+	xmap_enabled = false;
+	if (gpu_is_on(mach))
+		gpu_disable(mach);
+	zx_machine_destroy(mach);
+	return rc;
+}
+
+/** Test that two machines keep their video generators and GPUs apart.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+static int test_zx_run_two_machines(void)
+{
+	zx_machine_t *ma = NULL;
+	zx_machine_t *mb = NULL;
+	int rc = 1;
+
+	printf("Test two machines with Spec256 GPU on one of them...\n");
+
+	if (zx_scr_init() != 0 || zx_sound_init() != 0) {
+		printf("Cannot initialize screen and sound.\n");
+		return 1;
+	}
+
+	if (zx_machine_create(&video_out, &ma) != 0 ||
+	    zx_machine_create(&video_out, &mb) != 0) {
+		printf("Cannot create machine.\n");
+		goto out;
+	}
+
+	if (gpu_enable(ma) != 0) {
+		printf("Cannot enable GPU.\n");
+		goto out;
+	}
+	zx_scr_mode(ma, 1);
+	zx_scr_mode(mb, 1);
+	if (gpu_is_on(mb) || mb->gpu.mem != NULL || mb->spec256_on) {
+		printf("GPU turned on in the other machine.\n");
+		goto out;
+	}
+
+	/* One field of the first machine, on the GPU and Spec256 video */
+	if (test_zx_run_expect(ma, zx_run_gpu, "gpu") != 0)
+		goto out;
+	while (ma->cpu.clock < ULA_FIELD_TICKS + 100)
+		zx_machine_step(ma);
+
+	if (ma->spec256.clock < ULA_FIELD_TICKS) {
+		printf("Spec256 video did not advance.\n");
+		goto out;
+	}
+	if (mb->spec256.clock != 0 || mb->ula.cbase != 0 ||
+	    mb->cpu.clock != 0) {
+		printf("Other machine advanced.\n");
+		goto out;
+	}
+
+	/* Turning the GPU off in one machine leaves the other alone */
+	zx_machine_reset(mb);
+	gpu_set_allow(mb, false);
+	if (!gpu_is_on(ma) || !ma->spec256_on || !ma->gpu.allow) {
+		printf("GPU turned off in the other machine.\n");
+		goto out;
+	}
+
+	rc = 0;
+	printf(" ... passed\n");
+out:
+	if (ma != NULL) {
+		if (gpu_is_on(ma))
+			gpu_disable(ma);
+		zx_machine_destroy(ma);
+	}
+	if (mb != NULL)
+		zx_machine_destroy(mb);
+	zx_sound_done();
+	return rc;
+}
+
+/** Run run loop selection unit tests.
+ *
+ * @return Zero on success, non-zero on failure
+ */
+int test_zx_run(void)
+{
+	int rc;
+
+	rc = test_zx_run_select();
+	if (rc != 0)
+		return rc;
+
+	return test_zx_run_two_machines();
+}
@@ -0,0 +1,78 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * I/O port decoder types
+ *
+ * Copyright (c) 1999-2017 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file I/O port decoder types
+ */
+
+#ifndef TYPES_IODEC_H
+#define TYPES_IODEC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum {
+	/** Maximum number of devices, including the one for unclaimed ports */
+	iodec_max_devs = 16,
+	/** Number of I/O port addresses */
+	iodec_nports = 0x10000
+};
+
+/** Device attached to the I/O space */
+typedef struct {
+	/** Address bits the device decodes */
+	uint16_t mask;
+	/** Value of the decoded address bits */
+	uint16_t val;
+	/** Read port, NULL if the device does not answer reads */
+	uint8_t (*in8)(void *, uint16_t);
+	/** Write port, NULL if the device ignores writes */
+	void (*out8)(void *, uint16_t, uint8_t);
+	/** Reading the port returns the same value until the next event
+	    (optional, NULL means it does not) */
+	bool (*in8_stable)(void *, uint16_t);
+	/** Argument to callback functions */
+	void *arg;
+} iodec_dev_t;
+
+/** I/O port decoder */
+typedef struct {
+	/** Devices, dev[0] answers ports no other device claims */
+	iodec_dev_t *dev[iodec_max_devs];
+	/** Number of entries in @c dev */
+	unsigned ndevs;
+	/** Index into @c dev of the device answering reads of each port */
+	uint8_t rd[iodec_nports];
+	/** Index into @c dev of the device taking writes to each port */
+	uint8_t wr[iodec_nports];
+} iodec_t;
+
+#endif
@@ -36,6 +36,8 @@
 
 /** Spec256 video generator */
 typedef struct {
+	/** Machine the video generator belongs to */
+	struct zx_machine *mach;
 	struct video_out *vout;
 	unsigned long clock;
 	uint8_t *gfxpal;
@@ -39,6 +39,8 @@
 
 /** ULA video generator */
 typedef struct {
+	/** Machine the ULA belongs to */
+	struct zx_machine *mach;
 	struct video_out *vout;
 	unsigned long clock;
 	unsigned long cbase;
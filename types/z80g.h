@@ -0,0 +1,66 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * Z80 GPU (a.k.a. Spec256) types
+ *
+ * Copyright (c) 1999-2019 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TYPES_Z80G_H
+#define TYPES_Z80G_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** GPU registers, one byte lane per plane */
+typedef struct {
+	uint64_t r[8];		/* B, C, D, E, H, L, F, A */
+	uint64_t r_[8];		/* alternate registers */
+	uint64_t xh[2];		/* IXh, IYh */
+	uint64_t xl[2];		/* IXl, IYl */
+	bool int_pending;
+	bool nmi_pending;
+} gpu_regs_t;
+
+/** Z80 GPU */
+typedef struct {
+	/** CPU whose code the GPU executes */
+	struct _z80 *cpu;
+	/** Allow probing for GFX and turning on GPU when needed */
+	bool allow;
+	/** GPU is on */
+	bool on;
+	/** Execute instructions in all planes at once where possible */
+	bool lanes;
+	/** Plane accessed by gpu_z80_dep */
+	int plane;
+	/** GPU memory, one word per address with plane i in bits 8i..8i+7 */
+	uint64_t *mem;
+	/** GPU registers */
+	gpu_regs_t regs;
+} gpu_t;
+
+#endif
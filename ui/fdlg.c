@@ -107,7 +107,7 @@ void select_tapefile_dialog(void)
 	if (file_sel(&fname, "Select Tapefile") > 0) {
 		fprintf(logfi, "selecting tape file\n");
 		fflush(logfi);
-		(void) tape_deck_open(tape_deck, fname);
+		(void) tape_deck_open(gzx_mach->tape_deck, fname);
 		fprintf(logfi, "freeing filename\n");
 		fflush(logfi);
 		free(fname);
@@ -120,7 +120,7 @@ void load_snap_dialog(void)
 	char *fname;
 
 	if (file_sel(&fname, "Load Snapshot") > 0) {
-		zx_load_snap(fname);
+		zx_load_snap(gzx_mach, fname);
 		free(fname);
 	}
 }
@@ -135,7 +135,7 @@ void save_snap_dialog(void)
 	if (rc != 0)
 		return;
 
-	zx_save_snap(fname);
+	zx_save_snap(gzx_mach, fname);
 	free(fname);
 }
 
@@ -149,7 +149,7 @@ void save_tape_as_dialog(void)
 	if (rc != 0)
 		return;
 
-	tape_deck_save_as(tape_deck, fname);
+	tape_deck_save_as(gzx_mach->tape_deck, fname);
 	free(fname);
 }
 
@@ -31,6 +31,7 @@
 
 #include <stdlib.h>
 
+#include "../gzx.h"
 #include "../mgfx.h"
 #include "../video/ula.h"
 #include "../z80g.h"
@@ -63,16 +64,16 @@ static void hwopts_prev_opt(int l)
 {
 	switch (l) {
 	case 0:
-		ay0_enable = !ay0_enable;
+		gzx_mach->ay_enable = !gzx_mach->ay_enable;
 		break;
 	case 1:
-		kjoy0_enable = !kjoy0_enable;
+		gzx_mach->kjoy_enable = !gzx_mach->kjoy_enable;
 		break;
 	case 2:
-		video_ula_enable_plus(&video_ula, !video_ula.plus_enable);
+		video_ula_enable_plus(&gzx_mach->ula, !gzx_mach->ula.plus_enable);
 		break;
 	case 3:
-		gpu_set_allow(!gpu_allow);
+		gpu_set_allow(gzx_mach, !gzx_mach->gpu.allow);
 		break;
 	}
 }
@@ -81,16 +82,16 @@ static void hwopts_next_opt(int l)
 {
 	switch (l) {
 	case 0:
-		ay0_enable = !ay0_enable;
+		gzx_mach->ay_enable = !gzx_mach->ay_enable;
 		break;
 	case 1:
-		kjoy0_enable = !kjoy0_enable;
+		gzx_mach->kjoy_enable = !gzx_mach->kjoy_enable;
 		break;
 	case 2:
-		video_ula_enable_plus(&video_ula, !video_ula.plus_enable);
+		video_ula_enable_plus(&gzx_mach->ula, !gzx_mach->ula.plus_enable);
 		break;
 	case 3:
-		gpu_set_allow(!gpu_allow);
+		gpu_set_allow(gzx_mach, !gzx_mach->gpu.allow);
 		break;
 	}
 }
@@ -99,13 +100,13 @@ static const char *hwopts_get_opt(int l)
 {
 	switch (l) {
 	case 0:
-		return ay0_enable ? "On" : "Off";
+		return gzx_mach->ay_enable ? "On" : "Off";
 	case 1:
-		return kjoy0_enable ? "On" : "Off";
+		return gzx_mach->kjoy_enable ? "On" : "Off";
 	case 2:
-		return video_ula.plus_enable ? "On" : "Off";
+		return gzx_mach->ula.plus_enable ? "On" : "Off";
 	case 3:
-		return gpu_allow ? "Auto" : "Off";
+		return gzx_mach->gpu.allow ? "Auto" : "Off";
 	default:
 		return NULL;
 	}
@@ -70,12 +70,12 @@ static void menu_run_line(int l)
 		select_tapefile_dialog();
 		break;
 	case 3:
-		zx_select_memmodel(ZXM_48K);
-		zx_reset();
+		zx_select_memmodel(gzx_mach, ZXM_48K);
+		zx_reset(gzx_mach);
 		break;
 	case 4:
-		zx_select_memmodel(ZXM_128K);
-		zx_reset();
+		zx_select_memmodel(gzx_mach, ZXM_128K);
+		zx_reset(gzx_mach);
 		break;
 	case 5:
 		display_menu();
@@ -57,22 +57,22 @@ static void tmenu_run_line(int l)
 {
 	switch (l) {
 	case 0:
-		tape_deck_play(tape_deck);
+		tape_deck_play(gzx_mach->tape_deck);
 		break;
 	case 1:
-		tape_deck_stop(tape_deck);
+		tape_deck_stop(gzx_mach->tape_deck);
 		break;
 	case 2:
-		tape_deck_rewind(tape_deck);
+		tape_deck_rewind(gzx_mach->tape_deck);
 		break;
 	case 3:
 		slow_load = !slow_load;
 		break;
 	case 4:
-		tape_deck_new(tape_deck);
+		tape_deck_new(gzx_mach->tape_deck);
 		break;
 	case 5:
-		tape_deck_save(tape_deck);
+		tape_deck_save(gzx_mach->tape_deck);
 		break;
 	case 6:
 		save_tape_as_dialog();
@@ -40,6 +40,7 @@
 #include "../sys_all.h"
 #include "../xtrace.h"
 #include "../z80g.h"
+#include "../zx.h"
 #include "out.h"
 #include "spec256.h"
 
@@ -79,20 +80,20 @@ static uint16_t vxswapb(uint16_t ofs)
  */
 static void video_spec256_disp_fast_elem(video_spec256_t *spec, int x, int y)
 {
-	int i, j;
+	int i;
 	uint8_t b;
 	uint8_t color;
 	uint16_t offs;
 	uint16_t bgoff;
+	uint64_t pix;
 
 	offs = vxswapb(y * 32 + x);
 
+	/* byte 7 - i holds the color of pixel i, bit j from plane j */
+	pix = gfx_transpose(spec->mach->gpu.mem[0x4000 + offs]);
+
 	for (i = 0; i < 8; i++) {
-		b = 0;
-		for (j = 0; j < 8; j++) {
-			if (gfxscr[j][offs] & (1 << (7 - i)))
-				b |= (1 << j);
-		}
+		b = (pix >> (8 * (7 - i))) & 0xff;
 		if (b != 0) {
 			color = b;
 		} else {
@@ -127,19 +128,19 @@ void video_spec256_disp_fast(video_spec256_t *spec)
 	 */
 
 	/* top + corners */
-	video_out_rect(spec->vout, 0, 0, zx_field_w - 1, zx_paper_y0 - 1, border);
+	video_out_rect(spec->vout, 0, 0, zx_field_w - 1, zx_paper_y0 - 1, spec->mach->border);
 
 	/* bottom + corners */
 	video_out_rect(spec->vout, 0, zx_paper_y1, zx_field_w - 1,
-	    zx_field_h - 1, border);
+	    zx_field_h - 1, spec->mach->border);
 
 	/* left */
 	video_out_rect(spec->vout, 0, zx_paper_y0, zx_paper_x0 - 1,
-	    zx_paper_y1, border);
+	    zx_paper_y1, spec->mach->border);
 
 	/* right */
 	video_out_rect(spec->vout, zx_paper_x1, zx_paper_y0, zx_field_w - 1,
-	    zx_paper_y1, border);
+	    zx_paper_y1, spec->mach->border);
 
 	/*
 	 * Draw paper
@@ -151,25 +152,28 @@ void video_spec256_disp_fast(video_spec256_t *spec)
 
 	spec->clock += ULA_FIELD_TICKS;
 
-#ifdef XTRACE
-	xtrace_int();
-#endif
-	z80_int();
+	if (xtrace_enabled)
+		xtrace_int();
+	z80_int(&spec->mach->cpu);
 
-	if (gpu_is_on())
-		z80_g_int();
+	if (gpu_is_on(spec->mach))
+		z80_g_int(spec->mach);
 }
 
 /** Initialize Spec256 video generator.
  *
  * @param spec Spec256 video generator
+ * @param mach Machine the video generator belongs to
  * @param vout Video output
  * @return Zero on success or an error code
  */
-int video_spec256_init(video_spec256_t *spec, video_out_t *vout)
+int video_spec256_init(video_spec256_t *spec, zx_machine_t *mach,
+    video_out_t *vout)
 {
+	spec->mach = mach;
 	spec->gfxpal = NULL;
 	spec->vout = vout;
+	spec->nbgs = 0;
 	spec->background = NULL;
 	spec->cur_bg = -1;
 	spec->clock = 0;
@@ -177,6 +181,19 @@ int video_spec256_init(video_spec256_t *spec, video_out_t *vout)
 	return 0;
 }
 
+/** Finalize Spec256 video generator.
+ *
+ * Free the palette and the backgrounds.
+ *
+ * @param spec Spec256 video generator
+ */
+void video_spec256_fini(video_spec256_t *spec)
+{
+	video_spec256_clear_bg(spec);
+	free(spec->gfxpal);
+	spec->gfxpal = NULL;
+}
+
 /** Initialize Spec256 video generator palette.
  *
  * @param spec Spec256 video generator
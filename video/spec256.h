@@ -34,7 +34,11 @@
 #include "../types/video/out.h"
 #include "../types/video/spec256.h"
 
-extern int video_spec256_init(video_spec256_t *, video_out_t *);
+struct zx_machine;
+
+extern int video_spec256_init(video_spec256_t *, struct zx_machine *,
+    video_out_t *);
+extern void video_spec256_fini(video_spec256_t *);
 extern int video_spec256_init_pal(video_spec256_t *);
 extern int video_spec256_load_bg(video_spec256_t *, const char *, int);
 extern void video_spec256_prev_bg(video_spec256_t *);
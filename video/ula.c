@@ -37,6 +37,7 @@
 #include "../memio.h"
 #include "../xtrace.h"
 #include "../z80.h"
+#include "../zx.h"
 #include "out.h"
 #include "ula.h"
 #include "ulaplus.h"
@@ -139,13 +140,12 @@ static void video_ula_next_field(video_ula_t *ula)
 		ula->fl_rev = !ula->fl_rev;
 	}
 
-#ifdef XTRACE
-	xtrace_int();
-#endif
-	z80_int();
+	if (xtrace_enabled)
+		xtrace_int();
+	z80_int(&ula->mach->cpu);
 
-	if (gpu_is_on())
-		z80_g_int();
+	if (gpu_is_on(ula->mach))
+		z80_g_int(ula->mach);
 }
 
 /** Crude and fast ULA display routine, called 50 times a second.
@@ -167,19 +167,19 @@ void video_ula_disp_fast(video_ula_t *ula)
 	 */
 
 	/* top + corners */
-	video_out_rect(ula->vout, 0, 0, zx_field_w - 1, zx_paper_y0 - 1, border);
+	video_out_rect(ula->vout, 0, 0, zx_field_w - 1, zx_paper_y0 - 1, ula->mach->border);
 
 	/* bottom + corners */
 	video_out_rect(ula->vout, 0, zx_paper_y1, zx_field_w - 1,
-	    zx_field_h - 1, border);
+	    zx_field_h - 1, ula->mach->border);
 
 	/* left */
 	video_out_rect(ula->vout, 0, zx_paper_y0, zx_paper_x0 - 1,
-	    zx_paper_y1, border);
+	    zx_paper_y1, ula->mach->border);
 
 	/* right */
 	video_out_rect(ula->vout, zx_paper_x1, zx_paper_y0,
-	    zx_field_w - 1, zx_paper_y1, border);
+	    zx_field_w - 1, zx_paper_y1, ula->mach->border);
 
 	/*
 	 * Draw paper
@@ -187,11 +187,11 @@ void video_ula_disp_fast(video_ula_t *ula)
 
 	for (y = 0; y < 24; y++) {
 		for (x = 0; x < 32; x++) {
-			attr = zxscr[ZX_ATTR_START + y * 32 + x];
+			attr = ula->mach->scr[ZX_ATTR_START + y * 32 + x];
 			video_ula_attr_to_colors(ula, attr, &fgc, &bgc);
 
 			for (yy = 0; yy < 8; yy++) {
-				a = zxscr[ZX_PIXEL_START +
+				a = ula->mach->scr[ZX_PIXEL_START +
 				    vxswapb((y * 8 + yy) * 32 + x)];
 				for (xx = 0; xx < 8; xx++) {
 					b = (a & 0x80);
@@ -229,8 +229,8 @@ static void scr_dispscrelem(video_ula_t *ula, int x, int y)
 	col = (x - zx_paper_x0) >> 3;
 	line = y - zx_paper_y0;
 
-	attr = zxscr[ZX_ATTR_START + (line >> 3) * 32 + col];
-	pix = zxscr[ZX_PIXEL_START + vxswapb(line * 32 + col)];
+	attr = ula->mach->scr[ZX_ATTR_START + (line >> 3) * 32 + col];
+	pix = ula->mach->scr[ZX_PIXEL_START + vxswapb(line * 32 + col)];
 
 	/*
 	 * In reality attr/pix are read at different times and we can get
@@ -257,7 +257,7 @@ static void scr_dispscrelem(video_ula_t *ula, int x, int y)
  */
 static void scr_dispbrdelem(video_ula_t *ula, int x, int y)
 {
-	video_out_rect(ula->vout, x, y, x + 7, y, border);
+	video_out_rect(ula->vout, x, y, x + 7, y, ula->mach->border);
 	ula->idle_bus_byte = 0xff;
 }
 
@@ -289,12 +289,15 @@ void video_ula_disp(video_ula_t *ula)
 /** Initialize ULA video generator.
  *
  * @param ula ULA video generator
+ * @param mach Machine the ULA belongs to
  * @param clock Initial clock value
  * @param vout Video output
  * @return EOK on success or an error code
  */
-int video_ula_init(video_ula_t *ula, unsigned long clock, video_out_t *vout)
+int video_ula_init(video_ula_t *ula, zx_machine_t *mach, unsigned long clock,
+    video_out_t *vout)
 {
+	ula->mach = mach;
 	ula->vout = vout;
 
 	ula->clock = 0;
@@ -358,6 +361,23 @@ unsigned long video_ula_get_clock(video_ula_t *ula)
 	return ula->cbase + ula->clock;
 }
 
+/** Get CPU clock at which the ULA will start the next field.
+ *
+ * Catching up with the CPU up to this clock value will end the current
+ * field and raise an interrupt, catching up to any earlier value will not.
+ *
+ * @param ula ULA video generator
+ * @return CPU clock value
+ */
+unsigned long video_ula_next_event(video_ula_t *ula)
+{
+	unsigned long last;
+
+	/* Start of the last display step in this field */
+	last = ula->clock + (ULA_FIELD_TICKS - ula->clock - 1) / 4 * 4;
+	return ula->cbase + last + 1;
+}
+
 void video_ula_enable_plus(video_ula_t *ula, bool enable)
 {
 	ula->plus_enable = enable;
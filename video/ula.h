@@ -36,12 +36,16 @@
 #include "../types/video/out.h"
 #include "../types/video/ula.h"
 
-extern int video_ula_init(video_ula_t *, unsigned long, video_out_t *);
+struct zx_machine;
+
+extern int video_ula_init(video_ula_t *, struct zx_machine *, unsigned long,
+    video_out_t *);
 extern void video_ula_reset(video_ula_t *);
 extern void video_ula_disp_fast(video_ula_t *);
 extern void video_ula_disp(video_ula_t *);
 extern void video_ula_setpal(video_ula_t *);
 extern unsigned long video_ula_get_clock(video_ula_t *);
+extern unsigned long video_ula_next_event(video_ula_t *);
 extern void video_ula_enable_plus(video_ula_t *, bool);
 
 #endif
@@ -33,8 +33,10 @@
 #include <stdio.h>
 #include "xmap.h"
 #include "z80.h"
+#include "zx.h"
 
-#ifdef XMAP
+/** Mark executed addresses (and save the map to xmap.txt at exit) */
+bool xmap_enabled;
 
 static uint8_t xmap[8 * 1024];
 
@@ -46,13 +48,13 @@ void xmap_clear(void)
 		xmap[u] = 0;
 }
 
-void xmap_mark(void)
+void xmap_mark(zx_machine_t *mach)
 {
 	uint8_t mask;
 	unsigned offs;
 
-	mask = 1 << (cpus.PC & 7);
-	offs = cpus.PC >> 3;
+	mask = 1 << (mach->cpu.cpus.PC & 7);
+	offs = mach->cpu.cpus.PC >> 3;
 	xmap[offs] = xmap[offs] | mask;
 }
 
@@ -71,5 +73,3 @@ void xmap_save(void)
 	}
 	fclose(f);
 }
-
-#endif
@@ -32,8 +32,14 @@
 #ifndef XMAP_H
 #define XMAP_H
 
+#include <stdbool.h>
+
+struct zx_machine;
+
+extern bool xmap_enabled;
+
 extern void xmap_clear(void);
-extern void xmap_mark(void);
+extern void xmap_mark(struct zx_machine *);
 extern void xmap_save(void);
 
 #endif
@@ -35,29 +35,36 @@
 #include "memio.h"
 #include "xtrace.h"
 #include "z80.h"
+#include "zx.h"
 
-static void xtrace_fprintregs(FILE *f)
+/** Log every instruction executed (and interrupts) to the log file */
+bool xtrace_enabled;
+
+static void xtrace_fprintregs(zx_machine_t *mach, FILE *f)
 {
 	fprintf(f, "AF %04x BC %04x DE %04x HL %04x IX %04x PC %04x R %02d (HL)%02x Pg%02x\n",
-	    z80_getAF() & 0xffd7, z80_getBC(), z80_getDE(), z80_getHL(),
-	    cpus.IX, cpus.PC, cpus.R, zx_memget8(z80_getHL()), page_reg);
+	    z80_getAF(&mach->cpu) & 0xffd7, z80_getBC(&mach->cpu), z80_getDE(&mach->cpu), z80_getHL(&mach->cpu),
+	    mach->cpu.cpus.IX, mach->cpu.cpus.PC, mach->cpu.cpus.R, zx_memget8(mach, z80_getHL(&mach->cpu)), mach->page_reg);
 	fprintf(f, "AF'%04x BC'%04x DE'%04x HL'%04x IY %04x SP'%04x I%02d IFF%d%d IM%d\n",
-          z80_getAF_() & 0xffd7, z80_getBC_(), z80_getDE_(), z80_getHL_(), cpus.IY,
-	  cpus.SP, cpus.I, cpus.IFF1, cpus.IFF2, cpus.int_mode);
+          z80_getAF_(&mach->cpu) & 0xffd7, z80_getBC_(&mach->cpu), z80_getDE_(&mach->cpu), z80_getHL_(&mach->cpu), mach->cpu.cpus.IY,
+	  mach->cpu.cpus.SP, mach->cpu.cpus.I, mach->cpu.cpus.IFF1, mach->cpu.cpus.IFF2, mach->cpu.cpus.int_mode);
 }
 
-static void xtrace_fprintinstr(FILE *f)
+static void xtrace_fprintinstr(zx_machine_t *mach, FILE *f)
 {
-	disasm_org = cpus.PC;
-	if (disasm_instr() == 0)
-		fprintf(f, "%04x: %s\n", cpus.PC, disasm_buf);
+	disasm_org = mach->cpu.cpus.PC;
+	if (disasm_instr(mach) == 0)
+		fprintf(f, "%04x: %s\n", mach->cpu.cpus.PC, disasm_buf);
 }
 
-/** Log an instruction that is about to be executed. */
-void xtrace_instr(void)
+/** Log an instruction that is about to be executed.
+ *
+ * @param mach Machine
+ */
+void xtrace_instr(zx_machine_t *mach)
 {
-	xtrace_fprintregs(logfi);
-	xtrace_fprintinstr(logfi);
+	xtrace_fprintregs(mach, logfi);
+	xtrace_fprintinstr(mach, logfi);
 }
 
 /** Log that the emulator is resetting the machine. */
@@ -32,7 +32,13 @@
 #ifndef XTRACE_H
 #define XTRACE_H
 
-extern void xtrace_instr(void);
+#include <stdbool.h>
+
+struct zx_machine;
+
+extern bool xtrace_enabled;
+
+extern void xtrace_instr(struct zx_machine *);
 extern void xtrace_reset(void);
 extern void xtrace_int(void);
 
@@ -48,54 +48,333 @@
     - timing of undocumented instructions
 */
 
+#include <limits.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "z80.h"
 #include "z80dep.h"
 
-static int z80_readinstr(void);
-static void z80_check_nmi(void);
-static void z80_check_int(void);
+static int z80_readinstr(z80_t *z);
+static void z80_events(z80_t *z);
+static inline void z80_clock_base(z80_t *z, int tabi, uint8_t op);
 
-static uint8_t opcode;
-z80s cpus;
-/** CPU state used to read memory addresses from. Used by Spec256. */
-z80s *rcpus = &cpus;
-static uint8_t cbop;
-unsigned long z80_clock;
 
-/* debugging & statistics */
-unsigned long uoc;	/* unsupported opcode counter */
-unsigned long smc;	/* stray modifier counter */
-static uint8_t prefix1,prefix2;
+/* fast flag computation lookup tables */
+static uint8_t ox_tab[256]; /* OR,XOR and more */
+static uint8_t sz53_tab[256]; /* S,Z and undoc flags of a result */
+static uint8_t inc_tab[256]; /* INC flags (except CF) by result */
+static uint8_t dec_tab[256]; /* DEC flags (except CF) by result */
 
-static void (*const *ei_tab)(void);
+/*
+ * Half-carry and overflow of an 8-bit add/sub, indexed by bits 3 (for HC)
+ * or 7 (for PV) of the operands and of the result. See flag_idx8().
+ */
+static const uint8_t hc_add_tab[8] = { 0, fHC, fHC, fHC, 0, 0, 0, fHC };
+static const uint8_t hc_sub_tab[8] = { 0, 0, fHC, 0, fHC, 0, fHC, fHC };
+static const uint8_t ov_add_tab[8] = { 0, 0, 0, fPV, fPV, 0, 0, 0 };
+static const uint8_t ov_sub_tab[8] = { 0, fPV, 0, 0, 0, 0, fPV, 0 };
 
-#ifndef NO_Z80STAT
-static unsigned stat_tab[7][256];
-static int stat_i;
+/*
+ * Without undocumented flag emulation the undoc flags keep their
+ * previous value.
+ */
+#ifndef NO_Z80UNDOC
+#define F_KEEP_U 0
+#else
+#define F_KEEP_U fU
 #endif
 
-/* fast flag computation lookup table */
-static uint8_t ox_tab[256]; /* OR,XOR and more */
+/*
+ * Index into hc_*_tab (bits 0-2) and ov_*_tab (bits 4-6) from operands
+ * a, b and the result.
+ */
+static inline uint8_t flag_idx8(uint8_t a, uint8_t b, uint8_t res) {
+  return ((a & 0x88) >> 3) | ((b & 0x88) >> 2) | ((res & 0x88) >> 1);
+}
+
+/* 8-bit arithmetic operations whose flags can be computed later */
+enum {
+  LF_NONE,                 /* F is up to date */
+  LF_ADD,                  /* ADD, ADC */
+  LF_SUB,                  /* SUB, SBC */
+  LF_CP,
+  LF_INC,
+  LF_DEC
+};
+
+/* flags of an arithmetic operation, except those kept from before */
+static inline uint8_t arith_flags(int op, uint16_t a, uint16_t b,
+    uint16_t res) {
+  uint8_t idx;
+
+  idx=flag_idx8(a,b,res);
+  switch(op) {
+    case LF_ADD:
+      return sz53_tab[res&0xff] | hc_add_tab[idx&7] | ov_add_tab[idx>>4] |
+        (res>0xff ? fC : 0);
+    case LF_SUB:
+      return sz53_tab[res&0xff] | hc_sub_tab[idx&7] | ov_sub_tab[idx>>4] |
+        fN | (res>0xff ? fC : 0);
+    case LF_CP:
+      /* undoc flags come from the operand, not from the result! */
+      return (sz53_tab[res&0xff]&(fS|fZ)) | hc_sub_tab[idx&7] |
+        ov_sub_tab[idx>>4] | fN | (res>0xff ? fC : 0) | (b & fU & ~F_KEEP_U);
+    case LF_INC:
+      return inc_tab[res&0xff];
+    case LF_DEC:
+      return dec_tab[res&0xff];
+  }
+  return 0;
+}
+
+#ifdef Z80_LAZY
+
+/*
+ * Lazy flags: arithmetic operations only record the operation, operands
+ * and result, F is computed when something reads it. Likewise increments
+ * of R are only counted. The core brings F and R up to date before
+ * returning from z80_execinstr() or z80_run_until().
+ */
+
+static void lf_eval(z80_t *z) {
+  z->cpus.F = z->lf_f | arith_flags(z->lf_op, z->lf_a, z->lf_b, z->lf_res);
+  z->lf_op = LF_NONE;
+}
+
+static inline uint8_t getF(z80_t *z) {
+  if(z->lf_op != LF_NONE) lf_eval(z);
+  return z->cpus.F;
+}
+
+static inline void setF(z80_t *z, uint8_t f) {
+  z->cpus.F = f;
+  z->lf_op = LF_NONE;
+}
+
+/* flags become those of op, except bits keep which are already known */
+static inline void defer_flags(z80_t *z, int op, uint8_t keep, uint16_t a,
+    uint16_t b, uint16_t res) {
+  z->lf_op = op;
+  z->lf_f = keep;
+  z->lf_a = a;
+  z->lf_b = b;
+  z->lf_res = res;
+}
+
+/*
+ * Conditions can mostly be tested without computing all of F.
+ * INC and DEC keep CF, all operations have S and Z from the result.
+ */
+static inline int flag_c(z80_t *z) {
+  if(z->lf_op == LF_NONE) return z->cpus.F & fC;
+  if(z->lf_op >= LF_INC) return z->lf_f & fC;
+  return z->lf_res > 0xff;
+}
+
+static inline int flag_z(z80_t *z) {
+  if(z->lf_op == LF_NONE) return z->cpus.F & fZ;
+  return (z->lf_res & 0xff) == 0;
+}
+
+static inline int flag_s(z80_t *z) {
+  if(z->lf_op == LF_NONE) return z->cpus.F & fS;
+  return z->lf_res & 0x80;
+}
+
+static inline uint8_t getR(z80_t *z) {
+  z->cpus.R = (z->cpus.R & 0x80) | ((z->cpus.R + z->r_inc) & 0x7f);
+  z->r_inc = 0;
+  return z->cpus.R;
+}
+
+static inline void setR(z80_t *z, uint8_t r) {
+  z->cpus.R = r;
+  z->r_inc = 0;
+}
+
+static void incr_R(z80_t *z, uint8_t amount) {
+  z->r_inc += amount;
+}
+
+/* bring lazily evaluated registers up to date */
+static void lazy_sync(z80_t *z) {
+  (void)getF(z);
+  (void)getR(z);
+}
+
+#else
+
+static inline uint8_t getF(z80_t *z) {
+  return z->cpus.F;
+}
+
+static inline void setF(z80_t *z, uint8_t f) {
+  z->cpus.F = f;
+}
+
+static inline void defer_flags(z80_t *z, int op, uint8_t keep, uint16_t a,
+    uint16_t b, uint16_t res) {
+  z->cpus.F = keep | arith_flags(op, a, b, res);
+}
+
+static inline int flag_c(z80_t *z) {
+  return z->cpus.F & fC;
+}
+
+static inline int flag_z(z80_t *z) {
+  return z->cpus.F & fZ;
+}
+
+static inline int flag_s(z80_t *z) {
+  return z->cpus.F & fS;
+}
+
+static inline uint8_t getR(z80_t *z) {
+  return z->cpus.R;
+}
+
+static inline void setR(z80_t *z, uint8_t r) {
+  z->cpus.R = r;
+}
+
+static void incr_R(z80_t *z, uint8_t amount) {
+  z->cpus.R = (z->cpus.R & 0x80) | ((z->cpus.R+amount)&0x7f);
+}
+
+static inline void lazy_sync(z80_t *z) {
+  (void)z;
+}
 
-static uint16_t z80_memget16(uint16_t addr) {
-  return (uint16_t)z80_memget8(addr)+(((uint16_t)z80_memget8(addr+1))<<8);
+#endif
+
+static inline int flag_pv(z80_t *z) {
+  return getF(z) & fPV;
+}
+
+/* flags that operations which do not emulate them leave unchanged */
+static inline uint8_t keep_undoc(z80_t *z) {
+  return F_KEEP_U ? (getF(z) & F_KEEP_U) : 0;
+}
+
+/* memory and I/O access through the context callbacks */
+
+#ifdef Z80_JIT
+static void jit_init_info(void);
+static void jit_inval(z80_t *z, uint16_t addr);
+static void jit_inval_bank(z80_t *z, int w);
+#endif
+
+#ifndef NO_Z80ICACHE
+/* drop decoded instructions that may contain the byte at addr */
+static inline void icache_inval(z80_t *z, uint16_t addr) {
+  z->icache[addr].gen=0;
+  z->icache[(uint16_t)(addr-1)].gen=0;
+  z->icache[(uint16_t)(addr-2)].gen=0;
+}
+#endif
+
+/*
+ * Data access. With page tables in z->dep this is a load from or store to
+ * the host memory of the page, the callbacks are left for pages that need
+ * them (and contexts that do not have tables at all).
+ */
+static inline uint8_t z80_memget8(z80_t *z, uint16_t addr) {
+#ifndef NO_Z80PAGEMAP
+  if(z->dep->rpage!=NULL)
+    return z->dep->rpage[addr >> Z80_PAGE_SHIFT][addr & Z80_PAGE_MASK];
+#endif
+  return z->dep->memget8(z->dep_arg, addr);
+}
+
+#ifndef NO_Z80IWIN
+/* find out where the window containing addr is in host memory, fetch */
+static uint8_t iwin_fill(z80_t *z, uint16_t addr) {
+  int w=addr>>14;
+
+  z->iwin[w]=z->dep->imemptr!=NULL ? z->dep->imemptr(z->dep_arg, addr) : NULL;
+  z->iwin_known|=1 << w;
+  if(z->iwin[w]!=NULL) return z->iwin[w][addr & 0x3fff];
+  return z->dep->imemget8(z->dep_arg, addr);
+}
+
+/* forget all windows, e.g. because z->dep has changed */
+static void iwin_reset(z80_t *z) {
+  memset(z->iwin, 0, sizeof(z->iwin));
+  z->iwin_known=0;
+}
+#endif
+
+/*
+ * Instruction fetch. Unless the memory of the window cannot be accessed
+ * directly, this is just a load from the host memory of the bank.
+ */
+static inline uint8_t z80_imemget8(z80_t *z, uint16_t addr) {
+#ifndef NO_Z80IWIN
+  const uint8_t *p=z->iwin[addr>>14];
+
+  if(p!=NULL) return p[addr & 0x3fff];
+  if(!(z->iwin_known & (1 << (addr>>14)))) return iwin_fill(z, addr);
+#endif
+  return z->dep->imemget8(z->dep_arg, addr);
+}
+
+static inline void z80_memset8(z80_t *z, uint16_t addr, uint8_t val) {
+#ifndef NO_Z80PAGEMAP
+  uint8_t *p=z->dep->wpage!=NULL ? z->dep->wpage[addr >> Z80_PAGE_SHIFT] : NULL;
+
+  if(p!=NULL) p[addr & Z80_PAGE_MASK]=val;
+  else
+#endif
+  z->dep->memset8(z->dep_arg, addr, val);
+#ifndef NO_Z80ICACHE
+  icache_inval(z, addr);
+#endif
+#ifdef Z80_JIT
+  if(z->jit!=NULL) jit_inval(z, addr);
+#endif
+#ifndef NO_Z80IDLE
+  z->idle_dirty=1;
+#endif
+}
+
+static void z80_out8(z80_t *z, uint16_t addr, uint8_t val) {
+  z->dep->out8(z->dep_arg, addr, val);
+#ifndef NO_Z80IDLE
+  z->idle_dirty=1;
+#endif
+}
+
+static uint8_t z80_in8(z80_t *z, uint16_t addr) {
+#ifndef NO_Z80IDLE
+  if(z->dep->in8_stable==NULL || !z->dep->in8_stable(z->dep_arg, addr))
+    z->idle_dirty=1;
+#endif
+  return z->dep->in8(z->dep_arg, addr);
 }
 
-static uint16_t z80_imemget16(uint16_t addr) {
-  return (uint16_t)z80_imemget8(addr)+(((uint16_t)z80_imemget8(addr+1))<<8);
+static uint8_t z80_snoop8(z80_t *z) {
+  return z->dep->snoop8(z->dep_arg);
 }
 
-static void z80_memset16(uint16_t addr, uint16_t val) {
-  z80_memset8(addr, val & 0xff);
-  z80_memset8(addr+1, val >> 8);
+static uint16_t z80_memget16(z80_t *z, uint16_t addr) {
+  return (uint16_t)z80_memget8(z, addr)+(((uint16_t)z80_memget8(z, addr+1))<<8);
 }
 
-static inline void z80_clock_inc(uint8_t inc)
+static uint16_t z80_imemget16(z80_t *z, uint16_t addr) {
+  return (uint16_t)z80_imemget8(z, addr)+(((uint16_t)z80_imemget8(z, addr+1))<<8);
+}
+
+static void z80_memset16(z80_t *z, uint16_t addr, uint16_t val) {
+  z80_memset8(z, addr, val & 0xff);
+  z80_memset8(z, addr+1, val >> 8);
+}
+
+static inline void z80_clock_inc(z80_t *z, uint8_t inc)
 {
 #ifndef NO_Z80CLOCK
-	z80_clock += inc;
+	z->clock += inc;
 #endif
 }
 
@@ -116,30 +395,6 @@ static int u16sval(uint16_t u) {
 /*  these functions return 1 when sign overflow occurs */
 /*  (the result would be >127 or <-128) */
 
-static int add_v8(uint8_t a, uint8_t b) {
-  int sign_r;
-  sign_r=u8sval(a)+u8sval(b);
-  return sign_r<-128 || sign_r>127;
-}
-
-static int sub_v8(uint8_t a, uint8_t b) {
-  int sign_r;
-  sign_r=u8sval(a)-u8sval(b);
-  return sign_r<-128 || sign_r>127;
-}
-
-static int adc_v8(uint8_t a, uint8_t b, uint8_t c) {
-  int sign_r;
-  sign_r=u8sval(a)+u8sval(b)+u8sval(c);
-  return sign_r<-128 || sign_r>127;
-}
-
-static int sbc_v8(uint8_t a, uint8_t b, uint8_t c) {
-  int sign_r;
-  sign_r=u8sval(a)-u8sval(b)-c;
-  return sign_r<-128 || sign_r>127;
-}
-
 static int adc_v16(uint16_t a, uint16_t b, uint16_t c) {
   int sign_r;
   sign_r=u16sval(a)+u16sval(b)+u16sval(c);
@@ -162,237 +417,255 @@ static int oddp8(uint8_t x) {
   return x&1;
 }
 
-static void setflags(int s, int z, int hc, int pv, int n, int c) {
-  if(s>=0) cpus.F = (cpus.F & (fS^0xff)) | (s?fS:0);
-  if(z>=0) cpus.F = (cpus.F & (fZ^0xff)) | (z?fZ:0);
-  if(hc>=0) cpus.F = (cpus.F & (fHC^0xff)) | (hc?fHC:0);
-  if(pv>=0) cpus.F = (cpus.F & (fPV^0xff)) | (pv?fPV:0);
-  if(n>=0) cpus.F = (cpus.F & (fN^0xff)) | (n?fN:0);
-  if(c>=0) cpus.F = (cpus.F & (fC^0xff)) | (c?fC:0);
+static void setflags(z80_t *z, int s, int zf, int hc, int pv, int n, int c) {
+  uint8_t f;
+
+  f=getF(z);
+  if(s>=0) f = (f & (fS^0xff)) | (s?fS:0);
+  if(zf>=0) f = (f & (fZ^0xff)) | (zf?fZ:0);
+  if(hc>=0) f = (f & (fHC^0xff)) | (hc?fHC:0);
+  if(pv>=0) f = (f & (fPV^0xff)) | (pv?fPV:0);
+  if(n>=0) f = (f & (fN^0xff)) | (n?fN:0);
+  if(c>=0) f = (f & (fC^0xff)) | (c?fC:0);
+  setF(z, f);
 }
 
 #ifndef NO_Z80UNDOC
 
-static void setundocflags8(uint8_t res) {
-  cpus.F &= fD;		/* leave only documented flags */
-  cpus.F |= (res & fU);     /* set undocumented flags */
+static void setundocflags8(z80_t *z, uint8_t res) {
+  /* leave only documented flags, set undocumented flags */
+  setF(z, (getF(z) & fD) | (res & fU));
 }
 
 #else
 
-#define setundocflags8(res) ((void)(res))
+#define setundocflags8(z, res) ((void)(res))
 
-static void ei_undoc(void)
+static void ei_undoc(z80_t *z)
 {
-	z80_clock_inc(4);
+	/* does nothing, but takes the time of the instruction it replaces */
 }
 
 #endif
 
-static void incr_R(uint8_t amount) {
-  cpus.R = (cpus.R & 0x80) | ((cpus.R+amount)&0x7f);
+/*
+ * ev_clock while nothing is pending. (If the clock gets this far, the event
+ * check just finds nothing to do once and pushes ev_clock ahead again.)
+ */
+#define EV_NEVER (ULONG_MAX >> 1)
+
+/*
+ * Is an event (INT or NMI) due? Raising one makes it due at once and it
+ * stays due until nothing is pending any more, so this is the only
+ * check needed between instructions.
+ */
+static inline int ev_due(z80_t *z) {
+  return (long)(z->clock - z->ev_clock) >= 0;
+}
+
+/* is there a breakpoint at PC? */
+static inline int brk_hit(z80_t *z) {
+  return (z->brk[z->cpus.PC >> 3] >> (z->cpus.PC & 7)) & 1;
 }
 
 /**************************** address register access *******************/
 
 /*
  * In GPU case we need to take addresses from the CPU registers as a special
- * case. If GPU is not enabled, rcpus just points to the CPU state.
+ * case. If GPU is not enabled, z->rcpus just points to the CPU state.
  */
 
-static uint16_t get_addrBC(void)
+static uint16_t get_addrBC(z80_t *z)
 {
-  return ((uint16_t)rcpus->r[rB] << 8) | rcpus->r[rC];
+  return z->rcpus->rp[rBC];
 }
 
-static uint16_t get_addrDE(void)
+static uint16_t get_addrDE(z80_t *z)
 {
-  return ((uint16_t)rcpus->r[rD] << 8) | rcpus->r[rE];
+  return z->rcpus->rp[rDE];
 }
 
-static uint16_t get_addrHL(void)
+static uint16_t get_addrHL(z80_t *z)
 {
-  return ((uint16_t)rcpus->r[rH] << 8) | rcpus->r[rL];
+  return z->rcpus->rp[rHL];
 }
 
-static uint16_t get_addrIX(void)
+static uint16_t get_addrIX(z80_t *z)
 {
-  return rcpus->IX;
+  return z->rcpus->IX;
 }
 
-static uint16_t get_addrIY(void)
+static uint16_t get_addrIY(z80_t *z)
 {
-  return rcpus->IY;
+  return z->rcpus->IY;
 }
 
 /**************************** operand access ***************************/
 
 /* returns (HL)(8) */
-static uint8_t _iHL8(void) {
-  return z80_memget8(get_addrHL());
+static uint8_t _iHL8(z80_t *z) {
+  return z80_memget8(z, get_addrHL(z));
 }
 
 /* returns (BC) */
-static uint8_t _iBC8(void) {
-  return z80_memget8(get_addrBC());
+static uint8_t _iBC8(z80_t *z) {
+  return z80_memget8(z, get_addrBC(z));
 }
 
 /* returns (DE) */
-static uint8_t _iDE8(void) {
-  return z80_memget8(get_addrDE());
+static uint8_t _iDE8(z80_t *z) {
+  return z80_memget8(z, get_addrDE(z));
 }
 
 /* returns (IX+N) */
-static uint8_t _iIXN8(uint16_t N) {
-  return z80_memget8(get_addrIX()+u8sval(N));
+static uint8_t _iIXN8(z80_t *z, uint16_t N) {
+  return z80_memget8(z, get_addrIX(z)+u8sval(N));
 }
 
 /* returns (IY+N) */
-static uint8_t _iIYN8(uint16_t N) {
-  return z80_memget8(get_addrIY()+u8sval(N));
+static uint8_t _iIYN8(z80_t *z, uint16_t N) {
+  return z80_memget8(z, get_addrIY(z)+u8sval(N));
 }
 
 /* (IX+N) <- val*/
-static void s_iIXN8(uint16_t N, uint8_t val) {
-  z80_memset8(get_addrIX()+u8sval(N),val);
+static void s_iIXN8(z80_t *z, uint16_t N, uint8_t val) {
+  z80_memset8(z, get_addrIX(z)+u8sval(N),val);
 }
 
 /* (IY+N) <- val*/
-static void s_iIYN8(uint16_t N, uint8_t val) {
-  z80_memset8(get_addrIY()+u8sval(N),val);
+static void s_iIYN8(z80_t *z, uint16_t N, uint8_t val) {
+  z80_memset8(z, get_addrIY(z)+u8sval(N),val);
 }
 
 
 /* (HL) <- val */
-static void s_iHL8(uint8_t val) {
-  z80_memset8(get_addrHL(),val);
+static void s_iHL8(z80_t *z, uint8_t val) {
+  z80_memset8(z, get_addrHL(z),val);
 }
 
 /* (BC) <- val */
-static void s_iBC8(uint8_t val) {
-  z80_memset8(get_addrBC(),val);
+static void s_iBC8(z80_t *z, uint8_t val) {
+  z80_memset8(z, get_addrBC(z),val);
 }
 
 /* (DE) <- val */
-static void s_iDE8(uint8_t val) {
-  z80_memset8(get_addrDE(),val);
+static void s_iDE8(z80_t *z, uint8_t val) {
+  z80_memset8(z, get_addrDE(z),val);
 }
 
 /* returns (SP)(16-bits) */
-static uint16_t _iSP16(void) {
-  return z80_memget16(cpus.SP);
+static uint16_t _iSP16(z80_t *z) {
+  return z80_memget16(z, z->cpus.SP);
 }
 
 /* (SP)(16-bits) <- val */
-static void s_iSP16(uint16_t val) {
-  z80_memset16(cpus.SP,val);
+static void s_iSP16(z80_t *z, uint16_t val) {
+  z80_memset16(z, z->cpus.SP,val);
 }
 
-static uint16_t getAF(void) {
-  return ((uint16_t)cpus.r[rA] << 8)|(uint16_t)cpus.F;
+static uint16_t getAF(z80_t *z) {
+  (void)getF(z);
+  return z->cpus.rp[rAF];
 }
 
-static uint16_t getBC(void) {
-  return ((uint16_t)cpus.r[rB] << 8)|(uint16_t)cpus.r[rC];
+static uint16_t getBC(z80_t *z) {
+  return z->cpus.rp[rBC];
 }
 
-static uint16_t getDE(void) {
-  return ((uint16_t)cpus.r[rD] << 8)|(uint16_t)cpus.r[rE];
+static uint16_t getDE(z80_t *z) {
+  return z->cpus.rp[rDE];
 }
 
-static uint16_t getHL(void) {
-  return ((uint16_t)cpus.r[rH] << 8)|(uint16_t)cpus.r[rL];
+static uint16_t getHL(z80_t *z) {
+  return z->cpus.rp[rHL];
 }
 
-static uint16_t getAF_(void) {
-  return ((uint16_t)cpus.r_[rA] << 8)|(uint16_t)cpus.F_;
+static uint16_t getAF_(z80_t *z) {
+  return z->cpus.rp_[rAF];
 }
 
-static uint16_t getBC_(void) {
-  return ((uint16_t)cpus.r_[rB] << 8)|(uint16_t)cpus.r_[rC];
+static uint16_t getBC_(z80_t *z) {
+  return z->cpus.rp_[rBC];
 }
 
-static uint16_t getDE_(void) {
-  return ((uint16_t)cpus.r_[rD] << 8)|(uint16_t)cpus.r_[rE];
+static uint16_t getDE_(z80_t *z) {
+  return z->cpus.rp_[rDE];
 }
 
-static uint16_t getHL_(void) {
-  return ((uint16_t)cpus.r_[rH] << 8)|(uint16_t)cpus.r_[rL];
+static uint16_t getHL_(z80_t *z) {
+  return z->cpus.rp_[rHL];
 }
 
-static void setAF(uint16_t val) {
-  cpus.r[rA]=val>>8;
-  cpus.F=val & 0xff;
+static void setAF(z80_t *z, uint16_t val) {
+  setF(z, val & 0xff);
+  z->cpus.rp[rAF]=val;
 }
 
-static void setBC(uint16_t val) {
-  cpus.r[rB]=val>>8;
-  cpus.r[rC]=val & 0xff;
+static void setBC(z80_t *z, uint16_t val) {
+  z->cpus.rp[rBC]=val;
 }
 
-static void setDE(uint16_t val) {
-  cpus.r[rD]=val>>8;
-  cpus.r[rE]=val & 0xff;
+static void setDE(z80_t *z, uint16_t val) {
+  z->cpus.rp[rDE]=val;
 }
 
-static void setHL(uint16_t val) {
-  cpus.r[rH]=val>>8;
-  cpus.r[rL]=val & 0xff;
+static void setHL(z80_t *z, uint16_t val) {
+  z->cpus.rp[rHL]=val;
 }
 
-uint16_t z80_getAF(void)
+uint16_t z80_getAF(z80_t *z)
 {
-	return getAF();
+	return getAF(z);
 }
 
-uint16_t z80_getBC(void)
+uint16_t z80_getBC(z80_t *z)
 {
-	return getBC();
+	return getBC(z);
 }
 
-uint16_t z80_getDE(void)
+uint16_t z80_getDE(z80_t *z)
 {
-	return getDE();
+	return getDE(z);
 }
 
-uint16_t z80_getHL(void)
+uint16_t z80_getHL(z80_t *z)
 {
-	return getHL();
+	return getHL(z);
 }
 
-uint16_t z80_getAF_(void)
+uint16_t z80_getAF_(z80_t *z)
 {
-	return getAF_();
+	return getAF_(z);
 }
 
-uint16_t z80_getBC_(void)
+uint16_t z80_getBC_(z80_t *z)
 {
-	return getBC_();
+	return getBC_(z);
 }
 
-uint16_t z80_getDE_(void)
+uint16_t z80_getDE_(z80_t *z)
 {
-	return getDE_();
+	return getDE_(z);
 }
 
-uint16_t z80_getHL_(void)
+uint16_t z80_getHL_(z80_t *z)
 {
-	return getHL_();
+	return getHL_(z);
 }
 
-static uint8_t z80_iget8(void) {
+static uint8_t z80_iget8(z80_t *z) {
   uint8_t tmp;
 
-  tmp=z80_imemget8(cpus.PC);
-  cpus.PC++;
+  tmp=z80_imemget8(z, z->cpus.PC);
+  z->cpus.PC++;
   return tmp;
 }
 
-static uint16_t z80_iget16(void) {
+static uint16_t z80_iget16(z80_t *z) {
   uint16_t tmp;
 
-  tmp=z80_imemget16(cpus.PC);
-  cpus.PC+=2;
+  tmp=z80_imemget16(z, z->cpus.PC);
+  z->cpus.PC+=2;
   return tmp;
 }
 
@@ -400,42 +673,42 @@ static uint16_t z80_iget16(void) {
 
 #ifndef NO_Z80UNDOC
 
-static void setIXh(uint8_t val) {
-  cpus.IX = (cpus.IX & 0x00ff) | ((uint16_t)val<<8);
+static void setIXh(z80_t *z, uint8_t val) {
+  z->cpus.IX = (z->cpus.IX & 0x00ff) | ((uint16_t)val<<8);
 }
 
-static void setIYh(uint8_t val) {
-  cpus.IY = (cpus.IY & 0x00ff) | ((uint16_t)val<<8);
+static void setIYh(z80_t *z, uint8_t val) {
+  z->cpus.IY = (z->cpus.IY & 0x00ff) | ((uint16_t)val<<8);
 }
 
-static void setIXl(uint8_t val) {
-  cpus.IX = (cpus.IX & 0xff00) | (uint16_t)val;
+static void setIXl(z80_t *z, uint8_t val) {
+  z->cpus.IX = (z->cpus.IX & 0xff00) | (uint16_t)val;
 }
 
-static void setIYl(uint8_t val) {
-  cpus.IY = (cpus.IY & 0xff00) | (uint16_t)val;
+static void setIYl(z80_t *z, uint8_t val) {
+  z->cpus.IY = (z->cpus.IY & 0xff00) | (uint16_t)val;
 }
 
-static uint8_t getIXh(void) {
-  return cpus.IX>>8;
+static uint8_t getIXh(z80_t *z) {
+  return z->cpus.IX>>8;
 }
 
-static uint8_t getIYh(void) {
-  return cpus.IY>>8;
+static uint8_t getIYh(z80_t *z) {
+  return z->cpus.IY>>8;
 }
 
-static uint8_t getIXl(void) {
-  return cpus.IX&0xff;
+static uint8_t getIXl(z80_t *z) {
+  return z->cpus.IX&0xff;
 }
 
-static uint8_t getIYl(void) {
-  return cpus.IY&0xff;
+static uint8_t getIYl(z80_t *z) {
+  return z->cpus.IY&0xff;
 }
 
 #endif
 
 /************************************************************************/
-static void _push16(uint16_t val);
+static void _push16(z80_t *z, uint16_t val);
 /************************************************************************/
 
 
@@ -447,95 +720,99 @@ void z80_init_tables(void) {
     if(oddp8(u)) ox_tab[u] |= fPV;
   }
   ox_tab[0] |= fZ;
+
+#ifdef Z80_JIT
+  jit_init_info();
+#endif
+
+  for(u=0;u<256;u++) {
+    sz53_tab[u] = ox_tab[u] & ~fPV & ~F_KEEP_U;
+
+    inc_tab[u] = sz53_tab[u];
+    if((u&0x0f)==0x00) inc_tab[u] |= fHC;
+    if(u==0x80) inc_tab[u] |= fPV;
+
+    dec_tab[u] = sz53_tab[u] | fN;
+    if((u&0x0f)==0x0f) dec_tab[u] |= fHC;
+    if(u==0x7f) dec_tab[u] |= fPV;
+  }
 }
 
 /************************ operations ************************************/
 
-static uint8_t _adc8(uint16_t a, uint16_t b) {
+static uint8_t _adc8(z80_t *z, uint16_t a, uint16_t b) {
   uint16_t res;
   uint16_t c;
   
-  c=(cpus.F&fC)?1:0;
+  c=flag_c(z)?1:0;
 
   res=a+b+c;
-  setflags((res>>7)&1,
-	   (res&0xff)==0,
-	   (a&0x0f)+(b&0x0f)+c > 0x0f,
-	   adc_v8(a,b,c),
-	   0,
-	   res>0xff);
-  setundocflags8(res);
+  defer_flags(z, LF_ADD, keep_undoc(z), a, b, res);
   return res & 0xff;
 }
 
-static uint16_t _adc16(uint16_t a, uint16_t b) {
+static uint16_t _adc16(z80_t *z, uint16_t a, uint16_t b) {
   uint16_t res0,res1,a1,b1,c,c1;
   
-  c=((cpus.F&fC)?1:0);
+  c=flag_c(z)?1:0;
 
   res0=(a&0xff)+(b&0xff)+ c;
   a1=a>>8; b1=b>>8; c1=((res0>0xff)?1:0);
   res1=a1+b1+c1;
-  setflags(res1&0x80,
+  setflags(z, res1&0x80,
 	   !((res0&0xff)|(res1&0xff)),
 	   (a1&0x0f) + (b1&0x0f)>0x0f,
 	   adc_v16(a,b,c),
 	   0,
 	   res1>0xff);
-  setundocflags8(res1);
+  setundocflags8(z, res1);
   return (res0&0xff)|((res1&0xff)<<8);
 }
 
 /************************************************************************/
 
-static uint8_t _add8(uint16_t a, uint16_t b) {
+static uint8_t _add8(z80_t *z, uint16_t a, uint16_t b) {
   uint16_t res;
 
   res=a+b;
-  setflags((res>>7)&1,
-	   (res&0xff)==0,
-	   (a&0x0f)+(b&0x0f) > 0x0f,
-	   add_v8(a,b),
-	   0,
-	   res>0xff);
-  setundocflags8(res);
+  defer_flags(z, LF_ADD, keep_undoc(z), a, b, res);
   return res & 0xff;
 }
 
-static uint16_t _add16(uint16_t a, uint16_t b) {
+static uint16_t _add16(z80_t *z, uint16_t a, uint16_t b) {
   uint16_t res0,res1,a1,b1;
 
   res0=(a&0xff)+(b&0xff);
   a1=a>>8; b1=b>>8;
   res1=a1+b1+((res0>0xff)?1:0);
-  setflags(-1,
+  setflags(z, -1,
 	   -1,
 	   (a1&0x0f) + (b1&0x0f)>0x0f,
 	   -1,
 	   0,
 	   res1>0xff);
-  setundocflags8(res1);
+  setundocflags8(z, res1);
   return (res0&0xff)|((res1&0xff)<<8);
 }
 
 /************************************************************************/
 
-static uint8_t _and8(uint8_t a, uint8_t b) {
+static uint8_t _and8(z80_t *z, uint8_t a, uint8_t b) {
   uint8_t res;
 
   res=a&b;
-  cpus.F=ox_tab[res]|fHC;
+  setF(z, ox_tab[res]|fHC);
   return res;
 }
 
 /************************************************************************/
 
-static uint8_t _bit8(uint8_t a, uint8_t b) {
+static uint8_t _bit8(z80_t *z, uint8_t a, uint8_t b) {
   uint8_t res;
 
   res=b & (1<<a);
-  cpus.F=(cpus.F&fC)|ox_tab[res]; /* CF does not change */
-/*  setflags(res&0x80,
+  setF(z, (flag_c(z)?fC:0)|ox_tab[res]); /* CF does not change */
+/*  setflags(z, res&0x80,
 	   res==0,
 	   1,
 	   res==0, 
@@ -548,119 +825,96 @@ static uint8_t _bit8(uint8_t a, uint8_t b) {
 
 /************************************************************************/
 
-static void _call16(uint16_t addr) {
-  _push16(cpus.PC);
-  cpus.PC=addr;
+static void _call16(z80_t *z, uint16_t addr) {
+  _push16(z, z->cpus.PC);
+  z->cpus.PC=addr;
 }
 
 /************************************************************************/
 
-static uint8_t _cp8(uint16_t a, uint16_t b) {
+static uint8_t _cp8(z80_t *z, uint16_t a, uint16_t b) {
   uint16_t res;
 
   res=a-b;
-  setflags((res>>7)&1,
-	   (res&0xff)==0,
-	   (a&0x0f)-(b&0x0f) < 0, /* I hope */
-	   sub_v8(a,b),
-	   1,
-	   res>0xff);
-  setundocflags8(b); /* not from the result! */
+  defer_flags(z, LF_CP, keep_undoc(z), a, b, res);
   return res & 0xff;
 }
 
 /************************************************************************/
 
-static uint8_t _dec8(uint16_t a) {
+static uint8_t _dec8(z80_t *z, uint16_t a) {
   uint16_t res;
 
   res=(a-1)&0xff;
-  setflags(res>>7,
-	   res==0,
-	   (a&0x0f)-1<0, /* I hope */
-	   sub_v8(a,1),
-	   1,    /* !spemu */
-	   -1);
-  setundocflags8(res);
+  defer_flags(z, LF_DEC, (flag_c(z)?fC:0) | keep_undoc(z), 0, 0, res);
   return res;
 }
 
 /************************************************************************/
 
-static uint8_t _in8pf(uint16_t a) {
-  return z80_in8(a);		/* query ZX */
+static uint8_t _in8pf(z80_t *z, uint16_t a) {
+  return z80_in8(z, a);		/* query ZX */
 }
 
-static uint8_t _in8(uint16_t a) {
+static uint8_t _in8(z80_t *z, uint16_t a) {
   uint16_t res;
 
-  res=_in8pf(a)&0xff;
-  setflags(res>>7,
-	   res==0,
-	   0,
-	   oddp8(res),
-	   0,
-	   -1);
+  res=_in8pf(z, a)&0xff;
+  setF(z, (getF(z)&(fC|fU)) | (ox_tab[res]&~fU));
   return res;
 }
 
 /************************************************************************/
 
-static uint8_t _inc8(uint16_t a) {
+static uint8_t _inc8(z80_t *z, uint16_t a) {
   uint16_t res;
 
   res=(a+1)&0xff;
-  setflags(res>>7,
-	   res==0,
-	   (a&0x0f)+1>0x0f,
-	   add_v8(a,1),
-	   0,		/* !spemu */
-	   -1);
-  setundocflags8(res);
+  defer_flags(z, LF_INC, (flag_c(z)?fC:0) | keep_undoc(z), 0, 0, res);
   return res;
 }
 
 /************************************************************************/
 
 
-static void _jp16(uint16_t addr) {
-  cpus.PC=addr;
+static void _jp16(z80_t *z, uint16_t addr) {
+  z->cpus.PC=addr;
 }
 
 /************************************************************************/
 
-static void _jr8(uint8_t ofs) {
-  cpus.PC+=u8sval(ofs);
+static void _jr8(z80_t *z, uint8_t ofs) {
+  z->cpus.PC+=u8sval(ofs);
 }
 
 /************************************************************************/
 
-static uint8_t _or8(uint8_t a, uint8_t b) {
+static uint8_t _or8(z80_t *z, uint8_t a, uint8_t b) {
   uint8_t res;
 
   res=a|b;
-  cpus.F=ox_tab[res];
+  setF(z, ox_tab[res]);
   return res;
 }
 
 /************************************************************************/
 
-static void _out8(uint16_t addr, uint8_t val) {
-  z80_out8(addr,val);			/* pass it to ZX */
+static void _out8(z80_t *z, uint16_t addr, uint8_t val) {
+  z80_out8(z, addr,val);			/* pass it to ZX */
 }
 
 /************************************************************************/
 
-static void _push16(uint16_t val) {
-  cpus.SP-=2;
-  z80_memset16(cpus.SP,val);
+static void _push16(z80_t *z, uint16_t val) {
+  z->cpus.SP-=2;
+  z80_memset16(z, z->cpus.SP,val);
 }
 
-static uint16_t _pop16(void) {
+static uint16_t _pop16(z80_t *z) {
   uint16_t res;
 
-  res=z80_memget16(cpus.SP);
-  cpus.SP+=2;
+  res=z80_memget16(z, z->cpus.SP);
+  z->cpus.SP+=2;
   return res;
 }
 
@@ -675,79 +929,79 @@ static uint8_t _res8(uint16_t a, uint16_t b) {
 
 /************************************************************************/
 
-static uint8_t _rla8(uint8_t a) {
+static uint8_t _rla8(z80_t *z, uint8_t a) {
   uint8_t nC,oC;
 
   nC=a>>7;
-  oC=(cpus.F & fC)?1:0;
+  oC=flag_c(z)?1:0;
   a=(a<<1)|oC;
-  cpus.F = (cpus.F & ~(fU1|fHC|fU2|fN|fC)) | (a&(fU1|fU2)) | nC;
+  setF(z, (getF(z) & ~(fU1|fHC|fU2|fN|fC)) | (a&(fU1|fU2)) | nC);
   return a;
 }
 
-static uint8_t _rl8(uint8_t a) {
+static uint8_t _rl8(z80_t *z, uint8_t a) {
   uint8_t nC,oC;
 
   nC=a>>7;
-  oC=(cpus.F & fC)?1:0;
+  oC=flag_c(z)?1:0;
   a=(a<<1)|oC;
-  cpus.F=ox_tab[a]|nC;
+  setF(z, ox_tab[a]|nC);
   return a;
 }
 
-static uint8_t _rlca8(uint8_t a) {
+static uint8_t _rlca8(z80_t *z, uint8_t a) {
   uint8_t tmp;
 
   tmp=a>>7;
   a=(a<<1)|tmp;
-  cpus.F = (cpus.F & ~(fU1|fHC|fU2|fN|fC)) | (a&(fU1|fU2)) | tmp;
+  setF(z, (getF(z) & ~(fU1|fHC|fU2|fN|fC)) | (a&(fU1|fU2)) | tmp);
   return a;
 }
 
-static uint8_t _rlc8(uint8_t a) {
+static uint8_t _rlc8(z80_t *z, uint8_t a) {
   uint8_t tmp;
 
   tmp=a>>7;
   a=(a<<1)|tmp;
-  cpus.F=ox_tab[a]|tmp;
+  setF(z, ox_tab[a]|tmp);
   return a;
 }
 
-static uint8_t _rra8(uint8_t a) {
+static uint8_t _rra8(z80_t *z, uint8_t a) {
   uint8_t nC,oC;
 
   nC=a&1;
-  oC=(cpus.F & fC)?1:0;
+  oC=flag_c(z)?1:0;
   a=(a>>1)|(oC<<7);
-  cpus.F = (cpus.F & ~(fU1|fHC|fU2|fN|fC)) | (a&(fU1|fU2)) | nC;
+  setF(z, (getF(z) & ~(fU1|fHC|fU2|fN|fC)) | (a&(fU1|fU2)) | nC);
   return a;
 }
 
-static uint8_t _rr8(uint8_t a) {
+static uint8_t _rr8(z80_t *z, uint8_t a) {
   uint8_t nC,oC;
 
   nC=a&1;
-  oC=(cpus.F & fC)?1:0;
+  oC=flag_c(z)?1:0;
   a=(a>>1)|(oC<<7);
-  cpus.F=ox_tab[a]|nC;
+  setF(z, ox_tab[a]|nC);
   return a;
 }
 
-static uint8_t _rrca8(uint8_t a) {
+static uint8_t _rrca8(z80_t *z, uint8_t a) {
   uint8_t tmp;
 
   tmp=a&1;
   a=(a>>1)|(tmp<<7);
-  cpus.F = (cpus.F & ~(fU1|fHC|fU2|fN|fC)) | (a&(fU1|fU2)) | tmp;
+  setF(z, (getF(z) & ~(fU1|fHC|fU2|fN|fC)) | (a&(fU1|fU2)) | tmp);
   return a;
 }
 
-static uint8_t _rrc8(uint8_t a) {
+static uint8_t _rrc8(z80_t *z, uint8_t a) {
   uint8_t tmp;
 
   tmp=a&1;
   a=(a>>1)|(tmp<<7);
-  cpus.F=ox_tab[a]|tmp;
+  setF(z, ox_tab[a]|tmp);
   return a;
 }
 
@@ -755,81 +1009,75 @@ static uint8_t _rrc8(uint8_t a) {
 
 /************************************************************************/
 
-static uint8_t _sla8(uint8_t a) {
+static uint8_t _sla8(z80_t *z, uint8_t a) {
   uint8_t nC;
 
   nC=a>>7;
   a<<=1;
-  cpus.F=ox_tab[a]|nC;
+  setF(z, ox_tab[a]|nC);
   return a;
 }
 
-static uint8_t _sra8(uint8_t a) {
+static uint8_t _sra8(z80_t *z, uint8_t a) {
   uint8_t nC;
 
   nC=a&1;
   a=(a&0x80) | (a>>1);
-  cpus.F=ox_tab[a]|nC;
+  setF(z, ox_tab[a]|nC);
   return a;
 }
 
 #ifndef NO_Z80UNDOC
 
-static uint8_t _sll8(uint8_t a) {
+static uint8_t _sll8(z80_t *z, uint8_t a) {
   uint8_t nC,oC;
 
   nC=a>>7;
-  oC=(cpus.F & fC)?1:0;
+  oC=flag_c(z)?1:0;
   a=(a<<1)|oC;
-  cpus.F=ox_tab[a]|nC;
+  setF(z, ox_tab[a]|nC);
   return a;
 }
 
 #endif
 
-static uint8_t _srl8(uint16_t a) {
+static uint8_t _srl8(z80_t *z, uint16_t a) {
   uint16_t nC;
 
   nC=a&1;
   a>>=1;
-  cpus.F=ox_tab[a]|nC;
+  setF(z, ox_tab[a]|nC);
   return a;
 }
 
 /************************************************************************/
 
-static uint8_t _sbc8(uint16_t a, uint16_t b) {
+static uint8_t _sbc8(z80_t *z, uint16_t a, uint16_t b) {
   uint16_t res;
   uint16_t c;
   
-  c=((cpus.F&fC)!=0);
+  c=flag_c(z)?1:0;
 
   res=a-b-c;
-  setflags((res>>7)&1,
-	   (res&0xff)==0,
-	   (a&0x0f)-(b&0x0f)-c < 0, /* I hope */
-	   sbc_v8(a,b,c),
-	   1,
-	   res>0xff);
-  setundocflags8(res);
+  defer_flags(z, LF_SUB, keep_undoc(z), a, b, res);
   return res & 0xff;
 }
 
-static uint16_t _sbc16(uint16_t a, uint16_t b) {
+static uint16_t _sbc16(z80_t *z, uint16_t a, uint16_t b) {
   uint16_t res0,res1,a1,b1,c,c1;
   
-  c=((cpus.F&fC)?1:0);
+  c=flag_c(z)?1:0;
 
   res0=(a&0xff)-(b&0xff)- c;
   a1=a>>8; b1=b>>8; c1=((res0>0xff)?1:0);
   res1=a1-b1-c1;
-  setflags(res1&0x80,
+  setflags(z, res1&0x80,
 	   !((res0&0xff)|(res1&0xff)),
 	   (a1&0x0f) - (b1&0x0f)<0,
 	   sbc_v16(a,b,c),
 	   0,
 	   res1>0xff);
-  setundocflags8(res1);
+  setundocflags8(z, res1);
   return (res0&0xff)|((res1&0xff)<<8);
 }
 
@@ -845,27 +1093,21 @@ static uint8_t _set8(uint16_t a, uint16_t b) {
 /************************************************************************/
 
 
-static uint8_t _sub8(uint16_t a, uint16_t b) {
+static uint8_t _sub8(z80_t *z, uint16_t a, uint16_t b) {
   uint16_t res;
 
   res=a-b;
-  setflags((res>>7)&1,
-	   (res&0xff)==0,
-	   (a&0x0f)-(b&0x0f) < 0, /* I hope */
-	   sub_v8(a,b),
-	   1,
-	   res>0xff);
-  setundocflags8(res);
+  defer_flags(z, LF_SUB, keep_undoc(z), a, b, res);
   return res & 0xff;
 }
 
 /************************************************************************/
 
-static uint8_t _xor8(uint8_t a, uint8_t b) {
+static uint8_t _xor8(z80_t *z, uint8_t a, uint8_t b) {
   uint8_t res;
 
   res=a^b;
-  cpus.F=ox_tab[res];
+  setF(z, ox_tab[res]);
   return res;
 }
 
@@ -875,2924 +1117,2570 @@ static uint8_t _xor8(uint8_t a, uint8_t b) {
 /************************************************************************/
 /********************* documented opcodes *******************************/
 
-static void ei_adc_A_r(void) {
+static void ei_adc_A_r(z80_t *z) {
   uint8_t res;
 
-  res=_adc8(cpus.r[rA],cpus.r[opcode & 0x07]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_adc8(z, z->cpus.r[rA],z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_adc_A_N(void) {
+static void ei_adc_A_N(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_adc8(cpus.r[rA],op);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(7);
+  res=_adc8(z, z->cpus.r[rA],op);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_adc_A_iHL(void) {
+static void ei_adc_A_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_adc8(cpus.r[rA],_iHL8());
-  cpus.r[rA]=res;
-
-  z80_clock_inc(7);
+  res=_adc8(z, z->cpus.r[rA],_iHL8(z));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_adc_A_iIXN(void) {
+static void ei_adc_A_iIXN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_adc8(cpus.r[rA],_iIXN8(op));
-  cpus.r[rA]=res;
-
-  z80_clock_inc(15);
+  res=_adc8(z, z->cpus.r[rA],_iIXN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_adc_A_iIYN(void) {
+static void ei_adc_A_iIYN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_adc8(cpus.r[rA],_iIYN8(op));
-  cpus.r[rA]=res;
+  op=z80_iget8(z);
 
-  z80_clock_inc(15);
+  res=_adc8(z, z->cpus.r[rA],_iIYN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_adc_HL_BC(void) {
+static void ei_adc_HL_BC(z80_t *z) {
   uint16_t res;
 
-  res=_adc16(getHL(),getBC());
-  setHL(res);
-
-  z80_clock_inc(15);
+  res=_adc16(z, getHL(z),getBC(z));
+  setHL(z, res);
 }
 
-static void ei_adc_HL_DE(void) {
+static void ei_adc_HL_DE(z80_t *z) {
   uint16_t res;
 
-  res=_adc16(getHL(),getDE());
-  setHL(res);
-
-  z80_clock_inc(15);
+  res=_adc16(z, getHL(z),getDE(z));
+  setHL(z, res);
 }
 
-static void ei_adc_HL_HL(void) {
+static void ei_adc_HL_HL(z80_t *z) {
   uint16_t res;
 
-  res=_adc16(getHL(),getHL());
-  setHL(res);
-
-  z80_clock_inc(15);
+  res=_adc16(z, getHL(z),getHL(z));
+  setHL(z, res);
 }
 
-static void ei_adc_HL_SP(void) {
+static void ei_adc_HL_SP(z80_t *z) {
   uint16_t res;
 
-  res=_adc16(getHL(),cpus.SP);
-  setHL(res);
-
-  z80_clock_inc(15);
+  res=_adc16(z, getHL(z),z->cpus.SP);
+  setHL(z, res);
 }
 
 /************************************************************************/
 
-static void ei_add_A_r(void) {
+static void ei_add_A_r(z80_t *z) {
   uint8_t res;
 
-  res=_add8(cpus.r[rA],cpus.r[opcode & 0x07]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_add8(z, z->cpus.r[rA],z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_add_A_N(void) {
+static void ei_add_A_N(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_add8(cpus.r[rA],op);
-  cpus.r[rA]=res;
+  op=z80_iget8(z);
 
-  z80_clock_inc(7);
+  res=_add8(z, z->cpus.r[rA],op);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_add_A_iHL(void) {
+static void ei_add_A_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_add8(cpus.r[rA],_iHL8());
-  cpus.r[rA]=res;
-
-  z80_clock_inc(7);
+  res=_add8(z, z->cpus.r[rA],_iHL8(z));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_add_A_iIXN(void) {
+static void ei_add_A_iIXN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_add8(cpus.r[rA],_iIXN8(op));
-  cpus.r[rA]=res;
+  op=z80_iget8(z);
 
-  z80_clock_inc(15);
+  res=_add8(z, z->cpus.r[rA],_iIXN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_add_A_iIYN(void) {
+static void ei_add_A_iIYN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_add8(cpus.r[rA],_iIYN8(op));
-  cpus.r[rA]=res;
-
-  z80_clock_inc(15);
+  res=_add8(z, z->cpus.r[rA],_iIYN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_add_HL_BC(void) {
+static void ei_add_HL_BC(z80_t *z) {
   uint16_t res;
 
-  res=_add16(getHL(),getBC());
-  setHL(res);
-
-  z80_clock_inc(11);
+  res=_add16(z, getHL(z),getBC(z));
+  setHL(z, res);
 }
 
-static void ei_add_HL_DE(void) {
+static void ei_add_HL_DE(z80_t *z) {
   uint16_t res;
 
-  res=_add16(getHL(),getDE());
-  setHL(res);
-
-  z80_clock_inc(11);
+  res=_add16(z, getHL(z),getDE(z));
+  setHL(z, res);
 }
 
-static void ei_add_HL_HL(void) {
+static void ei_add_HL_HL(z80_t *z) {
   uint16_t res;
 
-  res=_add16(getHL(),getHL());
-  setHL(res);
-
-  z80_clock_inc(11);
+  res=_add16(z, getHL(z),getHL(z));
+  setHL(z, res);
 }
 
-static void ei_add_HL_SP(void) {
+static void ei_add_HL_SP(z80_t *z) {
   uint16_t res;
 
-  res=_add16(getHL(),cpus.SP);
-  setHL(res);
-
-  z80_clock_inc(11);
+  res=_add16(z, getHL(z),z->cpus.SP);
+  setHL(z, res);
 }
 
-static void ei_add_IX_BC(void) {
+static void ei_add_IX_BC(z80_t *z) {
   uint16_t res;
 
-  res=_add16(cpus.IX,getBC());
-  cpus.IX=res;
-
-  z80_clock_inc(11);
+  res=_add16(z, z->cpus.IX,getBC(z));
+  z->cpus.IX=res;
 }
 
-static void ei_add_IX_DE(void) {
+static void ei_add_IX_DE(z80_t *z) {
   uint16_t res;
 
-  res=_add16(cpus.IX,getDE());
-  cpus.IX=res;
-
-  z80_clock_inc(11);
+  res=_add16(z, z->cpus.IX,getDE(z));
+  z->cpus.IX=res;
 }
 
-static void ei_add_IX_IX(void) {
+static void ei_add_IX_IX(z80_t *z) {
   uint16_t res;
 
-  res=_add16(cpus.IX,cpus.IX);
-  cpus.IX=res;
-
-  z80_clock_inc(11);
+  res=_add16(z, z->cpus.IX,z->cpus.IX);
+  z->cpus.IX=res;
 }
 
-static void ei_add_IX_SP(void) {
+static void ei_add_IX_SP(z80_t *z) {
   uint16_t res;
 
-  res=_add16(cpus.IX,cpus.SP);
-  cpus.IX=res;
-
-  z80_clock_inc(11);
+  res=_add16(z, z->cpus.IX,z->cpus.SP);
+  z->cpus.IX=res;
 }
 
-static void ei_add_IY_BC(void) {
+static void ei_add_IY_BC(z80_t *z) {
   uint16_t res;
 
-  res=_add16(cpus.IY,getBC());
-  cpus.IY=res;
-
-  z80_clock_inc(11);
+  res=_add16(z, z->cpus.IY,getBC(z));
+  z->cpus.IY=res;
 }
 
-static void ei_add_IY_DE(void) {
+static void ei_add_IY_DE(z80_t *z) {
   uint16_t res;
 
-  res=_add16(cpus.IY,getDE());
-  cpus.IY=res;
-
-  z80_clock_inc(11);
+  res=_add16(z, z->cpus.IY,getDE(z));
+  z->cpus.IY=res;
 }
 
-static void ei_add_IY_IY(void) {
+static void ei_add_IY_IY(z80_t *z) {
   uint16_t res;
 
-  res=_add16(cpus.IY,cpus.IY);
-  cpus.IY=res;
-
-  z80_clock_inc(11);
+  res=_add16(z, z->cpus.IY,z->cpus.IY);
+  z->cpus.IY=res;
 }
 
-static void ei_add_IY_SP(void) {
+static void ei_add_IY_SP(z80_t *z) {
   uint16_t res;
 
-  res=_add16(cpus.IY,cpus.SP);
-  cpus.IY=res;
-
-  z80_clock_inc(11);
+  res=_add16(z, z->cpus.IY,z->cpus.SP);
+  z->cpus.IY=res;
 }
 
 /************************************************************************/
 
-static void ei_and_r(void) {
+static void ei_and_r(z80_t *z) {
   uint8_t res;
 
-  res=_and8(cpus.r[rA],cpus.r[opcode & 0x07]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_and8(z, z->cpus.r[rA],z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_and_N(void) {
+static void ei_and_N(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_and8(cpus.r[rA],op);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(7);
+  res=_and8(z, z->cpus.r[rA],op);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_and_iHL(void) {
+static void ei_and_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_and8(cpus.r[rA],_iHL8());
-  cpus.r[rA]=res;
-
-  z80_clock_inc(7);
+  res=_and8(z, z->cpus.r[rA],_iHL8(z));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_and_iIXN(void) {
+static void ei_and_iIXN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_and8(cpus.r[rA],_iIXN8(op));
-  cpus.r[rA]=res;
-
-  z80_clock_inc(15);
+  res=_and8(z, z->cpus.r[rA],_iIXN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_and_iIYN(void) {
+static void ei_and_iIYN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_and8(cpus.r[rA],_iIYN8(op));
-  cpus.r[rA]=res;
+  op=z80_iget8(z);
 
-  z80_clock_inc(15);
+  res=_and8(z, z->cpus.r[rA],_iIYN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
 /************************************************************************/
 
-static void ei_bit_b_r(void) {
-  _bit8((opcode>>3)&0x07,cpus.r[opcode & 0x07]);
-
-  z80_clock_inc(8);
+static void ei_bit_b_r(z80_t *z) {
+  _bit8(z, (z->opcode>>3)&0x07,z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
 }
 
-static void ei_bit_b_iHL(void) {
-  _bit8((opcode>>3)&0x07,_iHL8());
+static void ei_bit_b_iHL(z80_t *z) {
+  _bit8(z, (z->opcode>>3)&0x07,_iHL8(z));
   /* undoc flags are set in a VERY weird way here.
      I didn't implement this yet. */
-
-  z80_clock_inc(12);
 }
 
 /* DDCB ! */
-static void ei_bit_b_iIXN(void) {
-  _bit8((opcode>>3)&0x07,_iIXN8(cbop));
-  setundocflags8((cpus.IX+u8sval(cbop))>>8); /* weird, huh? */
-
-  z80_clock_inc(16);
+static void ei_bit_b_iIXN(z80_t *z) {
+  _bit8(z, (z->opcode>>3)&0x07,_iIXN8(z, z->cbop));
+  setundocflags8(z, (z->cpus.IX+u8sval(z->cbop))>>8); /* weird, huh? */
 }
 
 /* FDCB ! */
-static void ei_bit_b_iIYN(void) {
-
-  _bit8((opcode>>3)&0x07,_iIYN8(cbop));
-  setundocflags8((cpus.IY+u8sval(cbop))>>8); /* weird, huh? */
+static void ei_bit_b_iIYN(z80_t *z) {
 
-  z80_clock_inc(16);
+  _bit8(z, (z->opcode>>3)&0x07,_iIYN8(z, z->cbop));
+  setundocflags8(z, (z->cpus.IY+u8sval(z->cbop))>>8); /* weird, huh? */
 }
 
 /************************************************************************/
 
-static void ei_call_NN(void) {
+static void ei_call_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  _call16(addr);
-  z80_clock_inc(17);
+  addr=z80_iget16(z);
+  _call16(z, addr);
 }
 
-static void ei_call_C_NN(void) {
+static void ei_call_C_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(cpus.F & fC) {
-    _call16(addr);
-    z80_clock_inc(17);
-  } else z80_clock_inc(10);
+  addr=z80_iget16(z);
+  if(flag_c(z)) {
+    _call16(z, addr);
+    z80_clock_inc(z, 7);
+  }
 }
 
-static void ei_call_NC_NN(void) {
+static void ei_call_NC_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(!(cpus.F & fC)) {
-    _call16(addr);
-    z80_clock_inc(17);
-  } else z80_clock_inc(10);
+  addr=z80_iget16(z);
+  if(!flag_c(z)) {
+    _call16(z, addr);
+    z80_clock_inc(z, 7);
+  }
 }
 
-static void ei_call_M_NN(void) {
+static void ei_call_M_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(cpus.F & fS) {
-    _call16(addr);
-    z80_clock_inc(17);
-  } else z80_clock_inc(10);
+  addr=z80_iget16(z);
+  if(flag_s(z)) {
+    _call16(z, addr);
+    z80_clock_inc(z, 7);
+  }
 }
 
-static void ei_call_P_NN(void) {
+static void ei_call_P_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(!(cpus.F & fS)) {
-    _call16(addr);
-    z80_clock_inc(17);
-  } else z80_clock_inc(10);
+  addr=z80_iget16(z);
+  if(!flag_s(z)) {
+    _call16(z, addr);
+    z80_clock_inc(z, 7);
+  }
 }
 
-static void ei_call_Z_NN(void) {
+static void ei_call_Z_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(cpus.F & fZ) {
-    _call16(addr);
-    z80_clock_inc(17);
-  } else z80_clock_inc(10);
+  addr=z80_iget16(z);
+  if(flag_z(z)) {
+    _call16(z, addr);
+    z80_clock_inc(z, 7);
+  }
 }
 
-static void ei_call_NZ_NN(void) {
+static void ei_call_NZ_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(!(cpus.F & fZ)) {
-    _call16(addr);
-    z80_clock_inc(17);
-  } else z80_clock_inc(10);
+  addr=z80_iget16(z);
+  if(!flag_z(z)) {
+    _call16(z, addr);
+    z80_clock_inc(z, 7);
+  }
 }
 
-static void ei_call_PE_NN(void) {
+static void ei_call_PE_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(cpus.F & fPV) {
-    _call16(addr);
-    z80_clock_inc(17);
-  } else z80_clock_inc(10);
+  addr=z80_iget16(z);
+  if(flag_pv(z)) {
+    _call16(z, addr);
+    z80_clock_inc(z, 7);
+  }
 }
 
-static void ei_call_PO_NN(void) {
+static void ei_call_PO_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(!(cpus.F & fPV)) {
-    _call16(addr);
-    z80_clock_inc(17);
-  } else z80_clock_inc(10);
+  addr=z80_iget16(z);
+  if(!flag_pv(z)) {
+    _call16(z, addr);
+    z80_clock_inc(z, 7);
+  }
 }
 
 /************************************************************************/
 
-static void ei_ccf(void) { /* complement carry flag */
+static void ei_ccf(z80_t *z) { /* complement carry flag */
   uint8_t nHC;
   
-  nHC=(cpus.F&fC)?fHC:0;
-  cpus.F= ((cpus.F ^ fC) & ~(fU1|fHC|fU2|fN)) | nHC | (cpus.r[rA]&(fU1|fU2));
-  z80_clock_inc(4);
+  nHC=flag_c(z)?fHC:0;
+  setF(z, ((getF(z) ^ fC) & ~(fU1|fHC|fU2|fN)) | nHC | (z->cpus.r[rA]&(fU1|fU2)));
 }
 
 /************************************************************************/
 
-static void ei_cp_r(void) {
-  _cp8(cpus.r[rA],cpus.r[opcode & 0x07]);
-  z80_clock_inc(4);
+static void ei_cp_r(z80_t *z) {
+  _cp8(z, z->cpus.r[rA],z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
 }
 
-static void ei_cp_N(void) {
+static void ei_cp_N(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  _cp8(cpus.r[rA],op);
-  z80_clock_inc(7);
+  _cp8(z, z->cpus.r[rA],op);
 }
 
-static void ei_cp_iHL(void) {
-  _cp8(cpus.r[rA],_iHL8());
-  z80_clock_inc(7);
+static void ei_cp_iHL(z80_t *z) {
+  _cp8(z, z->cpus.r[rA],_iHL8(z));
 }
 
-static void ei_cp_iIXN(void) {
+static void ei_cp_iIXN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  _cp8(cpus.r[rA],_iIXN8(op));
-  z80_clock_inc(15);
+  _cp8(z, z->cpus.r[rA],_iIXN8(z, op));
 }
 
-static void ei_cp_iIYN(void) {
+static void ei_cp_iIYN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
+
+  _cp8(z, z->cpus.r[rA],_iIYN8(z, op));
+}
+
+/*
+ * Repeating block instructions. Instead of returning to the host after
+ * each iteration, keep iterating as long as the host would not have
+ * anything to do in between, i.e. until the deadline.
+ */
+
+/* prepare next iteration of block instruction at pc, if it can run now */
+static int block_repeat(z80_t *z, uint16_t pc) {
+#ifndef NO_Z80CLOCK
+  if((long)(z->clock - z->deadline) >= 0) return 0;
+  if(ev_due(z)) return 0;
+  if(brk_hit(z)) return 0;
+
+  /* the instruction might have just overwritten itself */
+  if((uint16_t)(getDE(z)-pc+1)<=3 || (uint16_t)(getHL(z)-pc+1)<=3) return 0;
+
+  /* do what z80_execinstr() would do between the iterations */
+  z->iclock=z->clock;
+  incr_R(z, 2);	/* opcode fetch and ED prefix */
+  z->cpus.modifier=0;
+  z->cpus.PC+=2;
+#ifndef NO_Z80STAT
+  if(z->stat_on) z->stat_tab[z->ei_tabi][z->opcode]++;
+#endif
+  z80_clock_base(z, z->ei_tabi, z->opcode);
+#ifndef NO_Z80PROF
+  if(z->prof_on) {
+    z->prof[z->ei_tabi][z->opcode].count++;
+    if(z->prof_timed) z->prof[z->ei_tabi][z->opcode].samples++;
+  }
+#endif
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/* execute block instruction, iter executes one iteration */
+static inline void block_run(z80_t *z, void (*iter)(z80_t *)) {
+  uint16_t pc;
 
-  _cp8(cpus.r[rA],_iIYN8(op));
-  z80_clock_inc(15);
+  pc=z->cpus.PC-2; /* address of the ED prefix */
+  iter(z);
+  while(z->cpus.PC==pc && block_repeat(z, pc))
+    iter(z);
 }
 
-static void ei_cpd(void) {
+static void ei_cpd(z80_t *z) {
   uint8_t a,b,ufr,res;
   uint16_t newBC;
 
-  a=cpus.r[rA];
-  b=_iHL8();
+  a=z->cpus.r[rA];
+  b=_iHL8(z);
   res=a-b;
-  setHL(getHL()-1);
-  newBC=getBC()-1; setBC(newBC);
+  setHL(z, getHL(z)-1);
+  newBC=getBC(z)-1; setBC(z, newBC);
   
-  setflags((res>>7)&1,
+  setflags(z, (res>>7)&1,
 	   (res&0xff)==0,
 	   (a&0x0f)-(b&0x0f) < 0,
 	   newBC!=0,
 	   1,
 	   -1);
 	   
-  ufr=cpus.r[rA]-b;
+  ufr=z->cpus.r[rA]-b;
   if(newBC!=0) ufr--;  /* if we turned H flag on, decrease by 1 */
-  setundocflags8(((ufr&0x02)<<4)|(ufr&0x08));
-
-  z80_clock_inc(16);
+  setundocflags8(z, ((ufr&0x02)<<4)|(ufr&0x08));
 }
 
-static void ei_cpdr(void) {
+static void _cpdr(z80_t *z) {
   uint8_t a,b,ufr,res;
   uint16_t newBC;
 
-  a=cpus.r[rA];
-  b=_iHL8();
+  a=z->cpus.r[rA];
+  b=_iHL8(z);
   res=a-b;
-  setHL(getHL()-1);
-  newBC=getBC()-1; setBC(newBC);
+  setHL(z, getHL(z)-1);
+  newBC=getBC(z)-1; setBC(z, newBC);
   
-  setflags((res>>7)&1,
+  setflags(z, (res>>7)&1,
 	   (res&0xff)==0,
 	   (a&0x0f)-(b&0x0f) < 0,
 	   newBC!=0,
 	   1,
 	   -1);
 	   
-  ufr=cpus.r[rA]-b;
+  ufr=z->cpus.r[rA]-b;
   if(newBC!=0) ufr--;  /* if we turned H flag on, decrease by 1 */
-  setundocflags8(((ufr&0x02)<<4)|(ufr&0x08));
+  setundocflags8(z, ((ufr&0x02)<<4)|(ufr&0x08));
 
-  if(newBC==0 || (cpus.F & fZ)) {
-    z80_clock_inc(16);
-  } else {
-    z80_clock_inc(21);
-    cpus.PC-=2;
+  if(newBC!=0 && !flag_z(z)) {
+    z80_clock_inc(z, 5);
+    z->cpus.PC-=2;
   }
 }
 
-static void ei_cpi(void) {
+static void ei_cpdr(z80_t *z) {
+  block_run(z, _cpdr);
+}
+
+static void ei_cpi(z80_t *z) {
   uint8_t a,b,ufr,res;
   uint16_t newBC;
 
-  a=cpus.r[rA];
-  b=_iHL8();
+  a=z->cpus.r[rA];
+  b=_iHL8(z);
   res=a-b;
-  setHL(getHL()+1);
-  newBC=getBC()-1; setBC(newBC);
+  setHL(z, getHL(z)+1);
+  newBC=getBC(z)-1; setBC(z, newBC);
   
-  setflags((res>>7)&1,
+  setflags(z, (res>>7)&1,
 	   (res&0xff)==0,
 	   (a&0x0f)-(b&0x0f) < 0,
 	   newBC!=0,
 	   1,
 	   -1);
 	   
-  ufr=cpus.r[rA]-b;
+  ufr=z->cpus.r[rA]-b;
   if(newBC!=0) ufr--;  /* if we turned H flag on, decrease by 1 */
-  setundocflags8(((ufr&0x02)<<4)|(ufr&0x08));
-
-  z80_clock_inc(16);
+  setundocflags8(z, ((ufr&0x02)<<4)|(ufr&0x08));
 }
 
-static void ei_cpir(void) {
+static void _cpir(z80_t *z) {
   uint8_t a,b,ufr,res;
   uint16_t newBC;
 
-  a=cpus.r[rA];
-  b=_iHL8();
+  a=z->cpus.r[rA];
+  b=_iHL8(z);
   res=a-b;
-  setHL(getHL()+1);
-  newBC=getBC()-1; setBC(newBC);
+  setHL(z, getHL(z)+1);
+  newBC=getBC(z)-1; setBC(z, newBC);
   
-  setflags((res>>7)&1,
+  setflags(z, (res>>7)&1,
 	   (res&0xff)==0,
 	   (a&0x0f)-(b&0x0f) < 0,
 	   newBC!=0,
 	   1,
 	   -1);
 	   
-  ufr=cpus.r[rA]-b;
+  ufr=z->cpus.r[rA]-b;
   if(newBC!=0) ufr--;  /* if we turned H flag on, decrease by 1 */
-  setundocflags8(((ufr&0x02)<<4)|(ufr&0x08));
+  setundocflags8(z, ((ufr&0x02)<<4)|(ufr&0x08));
 
-  if(newBC==0 || (cpus.F & fZ)) {
-    z80_clock_inc(16);
-  } else {
-    z80_clock_inc(21);
-    cpus.PC-=2;
+  if(newBC!=0 && !flag_z(z)) {
+    z80_clock_inc(z, 5);
+    z->cpus.PC-=2;
   }
 }
 
+static void ei_cpir(z80_t *z) {
+  block_run(z, _cpir);
+}
+
 /************************************************************************/
 
-static void ei_cpl(void) { /* A <- cpl(A) ... one's complement */
-  cpus.r[rA] ^= 0xff;
-  setflags(-1,
+static void ei_cpl(z80_t *z) { /* A <- cpl(A) ... one's complement */
+  z->cpus.r[rA] ^= 0xff;
+  setflags(z, -1,
            -1,
 	   1,
 	   -1,
 	   1,
 	   -1);
-  setundocflags8(cpus.r[rA]);
-  z80_clock_inc(4);
+  setundocflags8(z, z->cpus.r[rA]);
 }
 
 
 /************************************************************************/
 
-static void ei_daa(void) {
+static void ei_daa(z80_t *z) {
   uint16_t res;
   
-  res=cpus.r[rA];
+  res=z->cpus.r[rA];
   
-  if((cpus.F & fN)==0) {
-    if(cpus.F & fC) res += 0x60;
-      else if(res>0x99) { res += 0x60; cpus.F|=fC; }
+  if((getF(z) & fN)==0) {
+    if(flag_c(z)) res += 0x60;
+      else if(res>0x99) { res += 0x60; setF(z, getF(z)|fC); }
       
-    if(cpus.F & fHC) res += 0x06;
-      else if((res&0x0f)>0x09) { res += 0x06; cpus.F|=fHC; }
+    if(getF(z) & fHC) res += 0x06;
+      else if((res&0x0f)>0x09) { res += 0x06; setF(z, getF(z)|fHC); }
   } else {
-    if(cpus.F & fC) res -= 0x60;
-      else if(res>0x99) { res -= 0x60; cpus.F|=fC; }
+    if(flag_c(z)) res -= 0x60;
+      else if(res>0x99) { res -= 0x60; setF(z, getF(z)|fC); }
       
-    if(cpus.F & fHC) res -= 0x06;
-      else if((res&0x0f)>0x09) { res -= 0x06; cpus.F|=fHC; }
+    if(getF(z) & fHC) res -= 0x06;
+      else if((res&0x0f)>0x09) { res -= 0x06; setF(z, getF(z)|fHC); }
   }
-  setflags((res>>7)&1,
-	   (res&0xff)==0,
-	   -1,
-	   oddp8(res&0xff),
-	   -1,
-	   -1);
-  setundocflags8(res);
+  setF(z, (getF(z)&(fHC|fN|fC|F_KEEP_U)) | (ox_tab[res&0xff]&~F_KEEP_U));
   
-  cpus.r[rA] = res & 0xff;
-  
-  z80_clock_inc(4);
+  z->cpus.r[rA] = res & 0xff;
 }
 
 /************************************************************************/
 
-static void ei_dec_A(void) {
+static void ei_dec_A(z80_t *z) {
   uint8_t res;
 
-  res=_dec8(cpus.r[rA]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_dec8(z, z->cpus.r[rA]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_dec_B(void) {
+static void ei_dec_B(z80_t *z) {
   uint8_t res;
 
-  res=_dec8(cpus.r[rB]);
-  cpus.r[rB]=res;
-
-  z80_clock_inc(4);
+  res=_dec8(z, z->cpus.r[rB]);
+  z->cpus.r[rB]=res;
 }
 
-static void ei_dec_C(void) {
+static void ei_dec_C(z80_t *z) {
   uint8_t res;
 
-  res=_dec8(cpus.r[rC]);
-  cpus.r[rC]=res;
-
-  z80_clock_inc(4);
+  res=_dec8(z, z->cpus.r[rC]);
+  z->cpus.r[rC]=res;
 }
 
-static void ei_dec_D(void) {
+static void ei_dec_D(z80_t *z) {
   uint8_t res;
 
-  res=_dec8(cpus.r[rD]);
-  cpus.r[rD]=res;
-
-  z80_clock_inc(4);
+  res=_dec8(z, z->cpus.r[rD]);
+  z->cpus.r[rD]=res;
 }
 
-static void ei_dec_E(void) {
+static void ei_dec_E(z80_t *z) {
   uint8_t res;
 
-  res=_dec8(cpus.r[rE]);
-  cpus.r[rE]=res;
-
-  z80_clock_inc(4);
+  res=_dec8(z, z->cpus.r[rE]);
+  z->cpus.r[rE]=res;
 }
 
-static void ei_dec_H(void) {
+static void ei_dec_H(z80_t *z) {
   uint8_t res;
 
-  res=_dec8(cpus.r[rH]);
-  cpus.r[rH]=res;
-
-  z80_clock_inc(4);
+  res=_dec8(z, z->cpus.r[rH]);
+  z->cpus.r[rH]=res;
 }
 
-static void ei_dec_L(void) {
+static void ei_dec_L(z80_t *z) {
   uint8_t res;
 
-  res=_dec8(cpus.r[rL]);
-  cpus.r[rL]=res;
-
-  z80_clock_inc(4);
+  res=_dec8(z, z->cpus.r[rL]);
+  z->cpus.r[rL]=res;
 }
 
-static void ei_dec_iHL(void) {
+static void ei_dec_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_dec8(_iHL8());
-  s_iHL8(res);
-
-  z80_clock_inc(11);
+  res=_dec8(z, _iHL8(z));
+  s_iHL8(z, res);
 }
 
-static void ei_dec_iIXN(void) {
+static void ei_dec_iIXN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_dec8(_iIXN8(op));
-  s_iIXN8(op,res);
+  op=z80_iget8(z);
 
-  z80_clock_inc(19);
+  res=_dec8(z, _iIXN8(z, op));
+  s_iIXN8(z, op,res);
 }
 
-static void ei_dec_iIYN(void) {
+static void ei_dec_iIYN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_dec8(_iIYN8(op));
-  s_iIYN8(op,res);
-
-  z80_clock_inc(19);
+  res=_dec8(z, _iIYN8(z, op));
+  s_iIYN8(z, op,res);
 }
 
-static void ei_dec_BC(void) {
+static void ei_dec_BC(z80_t *z) {
 
-  setBC(getBC()-1);
-  z80_clock_inc(6);
+  setBC(z, getBC(z)-1);
 }
 
-static void ei_dec_DE(void) {
+static void ei_dec_DE(z80_t *z) {
 
-  setDE(getDE()-1);
-  z80_clock_inc(6);
+  setDE(z, getDE(z)-1);
 }
 
-static void ei_dec_HL(void) {
+static void ei_dec_HL(z80_t *z) {
 
-  setHL(getHL()-1);
-  z80_clock_inc(6);
+  setHL(z, getHL(z)-1);
 }
 
-static void ei_dec_SP(void) {
+static void ei_dec_SP(z80_t *z) {
 
-  cpus.SP--;
-  z80_clock_inc(6);
+  z->cpus.SP--;
 }
 
-static void ei_dec_IX(void) {
+static void ei_dec_IX(z80_t *z) {
 
-  cpus.IX--;
-  z80_clock_inc(6);
+  z->cpus.IX--;
 }
 
-static void ei_dec_IY(void) {
+static void ei_dec_IY(z80_t *z) {
 
-  cpus.IY--;
-  z80_clock_inc(6);
+  z->cpus.IY--;
 }
 
 /************************************************************************/
 
-static void ei_di(void) {
-  cpus.IFF1=cpus.IFF2=0;
-  cpus.int_lock=1;
-  z80_clock_inc(4);
+static void ei_di(z80_t *z) {
+  z->cpus.IFF1=z->cpus.IFF2=0;
+  z->cpus.int_lock=1;
 }
 
 /************************************************************************/
 
-static void ei_djnz(void) {
+static void ei_djnz(z80_t *z) {
   uint8_t ofs;
   
-  ofs=z80_iget8();
-  cpus.r[rB]--;
-  if(cpus.r[rB]!=0) {
-    _jr8(ofs);
-    z80_clock_inc(13);
-  } else z80_clock_inc(8);
+  ofs=z80_iget8(z);
+  z->cpus.r[rB]--;
+  if(z->cpus.r[rB]!=0) {
+    _jr8(z, ofs);
+    z80_clock_inc(z, 5);
+  }
 }
 
 /************************************************************************/
 
-static void ei_ei(void) {
-  cpus.IFF1=cpus.IFF2=1;
-  cpus.int_lock=1;
-  z80_clock_inc(4);
+static void ei_ei(z80_t *z) {
+  z->cpus.IFF1=z->cpus.IFF2=1;
+  z->cpus.int_lock=1;
 }
 
 /************************************************************************/
 
-static void ei_ex_iSP_HL(void) {
+static void ei_ex_iSP_HL(z80_t *z) {
   uint16_t tmp;
 
-  tmp=_iSP16();
-  s_iSP16(getHL());
-  setHL(tmp);
-
-  z80_clock_inc(19);
+  tmp=_iSP16(z);
+  s_iSP16(z, getHL(z));
+  setHL(z, tmp);
 }
 
-static void ei_ex_iSP_IX(void) {
+static void ei_ex_iSP_IX(z80_t *z) {
   uint16_t tmp;
 
-  tmp=_iSP16();
-  s_iSP16(cpus.IX);
-  cpus.IX=tmp;
-
-  z80_clock_inc(19);
+  tmp=_iSP16(z);
+  s_iSP16(z, z->cpus.IX);
+  z->cpus.IX=tmp;
 }
 
-static void ei_ex_iSP_IY(void) {
+static void ei_ex_iSP_IY(z80_t *z) {
   uint16_t tmp;
 
-  tmp=_iSP16();
-  s_iSP16(cpus.IY);
-  cpus.IY=tmp;
-
-  z80_clock_inc(19);
+  tmp=_iSP16(z);
+  s_iSP16(z, z->cpus.IY);
+  z->cpus.IY=tmp;
 }
 
-static void ei_ex_AF_xAF(void) {
-  uint8_t tmp;
-
-  tmp=cpus.r[rA]; cpus.r[rA]=cpus.r_[rA]; cpus.r_[rA]=tmp;
-  tmp=cpus.F; cpus.F=cpus.F_; cpus.F_=tmp;
+static void ei_ex_AF_xAF(z80_t *z) {
+  uint16_t tmp;
 
-  z80_clock_inc(4);
+  tmp=getAF(z); setAF(z, z->cpus.rp_[rAF]); z->cpus.rp_[rAF]=tmp;
 }
 
-static void ei_ex_DE_HL(void) {
+static void ei_ex_DE_HL(z80_t *z) {
   uint16_t tmp;
 
-  tmp=getDE(); setDE(getHL()); setHL(tmp);
-  z80_clock_inc(4);
+  tmp=getDE(z); setDE(z, getHL(z)); setHL(z, tmp);
 }
 
-static void ei_exx(void) {
-  uint8_t tmp;
-
-  tmp=cpus.r[rB]; cpus.r[rB]=cpus.r_[rB]; cpus.r_[rB]=tmp;
-  tmp=cpus.r[rC]; cpus.r[rC]=cpus.r_[rC]; cpus.r_[rC]=tmp;
-  tmp=cpus.r[rD]; cpus.r[rD]=cpus.r_[rD]; cpus.r_[rD]=tmp;
-  tmp=cpus.r[rE]; cpus.r[rE]=cpus.r_[rE]; cpus.r_[rE]=tmp;
-  tmp=cpus.r[rH]; cpus.r[rH]=cpus.r_[rH]; cpus.r_[rH]=tmp;
-  tmp=cpus.r[rL]; cpus.r[rL]=cpus.r_[rL]; cpus.r_[rL]=tmp;
+static void ei_exx(z80_t *z) {
+  uint16_t tmp;
 
-  z80_clock_inc(4);
+  tmp=z->cpus.rp[rBC]; z->cpus.rp[rBC]=z->cpus.rp_[rBC]; z->cpus.rp_[rBC]=tmp;
+  tmp=z->cpus.rp[rDE]; z->cpus.rp[rDE]=z->cpus.rp_[rDE]; z->cpus.rp_[rDE]=tmp;
+  tmp=z->cpus.rp[rHL]; z->cpus.rp[rHL]=z->cpus.rp_[rHL]; z->cpus.rp_[rHL]=tmp;
 }
 
 
 /************************************************************************/
 
 
-static void ei_halt(void) {
-  cpus.halted=1;
-
-  z80_clock_inc(4);
+static void ei_halt(z80_t *z) {
+  z->cpus.halted=1;
 }
 
 
 /************************************************************************/
 
-static void ei_im_0(void) {
-  cpus.int_mode=0;
-  z80_clock_inc(8);
+static void ei_im_0(z80_t *z) {
+  z->cpus.int_mode=0;
 }
 
-static void ei_im_1(void) {
-  cpus.int_mode=1;
-  z80_clock_inc(8);
+static void ei_im_1(z80_t *z) {
+  z->cpus.int_mode=1;
 }
 
-static void ei_im_2(void) {
-  cpus.int_mode=2;
-  z80_clock_inc(8);
+static void ei_im_2(z80_t *z) {
+  z->cpus.int_mode=2;
 }
 
 /************************************************************************/
 
-static void ei_in_A_iN(void) {
+static void ei_in_A_iN(z80_t *z) {
   uint8_t res;
   uint16_t op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_in8pf(((uint16_t)cpus.r[rA]<<8)|(uint16_t)op);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(11);
+  res=_in8pf(z, ((uint16_t)z->cpus.r[rA]<<8)|(uint16_t)op);
+  z->cpus.r[rA]=res;
 }
 
-static void Ui_in_iC(void) {
+static void Ui_in_iC(z80_t *z) {
 
 //  printf("ei_in_iC (unsupported)\n");
-  _in8(getBC());
+  _in8(z, getBC(z));
 
-  uoc++;
-  z80_clock_inc(12);
+  z->uoc++;
 }
 
-static void ei_in_A_iC(void) {
+static void ei_in_A_iC(z80_t *z) {
   uint8_t res;
 
-  res=_in8(getBC());
-  cpus.r[rA]=res;
-
-  z80_clock_inc(12);
+  res=_in8(z, getBC(z));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_in_B_iC(void) {
+static void ei_in_B_iC(z80_t *z) {
   uint8_t res;
 
-  res=_in8(getBC());
-  cpus.r[rB]=res;
-
-  z80_clock_inc(12);
+  res=_in8(z, getBC(z));
+  z->cpus.r[rB]=res;
 }
 
-static void ei_in_C_iC(void) {
+static void ei_in_C_iC(z80_t *z) {
   uint8_t res;
 
-  res=_in8(getBC());
-  cpus.r[rC]=res;
-
-  z80_clock_inc(12);
+  res=_in8(z, getBC(z));
+  z->cpus.r[rC]=res;
 }
 
-static void ei_in_D_iC(void) {
+static void ei_in_D_iC(z80_t *z) {
   uint8_t res;
 
-  res=_in8(getBC());
-  cpus.r[rD]=res;
-
-  z80_clock_inc(12);
+  res=_in8(z, getBC(z));
+  z->cpus.r[rD]=res;
 }
 
-static void ei_in_E_iC(void) {
+static void ei_in_E_iC(z80_t *z) {
   uint8_t res;
 
-  res=_in8(getBC());
-  cpus.r[rE]=res;
-
-  z80_clock_inc(12);
+  res=_in8(z, getBC(z));
+  z->cpus.r[rE]=res;
 }
 
-static void ei_in_H_iC(void) {
+static void ei_in_H_iC(z80_t *z) {
   uint8_t res;
 
-  res=_in8(getBC());
-  cpus.r[rH]=res;
-
-  z80_clock_inc(12);
+  res=_in8(z, getBC(z));
+  z->cpus.r[rH]=res;
 }
 
-static void ei_in_L_iC(void) {
+static void ei_in_L_iC(z80_t *z) {
   uint8_t res;
 
-  res=_in8(getBC());
-  cpus.r[rL]=res;
-
-  z80_clock_inc(12);
+  res=_in8(z, getBC(z));
+  z->cpus.r[rL]=res;
 }
 
 /************************************************************************/
 
-static void ei_inc_A(void) {
+static void ei_inc_A(z80_t *z) {
   uint8_t res;
 
-  res=_inc8(cpus.r[rA]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_inc8(z, z->cpus.r[rA]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_inc_B(void) {
+static void ei_inc_B(z80_t *z) {
   uint8_t res;
 
-  res=_inc8(cpus.r[rB]);
-  cpus.r[rB]=res;
-
-  z80_clock_inc(4);
+  res=_inc8(z, z->cpus.r[rB]);
+  z->cpus.r[rB]=res;
 }
 
-static void ei_inc_C(void) {
+static void ei_inc_C(z80_t *z) {
   uint8_t res;
 
-  res=_inc8(cpus.r[rC]);
-  cpus.r[rC]=res;
-
-  z80_clock_inc(4);
+  res=_inc8(z, z->cpus.r[rC]);
+  z->cpus.r[rC]=res;
 }
 
-static void ei_inc_D(void) {
+static void ei_inc_D(z80_t *z) {
   uint8_t res;
 
-  res=_inc8(cpus.r[rD]);
-  cpus.r[rD]=res;
-
-  z80_clock_inc(4);
+  res=_inc8(z, z->cpus.r[rD]);
+  z->cpus.r[rD]=res;
 }
 
-static void ei_inc_E(void) {
+static void ei_inc_E(z80_t *z) {
   uint8_t res;
 
-  res=_inc8(cpus.r[rE]);
-  cpus.r[rE]=res;
-
-  z80_clock_inc(4);
+  res=_inc8(z, z->cpus.r[rE]);
+  z->cpus.r[rE]=res;
 }
 
-static void ei_inc_H(void) {
+static void ei_inc_H(z80_t *z) {
   uint8_t res;
 
-  res=_inc8(cpus.r[rH]);
-  cpus.r[rH]=res;
-
-  z80_clock_inc(4);
+  res=_inc8(z, z->cpus.r[rH]);
+  z->cpus.r[rH]=res;
 }
 
-static void ei_inc_L(void) {
+static void ei_inc_L(z80_t *z) {
   uint8_t res;
 
-  res=_inc8(cpus.r[rL]);
-  cpus.r[rL]=res;
-
-  z80_clock_inc(4);
+  res=_inc8(z, z->cpus.r[rL]);
+  z->cpus.r[rL]=res;
 }
 
-static void ei_inc_iHL(void) {
+static void ei_inc_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_inc8(_iHL8());
-  s_iHL8(res);
-
-  z80_clock_inc(11);
+  res=_inc8(z, _iHL8(z));
+  s_iHL8(z, res);
 }
 
-static void ei_inc_iIXN(void) {
+static void ei_inc_iIXN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_inc8(_iIXN8(op));
-  s_iIXN8(op,res);
-
-  z80_clock_inc(19);
+  res=_inc8(z, _iIXN8(z, op));
+  s_iIXN8(z, op,res);
 }
 
-static void ei_inc_iIYN(void) {
+static void ei_inc_iIYN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_inc8(_iIYN8(op));
-  s_iIYN8(op,res);
+  op=z80_iget8(z);
 
-  z80_clock_inc(19);
+  res=_inc8(z, _iIYN8(z, op));
+  s_iIYN8(z, op,res);
 }
 
-static void ei_inc_BC(void) {
+static void ei_inc_BC(z80_t *z) {
 
-  setBC(getBC()+1);
-  z80_clock_inc(6);
+  setBC(z, getBC(z)+1);
 }
 
-static void ei_inc_DE(void) {
+static void ei_inc_DE(z80_t *z) {
 
-  setDE(getDE()+1);
-  z80_clock_inc(6);
+  setDE(z, getDE(z)+1);
 }
 
-static void ei_inc_HL(void) {
+static void ei_inc_HL(z80_t *z) {
 
-  setHL(getHL()+1);
-  z80_clock_inc(6);
+  setHL(z, getHL(z)+1);
 }
 
-static void ei_inc_SP(void) {
+static void ei_inc_SP(z80_t *z) {
 
-  cpus.SP++;
-  z80_clock_inc(6);
+  z->cpus.SP++;
 }
 
-static void ei_inc_IX(void) {
+static void ei_inc_IX(z80_t *z) {
 
-  cpus.IX++;
-  z80_clock_inc(6);
+  z->cpus.IX++;
 }
 
-static void ei_inc_IY(void) {
+static void ei_inc_IY(z80_t *z) {
 
-  cpus.IY++;
-  z80_clock_inc(6);
+  z->cpus.IY++;
 }
 
 
 /************************************************************************/
 
-static void ei_ind(void) {
+static void ei_ind(z80_t *z) {
   uint8_t res,tmp;
 
-  tmp=_in8(getBC());
-  s_iHL8(tmp);
-  setHL(getHL()-1);
-  res=(cpus.r[rB]-1)&0xff;
+  tmp=_in8(z, getBC(z));
+  s_iHL8(z, tmp);
+  setHL(z, getHL(z)-1);
+  res=(z->cpus.r[rB]-1)&0xff;
   
-  setflags(res>>7,
+  setflags(z, res>>7,
            res==0,
-	   (cpus.r[rB]&0x0f)-1<0, /* I hope */
+	   (z->cpus.r[rB]&0x0f)-1<0, /* I hope */
 	   res==127,
 	   1,
 	   -1);
   /* dunno how undoc flags work here */
   
-  cpus.r[rB]=res;
-  z80_clock_inc(16);
+  z->cpus.r[rB]=res;
 }
 
-static void ei_indr(void) {
+static void _indr(z80_t *z) {
   uint8_t res;
   
-  res=_in8(getBC());
-  s_iHL8(res);
-  setHL(getHL()-1);
-  cpus.r[rB]--;
+  res=_in8(z, getBC(z));
+  s_iHL8(z, res);
+  setHL(z, getHL(z)-1);
+  z->cpus.r[rB]--;
   
-  if(cpus.r[rB]==0) {
+  if(z->cpus.r[rB]==0) {
 //    printf("B==0. indr terminated.\n");
-    setflags(0,1,0,0,1,-1);
+    setflags(z, 0,1,0,0,1,-1);
     /* dunno how undoc flags work here */
-    z80_clock_inc(16);
   } else {
-    z80_clock_inc(21);
-    cpus.PC-=2;
+    z80_clock_inc(z, 5);
+    z->cpus.PC-=2;
   }
 }
 
-static void ei_ini(void) {
+static void ei_indr(z80_t *z) {
+  block_run(z, _indr);
+}
+
+static void ei_ini(z80_t *z) {
   uint8_t res,tmp;
 
-  tmp=_in8(getBC());
-  s_iHL8(tmp);
-  setHL(getHL()+1);
-  res=(cpus.r[rB]-1)&0xff;
+  tmp=_in8(z, getBC(z));
+  s_iHL8(z, tmp);
+  setHL(z, getHL(z)+1);
+  res=(z->cpus.r[rB]-1)&0xff;
   
-  setflags(res>>7,
+  setflags(z, res>>7,
            res==0,
-	   (cpus.r[rB]&0x0f)-1<0, /* doufam */
+	   (z->cpus.r[rB]&0x0f)-1<0, /* doufam */
 	   res==127,
 	   1,
 	   -1);
   /* dunno how undoc flags work here */
   
-  cpus.r[rB]=res;
-  z80_clock_inc(16);
+  z->cpus.r[rB]=res;
 }
 
-static void ei_inir(void) {
+static void _inir(z80_t *z) {
   uint8_t res;
   
-  res=_in8(getBC());
-  s_iHL8(res);
-  setHL(getHL()+1);
-  cpus.r[rB]--;
+  res=_in8(z, getBC(z));
+  s_iHL8(z, res);
+  setHL(z, getHL(z)+1);
+  z->cpus.r[rB]--;
   
-  if(cpus.r[rB]==0) {
+  if(z->cpus.r[rB]==0) {
 //    printf("B==0. inir terminated.\n");
-    setflags(0,1,0,0,1,-1);
+    setflags(z, 0,1,0,0,1,-1);
     /* dunno how undoc flags work here */
-    z80_clock_inc(16);
   } else {
-    z80_clock_inc(21);
-    cpus.PC-=2;
+    z80_clock_inc(z, 5);
+    z->cpus.PC-=2;
   }
 }
 
+static void ei_inir(z80_t *z) {
+  block_run(z, _inir);
+}
+
 /************************************************************************/
 
-static void ei_jp_NN(void) {
+static void ei_jp_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
+  addr=z80_iget16(z);
  // printf("jp 0x%04x\n",addr);
-  _jp16(addr);
-  z80_clock_inc(10);
+  _jp16(z, addr);
 }
 
-static void ei_jp_HL(void) {
+static void ei_jp_HL(z80_t *z) {
   uint16_t addr;
 
-  addr=getHL();
-//  printf("%04x:jp HL [0x%04x]\n",cpus.PC,addr);
-  _jp16(addr);
-  z80_clock_inc(4);
+  addr=getHL(z);
+//  printf("%04x:jp HL [0x%04x]\n",z->cpus.PC,addr);
+  _jp16(z, addr);
 }
 
-static void ei_jp_IX(void) {
+static void ei_jp_IX(z80_t *z) {
   uint16_t addr;
 
-  addr=cpus.IX;
-  _jp16(addr);
-  z80_clock_inc(4);
+  addr=z->cpus.IX;
+  _jp16(z, addr);
 }
 
-static void ei_jp_IY(void) {
+static void ei_jp_IY(z80_t *z) {
   uint16_t addr;
 
-  addr=cpus.IY;
-  _jp16(addr);
-  z80_clock_inc(4);
+  addr=z->cpus.IY;
+  _jp16(z, addr);
 }
 
-static void ei_jp_C_NN(void) {
+static void ei_jp_C_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(cpus.F & fC) {
-    _jp16(addr);
+  addr=z80_iget16(z);
+  if(flag_c(z)) {
+    _jp16(z, addr);
   }
-  z80_clock_inc(10);
 }
 
-static void ei_jp_NC_NN(void) {
+static void ei_jp_NC_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(!(cpus.F & fC)) {
-    _jp16(addr);
+  addr=z80_iget16(z);
+  if(!flag_c(z)) {
+    _jp16(z, addr);
   }
-  z80_clock_inc(10);
 }
 
-static void ei_jp_M_NN(void) {
+static void ei_jp_M_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(cpus.F & fS) {
-    _jp16(addr);
+  addr=z80_iget16(z);
+  if(flag_s(z)) {
+    _jp16(z, addr);
   }
-  z80_clock_inc(10);
 }
 
-static void ei_jp_P_NN(void) {
+static void ei_jp_P_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(!(cpus.F & fS)) {
-    _jp16(addr);
+  addr=z80_iget16(z);
+  if(!flag_s(z)) {
+    _jp16(z, addr);
   }
-  z80_clock_inc(10);
 }
 
-static void ei_jp_Z_NN(void) {
+static void ei_jp_Z_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(cpus.F & fZ) {
-    _jp16(addr);
+  addr=z80_iget16(z);
+  if(flag_z(z)) {
+    _jp16(z, addr);
   }
-  z80_clock_inc(10);
 }
 
-static void ei_jp_NZ_NN(void) {
+static void ei_jp_NZ_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(!(cpus.F & fZ)) {
-    _jp16(addr);
+  addr=z80_iget16(z);
+  if(!flag_z(z)) {
+    _jp16(z, addr);
   }
-  z80_clock_inc(10);
 }
 
-static void ei_jp_PE_NN(void) {
+static void ei_jp_PE_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(cpus.F & fPV) {
-    _jp16(addr);
+  addr=z80_iget16(z);
+  if(flag_pv(z)) {
+    _jp16(z, addr);
   }
-  z80_clock_inc(10);
 }
 
-static void ei_jp_PO_NN(void) {
+static void ei_jp_PO_NN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  if(!(cpus.F & fPV)) {
-    _jp16(addr);
+  addr=z80_iget16(z);
+  if(!flag_pv(z)) {
+    _jp16(z, addr);
   }
-  z80_clock_inc(10);
 }
 
 /************************************************************************/
 
-static void ei_jr_N(void) {
+static void ei_jr_N(z80_t *z) {
   uint8_t ofs;
 
-  ofs=z80_iget8();
-  _jr8(ofs);
-  z80_clock_inc(12);
+  ofs=z80_iget8(z);
+  _jr8(z, ofs);
 }
 
-static void ei_jr_C_N(void) {
+static void ei_jr_C_N(z80_t *z) {
   uint8_t ofs;
 
-  ofs=z80_iget8();
-  if(cpus.F & fC) {
-    _jr8(ofs);
-    z80_clock_inc(12);
-  } else z80_clock_inc(7);
+  ofs=z80_iget8(z);
+  if(flag_c(z)) {
+    _jr8(z, ofs);
+    z80_clock_inc(z, 5);
+  }
 }
 
-static void ei_jr_NC_N(void) {
+static void ei_jr_NC_N(z80_t *z) {
   uint8_t ofs;
 
-  ofs=z80_iget8();
-  if(!(cpus.F & fC)) {
-    _jr8(ofs);
-    z80_clock_inc(12);
-  } else z80_clock_inc(7);
+  ofs=z80_iget8(z);
+  if(!flag_c(z)) {
+    _jr8(z, ofs);
+    z80_clock_inc(z, 5);
+  }
 }
 
-static void ei_jr_Z_N(void) {
+static void ei_jr_Z_N(z80_t *z) {
   uint8_t ofs;
 
-  ofs=z80_iget8();
-  if(cpus.F & fZ) {
-    _jr8(ofs);
-    z80_clock_inc(12);
-  } else z80_clock_inc(7);
+  ofs=z80_iget8(z);
+  if(flag_z(z)) {
+    _jr8(z, ofs);
+    z80_clock_inc(z, 5);
+  }
 }
 
-static void ei_jr_NZ_N(void) {
+static void ei_jr_NZ_N(z80_t *z) {
   uint8_t ofs;
 
-  ofs=z80_iget8();
-  if(!(cpus.F & fZ)) {
-    _jr8(ofs);
-    z80_clock_inc(12);
-  } else z80_clock_inc(7);
+  ofs=z80_iget8(z);
+  if(!flag_z(z)) {
+    _jr8(z, ofs);
+    z80_clock_inc(z, 5);
+  }
 }
 
 /************************************************************************/
 
-static void ei_ld_I_A(void) {
+static void ei_ld_I_A(z80_t *z) {
 
-  cpus.I=cpus.r[rA];
-  z80_clock_inc(9);
+  z->cpus.I=z->cpus.r[rA];
 }
 
-static void ei_ld_R_A(void) {
+static void ei_ld_R_A(z80_t *z) {
 
-  cpus.R=cpus.r[rA];
-  z80_clock_inc(9);
+  setR(z, z->cpus.r[rA]);
 }
 
-static void ei_ld_A_I(void) {
+static void ei_ld_A_I(z80_t *z) {
 
-  cpus.r[rA]=cpus.I;
-  setflags(cpus.r[rA]>>7,
-	   cpus.r[rA]!=0,
+  z->cpus.r[rA]=z->cpus.I;
+  setflags(z, z->cpus.r[rA]>>7,
+	   z->cpus.r[rA]!=0,
 	   0,
-	   cpus.IFF2,
+	   z->cpus.IFF2,
 	   0,
 	   -1);
-  setundocflags8(cpus.r[rA]);
-  z80_clock_inc(9);
+  setundocflags8(z, z->cpus.r[rA]);
 }
 
-static void ei_ld_A_R(void) {
+static void ei_ld_A_R(z80_t *z) {
 
-  //cpus.r[rA]=cpus.R;
-  cpus.r[rA] = 0x00;
-  setflags(cpus.r[rA]>>7,
-	   cpus.r[rA]!=0,
+  //z->cpus.r[rA]=z->cpus.R;
+  z->cpus.r[rA] = 0x00;
+  setflags(z, z->cpus.r[rA]>>7,
+	   z->cpus.r[rA]!=0,
 	   0,
-	   cpus.IFF2,
+	   z->cpus.IFF2,
 	   0,
 	   -1);
-  setundocflags8(cpus.r[rA]);
-  z80_clock_inc(9);
+  setundocflags8(z, z->cpus.r[rA]);
 }
 
-static void ei_ld_A_r(void) {
+static void ei_ld_A_r(z80_t *z) {
 
-  cpus.r[rA]=cpus.r[opcode & 0x07];
-  z80_clock_inc(4);
+  z->cpus.r[rA]=z->cpus.r[Z80_REG8(z->opcode & 0x07)];
 }
 
-static void ei_ld_A_N(void) {
+static void ei_ld_A_N(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rA]=op;
-  z80_clock_inc(7);
+  op=z80_iget8(z);
+  z->cpus.r[rA]=op;
 }
 
-static void ei_ld_A_iBC(void) {
+static void ei_ld_A_iBC(z80_t *z) {
 
-  cpus.r[rA]=_iBC8();
-  z80_clock_inc(7);
+  z->cpus.r[rA]=_iBC8(z);
 }
 
-static void ei_ld_A_iDE(void) {
+static void ei_ld_A_iDE(z80_t *z) {
 
-  cpus.r[rA]=_iDE8();
-  z80_clock_inc(7);
+  z->cpus.r[rA]=_iDE8(z);
 }
 
-static void ei_ld_A_iHL(void) {
+static void ei_ld_A_iHL(z80_t *z) {
 
-  cpus.r[rA]=_iHL8();
-  z80_clock_inc(7);
+  z->cpus.r[rA]=_iHL8(z);
 }
 
-static void ei_ld_A_iIXN(void) {
+static void ei_ld_A_iIXN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rA]=_iIXN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rA]=_iIXN8(z, op);
 }
 
-static void ei_ld_A_iIYN(void) {
+static void ei_ld_A_iIYN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rA]=_iIYN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rA]=_iIYN8(z, op);
 }
 
-static void ei_ld_A_iNN(void) {
+static void ei_ld_A_iNN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  cpus.r[rA]=z80_memget8(addr);
-  z80_clock_inc(13);
+  addr=z80_iget16(z);
+  z->cpus.r[rA]=z80_memget8(z, addr);
 }
 
-static void ei_ld_B_r(void) {
+static void ei_ld_B_r(z80_t *z) {
 
-  cpus.r[rB]=cpus.r[opcode & 0x07];
-  z80_clock_inc(4);
+  z->cpus.r[rB]=z->cpus.r[Z80_REG8(z->opcode & 0x07)];
 }
 
-static void ei_ld_B_N(void) {
+static void ei_ld_B_N(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rB]=op;
-  z80_clock_inc(7);
+  op=z80_iget8(z);
+  z->cpus.r[rB]=op;
 }
 
-static void ei_ld_B_iHL(void) {
+static void ei_ld_B_iHL(z80_t *z) {
 
-  cpus.r[rB]=_iHL8();
-  z80_clock_inc(7);
+  z->cpus.r[rB]=_iHL8(z);
 }
 
-static void ei_ld_B_iIXN(void) {
+static void ei_ld_B_iIXN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rB]=_iIXN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rB]=_iIXN8(z, op);
 }
 
-static void ei_ld_B_iIYN(void) {
+static void ei_ld_B_iIYN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rB]=_iIYN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rB]=_iIYN8(z, op);
 }
 
-static void ei_ld_C_r(void) {
+static void ei_ld_C_r(z80_t *z) {
 
-  cpus.r[rC]=cpus.r[opcode & 0x07];
-  z80_clock_inc(4);
+  z->cpus.r[rC]=z->cpus.r[Z80_REG8(z->opcode & 0x07)];
 }
 
-static void ei_ld_C_N(void) {
+static void ei_ld_C_N(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rC]=op;
-  z80_clock_inc(7);
+  op=z80_iget8(z);
+  z->cpus.r[rC]=op;
 }
 
-static void ei_ld_C_iHL(void) {
+static void ei_ld_C_iHL(z80_t *z) {
 
-  cpus.r[rC]=_iHL8();
-  z80_clock_inc(7);
+  z->cpus.r[rC]=_iHL8(z);
 }
 
-static void ei_ld_C_iIXN(void) {
+static void ei_ld_C_iIXN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rC]=_iIXN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rC]=_iIXN8(z, op);
 }
 
-static void ei_ld_C_iIYN(void) {
+static void ei_ld_C_iIYN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rC]=_iIYN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rC]=_iIYN8(z, op);
 }
 
-static void ei_ld_D_r(void) {
+static void ei_ld_D_r(z80_t *z) {
 
-  cpus.r[rD]=cpus.r[opcode & 0x07];
-  z80_clock_inc(4);
+  z->cpus.r[rD]=z->cpus.r[Z80_REG8(z->opcode & 0x07)];
 }
 
-static void ei_ld_D_N(void) {
+static void ei_ld_D_N(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rD]=op;
-  z80_clock_inc(7);
+  op=z80_iget8(z);
+  z->cpus.r[rD]=op;
 }
 
-static void ei_ld_D_iHL(void) {
+static void ei_ld_D_iHL(z80_t *z) {
 
-  cpus.r[rD]=_iHL8();
-  z80_clock_inc(7);
+  z->cpus.r[rD]=_iHL8(z);
 }
 
-static void ei_ld_D_iIXN(void) {
+static void ei_ld_D_iIXN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rD]=_iIXN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rD]=_iIXN8(z, op);
 }
 
-static void ei_ld_D_iIYN(void) {
+static void ei_ld_D_iIYN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rD]=_iIYN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rD]=_iIYN8(z, op);
 }
 
-static void ei_ld_E_r(void) {
+static void ei_ld_E_r(z80_t *z) {
 
-  cpus.r[rE]=cpus.r[opcode & 0x07];
-  z80_clock_inc(4);
+  z->cpus.r[rE]=z->cpus.r[Z80_REG8(z->opcode & 0x07)];
 }
 
-static void ei_ld_E_N(void) {
+static void ei_ld_E_N(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rE]=op;
-  z80_clock_inc(7);
+  op=z80_iget8(z);
+  z->cpus.r[rE]=op;
 }
 
-static void ei_ld_E_iHL(void) {
+static void ei_ld_E_iHL(z80_t *z) {
 
-  cpus.r[rE]=_iHL8();
-  z80_clock_inc(7);
+  z->cpus.r[rE]=_iHL8(z);
 }
 
-static void ei_ld_E_iIXN(void) {
+static void ei_ld_E_iIXN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rE]=_iIXN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rE]=_iIXN8(z, op);
 }
 
-static void ei_ld_E_iIYN(void) {
+static void ei_ld_E_iIYN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rE]=_iIYN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rE]=_iIYN8(z, op);
 }
 
-static void ei_ld_H_r(void) {
+static void ei_ld_H_r(z80_t *z) {
 
-  cpus.r[rH]=cpus.r[opcode & 0x07];
-  z80_clock_inc(4);
+  z->cpus.r[rH]=z->cpus.r[Z80_REG8(z->opcode & 0x07)];
 }
 
-static void ei_ld_H_N(void) {
+static void ei_ld_H_N(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rH]=op;
-  z80_clock_inc(7);
+  op=z80_iget8(z);
+  z->cpus.r[rH]=op;
 }
 
-static void ei_ld_H_iHL(void) {
+static void ei_ld_H_iHL(z80_t *z) {
 
-  cpus.r[rH]=_iHL8();
-  z80_clock_inc(7);
+  z->cpus.r[rH]=_iHL8(z);
 }
 
-static void ei_ld_H_iIXN(void) {
+static void ei_ld_H_iIXN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rH]=_iIXN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rH]=_iIXN8(z, op);
 }
 
-static void ei_ld_H_iIYN(void) {
+static void ei_ld_H_iIYN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rH]=_iIYN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rH]=_iIYN8(z, op);
 }
 
-static void ei_ld_L_r(void) {
+static void ei_ld_L_r(z80_t *z) {
 
-  cpus.r[rL]=cpus.r[opcode & 0x07];
-  z80_clock_inc(4);
+  z->cpus.r[rL]=z->cpus.r[Z80_REG8(z->opcode & 0x07)];
 }
 
-static void ei_ld_L_N(void) {
+static void ei_ld_L_N(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rL]=op;
-  z80_clock_inc(7);
+  op=z80_iget8(z);
+  z->cpus.r[rL]=op;
 }
 
-static void ei_ld_L_iHL(void) {
+static void ei_ld_L_iHL(z80_t *z) {
 
-  cpus.r[rL]=_iHL8();
-  z80_clock_inc(7);
+  z->cpus.r[rL]=_iHL8(z);
 }
 
-static void ei_ld_L_iIXN(void) {
+static void ei_ld_L_iIXN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  cpus.r[rL]=_iIXN8(op);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  z->cpus.r[rL]=_iIXN8(z, op);
 }
 
-static void ei_ld_L_iIYN(void) {
+static void ei_ld_L_iIYN(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  cpus.r[rL]=_iIYN8(op);
-
-  z80_clock_inc(15);
+  z->cpus.r[rL]=_iIYN8(z, op);
 }
 
-static void ei_ld_BC_iNN(void) {
+static void ei_ld_BC_iNN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  setBC(z80_memget16(addr));
-  z80_clock_inc(20);
+  addr=z80_iget16(z);
+  setBC(z, z80_memget16(z, addr));
 }
 
-static void ei_ld_BC_NN(void) {
+static void ei_ld_BC_NN(z80_t *z) {
   uint16_t data;
 
-  data=z80_iget16();
-  setBC(data);
-  z80_clock_inc(10);
+  data=z80_iget16(z);
+  setBC(z, data);
 }
 
-static void ei_ld_DE_iNN(void) {
+static void ei_ld_DE_iNN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  setDE(z80_memget16(addr));
-  z80_clock_inc(20);
+  addr=z80_iget16(z);
+  setDE(z, z80_memget16(z, addr));
 }
 
-static void ei_ld_DE_NN(void) {
+static void ei_ld_DE_NN(z80_t *z) {
   uint16_t data;
 
-  data=z80_iget16();
-  setDE(data);
-  z80_clock_inc(10);
+  data=z80_iget16(z);
+  setDE(z, data);
 }
 
-static void ei_ld_HL_iNN(void) {
+static void ei_ld_HL_iNN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  setHL(z80_memget16(addr));
-  z80_clock_inc(16);
+  addr=z80_iget16(z);
+  setHL(z, z80_memget16(z, addr));
 }
 
 /* ED prefixed variant, takes 4 more T states */
-static void ei_ld_HL_iNN_x(void) {
+static void ei_ld_HL_iNN_x(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  setHL(z80_memget16(addr));
-  z80_clock_inc(20);
+  addr=z80_iget16(z);
+  setHL(z, z80_memget16(z, addr));
 }
 
-static void ei_ld_HL_NN(void) {
+static void ei_ld_HL_NN(z80_t *z) {
   uint16_t data;
 
-  data=z80_iget16();
-  setHL(data);
-  z80_clock_inc(10);
+  data=z80_iget16(z);
+  setHL(z, data);
 }
 
-static void ei_ld_SP_iNN(void) {
+static void ei_ld_SP_iNN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  cpus.SP=z80_memget16(addr);
-  z80_clock_inc(20);
+  addr=z80_iget16(z);
+  z->cpus.SP=z80_memget16(z, addr);
 }
 
-static void ei_ld_SP_NN(void) {
+static void ei_ld_SP_NN(z80_t *z) {
   uint16_t data;
 
-  data=z80_iget16();
-  cpus.SP=data;
-  z80_clock_inc(10);
+  data=z80_iget16(z);
+  z->cpus.SP=data;
 }
 
-static void ei_ld_SP_HL(void) {
+static void ei_ld_SP_HL(z80_t *z) {
 
-  cpus.SP=getHL();
-  z80_clock_inc(6);
+  z->cpus.SP=getHL(z);
 }
 
-static void ei_ld_SP_IX(void) {
+static void ei_ld_SP_IX(z80_t *z) {
 
-  cpus.SP=cpus.IX;
-  z80_clock_inc(6);
+  z->cpus.SP=z->cpus.IX;
 }
 
-static void ei_ld_SP_IY(void) {
+static void ei_ld_SP_IY(z80_t *z) {
 
-  cpus.SP=cpus.IY;
-  z80_clock_inc(6);
+  z->cpus.SP=z->cpus.IY;
 }
 
-static void ei_ld_IX_iNN(void) {
+static void ei_ld_IX_iNN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  cpus.IX=z80_memget16(addr);
-  z80_clock_inc(16);
+  addr=z80_iget16(z);
+  z->cpus.IX=z80_memget16(z, addr);
 }
 
-static void ei_ld_IX_NN(void) {
+static void ei_ld_IX_NN(z80_t *z) {
   uint16_t data;
 
-  data=z80_iget16();
-  cpus.IX=data;
-  z80_clock_inc(10);
+  data=z80_iget16(z);
+  z->cpus.IX=data;
 }
 
-static void ei_ld_IY_iNN(void) {
+static void ei_ld_IY_iNN(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  cpus.IY=z80_memget16(addr);
-  z80_clock_inc(16);
+  addr=z80_iget16(z);
+  z->cpus.IY=z80_memget16(z, addr);
 }
 
-static void ei_ld_IY_NN(void) {
+static void ei_ld_IY_NN(z80_t *z) {
   uint16_t data;
 
-  data=z80_iget16();
-  cpus.IY=data;
-  z80_clock_inc(10);
+  data=z80_iget16(z);
+  z->cpus.IY=data;
 }
 
-static void ei_ld_iHL_r(void) {
+static void ei_ld_iHL_r(z80_t *z) {
 
-  s_iHL8(cpus.r[opcode & 0x07]);
-  z80_clock_inc(7);
+  s_iHL8(z, z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
 }
 
-static void ei_ld_iHL_N(void) {
+static void ei_ld_iHL_N(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  s_iHL8(op);
-  z80_clock_inc(10);
+  op=z80_iget8(z);
+  s_iHL8(z, op);
 }
 
-static void ei_ld_iBC_A(void) {
+static void ei_ld_iBC_A(z80_t *z) {
 
-  s_iBC8(cpus.r[rA]);
-  z80_clock_inc(7);
+  s_iBC8(z, z->cpus.r[rA]);
 }
 
-static void ei_ld_iDE_A(void) {
+static void ei_ld_iDE_A(z80_t *z) {
 
-  s_iDE8(cpus.r[rA]);
-  z80_clock_inc(7);
+  s_iDE8(z, z->cpus.r[rA]);
 }
 
-static void ei_ld_iNN_A(void) {
+static void ei_ld_iNN_A(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  z80_memset8(addr,cpus.r[rA]);
-  z80_clock_inc(13);
+  addr=z80_iget16(z);
+  z80_memset8(z, addr,z->cpus.r[rA]);
 }
 
-static void ei_ld_iNN_BC(void) {
+static void ei_ld_iNN_BC(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  z80_memset16(addr,getBC());
-  z80_clock_inc(20);
+  addr=z80_iget16(z);
+  z80_memset16(z, addr,getBC(z));
 }
 
-static void ei_ld_iNN_DE(void) {
+static void ei_ld_iNN_DE(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  z80_memset16(addr,getDE());
-  z80_clock_inc(20);
+  addr=z80_iget16(z);
+  z80_memset16(z, addr,getDE(z));
 }
 
-static void ei_ld_iNN_HL(void) {
+static void ei_ld_iNN_HL(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  z80_memset16(addr,getHL());
-  z80_clock_inc(16);
+  addr=z80_iget16(z);
+  z80_memset16(z, addr,getHL(z));
 }
 
-static void ei_ld_iNN_SP(void) {
+static void ei_ld_iNN_SP(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  z80_memset16(addr,cpus.SP);
-  z80_clock_inc(20);
+  addr=z80_iget16(z);
+  z80_memset16(z, addr,z->cpus.SP);
 }
 
-static void ei_ld_iNN_IX(void) {
+static void ei_ld_iNN_IX(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  z80_memset16(addr,cpus.IX);
-  z80_clock_inc(16);
+  addr=z80_iget16(z);
+  z80_memset16(z, addr,z->cpus.IX);
 }
 
-static void ei_ld_iNN_IY(void) {
+static void ei_ld_iNN_IY(z80_t *z) {
   uint16_t addr;
 
-  addr=z80_iget16();
-  z80_memset16(addr,cpus.IY);
-  z80_clock_inc(16);
+  addr=z80_iget16(z);
+  z80_memset16(z, addr,z->cpus.IY);
 }
 
-static void ei_ld_iIXN_r(void) {
+static void ei_ld_iIXN_r(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  s_iIXN8(op,cpus.r[opcode & 0x07]);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  s_iIXN8(z, op,z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
 }
 
-static void ei_ld_iIXN_N(void) {
+static void ei_ld_iIXN_N(z80_t *z) {
   uint8_t op,data;
 
-  op=z80_iget8();
-  data=z80_iget8();
-  s_iIXN8(op,data);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  data=z80_iget8(z);
+  s_iIXN8(z, op,data);
 }
 
-static void ei_ld_iIYN_r(void) {
+static void ei_ld_iIYN_r(z80_t *z) {
   uint8_t op;
 
-  op=z80_iget8();
-  s_iIYN8(op,cpus.r[opcode & 0x07]);
-  z80_clock_inc(15);
+  op=z80_iget8(z);
+  s_iIYN8(z, op,z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
 }
 
-static void ei_ld_iIYN_N(void) {
+static void ei_ld_iIYN_N(z80_t *z) {
   uint8_t op,data;
 
-  op=z80_iget8();
-  data=z80_iget8();
-
-  s_iIYN8(op,data);
+  op=z80_iget8(z);
+  data=z80_iget8(z);
 
-  z80_clock_inc(15);
+  s_iIYN8(z, op,data);
 }
 
 
 /************************************************************************/
 
-static void ei_ldd(void) {
+static void ei_ldd(z80_t *z) {
   uint8_t res,ufr;
   uint16_t newBC;
 
-  res=_iHL8();
-  s_iDE8(res);
-  setHL(getHL()-1);
-  newBC=getBC()-1;  setBC(newBC);
-  setDE(getDE()-1);
+  res=_iHL8(z);
+  s_iDE8(z, res);
+  setHL(z, getHL(z)-1);
+  newBC=getBC(z)-1;  setBC(z, newBC);
+  setDE(z, getDE(z)-1);
   
-  setflags(-1,
+  setflags(z, -1,
 	   -1,
 	   0,
 	   newBC!=0,
 	   0,
 	   -1);
-  ufr=res+cpus.r[rA];
-  setundocflags8(((ufr&0x02)<<4) | (ufr&0x08));
-
-  z80_clock_inc(16);
+  ufr=res+z->cpus.r[rA];
+  setundocflags8(z, ((ufr&0x02)<<4) | (ufr&0x08));
 }
 
-static void ei_lddr(void) {
+static void _lddr(z80_t *z) {
   uint8_t res,ufr;
   uint16_t newBC;
 
-  res=_iHL8();
-  s_iDE8(res);
-  setHL(getHL()-1);
-  newBC=getBC()-1;  setBC(newBC);
-  setDE(getDE()-1);
+  res=_iHL8(z);
+  s_iDE8(z, res);
+  setHL(z, getHL(z)-1);
+  newBC=getBC(z)-1;  setBC(z, newBC);
+  setDE(z, getDE(z)-1);
   
-  setflags(-1,
+  setflags(z, -1,
 	   -1,
 	   0,
 	   newBC!=0,
 	   0,
 	   -1);
-  ufr=res+cpus.r[rA];
-  setundocflags8(((ufr&0x02)<<4) | (ufr&0x08));
+  ufr=res+z->cpus.r[rA];
+  setundocflags8(z, ((ufr&0x02)<<4) | (ufr&0x08));
 
-  if(newBC==0) {
-    z80_clock_inc(16);
-  } else {
-    z80_clock_inc(21);
-    cpus.PC-=2;
+  if(newBC!=0) {
+    z80_clock_inc(z, 5);
+    z->cpus.PC-=2;
   }
 }
 
+static void ei_lddr(z80_t *z) {
+  block_run(z, _lddr);
+}
+
 
-static void ei_ldi(void) {
+static void ei_ldi(z80_t *z) {
   uint8_t res,ufr;
   uint16_t newBC;
 
-  res=_iHL8();
-  s_iDE8(res);
-  setHL(getHL()+1);
-  newBC=getBC()-1; setBC(newBC);
-  setDE(getDE()+1);
+  res=_iHL8(z);
+  s_iDE8(z, res);
+  setHL(z, getHL(z)+1);
+  newBC=getBC(z)-1; setBC(z, newBC);
+  setDE(z, getDE(z)+1);
   
-  setflags(-1,
+  setflags(z, -1,
 	   -1,
 	   0,
 	   newBC!=0,
 	   0,
 	   -1);
-  ufr=res+cpus.r[rA];
-  setundocflags8(((ufr&0x02)<<4) | (ufr&0x08));
-
-  z80_clock_inc(16);
+  ufr=res+z->cpus.r[rA];
+  setundocflags8(z, ((ufr&0x02)<<4) | (ufr&0x08));
 }
 
-static void ei_ldir(void) {
+static void _ldir(z80_t *z) {
   uint8_t res,ufr;
   uint16_t newBC;
 
-  res=_iHL8();
-  s_iDE8(res);
-  setHL(getHL()+1);
-  newBC=getBC()-1; setBC(newBC);
-  setDE(getDE()+1);
-  setflags(-1,
+  res=_iHL8(z);
+  s_iDE8(z, res);
+  setHL(z, getHL(z)+1);
+  newBC=getBC(z)-1; setBC(z, newBC);
+  setDE(z, getDE(z)+1);
+  setflags(z, -1,
 	   -1,
 	   0,
 	   newBC!=0,
 	   0,
 	   -1);
-  ufr=res+cpus.r[rA];
-  setundocflags8(((ufr&0x02)<<4) | (ufr&0x08));
+  ufr=res+z->cpus.r[rA];
+  setundocflags8(z, ((ufr&0x02)<<4) | (ufr&0x08));
 
-  if(newBC==0) {
-    z80_clock_inc(16);
-  } else {
-    z80_clock_inc(21);
-    cpus.PC-=2;
+  if(newBC!=0) {
+    z80_clock_inc(z, 5);
+    z->cpus.PC-=2;
   }
 }
 
+static void ei_ldir(z80_t *z) {
+  block_run(z, _ldir);
+}
+
 
 /************************************************************************/
 
-static void ei_neg(void) {               /* A <- neg(A) .. two's complement */
+static void ei_neg(z80_t *z) {               /* A <- neg(A) .. two's complement */
   uint16_t res;
 //  printf("NEG(2c)\n");
-  res = (cpus.r[rA] ^ 0xff)+1;
+  res = (z->cpus.r[rA] ^ 0xff)+1;
   
-  setflags((res>>7)&1,
+  setflags(z, (res>>7)&1,
 	   (res&0xff)==0,
 	   (res&0x0f)==0,        /* not sure about this, verify!!!! */
 	   (res&0xff)==0x80,     /* 127 -> -128 */
 	   1,
 	   res>0xff);		 /* not sure about this, verify!!!! */
 
-  cpus.r[rA] = res & 0xff;
-  setundocflags8(cpus.r[rA]);
-  z80_clock_inc(8);
+  z->cpus.r[rA] = res & 0xff;
+  setundocflags8(z, z->cpus.r[rA]);
 }
 
 
 /************************************************************************/
 
-static void ei_nop(void) {
-  z80_clock_inc(4);
+static void ei_nop(z80_t *z) {
 }
 
 /************************************************************************/
 
-static void ei_or_r(void) {
+static void ei_or_r(z80_t *z) {
   uint8_t res;
 
-  res=_or8(cpus.r[rA],cpus.r[opcode & 0x07]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_or8(z, z->cpus.r[rA],z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_or_N(void) {
+static void ei_or_N(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_or8(cpus.r[rA],op);
-  cpus.r[rA]=res;
+  op=z80_iget8(z);
 
-  z80_clock_inc(7);
+  res=_or8(z, z->cpus.r[rA],op);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_or_iHL(void) {
+static void ei_or_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_or8(cpus.r[rA],_iHL8());
-  cpus.r[rA]=res;
-
-  z80_clock_inc(7);
+  res=_or8(z, z->cpus.r[rA],_iHL8(z));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_or_iIXN(void) {
+static void ei_or_iIXN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_or8(cpus.r[rA],_iIXN8(op));
-  cpus.r[rA]=res;
+  op=z80_iget8(z);
 
-  z80_clock_inc(15);
+  res=_or8(z, z->cpus.r[rA],_iIXN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_or_iIYN(void) {
+static void ei_or_iIYN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_or8(cpus.r[rA],_iIYN8(op));
-  cpus.r[rA]=res;
-
-  z80_clock_inc(15);
+  res=_or8(z, z->cpus.r[rA],_iIYN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
 /************************************************************************/
 
-static void ei_out_iN_A(void) {
+static void ei_out_iN_A(z80_t *z) {
   uint16_t op;
 
-  op=z80_iget8();
-
-  _out8(((uint16_t)cpus.r[rA]<<8)|(uint16_t)op,cpus.r[rA]);
+  op=z80_iget8(z);
 
-  z80_clock_inc(11);
+  _out8(z, ((uint16_t)z->cpus.r[rA]<<8)|(uint16_t)op,z->cpus.r[rA]);
 }
 
-static void Ui_out_iC_0(void) {
+static void Ui_out_iC_0(z80_t *z) {
 
 //  printf("ei_out_iC_0 (unsupported)\n");
-  _out8(getBC(),0);
+  _out8(z, getBC(z),0);
 
-  uoc++;
-  z80_clock_inc(12);
+  z->uoc++;
 }
 
-static void ei_out_iC_A(void) {
+static void ei_out_iC_A(z80_t *z) {
 
-  _out8(getBC(),cpus.r[rA]);
-  z80_clock_inc(12);
+  _out8(z, getBC(z),z->cpus.r[rA]);
 }
 
-static void ei_out_iC_B(void) {
+static void ei_out_iC_B(z80_t *z) {
 
-  _out8(getBC(),cpus.r[rB]);
-  z80_clock_inc(12);
+  _out8(z, getBC(z),z->cpus.r[rB]);
 }
 
-static void ei_out_iC_C(void) {
+static void ei_out_iC_C(z80_t *z) {
 
-  _out8(getBC(),cpus.r[rC]);
-  z80_clock_inc(12);
+  _out8(z, getBC(z),z->cpus.r[rC]);
 }
 
-static void ei_out_iC_D(void) {
+static void ei_out_iC_D(z80_t *z) {
 
-  _out8(getBC(),cpus.r[rD]);
-  z80_clock_inc(12);
+  _out8(z, getBC(z),z->cpus.r[rD]);
 }
 
-static void ei_out_iC_E(void) {
+static void ei_out_iC_E(z80_t *z) {
 
-  _out8(getBC(),cpus.r[rE]);
-  z80_clock_inc(12);
+  _out8(z, getBC(z),z->cpus.r[rE]);
 }
 
-static void ei_out_iC_H(void) {
+static void ei_out_iC_H(z80_t *z) {
 
-  _out8(getBC(),cpus.r[rH]);
-  z80_clock_inc(12);
+  _out8(z, getBC(z),z->cpus.r[rH]);
 }
 
-static void ei_out_iC_L(void) {
+static void ei_out_iC_L(z80_t *z) {
 
-  _out8(getBC(),cpus.r[rL]);
-  z80_clock_inc(12);
+  _out8(z, getBC(z),z->cpus.r[rL]);
 }
 
 /************************************************************************/
 
-static void ei_outd(void) {
+static void ei_outd(z80_t *z) {
   uint8_t res;
 
-  _out8(getBC(),_iHL8());
-  setHL(getHL()-1);
-  res=(cpus.r[rB]-1)&0x0f;
+  _out8(z, getBC(z),_iHL8(z));
+  setHL(z, getHL(z)-1);
+  res=(z->cpus.r[rB]-1)&0x0f;
   
-  setflags(res>>7,
+  setflags(z, res>>7,
            res==0,
-	   (cpus.r[rB]&0x0f)+1>0x0f,
+	   (z->cpus.r[rB]&0x0f)+1>0x0f,
 	   res==127,
 	   1,
 	   -1);
   /* undoc flags not affected */
 	   
-  cpus.r[rB]=res;
-  z80_clock_inc(16);
+  z->cpus.r[rB]=res;
 }
 
-static void ei_otdr(void) {
-  _out8(getBC(),_iHL8());
-  setHL(getHL()-1);
-  cpus.r[rB]--;
+static void _otdr(z80_t *z) {
+  _out8(z, getBC(z),_iHL8(z));
+  setHL(z, getHL(z)-1);
+  z->cpus.r[rB]--;
   
-  if(cpus.r[rB]==0) {
+  if(z->cpus.r[rB]==0) {
 //    printf("B==0. otdr terminated.\n");
-    setflags(0,1,0,0,1,-1);
+    setflags(z, 0,1,0,0,1,-1);
     /* undoc flags not affected */
-    z80_clock_inc(1);
   } else {
-    z80_clock_inc(21);
-    cpus.PC-=2;
+    z80_clock_inc(z, 5);
+    z->cpus.PC-=2;
   }
 }
 
-static void ei_outi(void) {
+static void ei_otdr(z80_t *z) {
+  block_run(z, _otdr);
+}
+
+static void ei_outi(z80_t *z) {
   uint8_t res;
 
-  _out8(getBC(),_iHL8());
-  setHL(getHL()+1);
-  res=(cpus.r[rB]-1)&0xff;
+  _out8(z, getBC(z),_iHL8(z));
+  setHL(z, getHL(z)+1);
+  res=(z->cpus.r[rB]-1)&0xff;
   
-  setflags(res>>7,
+  setflags(z, res>>7,
            res==0,
-	   (cpus.r[rB]&0x0f)-1<0, /* I hope */
+	   (z->cpus.r[rB]&0x0f)-1<0, /* I hope */
 	   res==127,
 	   1,
 	   -1);
   /* undoc flags not affected */
   
-  cpus.r[rB]=res;
-  z80_clock_inc(16);
+  z->cpus.r[rB]=res;
 }
 
-static void ei_otir(void) {
-  _out8(getBC(),_iHL8());
-  setHL(getHL()+1);
-  cpus.r[rB]--;
+static void _otir(z80_t *z) {
+  _out8(z, getBC(z),_iHL8(z));
+  setHL(z, getHL(z)+1);
+  z->cpus.r[rB]--;
   
-  if(cpus.r[rB]==0) {
+  if(z->cpus.r[rB]==0) {
 //    printf("B==0. otir terminated.\n");
-    setflags(0,1,0,0,1,-1);
+    setflags(z, 0,1,0,0,1,-1);
     /* undoc flags not affected */
-    z80_clock_inc(1);
   } else {
-    z80_clock_inc(21);
-    cpus.PC-=2;
+    z80_clock_inc(z, 5);
+    z->cpus.PC-=2;
   }
 }
 
+static void ei_otir(z80_t *z) {
+  block_run(z, _otir);
+}
+
 
 /************************************************************************/
 
-static void ei_pop_AF(void) {
-  setAF(_pop16());
-  z80_clock_inc(10);
+static void ei_pop_AF(z80_t *z) {
+  setAF(z, _pop16(z));
 }
 
-static void ei_pop_BC(void) {
-  setBC(_pop16());
-  z80_clock_inc(10);
+static void ei_pop_BC(z80_t *z) {
+  setBC(z, _pop16(z));
 }
 
-static void ei_pop_DE(void) {
-  setDE(_pop16());
-  z80_clock_inc(10);
+static void ei_pop_DE(z80_t *z) {
+  setDE(z, _pop16(z));
 }
 
-static void ei_pop_HL(void) {
-  setHL(_pop16());
-  z80_clock_inc(10);
+static void ei_pop_HL(z80_t *z) {
+  setHL(z, _pop16(z));
 }
 
-static void ei_pop_IX(void) {
-  cpus.IX=_pop16();
-  z80_clock_inc(10);
+static void ei_pop_IX(z80_t *z) {
+  z->cpus.IX=_pop16(z);
 }
 
-static void ei_pop_IY(void) {
-  cpus.IY=_pop16();
-  z80_clock_inc(10);
+static void ei_pop_IY(z80_t *z) {
+  z->cpus.IY=_pop16(z);
 }
 
-static void ei_push_AF(void) {
-  _push16(getAF());
-  z80_clock_inc(11);
+static void ei_push_AF(z80_t *z) {
+  _push16(z, getAF(z));
 }
 
-static void ei_push_BC(void) {
-  _push16(getBC());
-  z80_clock_inc(11);
+static void ei_push_BC(z80_t *z) {
+  _push16(z, getBC(z));
 }
 
-static void ei_push_DE(void) {
-  _push16(getDE());
-  z80_clock_inc(11);
+static void ei_push_DE(z80_t *z) {
+  _push16(z, getDE(z));
 }
 
-static void ei_push_HL(void) {
-  _push16(getHL());
-  z80_clock_inc(11);
+static void ei_push_HL(z80_t *z) {
+  _push16(z, getHL(z));
 }
 
-static void ei_push_IX(void) {
-  _push16(cpus.IX);
-  z80_clock_inc(11);
+static void ei_push_IX(z80_t *z) {
+  _push16(z, z->cpus.IX);
 }
 
-static void ei_push_IY(void) {
-  _push16(cpus.IY);
-  z80_clock_inc(11);
+static void ei_push_IY(z80_t *z) {
+  _push16(z, z->cpus.IY);
 }
 
 /************************************************************************/
 
-static void ei_res_b_r(void) {
+static void ei_res_b_r(z80_t *z) {
   uint8_t res;
 
-  res=_res8((opcode>>3)&0x07,cpus.r[opcode & 0x07]);
-  cpus.r[opcode & 0x07]=res;
-
-  z80_clock_inc(8);
+  res=_res8((z->opcode>>3)&0x07,z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 }
 
-static void ei_res_b_iHL(void) {
+static void ei_res_b_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_res8((opcode>>3)&0x07,_iHL8());
-  s_iHL8(res);
-
-  z80_clock_inc(15);
+  res=_res8((z->opcode>>3)&0x07,_iHL8(z));
+  s_iHL8(z, res);
 }
 
 /* DDCB ! */
-static void ei_res_b_iIXN(void) {
+static void ei_res_b_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_res8((opcode>>3)&0x07,_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_res8((z->opcode>>3)&0x07,_iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
 }
 
 /* FDCB ! */
-static void ei_res_b_iIYN(void) {
+static void ei_res_b_iIYN(z80_t *z) {
    uint8_t res;
 
-  res=_res8((opcode>>3)&0x07,_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_res8((z->opcode>>3)&0x07,_iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
 }
 
 /************************************************************************/
 
-static void ei_ret(void) {
-  cpus.PC=_pop16();
-  z80_clock_inc(10);
+static void ei_ret(z80_t *z) {
+  z->cpus.PC=_pop16(z);
 }
 
-static void ei_ret_C(void) {
-  if(cpus.F & fC) {
-    cpus.PC=_pop16();
-    z80_clock_inc(11);
-  } else z80_clock_inc(5);
+static void ei_ret_C(z80_t *z) {
+  if(flag_c(z)) {
+    z->cpus.PC=_pop16(z);
+    z80_clock_inc(z, 6);
+  }
 }
 
-static void ei_ret_NC(void) {
-  if(!(cpus.F & fC)) {
-    cpus.PC=_pop16();
-    z80_clock_inc(11);
-  } else z80_clock_inc(5);
+static void ei_ret_NC(z80_t *z) {
+  if(!flag_c(z)) {
+    z->cpus.PC=_pop16(z);
+    z80_clock_inc(z, 6);
+  }
 }
 
-static void ei_ret_M(void) {
-  if(cpus.F & fS) {
-    cpus.PC=_pop16();
-    z80_clock_inc(11);
-  } else z80_clock_inc(5);
+static void ei_ret_M(z80_t *z) {
+  if(flag_s(z)) {
+    z->cpus.PC=_pop16(z);
+    z80_clock_inc(z, 6);
+  }
 }
 
-static void ei_ret_P(void) {
-  if(!(cpus.F & fS)) {
-    cpus.PC=_pop16();
-    z80_clock_inc(11);
-  } else z80_clock_inc(5);
+static void ei_ret_P(z80_t *z) {
+  if(!flag_s(z)) {
+    z->cpus.PC=_pop16(z);
+    z80_clock_inc(z, 6);
+  }
 }
 
 
-static void ei_ret_Z(void) {
-  if(cpus.F & fZ) {
-    cpus.PC=_pop16();
-    z80_clock_inc(11);
-  } else z80_clock_inc(5);
+static void ei_ret_Z(z80_t *z) {
+  if(flag_z(z)) {
+    z->cpus.PC=_pop16(z);
+    z80_clock_inc(z, 6);
+  }
 }
 
-static void ei_ret_NZ(void) {
-  if(!(cpus.F & fZ)) {
-    cpus.PC=_pop16();
-    z80_clock_inc(11);
-  } else z80_clock_inc(5);
+static void ei_ret_NZ(z80_t *z) {
+  if(!flag_z(z)) {
+    z->cpus.PC=_pop16(z);
+    z80_clock_inc(z, 6);
+  }
 }
 
-static void ei_ret_PE(void) {
-  if(cpus.F & fPV) {
-    cpus.PC=_pop16();
-    z80_clock_inc(11);
-  } else z80_clock_inc(5);
+static void ei_ret_PE(z80_t *z) {
+  if(flag_pv(z)) {
+    z->cpus.PC=_pop16(z);
+    z80_clock_inc(z, 6);
+  }
 }
 
-static void ei_ret_PO(void) {
-  if(!(cpus.F & fPV)) {
-    cpus.PC=_pop16();
-    z80_clock_inc(11);
-  } else z80_clock_inc(5);
+static void ei_ret_PO(z80_t *z) {
+  if(!flag_pv(z)) {
+    z->cpus.PC=_pop16(z);
+    z80_clock_inc(z, 6);
+  }
 }
 
 /************************************************************************/
 
-static void ei_reti(void) {
-  cpus.IFF1=cpus.IFF2;
-  cpus.PC=_pop16();
-  z80_clock_inc(14);
+static void ei_reti(z80_t *z) {
+  z->cpus.IFF1=z->cpus.IFF2;
+  z->cpus.PC=_pop16(z);
 }
 
 
-static void ei_retn(void) {
-  cpus.IFF1=cpus.IFF2;
-  cpus.PC=_pop16();
-  z80_clock_inc(14);
+static void ei_retn(z80_t *z) {
+  z->cpus.IFF1=z->cpus.IFF2;
+  z->cpus.PC=_pop16(z);
 }
 
 /************************************************************************/
 
-static void ei_rla(void) {
+static void ei_rla(z80_t *z) {
   uint8_t res;
 
-  res=_rla8(cpus.r[rA]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_rla8(z, z->cpus.r[rA]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_rl_r(void) {
+static void ei_rl_r(z80_t *z) {
   uint8_t res;
 
-  res=_rl8(cpus.r[opcode & 0x07]);
-  cpus.r[opcode & 0x07]=res;
-
-  z80_clock_inc(8);
+  res=_rl8(z, z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 }
 
-static void ei_rl_iHL(void) {
+static void ei_rl_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_rl8(_iHL8());
-  s_iHL8(res);
-
-  z80_clock_inc(15);
+  res=_rl8(z, _iHL8(z));
+  s_iHL8(z, res);
 }
 
 /* DDCB */
-static void ei_rl_iIXN(void) {
+static void ei_rl_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_rl8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_rl8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
 }
 
 /* FDCB */
-static void ei_rl_iIYN(void) {
+static void ei_rl_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_rl8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_rl8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
 }
 
-static void ei_rlca(void) {
+static void ei_rlca(z80_t *z) {
   uint8_t res;
 
-  res=_rlca8(cpus.r[rA]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_rlca8(z, z->cpus.r[rA]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_rlc_r(void) {
+static void ei_rlc_r(z80_t *z) {
   uint8_t res;
 
-  res=_rlc8(cpus.r[opcode & 0x07]);
-  cpus.r[opcode & 0x07]=res;
-
-  z80_clock_inc(8);
+  res=_rlc8(z, z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 }
 
-static void ei_rlc_iHL(void) {
+static void ei_rlc_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_rlc8(_iHL8());
-  s_iHL8(res);
-
-  z80_clock_inc(15);
+  res=_rlc8(z, _iHL8(z));
+  s_iHL8(z, res);
 }
 
 /* DDCB */
-static void ei_rlc_iIXN(void) {
+static void ei_rlc_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_rlc8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_rlc8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
 }
 
 /* FDCB */
-static void ei_rlc_iIYN(void) {
+static void ei_rlc_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_rlc8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_rlc8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
 }
 
-static void ei_rld(void) {
+static void ei_rld(z80_t *z) {
   uint8_t tmp,tmp2,tmp3;
 
-  tmp=cpus.r[rA] & 0x0f;
-  tmp2=_iHL8();
+  tmp=z->cpus.r[rA] & 0x0f;
+  tmp2=_iHL8(z);
   tmp3=tmp2>>4;
   tmp2=(tmp2<<4)|tmp;
-  cpus.r[rA]=(cpus.r[rA] & 0xf0)| tmp3;
-  s_iHL8(tmp2);
+  z->cpus.r[rA]=(z->cpus.r[rA] & 0xf0)| tmp3;
+  s_iHL8(z, tmp2);
   
-  cpus.F=(cpus.F&fC)|ox_tab[cpus.r[rA]];
-
-  z80_clock_inc(18);
+  setF(z, (flag_c(z)?fC:0)|ox_tab[z->cpus.r[rA]]);
 }
 
-static void ei_rra(void) {
+static void ei_rra(z80_t *z) {
   uint8_t res;
 
-  res=_rra8(cpus.r[rA]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_rra8(z, z->cpus.r[rA]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_rr_r(void) {
+static void ei_rr_r(z80_t *z) {
   uint8_t res;
 
-  res=_rr8(cpus.r[opcode & 0x07]);
-  cpus.r[opcode & 0x07]=res;
-
-  z80_clock_inc(8);
+  res=_rr8(z, z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 }
 
-static void ei_rr_iHL(void) {
+static void ei_rr_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_rr8(_iHL8());
-  s_iHL8(res);
-
-  z80_clock_inc(15);
+  res=_rr8(z, _iHL8(z));
+  s_iHL8(z, res);
 }
 
 /* DDCB */
-static void ei_rr_iIXN(void) {
+static void ei_rr_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_rr8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_rr8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
 }
 
 /* FDCB */
-static void ei_rr_iIYN(void) {
+static void ei_rr_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_rr8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_rr8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
 }
 
-static void ei_rrca(void) {
+static void ei_rrca(z80_t *z) {
   uint8_t res;
 
-  res=_rrca8(cpus.r[rA]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_rrca8(z, z->cpus.r[rA]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_rrc_r(void) {
+static void ei_rrc_r(z80_t *z) {
   uint8_t res;
 
-  res=_rrc8(cpus.r[opcode & 0x07]);
-  cpus.r[opcode & 0x07]=res;
-
-  z80_clock_inc(8);
+  res=_rrc8(z, z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 }
 
-static void ei_rrc_iHL(void) {
+static void ei_rrc_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_rrc8(_iHL8());
-  s_iHL8(res);
-
-  z80_clock_inc(15);
+  res=_rrc8(z, _iHL8(z));
+  s_iHL8(z, res);
 }
 
 /* DDCB */
-static void ei_rrc_iIXN(void) {
+static void ei_rrc_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_rrc8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_rrc8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
 }
 
 /* FDCB */
-static void ei_rrc_iIYN(void) {
+static void ei_rrc_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_rrc8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_rrc8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
 }
 
-static void ei_rrd(void) {
+static void ei_rrd(z80_t *z) {
   uint8_t tmp,tmp2,tmp3;
 
-  tmp=cpus.r[rA] & 0x0f;
-  tmp2=_iHL8();
+  tmp=z->cpus.r[rA] & 0x0f;
+  tmp2=_iHL8(z);
   tmp3=tmp2 & 0x0f;
   tmp2=(tmp2>>4)|(tmp<<4);
-  cpus.r[rA]=(cpus.r[rA] & 0xf0)| tmp3;
-  s_iHL8(tmp2);
+  z->cpus.r[rA]=(z->cpus.r[rA] & 0xf0)| tmp3;
+  s_iHL8(z, tmp2);
   
-  cpus.F=(cpus.F&fC)|ox_tab[cpus.r[rA]];
-
-  z80_clock_inc(18);
+  setF(z, (flag_c(z)?fC:0)|ox_tab[z->cpus.r[rA]]);
 }
 
 /************************************************************************/
 
-static void ei_rst_0(void) {
-  _call16(0x0000);
-  z80_clock_inc(11);
+static void ei_rst_0(z80_t *z) {
+  _call16(z, 0x0000);
 }
 
-static void ei_rst_8(void) {
-  _call16(0x0008);
-  z80_clock_inc(11);
+static void ei_rst_8(z80_t *z) {
+  _call16(z, 0x0008);
 }
 
-static void ei_rst_10(void) {
-  _call16(0x0010);
-  z80_clock_inc(11);
+static void ei_rst_10(z80_t *z) {
+  _call16(z, 0x0010);
 }
 
-static void ei_rst_18(void) {
-  _call16(0x0018);
-  z80_clock_inc(11);
+static void ei_rst_18(z80_t *z) {
+  _call16(z, 0x0018);
 }
 
-static void ei_rst_20(void) {
-  _call16(0x0020);
-  z80_clock_inc(11);
+static void ei_rst_20(z80_t *z) {
+  _call16(z, 0x0020);
 }
 
-static void ei_rst_28(void) {
-  _call16(0x0028);
-  z80_clock_inc(11);
+static void ei_rst_28(z80_t *z) {
+  _call16(z, 0x0028);
 }
 
-static void ei_rst_30(void) {
-  _call16(0x0030);
-  z80_clock_inc(11);
+static void ei_rst_30(z80_t *z) {
+  _call16(z, 0x0030);
 }
 
-static void ei_rst_38(void) {
-  _call16(0x0038);
-  z80_clock_inc(11);
+static void ei_rst_38(z80_t *z) {
+  _call16(z, 0x0038);
 }
 
 /************************************************************************/
 
-static void ei_sbc_A_r(void) {
+static void ei_sbc_A_r(z80_t *z) {
   uint8_t res;
 
-  res=_sbc8(cpus.r[rA],cpus.r[opcode & 0x07]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_sbc8(z, z->cpus.r[rA],z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_sbc_A_N(void) {
+static void ei_sbc_A_N(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_sbc8(cpus.r[rA],op);
-  cpus.r[rA]=res;
+  op=z80_iget8(z);
 
-  z80_clock_inc(7);
+  res=_sbc8(z, z->cpus.r[rA],op);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_sbc_A_iHL(void) {
+static void ei_sbc_A_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_sbc8(cpus.r[rA],_iHL8());
-  cpus.r[rA]=res;
-
-  z80_clock_inc(7);
+  res=_sbc8(z, z->cpus.r[rA],_iHL8(z));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_sbc_A_iIXN(void) {
+static void ei_sbc_A_iIXN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_sbc8(cpus.r[rA],_iIXN8(op));
-  cpus.r[rA]=res;
+  op=z80_iget8(z);
 
-  z80_clock_inc(15);
+  res=_sbc8(z, z->cpus.r[rA],_iIXN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_sbc_A_iIYN(void) {
+static void ei_sbc_A_iIYN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_sbc8(cpus.r[rA],_iIYN8(op));
-  cpus.r[rA]=res;
-
-  z80_clock_inc(15);
+  res=_sbc8(z, z->cpus.r[rA],_iIYN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_sbc_HL_BC(void) {
+static void ei_sbc_HL_BC(z80_t *z) {
   uint16_t res;
 
-  res=_sbc16(getHL(),getBC());
-  setHL(res);
-
-  z80_clock_inc(15);
+  res=_sbc16(z, getHL(z),getBC(z));
+  setHL(z, res);
 }
 
-static void ei_sbc_HL_DE(void) {
+static void ei_sbc_HL_DE(z80_t *z) {
   uint16_t res;
 
-  res=_sbc16(getHL(),getDE());
-  setHL(res);
-
-  z80_clock_inc(15);
+  res=_sbc16(z, getHL(z),getDE(z));
+  setHL(z, res);
 }
 
-static void ei_sbc_HL_HL(void) {
+static void ei_sbc_HL_HL(z80_t *z) {
   uint16_t res;
 
-  res=_sbc16(getHL(),getHL());
-  setHL(res);
-
-  z80_clock_inc(15);
+  res=_sbc16(z, getHL(z),getHL(z));
+  setHL(z, res);
 }
 
-static void ei_sbc_HL_SP(void) {
+static void ei_sbc_HL_SP(z80_t *z) {
   uint16_t res;
 
-  res=_sbc16(getHL(),cpus.SP);
-  setHL(res);
-
-  z80_clock_inc(15);
+  res=_sbc16(z, getHL(z),z->cpus.SP);
+  setHL(z, res);
 }
 
 
 /************************************************************************/
 
-static void ei_scf(void) {
-  setflags(-1,-1,0,-1,0,1);
-  setundocflags8(cpus.r[rA]);
-  z80_clock_inc(4);
+static void ei_scf(z80_t *z) {
+  setflags(z, -1,-1,0,-1,0,1);
+  setundocflags8(z, z->cpus.r[rA]);
 }
 
 /************************************************************************/
 
-static void ei_set_b_r(void) {
+static void ei_set_b_r(z80_t *z) {
   uint8_t res;
 
-  res=_set8((opcode>>3)&0x07,cpus.r[opcode & 0x07]);
-  cpus.r[opcode & 0x07]=res;
-
-  z80_clock_inc(8);
+  res=_set8((z->opcode>>3)&0x07,z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 }
 
-static void ei_set_b_iHL(void) {
+static void ei_set_b_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_set8((opcode>>3)&0x07,_iHL8());
-  s_iHL8(res);
-
-  z80_clock_inc(15);
+  res=_set8((z->opcode>>3)&0x07,_iHL8(z));
+  s_iHL8(z, res);
 }
 
 /* DDCB ! */
-static void ei_set_b_iIXN(void) {
+static void ei_set_b_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_set8((opcode>>3)&0x07,_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_set8((z->opcode>>3)&0x07,_iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
 }
 
 /* FDCB ! */
-static void ei_set_b_iIYN(void) {
+static void ei_set_b_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_set8((opcode>>3)&0x07,_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_set8((z->opcode>>3)&0x07,_iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
 }
 
 /************************************************************************/
 
-static void ei_sla_r(void) {
+static void ei_sla_r(z80_t *z) {
   uint8_t res;
 
-  res=_sla8(cpus.r[opcode & 0x07]);
-  cpus.r[opcode & 0x07]=res;
-
-  z80_clock_inc(8);
+  res=_sla8(z, z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 }
 
-static void ei_sla_iHL(void) {
+static void ei_sla_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_sla8(_iHL8());
-  s_iHL8(res);
-
-  z80_clock_inc(15);
+  res=_sla8(z, _iHL8(z));
+  s_iHL8(z, res);
 }
 
 /* DDCB */
-static void ei_sla_iIXN(void) {
+static void ei_sla_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_sla8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_sla8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
 }
 
 /* FDCB */
-static void ei_sla_iIYN(void) {
+static void ei_sla_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_sla8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_sla8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
 }
 
-static void ei_sra_r(void) {
+static void ei_sra_r(z80_t *z) {
   uint8_t res;
 
-  res=_sra8(cpus.r[opcode & 0x07]);
-  cpus.r[opcode & 0x07]=res;
-
-  z80_clock_inc(8);
+  res=_sra8(z, z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 }
 
-static void ei_sra_iHL(void) {
+static void ei_sra_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_sra8(_iHL8());
-  s_iHL8(res);
-
-  z80_clock_inc(15);
+  res=_sra8(z, _iHL8(z));
+  s_iHL8(z, res);
 }
 
 /* DDCB */
-static void ei_sra_iIXN(void) {
+static void ei_sra_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_sra8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_sra8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
 }
 
 /* FDCB */
-static void ei_sra_iIYN(void) {
+static void ei_sra_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_sra8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_sra8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
 }
 
 /************************************************************************/
 
 #ifndef NO_Z80UNDOC
 
-static void Ui_sll_r(void) {
+static void Ui_sll_r(z80_t *z) {
   uint8_t res;
 
-  res=_sll8(cpus.r[opcode & 0x07]);
-  cpus.r[opcode & 0x07]=res;
+  res=_sll8(z, z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  uoc++;
-  z80_clock_inc(8);
+  z->uoc++;
 }
 
-static void Ui_sll_iHL(void) {
+static void Ui_sll_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_sll8(_iHL8());
-  s_iHL8(res);
+  res=_sll8(z, _iHL8(z));
+  s_iHL8(z, res);
 
-  uoc++;
-  z80_clock_inc(15);
+  z->uoc++;
 }
 
 /* DDCB */
-static void Ui_sll_iIXN(void) {
+static void Ui_sll_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_sll8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
+  res=_sll8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
 
-  uoc++;
-  z80_clock_inc(19);
+  z->uoc++;
 }
 
 /* FDCB */
-static void Ui_sll_iIYN(void) {
+static void Ui_sll_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_sll8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
+  res=_sll8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
 
-  uoc++;
-  z80_clock_inc(19);
+  z->uoc++;
 }
 
 #else
@@ -3804,149 +3692,121 @@ static void Ui_sll_iIYN(void) {
 
 #endif
 
-static void ei_srl_r(void) {
+static void ei_srl_r(z80_t *z) {
   uint8_t res;
 
-  res=_srl8(cpus.r[opcode & 0x07]);
-  cpus.r[opcode & 0x07]=res;
-
-  z80_clock_inc(8);
+  res=_srl8(z, z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 }
 
-static void ei_srl_iHL(void) {
+static void ei_srl_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_srl8(_iHL8());
-  s_iHL8(res);
-
-  z80_clock_inc(15);
+  res=_srl8(z, _iHL8(z));
+  s_iHL8(z, res);
 }
 
 /* DDCB */
-static void ei_srl_iIXN(void) {
+static void ei_srl_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_srl8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_srl8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
 }
 
 /* FDCB */
-static void ei_srl_iIYN(void) {
+static void ei_srl_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_srl8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-
-  z80_clock_inc(19);
+  res=_srl8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
 }
 
 /************************************************************************/
 
-static void ei_sub_r(void) {
+static void ei_sub_r(z80_t *z) {
   uint8_t res;
 
-  res=_sub8(cpus.r[rA],cpus.r[opcode & 0x07]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_sub8(z, z->cpus.r[rA],z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_sub_N(void) {
+static void ei_sub_N(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_sub8(cpus.r[rA],op);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(7);
+  res=_sub8(z, z->cpus.r[rA],op);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_sub_iHL(void) {
+static void ei_sub_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_sub8(cpus.r[rA],_iHL8());
-  cpus.r[rA]=res;
-
-  z80_clock_inc(7);
+  res=_sub8(z, z->cpus.r[rA],_iHL8(z));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_sub_iIXN(void) {
+static void ei_sub_iIXN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_sub8(cpus.r[rA],_iIXN8(op));
-  cpus.r[rA]=res;
-
-  z80_clock_inc(15);
+  res=_sub8(z, z->cpus.r[rA],_iIXN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_sub_iIYN(void) {
+static void ei_sub_iIYN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_sub8(cpus.r[rA],_iIYN8(op));
-  cpus.r[rA]=res;
+  op=z80_iget8(z);
 
-  z80_clock_inc(15);
+  res=_sub8(z, z->cpus.r[rA],_iIYN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
 
 /************************************************************************/
 
-static void ei_xor_r(void) {
+static void ei_xor_r(z80_t *z) {
   uint8_t res;
 
-  res=_xor8(cpus.r[rA],cpus.r[opcode & 0x07]);
-  cpus.r[rA]=res;
-
-  z80_clock_inc(4);
+  res=_xor8(z, z->cpus.r[rA],z->cpus.r[Z80_REG8(z->opcode & 0x07)]);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_xor_N(void) {
+static void ei_xor_N(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_xor8(cpus.r[rA],op);
-  cpus.r[rA]=res;
+  op=z80_iget8(z);
 
-  z80_clock_inc(7);
+  res=_xor8(z, z->cpus.r[rA],op);
+  z->cpus.r[rA]=res;
 }
 
-static void ei_xor_iHL(void) {
+static void ei_xor_iHL(z80_t *z) {
   uint8_t res;
 
-  res=_xor8(cpus.r[rA],_iHL8());
-  cpus.r[rA]=res;
-
-  z80_clock_inc(7);
+  res=_xor8(z, z->cpus.r[rA],_iHL8(z));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_xor_iIXN(void) {
+static void ei_xor_iIXN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
-
-  res=_xor8(cpus.r[rA],_iIXN8(op));
-  cpus.r[rA]=res;
+  op=z80_iget8(z);
 
-  z80_clock_inc(15);
+  res=_xor8(z, z->cpus.r[rA],_iIXN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
-static void ei_xor_iIYN(void) {
+static void ei_xor_iIYN(z80_t *z) {
   uint8_t res,op;
 
-  op=z80_iget8();
+  op=z80_iget8(z);
 
-  res=_xor8(cpus.r[rA],_iIYN8(op));
-  cpus.r[rA]=res;
-
-  z80_clock_inc(15);
+  res=_xor8(z, z->cpus.r[rA],_iIYN8(z, op));
+  z->cpus.r[rA]=res;
 }
 
 /************************ undocumented opcodes ****************************/
@@ -3954,1140 +3814,1134 @@ static void ei_xor_iIYN(void) {
 
 #ifndef NO_Z80UNDOC
 
-static void Ui_inc_IXh(void) {
+static void Ui_inc_IXh(z80_t *z) {
   uint8_t res;
 
-  res=_inc8(getIXh());
-  setIXh(res);
+  res=_inc8(z, getIXh(z));
+  setIXh(z, res);
 
-  z80_clock_inc(4); /* timing&flags taken from inc_A */
-  uoc++;
+  /* flags taken from inc_A */
+  z->uoc++;
 }
 
-static void Ui_dec_IXh(void) {
+static void Ui_dec_IXh(z80_t *z) {
   uint8_t res;
 
-  res=_dec8(getIXh());
-  setIXh(res);
+  res=_dec8(z, getIXh(z));
+  setIXh(z, res);
 
-  z80_clock_inc(4); /* timing&flags taken from dec_A */
-  uoc++;
+  /* flags taken from dec_A */
+  z->uoc++;
 }
 
-static void Ui_ld_IXh_N(void) {
+static void Ui_ld_IXh_N(z80_t *z) {
   uint8_t res;
 
-  res=z80_iget8();
-  setIXh(res);
+  res=z80_iget8(z);
+  setIXh(z, res);
 
-  z80_clock_inc(7); /* timing&flags taken from ld_A_N */
-  uoc++;
+  /* flags taken from ld_A_N */
+  z->uoc++;
 }
 
-static void Ui_inc_IXl(void) {
+static void Ui_inc_IXl(z80_t *z) {
   uint8_t res;
 
-  res=_inc8(getIXl());
-  setIXl(res);
+  res=_inc8(z, getIXl(z));
+  setIXl(z, res);
 
-  z80_clock_inc(4); /* timing&flags taken from inc_A */
-  uoc++;
+  /* flags taken from inc_A */
+  z->uoc++;
 }
 
-static void Ui_dec_IXl(void) {
+static void Ui_dec_IXl(z80_t *z) {
   uint8_t res;
 
-  res=_dec8(getIXl());
-  setIXl(res);
+  res=_dec8(z, getIXl(z));
+  setIXl(z, res);
 
-  z80_clock_inc(4); /* timing&flags taken from dec_A */
-  uoc++;
+  /* flags taken from dec_A */
+  z->uoc++;
 }
 
-static void Ui_ld_IXl_N(void) {
+static void Ui_ld_IXl_N(z80_t *z) {
   uint8_t res;
 
-  res=z80_iget8();
-  setIXl(res);
+  res=z80_iget8(z);
+  setIXl(z, res);
 
-  z80_clock_inc(7); /* timing&flags taken from ld_A_N */
-  uoc++;
+  /* flags taken from ld_A_N */
+  z->uoc++;
 }
 
-static void Ui_ld_B_IXh(void) {
+static void Ui_ld_B_IXh(z80_t *z) {
 
-  cpus.r[rB]=getIXh();
+  z->cpus.r[rB]=getIXh(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_B_IXl(void) {
+static void Ui_ld_B_IXl(z80_t *z) {
 
-  cpus.r[rB]=getIXl();
+  z->cpus.r[rB]=getIXl(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_C_IXh(void) {
+static void Ui_ld_C_IXh(z80_t *z) {
 
-  cpus.r[rC]=getIXh();
+  z->cpus.r[rC]=getIXh(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_C_r */
-  uoc++;
+  /* flags taken from ld_C_r */
+  z->uoc++;
 }
 
-static void Ui_ld_C_IXl(void) {
+static void Ui_ld_C_IXl(z80_t *z) {
 
-  cpus.r[rC]=getIXl();
+  z->cpus.r[rC]=getIXl(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_C_r */
-  uoc++;
+  /* flags taken from ld_C_r */
+  z->uoc++;
 }
 
-static void Ui_ld_D_IXh(void) {
+static void Ui_ld_D_IXh(z80_t *z) {
 
-  cpus.r[rD]=getIXh();
+  z->cpus.r[rD]=getIXh(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_D_r */
-  uoc++;
+  /* flags taken from ld_D_r */
+  z->uoc++;
 }
 
-static void Ui_ld_D_IXl(void) {
+static void Ui_ld_D_IXl(z80_t *z) {
 
-  cpus.r[rD]=getIXl();
+  z->cpus.r[rD]=getIXl(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_D_r */
-  uoc++;
+  /* flags taken from ld_D_r */
+  z->uoc++;
 }
 
-static void Ui_ld_E_IXh(void) {
+static void Ui_ld_E_IXh(z80_t *z) {
 
-  cpus.r[rE]=getIXh();
+  z->cpus.r[rE]=getIXh(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_E_r */
-  uoc++;
+  /* flags taken from ld_E_r */
+  z->uoc++;
 }
 
-static void Ui_ld_E_IXl(void) {
+static void Ui_ld_E_IXl(z80_t *z) {
 
-  cpus.r[rE]=getIXl();
+  z->cpus.r[rE]=getIXl(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_E_r */
-  uoc++;
+  /* flags taken from ld_E_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXh_B(void) {
+static void Ui_ld_IXh_B(z80_t *z) {
 
-  setIXh(cpus.r[rB]);
+  setIXh(z, z->cpus.r[rB]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXh_C(void) {
+static void Ui_ld_IXh_C(z80_t *z) {
 
-  setIXh(cpus.r[rC]);
+  setIXh(z, z->cpus.r[rC]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXh_D(void) {
+static void Ui_ld_IXh_D(z80_t *z) {
 
-  setIXh(cpus.r[rD]);
+  setIXh(z, z->cpus.r[rD]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXh_E(void) {
+static void Ui_ld_IXh_E(z80_t *z) {
 
-  setIXh(cpus.r[rE]);
+  setIXh(z, z->cpus.r[rE]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXh_IXh(void) {
+static void Ui_ld_IXh_IXh(z80_t *z) {
 
   /* does nothing */
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXh_IXl(void) {
+static void Ui_ld_IXh_IXl(z80_t *z) {
 
-  setIXh(getIXl());
+  setIXh(z, getIXl(z));
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXh_A(void) {
+static void Ui_ld_IXh_A(z80_t *z) {
 
-  setIXh(cpus.r[rA]);
+  setIXh(z, z->cpus.r[rA]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXl_B(void) {
+static void Ui_ld_IXl_B(z80_t *z) {
 
-  setIXl(cpus.r[rB]);
+  setIXl(z, z->cpus.r[rB]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXl_C(void) {
+static void Ui_ld_IXl_C(z80_t *z) {
 
-  setIXl(cpus.r[rC]);
+  setIXl(z, z->cpus.r[rC]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXl_D(void) {
+static void Ui_ld_IXl_D(z80_t *z) {
 
-  setIXl(cpus.r[rD]);
+  setIXl(z, z->cpus.r[rD]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXl_E(void) {
+static void Ui_ld_IXl_E(z80_t *z) {
 
-  setIXl(cpus.r[rE]);
+  setIXl(z, z->cpus.r[rE]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXl_IXh(void) {
+static void Ui_ld_IXl_IXh(z80_t *z) {
 
-  setIXl(getIXh());
+  setIXl(z, getIXh(z));
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXl_IXl(void) {
+static void Ui_ld_IXl_IXl(z80_t *z) {
 
   /* does nothing */
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IXl_A(void) {
+static void Ui_ld_IXl_A(z80_t *z) {
 
-  setIXl(cpus.r[rA]);
+  setIXl(z, z->cpus.r[rA]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_A_IXh(void) {
+static void Ui_ld_A_IXh(z80_t *z) {
 
-  cpus.r[rA]=getIXh();
+  z->cpus.r[rA]=getIXh(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_A_IXl(void) {
+static void Ui_ld_A_IXl(z80_t *z) {
 
-  cpus.r[rA]=getIXl();
+  z->cpus.r[rA]=getIXl(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
 /***********************************************************************/
 
-static void Ui_add_A_IXh(void) {
+static void Ui_add_A_IXh(z80_t *z) {
   uint8_t res;
 
-  res=_add8(cpus.r[rA],getIXh());
-  cpus.r[rA]=res;
+  res=_add8(z, z->cpus.r[rA],getIXh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from add_A_r */
-  uoc++;
+  /* flags taken from add_A_r */
+  z->uoc++;
 }
 
-static void Ui_add_A_IXl(void) {
+static void Ui_add_A_IXl(z80_t *z) {
   uint8_t res;
 
-  res=_add8(cpus.r[rA],getIXl());
-  cpus.r[rA]=res;
+  res=_add8(z, z->cpus.r[rA],getIXl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from add_A_r */
-  uoc++;
+  /* flags taken from add_A_r */
+  z->uoc++;
 }
 
-static void Ui_adc_A_IXh(void) {
+static void Ui_adc_A_IXh(z80_t *z) {
   uint8_t res;
 
-  res=_adc8(cpus.r[rA],getIXh());
-  cpus.r[rA]=res;
+  res=_adc8(z, z->cpus.r[rA],getIXh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from adc_A_r */
-  uoc++;
+  /* flags taken from adc_A_r */
+  z->uoc++;
 }
 
-static void Ui_adc_A_IXl(void) {
+static void Ui_adc_A_IXl(z80_t *z) {
   uint8_t res;
 
-  res=_adc8(cpus.r[rA],getIXl());
-  cpus.r[rA]=res;
+  res=_adc8(z, z->cpus.r[rA],getIXl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from adc_A_r */
-  uoc++;
+  /* flags taken from adc_A_r */
+  z->uoc++;
 }
 
-static void Ui_sub_IXh(void) {
+static void Ui_sub_IXh(z80_t *z) {
   uint8_t res;
 
-  res=_sub8(cpus.r[rA],getIXh());
-  cpus.r[rA]=res;
+  res=_sub8(z, z->cpus.r[rA],getIXh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from sub_r */
-  uoc++;
+  /* flags taken from sub_r */
+  z->uoc++;
 }
 
-static void Ui_sub_IXl(void) {
+static void Ui_sub_IXl(z80_t *z) {
   uint8_t res;
 
-  res=_sub8(cpus.r[rA],getIXl());
-  cpus.r[rA]=res;
+  res=_sub8(z, z->cpus.r[rA],getIXl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from sub_r */
-  uoc++;
+  /* flags taken from sub_r */
+  z->uoc++;
 }
 
-static void Ui_sbc_IXh(void) {
+static void Ui_sbc_IXh(z80_t *z) {
   uint8_t res;
 
-  res=_sbc8(cpus.r[rA],getIXh());
-  cpus.r[rA]=res;
+  res=_sbc8(z, z->cpus.r[rA],getIXh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from sbc_r */
-  uoc++;
+  /* flags taken from sbc_r */
+  z->uoc++;
 }
 
-static void Ui_sbc_IXl(void) {
+static void Ui_sbc_IXl(z80_t *z) {
   uint8_t res;
 
-  res=_sbc8(cpus.r[rA],getIXl());
-  cpus.r[rA]=res;
+  res=_sbc8(z, z->cpus.r[rA],getIXl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from sbc_r */
-  uoc++;
+  /* flags taken from sbc_r */
+  z->uoc++;
 }
 
-static void Ui_and_IXh(void) {
+static void Ui_and_IXh(z80_t *z) {
   uint8_t res;
 
-  res=_and8(cpus.r[rA],getIXh());
-  cpus.r[rA]=res;
+  res=_and8(z, z->cpus.r[rA],getIXh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from and_r */
-  uoc++;
+  /* flags taken from and_r */
+  z->uoc++;
 }
 
-static void Ui_and_IXl(void) {
+static void Ui_and_IXl(z80_t *z) {
   uint8_t res;
 
-  res=_and8(cpus.r[rA],getIXl());
-  cpus.r[rA]=res;
+  res=_and8(z, z->cpus.r[rA],getIXl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from and_r */
-  uoc++;
+  /* flags taken from and_r */
+  z->uoc++;
 }
 
-static void Ui_xor_IXh(void) {
+static void Ui_xor_IXh(z80_t *z) {
   uint8_t res;
 
-  res=_xor8(cpus.r[rA],getIXh());
-  cpus.r[rA]=res;
+  res=_xor8(z, z->cpus.r[rA],getIXh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from xor_r */
-  uoc++;
+  /* flags taken from xor_r */
+  z->uoc++;
 }
 
-static void Ui_xor_IXl(void) {
+static void Ui_xor_IXl(z80_t *z) {
   uint8_t res;
 
-  res=_xor8(cpus.r[rA],getIXl());
-  cpus.r[rA]=res;
+  res=_xor8(z, z->cpus.r[rA],getIXl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from xor_r */
-  uoc++;
+  /* flags taken from xor_r */
+  z->uoc++;
 }
 
-static void Ui_or_IXh(void) {
+static void Ui_or_IXh(z80_t *z) {
   uint8_t res;
 
-  res=_or8(cpus.r[rA],getIXh());
-  cpus.r[rA]=res;
+  res=_or8(z, z->cpus.r[rA],getIXh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from or_r */
-  uoc++;
+  /* flags taken from or_r */
+  z->uoc++;
 }
 
-static void Ui_or_IXl(void) {
+static void Ui_or_IXl(z80_t *z) {
   uint8_t res;
 
-  res=_or8(cpus.r[rA],getIXl());
-  cpus.r[rA]=res;
+  res=_or8(z, z->cpus.r[rA],getIXl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from or_r */
-  uoc++;
+  /* flags taken from or_r */
+  z->uoc++;
 }
 
-static void Ui_cp_IXh(void) {
+static void Ui_cp_IXh(z80_t *z) {
   uint8_t res;
 
-  res=_cp8(cpus.r[rA],getIXh());
-  cpus.r[rA]=res;
+  res=_cp8(z, z->cpus.r[rA],getIXh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from cp_r */
-  uoc++;
+  /* flags taken from cp_r */
+  z->uoc++;
 }
 
-static void Ui_cp_IXl(void) {
+static void Ui_cp_IXl(z80_t *z) {
   uint8_t res;
 
-  res=_cp8(cpus.r[rA],getIXl());
-  cpus.r[rA]=res;
+  res=_cp8(z, z->cpus.r[rA],getIXl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from cp_r */
-  uoc++;
+  /* flags taken from cp_r */
+  z->uoc++;
 }
 
 /**** FD .. ***************************************************************/
 
-static void Ui_inc_IYh(void) {
+static void Ui_inc_IYh(z80_t *z) {
   uint8_t res;
 
-  res=_inc8(getIYh());
-  setIYh(res);
+  res=_inc8(z, getIYh(z));
+  setIYh(z, res);
 
-  z80_clock_inc(4); /* timing&flags taken from inc_A */
-  uoc++;
+  /* flags taken from inc_A */
+  z->uoc++;
 }
 
-static void Ui_dec_IYh(void) {
+static void Ui_dec_IYh(z80_t *z) {
   uint8_t res;
 
-  res=_dec8(getIYh());
-  setIYh(res);
+  res=_dec8(z, getIYh(z));
+  setIYh(z, res);
 
-  z80_clock_inc(4); /* timing&flags taken from dec_A */
-  uoc++;
+  /* flags taken from dec_A */
+  z->uoc++;
 }
 
-static void Ui_ld_IYh_N(void) {
+static void Ui_ld_IYh_N(z80_t *z) {
   uint8_t res;
 
-  res=z80_iget8();
-  setIYh(res);
+  res=z80_iget8(z);
+  setIYh(z, res);
 
-  z80_clock_inc(7); /* timing&flags taken from ld_A_N */
-  uoc++;
+  /* flags taken from ld_A_N */
+  z->uoc++;
 }
 
-static void Ui_inc_IYl(void) {
+static void Ui_inc_IYl(z80_t *z) {
   uint8_t res;
 
-  res=_inc8(getIYl());
-  setIYl(res);
+  res=_inc8(z, getIYl(z));
+  setIYl(z, res);
 
-  z80_clock_inc(4); /* timing&flags taken from inc_A */
-  uoc++;
+  /* flags taken from inc_A */
+  z->uoc++;
 }
 
-static void Ui_dec_IYl(void) {
+static void Ui_dec_IYl(z80_t *z) {
   uint8_t res;
 
-  res=_dec8(getIYl());
-  setIYl(res);
+  res=_dec8(z, getIYl(z));
+  setIYl(z, res);
 
-  z80_clock_inc(4); /* timing&flags taken from dec_A */
-  uoc++;
+  /* flags taken from dec_A */
+  z->uoc++;
 }
 
-static void Ui_ld_IYl_N(void) {
+static void Ui_ld_IYl_N(z80_t *z) {
   uint8_t res;
 
-  res=z80_iget8();
-  setIYl(res);
+  res=z80_iget8(z);
+  setIYl(z, res);
 
-  z80_clock_inc(7); /* timing&flags taken from ld_A_N */
-  uoc++;
+  /* flags taken from ld_A_N */
+  z->uoc++;
 }
 
-static void Ui_ld_B_IYh(void) {
+static void Ui_ld_B_IYh(z80_t *z) {
 
-  cpus.r[rB]=getIYh();
+  z->cpus.r[rB]=getIYh(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_B_IYl(void) {
+static void Ui_ld_B_IYl(z80_t *z) {
 
-  cpus.r[rB]=getIYl();
+  z->cpus.r[rB]=getIYl(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_C_IYh(void) {
+static void Ui_ld_C_IYh(z80_t *z) {
 
-  cpus.r[rC]=getIYh();
+  z->cpus.r[rC]=getIYh(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_C_r */
-  uoc++;
+  /* flags taken from ld_C_r */
+  z->uoc++;
 }
 
-static void Ui_ld_C_IYl(void) {
+static void Ui_ld_C_IYl(z80_t *z) {
 
-  cpus.r[rC]=getIYl();
+  z->cpus.r[rC]=getIYl(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_C_r */
-  uoc++;
+  /* flags taken from ld_C_r */
+  z->uoc++;
 }
 
-static void Ui_ld_D_IYh(void) {
+static void Ui_ld_D_IYh(z80_t *z) {
 
-  cpus.r[rD]=getIYh();
+  z->cpus.r[rD]=getIYh(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_D_r */
-  uoc++;
+  /* flags taken from ld_D_r */
+  z->uoc++;
 }
 
-static void Ui_ld_D_IYl(void) {
+static void Ui_ld_D_IYl(z80_t *z) {
 
-  cpus.r[rD]=getIYl();
+  z->cpus.r[rD]=getIYl(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_D_r */
-  uoc++;
+  /* flags taken from ld_D_r */
+  z->uoc++;
 }
 
-static void Ui_ld_E_IYh(void) {
+static void Ui_ld_E_IYh(z80_t *z) {
 
-  cpus.r[rE]=getIYh();
+  z->cpus.r[rE]=getIYh(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_E_r */
-  uoc++;
+  /* flags taken from ld_E_r */
+  z->uoc++;
 }
 
-static void Ui_ld_E_IYl(void) {
+static void Ui_ld_E_IYl(z80_t *z) {
 
-  cpus.r[rE]=getIYl();
+  z->cpus.r[rE]=getIYl(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_E_r */
-  uoc++;
+  /* flags taken from ld_E_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYh_B(void) {
+static void Ui_ld_IYh_B(z80_t *z) {
 
-  setIYh(cpus.r[rB]);
+  setIYh(z, z->cpus.r[rB]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYh_C(void) {
+static void Ui_ld_IYh_C(z80_t *z) {
 
-  setIYh(cpus.r[rC]);
+  setIYh(z, z->cpus.r[rC]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYh_D(void) {
+static void Ui_ld_IYh_D(z80_t *z) {
 
-  setIYh(cpus.r[rD]);
+  setIYh(z, z->cpus.r[rD]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYh_E(void) {
+static void Ui_ld_IYh_E(z80_t *z) {
 
-  setIYh(cpus.r[rE]);
+  setIYh(z, z->cpus.r[rE]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYh_IYh(void) {
+static void Ui_ld_IYh_IYh(z80_t *z) {
 
   /* does nothing */
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYh_IYl(void) {
+static void Ui_ld_IYh_IYl(z80_t *z) {
 
-  setIYh(getIYl());
+  setIYh(z, getIYl(z));
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYh_A(void) {
+static void Ui_ld_IYh_A(z80_t *z) {
 
-  setIYh(cpus.r[rA]);
+  setIYh(z, z->cpus.r[rA]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYl_B(void) {
+static void Ui_ld_IYl_B(z80_t *z) {
 
-  setIYl(cpus.r[rB]);
+  setIYl(z, z->cpus.r[rB]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYl_C(void) {
+static void Ui_ld_IYl_C(z80_t *z) {
 
-  setIYl(cpus.r[rC]);
+  setIYl(z, z->cpus.r[rC]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYl_D(void) {
+static void Ui_ld_IYl_D(z80_t *z) {
 
-  setIYl(cpus.r[rD]);
+  setIYl(z, z->cpus.r[rD]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYl_E(void) {
+static void Ui_ld_IYl_E(z80_t *z) {
 
-  setIYl(cpus.r[rE]);
+  setIYl(z, z->cpus.r[rE]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYl_IYh(void) {
+static void Ui_ld_IYl_IYh(z80_t *z) {
 
-  setIYl(getIYh());
+  setIYl(z, getIYh(z));
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYl_IYl(void) {
+static void Ui_ld_IYl_IYl(z80_t *z) {
 
   /* does nothing */
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_IYl_A(void) {
+static void Ui_ld_IYl_A(z80_t *z) {
 
-  setIYl(cpus.r[rA]);
+  setIYl(z, z->cpus.r[rA]);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_A_IYh(void) {
+static void Ui_ld_A_IYh(z80_t *z) {
 
-  cpus.r[rA]=getIYh();
+  z->cpus.r[rA]=getIYh(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
-static void Ui_ld_A_IYl(void) {
+static void Ui_ld_A_IYl(z80_t *z) {
 
-  cpus.r[rA]=getIYl();
+  z->cpus.r[rA]=getIYl(z);
 
-  z80_clock_inc(4); /* timing&flags taken from ld_B_r */
-  uoc++;
+  /* flags taken from ld_B_r */
+  z->uoc++;
 }
 
 /***********************************************************************/
 
-static void Ui_add_A_IYh(void) {
+static void Ui_add_A_IYh(z80_t *z) {
   uint8_t res;
 
-  res=_add8(cpus.r[rA],getIYh());
-  cpus.r[rA]=res;
+  res=_add8(z, z->cpus.r[rA],getIYh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from add_A_r */
-  uoc++;
+  /* flags taken from add_A_r */
+  z->uoc++;
 }
 
-static void Ui_add_A_IYl(void) {
+static void Ui_add_A_IYl(z80_t *z) {
   uint8_t res;
 
-  res=_add8(cpus.r[rA],getIYl());
-  cpus.r[rA]=res;
+  res=_add8(z, z->cpus.r[rA],getIYl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from add_A_r */
-  uoc++;
+  /* flags taken from add_A_r */
+  z->uoc++;
 }
 
-static void Ui_adc_A_IYh(void) {
+static void Ui_adc_A_IYh(z80_t *z) {
   uint8_t res;
 
-  res=_adc8(cpus.r[rA],getIYh());
-  cpus.r[rA]=res;
+  res=_adc8(z, z->cpus.r[rA],getIYh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from adc_A_r */
-  uoc++;
+  /* flags taken from adc_A_r */
+  z->uoc++;
 }
 
-static void Ui_adc_A_IYl(void) {
+static void Ui_adc_A_IYl(z80_t *z) {
   uint8_t res;
 
-  res=_adc8(cpus.r[rA],getIYl());
-  cpus.r[rA]=res;
+  res=_adc8(z, z->cpus.r[rA],getIYl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from adc_A_r */
-  uoc++;
+  /* flags taken from adc_A_r */
+  z->uoc++;
 }
 
-static void Ui_sub_IYh(void) {
+static void Ui_sub_IYh(z80_t *z) {
   uint8_t res;
 
-  res=_sub8(cpus.r[rA],getIYh());
-  cpus.r[rA]=res;
+  res=_sub8(z, z->cpus.r[rA],getIYh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from sub_r */
-  uoc++;
+  /* flags taken from sub_r */
+  z->uoc++;
 }
 
-static void Ui_sub_IYl(void) {
+static void Ui_sub_IYl(z80_t *z) {
   uint8_t res;
 
-  res=_sub8(cpus.r[rA],getIYl());
-  cpus.r[rA]=res;
+  res=_sub8(z, z->cpus.r[rA],getIYl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from sub_r */
-  uoc++;
+  /* flags taken from sub_r */
+  z->uoc++;
 }
 
-static void Ui_sbc_IYh(void) {
+static void Ui_sbc_IYh(z80_t *z) {
   uint8_t res;
 
-  res=_sbc8(cpus.r[rA],getIYh());
-  cpus.r[rA]=res;
+  res=_sbc8(z, z->cpus.r[rA],getIYh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from sbc_r */
-  uoc++;
+  /* flags taken from sbc_r */
+  z->uoc++;
 }
 
-static void Ui_sbc_IYl(void) {
+static void Ui_sbc_IYl(z80_t *z) {
   uint8_t res;
 
-  res=_sbc8(cpus.r[rA],getIYl());
-  cpus.r[rA]=res;
+  res=_sbc8(z, z->cpus.r[rA],getIYl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from sbc_r */
-  uoc++;
+  /* flags taken from sbc_r */
+  z->uoc++;
 }
 
-static void Ui_and_IYh(void) {
+static void Ui_and_IYh(z80_t *z) {
   uint8_t res;
 
-  res=_and8(cpus.r[rA],getIYh());
-  cpus.r[rA]=res;
+  res=_and8(z, z->cpus.r[rA],getIYh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from and_r */
-  uoc++;
+  /* flags taken from and_r */
+  z->uoc++;
 }
 
-static void Ui_and_IYl(void) {
+static void Ui_and_IYl(z80_t *z) {
   uint8_t res;
 
-  res=_and8(cpus.r[rA],getIYl());
-  cpus.r[rA]=res;
+  res=_and8(z, z->cpus.r[rA],getIYl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from and_r */
-  uoc++;
+  /* flags taken from and_r */
+  z->uoc++;
 }
 
-static void Ui_xor_IYh(void) {
+static void Ui_xor_IYh(z80_t *z) {
   uint8_t res;
 
-  res=_xor8(cpus.r[rA],getIYh());
-  cpus.r[rA]=res;
+  res=_xor8(z, z->cpus.r[rA],getIYh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from xor_r */
-  uoc++;
+  /* flags taken from xor_r */
+  z->uoc++;
 }
 
-static void Ui_xor_IYl(void) {
+static void Ui_xor_IYl(z80_t *z) {
   uint8_t res;
 
-  res=_xor8(cpus.r[rA],getIYl());
-  cpus.r[rA]=res;
+  res=_xor8(z, z->cpus.r[rA],getIYl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from xor_r */
-  uoc++;
+  /* flags taken from xor_r */
+  z->uoc++;
 }
 
-static void Ui_or_IYh(void) {
+static void Ui_or_IYh(z80_t *z) {
   uint8_t res;
 
-  res=_or8(cpus.r[rA],getIYh());
-  cpus.r[rA]=res;
+  res=_or8(z, z->cpus.r[rA],getIYh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from or_r */
-  uoc++;
+  /* flags taken from or_r */
+  z->uoc++;
 }
 
-static void Ui_or_IYl(void) {
+static void Ui_or_IYl(z80_t *z) {
   uint8_t res;
 
-  res=_or8(cpus.r[rA],getIYl());
-  cpus.r[rA]=res;
+  res=_or8(z, z->cpus.r[rA],getIYl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from or_r */
-  uoc++;
+  /* flags taken from or_r */
+  z->uoc++;
 }
 
-static void Ui_cp_IYh(void) {
+static void Ui_cp_IYh(z80_t *z) {
   uint8_t res;
 
-  res=_cp8(cpus.r[rA],getIYh());
-  cpus.r[rA]=res;
+  res=_cp8(z, z->cpus.r[rA],getIYh(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from cp_r */
-  uoc++;
+  /* flags taken from cp_r */
+  z->uoc++;
 }
 
-static void Ui_cp_IYl(void) {
+static void Ui_cp_IYl(z80_t *z) {
   uint8_t res;
 
-  res=_cp8(cpus.r[rA],getIYl());
-  cpus.r[rA]=res;
+  res=_cp8(z, z->cpus.r[rA],getIYl(z));
+  z->cpus.r[rA]=res;
 
-  z80_clock_inc(4); /* timing&flags taken from cp_r */
-  uoc++;
+  /* flags taken from cp_r */
+  z->uoc++;
 }
 
 /**** ED .. ***************************************************************/
 
-static void Ui_ednop(void) { /* different from ei_nop! */
-  z80_clock_inc(8); /* according to Sean it's like 2 NOPs */
-  uoc++;
+static void Ui_ednop(z80_t *z) { /* different from ei_nop! */
+  /* according to Sean it's like 2 NOPs */
+  z->uoc++;
 }
 
-static void Ui_neg(void) {               /* A <- neg(A) .. two's complement */
+static void Ui_neg(z80_t *z) {               /* A <- neg(A) .. two's complement */
   uint16_t res;
 //  printf("NEG(2c)\n");
-  res = (cpus.r[rA] ^ 0xff)+1;
-  cpus.r[rA] = res & 0xff;
-  setflags((res>>7)&1,
+  res = (z->cpus.r[rA] ^ 0xff)+1;
+  z->cpus.r[rA] = res & 0xff;
+  setflags(z, (res>>7)&1,
 	   (res&0xff)==0,
 	   (res&0x0f)==0,        /* not sure about this, verify !!!!! */
 	   -2,
 	   1,
 	   res>0xff);		 /* not sure about this, verify !!!!! */
 
-  cpus.r[rA] = res & 0xff;
-  z80_clock_inc(8); /* timing taken from ei_neg */
-  uoc++;
+  z->cpus.r[rA] = res & 0xff;
+  z->uoc++;
 }
 
-static void Ui_im_0(void) { /* probably ..*/
+static void Ui_im_0(z80_t *z) { /* probably ..*/
 //  printf("IM 0\n");
-  cpus.int_mode=0;
-  z80_clock_inc(8); /* timing taken from ei_im_0 */
-  uoc++;
+  z->cpus.int_mode=0;
+  z->uoc++;
 }
 
-static void Ui_im_1(void) { /* probably ..*/
+static void Ui_im_1(z80_t *z) { /* probably ..*/
 //  printf("IM 1\n");
-  cpus.int_mode=1;
-  z80_clock_inc(8); /* timing taken from ei_im_1 */
-  uoc++;
+  z->cpus.int_mode=1;
+  z->uoc++;
 }
 
-static void Ui_im_2(void) { /* probably ..*/
+static void Ui_im_2(z80_t *z) { /* probably ..*/
 //  printf("IM 2\n");
-  cpus.int_mode=2;
-  z80_clock_inc(8); /* timing taken from ei_im_2 */
-  uoc++;
+  z->cpus.int_mode=2;
+  z->uoc++;
 }
 
-static void Ui_reti(void) { /* undoc RETI behaves like RETN actually.. */
-  cpus.IFF1=cpus.IFF2;
-  cpus.PC=_pop16();
-  z80_clock_inc(14); /* timing taken from ei_reti */
-  uoc++;
+static void Ui_reti(z80_t *z) { /* undoc RETI behaves like RETN actually.. */
+  z->cpus.IFF1=z->cpus.IFF2;
+  z->cpus.PC=_pop16(z);
+  z->uoc++;
 }
 
-static void Ui_retn(void) {
-  cpus.IFF1=cpus.IFF2;
-  cpus.PC=_pop16();
-  z80_clock_inc(14);  /* timing taken from ei_retn */
-  uoc++;
+static void Ui_retn(z80_t *z) {
+  z->cpus.IFF1=z->cpus.IFF2;
+  z->cpus.PC=_pop16(z);
+  z->uoc++;
 }
 
 /**** DD CB dd .. ***************************************************************/
 
-static void Ui_ld_r_rlc_iIXN(void) {
+static void Ui_ld_r_rlc_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_rlc8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_rlc8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_rlc_iIXN */
-  uoc++;
+  /* flags taken from ei_rlc_iIXN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_rrc_iIXN(void) {
+static void Ui_ld_r_rrc_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_rrc8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_rrc8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_rrc_iIXN */
-  uoc++;
+  /* flags taken from ei_rrc_iIXN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_rl_iIXN(void) {
+static void Ui_ld_r_rl_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_rl8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_rl8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_rl_iIXN */
-  uoc++;
+  /* flags taken from ei_rl_iIXN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_rr_iIXN(void) {
+static void Ui_ld_r_rr_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_rr8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_rr8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_rr_iIXN */
-  uoc++;
+  /* flags taken from ei_rr_iIXN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_sla_iIXN(void) {
+static void Ui_ld_r_sla_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_sla8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_sla8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_sla_iIXN */
-  uoc++;
+  /* flags taken from ei_sla_iIXN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_sra_iIXN(void) {
+static void Ui_ld_r_sra_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_sra8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_sra8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_sra_iIXN */
-  uoc++;
+  /* flags taken from ei_sra_iIXN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_sll_iIXN(void) {
+static void Ui_ld_r_sll_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_sll8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_sll8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_sll_iIXN */
-  uoc++;
+  /* flags taken from ei_sll_iIXN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_srl_iIXN(void) {
+static void Ui_ld_r_srl_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_srl8(_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_srl8(z, _iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_srl_iIXN */
-  uoc++;
+  /* flags taken from ei_srl_iIXN */
+  z->uoc++;
 }
 
 /************************************************************************/
 
-static void Ui_bit_b_iIXN(void) {
+static void Ui_bit_b_iIXN(z80_t *z) {
 
-  _bit8((opcode>>3)&0x07,_iIXN8(cbop));
+  _bit8(z, (z->opcode>>3)&0x07,_iIXN8(z, z->cbop));
   
-  setundocflags8((cpus.IX+u8sval(cbop))>>8); /* weird, huh? */
+  setundocflags8(z, (z->cpus.IX+u8sval(z->cbop))>>8); /* weird, huh? */
 
-  z80_clock_inc(16); /* timing&flags taken from ei_bit_b_iIXN */
-  uoc++;
+  /* flags taken from ei_bit_b_iIXN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_res_b_iIXN(void) {
+static void Ui_ld_r_res_b_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_res8((opcode>>3)&0x07,_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_res8((z->opcode>>3)&0x07,_iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_res_b_iIXN */
-  uoc++;
+  /* flags taken from ei_res_b_iIXN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_set_b_iIXN(void) {
+static void Ui_ld_r_set_b_iIXN(z80_t *z) {
   uint8_t res;
 
-  res=_set8((opcode>>3)&0x07,_iIXN8(cbop));
-  s_iIXN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_set8((z->opcode>>3)&0x07,_iIXN8(z, z->cbop));
+  s_iIXN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_set_b_iIXN */
-  uoc++;
+  /* flags taken from ei_set_b_iIXN */
+  z->uoc++;
 }
 
 /**** FD CB dd .. ***************************************************************/
 
-static void Ui_ld_r_rlc_iIYN(void) {
+static void Ui_ld_r_rlc_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_rlc8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_rlc8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_rlc_iIYN */
-  uoc++;
+  /* flags taken from ei_rlc_iIYN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_rrc_iIYN(void) {
+static void Ui_ld_r_rrc_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_rrc8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_rrc8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_rrc_iIYN */
-  uoc++;
+  /* flags taken from ei_rrc_iIYN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_rl_iIYN(void) {
+static void Ui_ld_r_rl_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_rl8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_rl8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_rl_iIYN */
-  uoc++;
+  /* flags taken from ei_rl_iIYN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_rr_iIYN(void) {
+static void Ui_ld_r_rr_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_rr8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_rr8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_rr_iIYN */
-  uoc++;
+  /* flags taken from ei_rr_iIYN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_sla_iIYN(void) {
+static void Ui_ld_r_sla_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_sla8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_sla8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_sla_iIYN */
-  uoc++;
+  /* flags taken from ei_sla_iIYN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_sra_iIYN(void) {
+static void Ui_ld_r_sra_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_sra8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_sra8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_sra_iIYN */
-  uoc++;
+  /* flags taken from ei_sra_iIYN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_sll_iIYN(void) {
+static void Ui_ld_r_sll_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_sll8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_sll8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_sll_iIYN */
-  uoc++;
+  /* flags taken from ei_sll_iIYN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_srl_iIYN(void) {
+static void Ui_ld_r_srl_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_srl8(_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_srl8(z, _iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_srl_iIYN */
-  uoc++;
+  /* flags taken from ei_srl_iIYN */
+  z->uoc++;
 }
 
 /************************************************************************/
 
-static void Ui_bit_b_iIYN(void) {
+static void Ui_bit_b_iIYN(z80_t *z) {
 
-  _bit8((opcode>>3)&0x07,_iIYN8(cbop));
-  setundocflags8((cpus.IY+u8sval(cbop))>>8); /* weird, huh? */
+  _bit8(z, (z->opcode>>3)&0x07,_iIYN8(z, z->cbop));
+  setundocflags8(z, (z->cpus.IY+u8sval(z->cbop))>>8); /* weird, huh? */
 
-  z80_clock_inc(16); /* timing&flags taken from ei_bit_b_iIYN */
-  uoc++;
+  /* flags taken from ei_bit_b_iIYN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_res_b_iIYN(void) {
+static void Ui_ld_r_res_b_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_res8((opcode>>3)&0x07,_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_res8((z->opcode>>3)&0x07,_iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_res_b_iIYN */
-  uoc++;
+  /* flags taken from ei_res_b_iIYN */
+  z->uoc++;
 }
 
-static void Ui_ld_r_set_b_iIYN(void) {
+static void Ui_ld_r_set_b_iIYN(z80_t *z) {
   uint8_t res;
 
-  res=_set8((opcode>>3)&0x07,_iIYN8(cbop));
-  s_iIYN8(cbop,res);
-  cpus.r[opcode & 0x07]=res;
+  res=_set8((z->opcode>>3)&0x07,_iIYN8(z, z->cbop));
+  s_iIYN8(z, z->cbop,res);
+  z->cpus.r[Z80_REG8(z->opcode & 0x07)]=res;
 
-  z80_clock_inc(19); /* timing&flags taken from ei_set_b_iIYN */
-  uoc++;
+  /* flags taken from ei_set_b_iIYN */
+  z->uoc++;
 }
 
 #else
@@ -5220,231 +5074,1748 @@ static void Ui_ld_r_set_b_iIYN(void) {
 /************************************************************************/
 /************************************************************************/
 
-static void Si_stray(void);
-static void Mi_dd(void);
-static void Mi_fd(void);
+static void Si_stray(z80_t *z);
+static void Mi_dd(z80_t *z);
+static void Mi_fd(z80_t *z);
+static void Mi_cbed(z80_t *z);
+
+/* decode tables, indexed by ei_tabi (same order as stat_tab) */
+#define EI_TAB_OP	0	/* +modifier for DD, FD */
+#define EI_TAB_CB	3	/* +modifier for DDCB, FDCB */
+#define EI_TAB_ED	6
+
+#ifndef Z80_SWITCH
+
+#define EI_TAB_BEGIN(name) \
+  static void (*const name[256])(z80_t *) PROGMEM = {
+#define EI4(op, f0, f1, f2, f3, t0, t1, t2, t3) f0, f1, f2, f3,
+#define EI_TAB_END };
+
+#include "z80itab.c"
+
+static void (*const *const ei_tabs[7])(z80_t *) = {
+  ei_op, ei_ddop, ei_fdop, ei_cbop, ei_ddcbop, ei_fdcbop, ei_edop
+};
+
+#else
+
+/*
+ * Switch dispatch: build one switch statement per decode table so that
+ * the compiler can inline the handlers instead of calling them through
+ * a pointer.
+ *
+ * Caching the hot registers in locals of the switch is not implemented,
+ * the handlers work on z->cpus as in the table build. This build runs
+ * slower than table dispatch on the make bench-z80 workloads.
+ */
+#define EI_TAB_BEGIN(name) \
+  static void name##_sw(z80_t *z) { switch(z->opcode) {
+#define EI4(op, f0, f1, f2, f3, t0, t1, t2, t3) \
+  case (op):   f0(z); break; \
+  case (op)+1: f1(z); break; \
+  case (op)+2: f2(z); break; \
+  case (op)+3: f3(z); break;
+#define EI_TAB_END } }
+
+#include "z80itab.c"
+
+#endif
+
+#undef EI_TAB_BEGIN
+#undef EI4
+#undef EI_TAB_END
+
+/* base T-states of the opcodes, see z80itab.c */
+#define EI_TAB_BEGIN(name) \
+  static const uint8_t name##_t[256] PROGMEM = {
+#define EI4(op, f0, f1, f2, f3, t0, t1, t2, t3) t0, t1, t2, t3,
+#define EI_TAB_END };
 
 #include "z80itab.c"
 
-static void (*const *(ei_opm  [3]))(void) = { ei_op,   ei_ddop,   ei_fdop   };
-static void (*const *(ei_cbopm[3]))(void) = { ei_cbop, ei_ddcbop, ei_fdcbop };
+#undef EI_TAB_BEGIN
+#undef EI4
+#undef EI_TAB_END
+
+static const uint8_t *const ei_times[7] = {
+  ei_op_t, ei_ddop_t, ei_fdop_t, ei_cbop_t, ei_ddcbop_t, ei_fdcbop_t, ei_edop_t
+};
+
+/*
+ * charge the base T-states of opcode op from decode table tabi. This is done
+ * once for each instruction before it executes, the handler only adds
+ * the extra T-states of a taken branch or a repeating block instruction.
+ */
+static inline void z80_clock_base(z80_t *z, int tabi, uint8_t op) {
+  z80_clock_inc(z, pgm_read_byte(&ei_times[tabi][op]));
+}
+
+/* execute opcode from decode table tabi */
+static void z80_dispatch(z80_t *z, int tabi) {
+#ifndef Z80_SWITCH
+  ((void (*)(z80_t *))pgm_read_ptr(&ei_tabs[tabi][z->opcode]))(z);
+#else
+  switch(tabi) {
+    case 0: ei_op_sw(z); break;
+    case 1: ei_ddop_sw(z); break;
+    case 2: ei_fdop_sw(z); break;
+    case 3: ei_cbop_sw(z); break;
+    case 4: ei_ddcbop_sw(z); break;
+    case 5: ei_fdcbop_sw(z); break;
+    case 6: ei_edop_sw(z); break;
+  }
+#endif
+}
 
-static void Mi_dd(void) {
-  z80_clock_inc(4);  /* according to Sean: 4T(as NOP), 1R */
-  cpus.int_lock=1; /* no interrupts! */
-  cpus.modifier=1; /* DD */
+static void Mi_dd(z80_t *z) {
+  /* according to Sean: 4T(as NOP), 1R */
+  z->cpus.int_lock=1; /* no interrupts! */
+  z->cpus.modifier=1; /* DD */
 }
 
-static void Mi_fd(void) {
-  z80_clock_inc(4);  /* according to Sean: 4T(as NOP), 1R */
-  cpus.int_lock=1; /* no interrupts! */
-  cpus.modifier=2; /* FD */
+static void Mi_fd(z80_t *z) {
+  /* according to Sean: 4T(as NOP), 1R */
+  z->cpus.int_lock=1; /* no interrupts! */
+  z->cpus.modifier=2; /* FD */
 }
 
-static void Si_stray(void) {  /* DD/FD was stray.. another DD/FD or unprefixed
+static void Si_stray(z80_t *z) {  /* DD/FD was stray.. another DD/FD or unprefixed
                          instruction followed */
-  smc++;
-  ei_opm[0][opcode](); /* execute the instruction(without modifiers) */
+  z->smc++;
+  z80_dispatch(z, EI_TAB_OP); /* execute the instruction(without modifiers) */
 }
 
-void z80_resetstat(void) {
-#ifndef NO_Z80STAT
-  int i,j;
-  
-  for(i=0;i<7;i++)
-    for(j=0;j<256;j++)
-      stat_tab[i][j]=0;
-#endif
+static void Mi_cbed(z80_t *z) {
+  /* never executed, CB/ED prefixes are decoded by z80_readinstr(z) */
 }
 
-unsigned z80_getstat(int tab, uint8_t opcode)
-{
+/* execute the instruction decoded by z80_readinstr() */
+static inline void exec_decoded(z80_t *z) {
+  z80_clock_base(z, z->ei_tabi, z->opcode);
+  z80_dispatch(z, z->ei_tabi);
+}
+
+#if !defined(NO_Z80IDLE) || defined(Z80_JIT)
+/* same state except R */
+static int cpus_same(z80s *a, z80s *b) {
+  return !memcmp(a->r, b->r, 8) && !memcmp(a->r_, b->r_, 8) &&
+    a->I==b->I && a->IX==b->IX && a->IY==b->IY &&
+    a->PC==b->PC && a->SP==b->SP && a->IFF1==b->IFF1 &&
+    a->IFF2==b->IFF2 && a->int_mode==b->int_mode &&
+    a->int_lock==b->int_lock && a->int_pending==b->int_pending &&
+    a->nmi_pending==b->nmi_pending && a->modifier==b->modifier &&
+    a->halted==b->halted;
+}
+#endif
+
+#if !defined(NO_Z80AOT) || defined(Z80_JIT)
+/* do what z80_readinstr() would have done */
+static inline void aot_decoded(z80_t *z, uint8_t dlen, int tabi, uint8_t op,
+  uint8_t cbop, int rinc) {
+  z->opcode=op;
+  z->ei_tabi=tabi;
+  z->cbop=cbop;
+  if(rinc) incr_R(z, 1);
+  z->cpus.PC+=dlen;
 #ifndef NO_Z80STAT
-	return stat_tab[tab][opcode];
-#else
-	return 0;
+  if(z->stat_on) z->stat_tab[tabi][op]++;
 #endif
+  z80_clock_base(z, tabi, op);
 }
 
-int z80_readinstr(void) {
+/* finish the instruction as execinstr() would */
+static inline void aot_executed(z80_t *z) {
+  incr_R(z, 1);
+  if(z->opcode!=0xdd && z->opcode!=0xfd) z->cpus.modifier=0;
+}
 
-  opcode=z80_iget8();
+/*
+ * check whether translated code can go on with the next instruction
+ * without returning to the interpreter and if so, start it
+ */
+static inline int aot_boundary(z80_t *z) {
+  if((long)(z->clock - z->deadline) >= 0) return 0;
+  if(ev_due(z)) return 0;
+  if(brk_hit(z)) return 0;
 
-  if(opcode==0xed) {
-    incr_R(1);
-    opcode=z80_iget8();
-    ei_tab=ei_edop;
-#ifndef NO_Z80STAT
-    stat_i=6;
+  z->iclock=z->clock;
+  z->cpus.int_lock=0;
+  return 1;
+}
 #endif
-//    prefix2=0xed;    
-    return 0;
+
+#ifndef NO_Z80AOT
+/*
+ * Translated ROM code
+ *
+ * aotgen translates the code of the known ROM images to C at build time
+ * (z80aotrom.c). A block executes its instructions by calling their
+ * handlers directly, without fetching and decoding them. Between
+ * instructions it returns to the interpreter whenever the interpreter would
+ * do anything other than go on with the next instruction: a jump was taken,
+ * the deadline was reached, an interrupt or NMI is pending or PC hit
+ * a breakpoint (such as a tape trap).
+ */
+
+struct z80_aot {
+  uint64_t hash;           /* hash of the ROM image */
+  void (*const *blk)(z80_t *); /* blocks */
+  const uint16_t *ents;    /* (address, block) for each entry point */
+  unsigned nents;
+  uint16_t *idx;           /* block number + 1 by address, 0 = none */
+  int ready;               /* idx has been filled in */
+};
+
+/*
+ * finish the instruction and check whether the block can go on with
+ * the instruction at pc (out of line, it is there after every instruction)
+ */
+static __attribute__((noinline)) int aot_next(z80_t *z, uint16_t pc) {
+  aot_executed(z);
+  if(z->cpus.PC!=pc) return 0;
+  return aot_boundary(z);
+}
+
+#define AOT_I(dlen, tabi, op, cbop, rinc, fn, next) \
+  aot_decoded(z, dlen, tabi, op, cbop, rinc); \
+  fn(z); \
+  if(!aot_next(z, next)) return;
+
+#include "z80aotrom.c"
+
+#undef AOT_I
+
+/* must match aot_hash() in aotgen.c */
+static uint64_t aot_hash(const uint8_t *rom) {
+  uint64_t h=0xcbf29ce484222325ULL;
+  unsigned i;
+
+  for(i=0;i<0x4000;i++) {
+    h^=rom[i];
+    h*=0x100000001b3ULL;
   }
+  return h;
+}
 
-  if(opcode==0xcb) {
-    if(cpus.modifier!=0) {
-      cbop=z80_iget8();
-    } else {
-      incr_R(1);
-    }
-    opcode=z80_iget8();
-    ei_tab=ei_cbopm[cpus.modifier];
-#ifndef NO_Z80STAT
-    stat_i=cpus.modifier+3;
-#endif
-//    prefix2=0xcb;
+/* execute translated code at PC, if there is any */
+static int aot_run(z80_t *z) {
+  z80_aot_t *a=z->aot;
+  uint16_t b;
+
+  if(a==NULL || !z->aot_on || z->cpus.PC>=0x4000 || z->cpus.modifier!=0)
     return 0;
+  b=a->idx[z->cpus.PC];
+  if(b==0) return 0;
+
+  a->blk[b-1](z);
+  return 1;
+}
+#else
+static inline int aot_run(z80_t *z) {
+  (void)z;
+  return 0;
+}
+#endif
+
+/* find translated code for 16K ROM image, NULL if there is none */
+z80_aot_t *z80_aot_find(const uint8_t *rom) {
+#ifndef NO_Z80AOT
+  z80_aot_t *a;
+  uint64_t h;
+  unsigned i,j;
+
+  h=aot_hash(rom);
+  for(i=0;i<sizeof(aot_roms)/sizeof(aot_roms[0]);i++) {
+    a=&aot_roms[i];
+    if(a->hash!=h) continue;
+    if(!a->ready) {
+      for(j=0;j<a->nents;j++)
+        a->idx[a->ents[2*j]]=a->ents[2*j+1]+1;
+      a->ready=1;
+    }
+    return a;
   }
+#else
+  (void)rom;
+#endif
+  return NULL;
+}
 
-  /* one-byte opcode */
-//  prefix2=0;
-  ei_tab=ei_opm[cpus.modifier];
-#ifndef NO_Z80STAT
-  stat_i=cpus.modifier;
+/* ROM at 0000-3FFF now has translated code a (NULL for none) */
+void z80_aot_map(z80_t *z, z80_aot_t *a) {
+#ifndef NO_Z80AOT
+  z->aot=a;
+#else
+  (void)z; (void)a;
+#endif
+}
+
+/* enable or disable execution of translated code (ROM and JIT) */
+void z80_aot_enable(z80_t *z, int enable) {
+#if !defined(NO_Z80AOT) || defined(Z80_JIT)
+  z->aot_on=enable;
+#else
+  (void)z; (void)enable;
 #endif
-  return 0;
 }
 
-void z80_execinstr(void) {
-  int lastuoc;
+#if defined(Z80_JIT) || !defined(NO_Z80PROF)
+/* handler names of the decode tables */
+#define EI_TAB_BEGIN(name) static const char *const name##_nm[256] = {
+#define EI4(op, f0, f1, f2, f3, t0, t1, t2, t3) #f0, #f1, #f2, #f3,
+#define EI_TAB_END };
 
-  /* Process pending NMI or interrupt */
-  z80_check_nmi();
-  z80_check_int();
+#include "z80itab.c"
 
-  cpus.int_lock=0;
+#undef EI_TAB_BEGIN
+#undef EI4
+#undef EI_TAB_END
 
-  if(cpus.halted) { /* NOP */
-    z80_clock_inc(4);
-    incr_R(1);
-  } else {
-    //printf("read instr..\n");
-    z80_readinstr();
+static const char *const *const ei_names[7] = {
+  ei_op_nm, ei_ddop_nm, ei_fdop_nm, ei_cbop_nm, ei_ddcbop_nm, ei_fdcbop_nm,
+  ei_edop_nm
+};
+#endif
 
-    //printf("exec instr..\n");
-#ifndef NO_Z80STAT
-    stat_tab[stat_i][opcode]++;
+#ifdef Z80_JIT
+/*
+ * JIT translator
+ *
+ * Blocks of code which the interpreter executes often enough are
+ * translated to x86-64 machine code. Like the translated ROM code above,
+ * a block calls the handlers of its instructions directly and returns to
+ * the interpreter whenever the interpreter would not just go on with the
+ * next instruction. At the end of a block, execution continues directly
+ * with the block at the new PC if there is one (chaining).
+ *
+ * A block is invalidated by CPU writes to its code, by z80_icache_inval()
+ * and by z80_icache_flush_bank() (bank switching). The block being
+ * executed then stops after the current instruction. Blocks are listed
+ * by the page their code starts in, so that a write only has to look at
+ * the blocks of two pages.
+ *
+ * The arena is never writable and executable at the same time: it is
+ * made writable to emit a block and executable again once it is done.
+ *
+ * In Z80_JIT_CHECK mode each block run is verified by running the same
+ * instructions in the interpreter: the memory and I/O accesses of the block
+ * are recorded, then the state is rolled back and the interpreter replays
+ * the instructions against the recording.
+ */
+
+#if !defined(__x86_64__)
+#error Z80_JIT requires an x86-64 host
 #endif
-    
-    lastuoc=uoc;
-    ((void (*)(void))pgm_read_ptr(&ei_tab[opcode]))(); /* FAST branch .. execute the instruction */
-    
-    (void)lastuoc;
-    (void) prefix1;
-    (void) prefix2;
-/*    switch(cpus.modifier) {
-      case 0: prefix1=0;    break;
-      case 1: prefix1=0xdd; break;
-      case 2: prefix1=0xfd; break;
-    }  
-    if(uoc>lastuoc) fprintf(logfi,"undoc opcode %02x\n",(prefix1<<16)|(prefix2<<8)|opcode);
-*/
-    incr_R(1);
-    
-    /* turn off old modifier prefix (unless set just now) */
-    if(opcode!=0xdd && opcode!=0xfd) cpus.modifier=0;
-  }
-#ifdef NO_Z80CLOCK
-	z80_clock += 12;
+#ifdef Z80_SWITCH
+#error Z80_JIT cannot be combined with Z80_SWITCH
 #endif
-}
 
-static void z80_check_int(void) {
+#include <stddef.h>
+#include <sys/mman.h>
+
+#define JIT_ARENA   (16 << 20) /* size of the translation arena */
+#define JIT_NBLK    8192       /* maximum number of blocks */
+#define JIT_BLK_MAX 64         /* maximum instructions in a block */
+#define JIT_BLK_CODE (JIT_BLK_MAX*256+64) /* code size limit of a block */
+#define JIT_HOT     16         /* interpreted entries before translation */
+#define JIT_NLOG    4096       /* accesses recorded in Z80_JIT_CHECK mode */
+#define JIT_PROLOGUE 20        /* prologue skipped when chaining */
+#define JIT_PAGE_SHIFT 8       /* blocks are indexed by 256-byte pages */
+#define JIT_NPAGES (65536 >> JIT_PAGE_SHIFT)
+
+/* a block covering an address must start in its page or the one before */
+#if JIT_BLK_MAX*4 > (1 << JIT_PAGE_SHIFT)
+#error JIT_BLK_MAX too large for JIT_PAGE_SHIFT
+#endif
+
+/* kinds of recorded accesses */
+enum { JIT_LOG_RD, JIT_LOG_WR, JIT_LOG_IN, JIT_LOG_OUT, JIT_LOG_SNOOP };
+
+typedef struct jit_blk {
+  uint16_t start;          /* address of the first instruction */
+  uint16_t len;            /* length of the code in bytes, 0 = dead */
+  uint8_t *code;           /* entry point of the native code */
+  struct jit_blk *next;    /* next block starting in the same page */
+} jit_blk_t;
+
+typedef struct {
+  uint8_t kind;            /* JIT_LOG_xxx */
+  uint8_t val;
   uint16_t addr;
-  uint8_t data;
-//  printf("interrupt->DI\n");
+} jit_log_t;
+
+struct z80_jit {
+  int mode;                /* Z80_JIT_xxx */
+  uint8_t *arena;          /* translated code */
+  unsigned used;           /* bytes of arena used */
+  jit_blk_t blk[JIT_NBLK];
+  unsigned nblk;
+  jit_blk_t *map[65536];   /* live block by start address */
+  jit_blk_t *page[JIT_NPAGES]; /* blocks by page of start address */
+  uint8_t cnt[65536];      /* interpreted entries by address */
+  uint8_t cover[65536];    /* live blocks covering each byte (saturating) */
+  int dirty;               /* a block was invalidated since entry */
+  unsigned ninstr;         /* instructions executed since entry */
+
+  /* Z80_JIT_CHECK */
+  const z80_dep_t *dep;    /* real dep and its argument */
+  void *dep_arg;
+  uint16_t src_start;      /* code of the block being verified */
+  uint16_t src_len;        /* as it was before it ran */
+  uint8_t src[JIT_BLK_MAX*4];
+  jit_log_t log[JIT_NLOG];
+  unsigned nlog;           /* recorded accesses */
+  unsigned plog;           /* accesses replayed */
+  int bad;                 /* replay did not match */
+
+  z80_jit_stat_t stat;
+};
+
+/* what the translator needs to know about each decode table entry */
+typedef struct {
+  uint8_t oplen;           /* operand bytes following the decoded part */
+  uint8_t end;             /* the instruction may not continue in sequence */
+  uint8_t modifier;        /* DD/FD modifier set for the next instruction */
+} jit_info_t;
+
+static jit_info_t jit_info[7][256];
+
+/* operand bytes of instruction with handler name (as aot_oplen() in aotgen.c) */
+static unsigned jit_oplen(const char *name) {
+  char buf[64];
+  char *tok;
+  unsigned len=0;
+
+  if(strcmp(name, "ei_djnz")==0) return 1;
+
+  strncpy(buf, name+3, sizeof(buf)-1);
+  buf[sizeof(buf)-1]='\0';
+  for(tok=strtok(buf, "_");tok!=NULL;tok=strtok(NULL, "_")) {
+    if(!strcmp(tok, "NN") || !strcmp(tok, "iNN")) len+=2;
+    else if(!strcmp(tok, "N") || !strcmp(tok, "iN") || !strcmp(tok, "iIXN")
+      || !strcmp(tok, "iIYN")) len+=1;
+  }
+  return len;
+}
+
+static void jit_init_info(void) {
+  const char *name,*s;
+  jit_info_t *i;
+  int t,op;
+
+  for(t=0;t<7;t++) {
+    for(op=0;op<256;op++) {
+      i=&jit_info[t][op];
+      name=ei_names[t][op];
+      if(!strcmp(name, "Si_stray")) name=ei_op_nm[op];
+      s=name+3;
+
+      i->oplen=(t<EI_TAB_CB || t==EI_TAB_ED) ? jit_oplen(name) : 0;
+      i->modifier=!strcmp(name, "Mi_dd") ? 1 : !strcmp(name, "Mi_fd") ? 2 : 0;
+      i->end=!strncmp(s, "jp_", 3) || !strncmp(s, "jr_", 3) ||
+        !strncmp(s, "call_", 5) || !strncmp(s, "ret", 3) ||
+        !strncmp(s, "rst_", 4) || !strcmp(s, "djnz") || !strcmp(s, "halt");
+      /* DD/FD after CB/ED leaves the modifier in effect */
+      if(t>=EI_TAB_CB && (op==0xdd || op==0xfd)) i->end=1;
+    }
+  }
+}
 
-  if(!cpus.int_pending) return;
-  if(cpus.int_lock) return; /* after EI or DI or inside an instruction */
+/* kill block b */
+static void jit_kill(z80_jit_t *j, jit_blk_t *b) {
+  unsigned i;
 
-  /* Clear interrupt pending flag */
-  cpus.int_pending=0;
+  if(b->len==0) return;
+  j->map[b->start]=NULL;
+  j->cnt[b->start]=0;
+  for(i=0;i<b->len;i++)
+    if(j->cover[(uint16_t)(b->start+i)]<255) j->cover[(uint16_t)(b->start+i)]--;
+  b->len=0;
+  j->dirty=1;
+  j->stat.invals++;
+}
 
-  /* If interrupts are disabled, just drop the interrupt */
-  if(!cpus.IFF1) return; /* IFF2 just tells the NMI service routine
-                               whether the interrupted program disabled
-			       maskable interrupts */
-  cpus.halted=0;
-  cpus.IFF1=cpus.IFF2=0;
+/* kill blocks of page pg covering addr, unlink dead blocks */
+static void jit_inval_page(z80_jit_t *j, unsigned pg, uint16_t addr) {
+  jit_blk_t **bp=&j->page[pg];
+  jit_blk_t *b;
 
-  switch(cpus.int_mode) {
-    case 0: /* this is not quite right yet ..*/
-      /* the actual instruction should be read from the data bus */
-      /* but if that instruction were longer than 1 byte? */
-      incr_R(2);
-      _push16(cpus.PC);
-      cpus.PC=0x0038;
-      z80_clock_inc(13);
-      break;
-    case 1:
-      incr_R(2);
-      _push16(cpus.PC);
-      cpus.PC=0x0038;
-      z80_clock_inc(13);
-      break;
-    case 2:
-      incr_R(2);
-      _push16(cpus.PC);
-      data = z80_snoop8();
-      addr=((uint16_t)cpus.I<<8) | (uint16_t)data;
-      cpus.PC=z80_memget16(addr);
-//      printf("IM 2 INT: I=%02x D8=%02x tabi=%04x dst=%04x\n",cpus.I,data,addr,cpus.PC);
-      z80_clock_inc(19);
-      break;
+  while((b=*bp)!=NULL) {
+    if((uint16_t)(addr-b->start) < b->len) jit_kill(j, b);
+    if(b->len==0) *bp=b->next;
+      else bp=&b->next;
   }
 }
 
-static void z80_check_nmi(void) {
+/* memory at addr was modified */
+static void jit_inval(z80_t *z, uint16_t addr) {
+  z80_jit_t *j=z->jit;
+  unsigned pg=addr >> JIT_PAGE_SHIFT;
 
-  if(!cpus.nmi_pending) return;
-  if(cpus.int_lock) return;
-//  printf("NMI!\n");
-  
-  cpus.nmi_pending=0;
-  cpus.halted=0;
-  cpus.IFF1=0;
+  if(!j->cover[addr]) return;
+  jit_inval_page(j, pg, addr);
+  jit_inval_page(j, (pg-1) & (JIT_NPAGES-1), addr);
+}
 
-  _push16(cpus.PC);
-  cpus.PC=0x0066;
-  
-  incr_R(2);
-  z80_clock_inc(11);
+/* 16K window w was remapped or modified */
+static void jit_inval_bank(z80_t *z, int w) {
+  z80_jit_t *j=z->jit;
+  unsigned pg,npg=0x4000 >> JIT_PAGE_SHIFT;
+  jit_blk_t *b;
+
+  for(pg=w*npg;pg<(w+1)*npg;pg++) {
+    for(b=j->page[pg];b!=NULL;b=b->next)
+      jit_kill(j, b);
+    j->page[pg]=NULL;
+  }
 }
 
-void z80_int(void)
-{
-  cpus.int_pending = 1;
+/* make the arena writable to emit code, or executable to run it */
+static int jit_protect(z80_jit_t *j, int write) {
+  return mprotect(j->arena, JIT_ARENA,
+    write ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC);
 }
 
-void z80_nmi(void)
-{
-  cpus.nmi_pending = 1;
+/* drop all translations */
+static void jit_flush(z80_jit_t *j) {
+  memset(j->map, 0, sizeof(j->map));
+  memset(j->page, 0, sizeof(j->page));
+  memset(j->cover, 0, sizeof(j->cover));
+  j->nblk=0;
+  j->used=0;
+  j->stat.flushes++;
 }
 
-int z80_reset(void) {
-  cpus.IFF1=cpus.IFF2=0;
-  cpus.int_mode=0;
-  cpus.int_pending=0;
-  cpus.nmi_pending=0;
-  cpus.PC=0;
+typedef struct {
+  uint8_t dlen;            /* bytes consumed by the decoder */
+  uint8_t len;             /* length including operands */
+  uint8_t tabi;
+  uint8_t opcode;
+  uint8_t cbop;
+  uint8_t rinc;
+} jit_instr_t;
 
-  cpus.SP=0;
-  cpus.I=0;
-  cpus.R=0;
-  
-  cpus.halted=0;
-  cpus.int_lock=0;
-  cpus.modifier=0;
-  
-  cpus.r[rA]=0;  cpus.F=0;
-  cpus.r[rB]=0;  cpus.r[rC]=0;
-  cpus.r[rD]=0;  cpus.r[rE]=0;
-  cpus.r[rH]=0;  cpus.r[rL]=0;
-  cpus.IX=0;     cpus.IY=0;
-  cpus.r_[rA]=0; cpus.F_=0;
-  cpus.r_[rB]=0; cpus.r_[rC]=0;
-  cpus.r_[rD]=0; cpus.r_[rE]=0;
-  cpus.r_[rH]=0; cpus.r_[rL]=0;
+/* native entry of the block to continue with, NULL to return */
+static uint8_t *jit_chain(z80_t *z) {
+  z80_jit_t *j=z->jit;
+  jit_blk_t *b;
 
-  return 0;
+  if(j->dirty || j->mode!=Z80_JIT_ON) return NULL;
+  if(z->cpus.halted || z->cpus.modifier!=0) return NULL;
+  b=j->map[z->cpus.PC];
+  if(b==NULL || !aot_boundary(z)) return NULL;
+  j->stat.chains++;
+  return b->code+JIT_PROLOGUE;
+}
+
+/*
+ * x86-64 code emission
+ *
+ * While a block runs, rbx holds the Z80 context and r12 the JIT state.
+ * The bookkeeping that execinstr() does around each instruction is
+ * emitted inline, only the handlers and jit_chain() are called.
+ */
+
+#define JIT_Z(field) offsetof(z80_t, field)
+#define JIT_J(field) offsetof(z80_jit_t, field)
+
+static uint8_t *jit_b(uint8_t *p, const char *bytes, unsigned n) {
+  memcpy(p, bytes, n);
+  return p+n;
+}
+
+static uint8_t *jit_imm32(uint8_t *p, uint32_t v) {
+  memcpy(p, &v, 4);
+  return p+4;
+}
+
+static uint8_t *jit_imm64(uint8_t *p, uint64_t v) {
+  memcpy(p, &v, 8);
+  return p+8;
+}
+
+/* instruction with operand [base+off], the opcode bytes include ModRM/SIB */
+static uint8_t *jit_mem(uint8_t *p, const char *op, unsigned n, size_t off) {
+  p=jit_b(p, op, n);
+  return jit_imm32(p, off);
+}
+
+/* jcc rel32 (cc = second opcode byte) to the block exit */
+static uint8_t *jit_jcc_exit(uint8_t *p, uint8_t cc, uint8_t *exit) {
+  *p++=0x0f;
+  *p++=cc;
+  return jit_imm32(p, (uint32_t)(exit-(p+4)));
+}
+
+#define JIT_JE  0x84
+#define JIT_JNE 0x85
+#define JIT_JNS 0x89
+
+/* R+=k as incr_R() */
+static uint8_t *jit_incr_R(uint8_t *p, uint8_t k) {
+#ifdef Z80_LAZY
+  p=jit_mem(p, "\x83\x83", 2, JIT_Z(r_inc));  /* add dword [rbx+r_inc],k */
+  *p++=k;
+#else
+  p=jit_mem(p, "\x8a\x83", 2, JIT_Z(cpus.R)); /* mov al,[rbx+R] */
+  p=jit_b(p, "\x88\xc1", 2);                  /* mov cl,al */
+  p=jit_b(p, "\x04", 1);                      /* add al,k */
+  *p++=k;
+  p=jit_b(p, "\x24\x7f\x80\xe1\x80\x08\xc8", 7); /* and al,7f; and cl,80; or al,cl */
+  p=jit_mem(p, "\x88\x83", 2, JIT_Z(cpus.R)); /* mov [rbx+R],al */
+#endif
+  return p;
+}
+
+/*
+ * instruction in as z80_readinstr(), the handler and execinstr() would,
+ * counting it in stat_tab if stat is set
+ */
+static uint8_t *jit_emit_instr(uint8_t *p, jit_instr_t *in, int stat) {
+  uint64_t fn=(uintptr_t)ei_tabs[in->tabi][in->opcode];
+
+  p=jit_mem(p, "\xc6\x83", 2, JIT_Z(opcode)); /* mov byte [rbx+opcode],op */
+  *p++=in->opcode;
+  p=jit_mem(p, "\xc7\x83", 2, JIT_Z(ei_tabi)); /* mov dword [rbx+ei_tabi],t */
+  p=jit_imm32(p, in->tabi);
+  if(in->tabi>EI_TAB_CB && in->tabi<EI_TAB_ED) {
+    p=jit_mem(p, "\xc6\x83", 2, JIT_Z(cbop)); /* mov byte [rbx+cbop],d */
+    *p++=in->cbop;
+  }
+  p=jit_mem(p, "\x66\x83\x83", 3, JIT_Z(cpus.PC)); /* add word [rbx+PC],n */
+  *p++=in->dlen;
+  if(in->rinc) p=jit_incr_R(p, 1);
+#ifndef NO_Z80STAT
+  if(stat) {
+    p=jit_mem(p, "\x83\x83", 2, JIT_Z(stat_tab) + /* add dword [rbx+stat],1 */
+      sizeof(unsigned)*(in->tabi*256+in->opcode));
+    *p++=1;
+  }
+#else
+  (void)stat;
+#endif
+#ifndef NO_Z80CLOCK
+  p=jit_mem(p, "\x48\x83\x83", 3, JIT_Z(clock)); /* add qword [rbx+clock],t */
+  *p++=pgm_read_byte(&ei_times[in->tabi][in->opcode]);
+#endif
+
+  p=jit_b(p, "\x48\x89\xdf\x48\xb8", 5);      /* mov rdi,rbx; mov rax,fn */
+  p=jit_imm64(p, fn);
+  p=jit_b(p, "\xff\xd0", 2);                  /* call rax */
+
+  p=jit_incr_R(p, 1);
+  if(in->opcode!=0xdd && in->opcode!=0xfd) {
+    p=jit_mem(p, "\xc7\x83", 2, JIT_Z(cpus.modifier)); /* modifier=0 */
+    p=jit_imm32(p, 0);
+  }
+  p=jit_mem(p, "\x41\x83\x84\x24", 4, JIT_J(ninstr)); /* add [r12+ninstr],1 */
+  *p++=1;
+  return p;
+}
+
+/* go on with the instruction at pc as aot_next() would, else exit */
+static uint8_t *jit_emit_next(uint8_t *p, uint16_t pc, uint8_t *exit) {
+  p=jit_mem(p, "\x41\x83\xbc\x24", 4, JIT_J(dirty)); /* cmp [r12+dirty],0 */
+  *p++=0;
+  p=jit_jcc_exit(p, JIT_JNE, exit);
+  p=jit_mem(p, "\x66\x81\xbb", 3, JIT_Z(cpus.PC)); /* cmp word [rbx+PC],pc */
+  *p++=pc & 0xff;
+  *p++=pc >> 8;
+  p=jit_jcc_exit(p, JIT_JNE, exit);
+  p=jit_mem(p, "\x48\x8b\x83", 3, JIT_Z(clock)); /* mov rax,[rbx+clock] */
+  p=jit_mem(p, "\x48\x2b\x83", 3, JIT_Z(deadline)); /* sub rax,[rbx+deadline] */
+  p=jit_jcc_exit(p, JIT_JNS, exit);
+  p=jit_mem(p, "\x48\x8b\x83", 3, JIT_Z(clock)); /* mov rax,[rbx+clock] */
+  p=jit_mem(p, "\x48\x2b\x83", 3, JIT_Z(ev_clock)); /* sub rax,[...] */
+  p=jit_jcc_exit(p, JIT_JNS, exit);
+  p=jit_mem(p, "\xf6\x83", 2, JIT_Z(brk)+(pc>>3)); /* test byte [brk],bit */
+  *p++=1 << (pc & 7);
+  p=jit_jcc_exit(p, JIT_JNE, exit);
+
+  p=jit_mem(p, "\x48\x8b\x83", 3, JIT_Z(clock)); /* iclock=clock */
+  p=jit_mem(p, "\x48\x89\x83", 3, JIT_Z(iclock));
+  p=jit_mem(p, "\xc7\x83", 2, JIT_Z(cpus.int_lock)); /* int_lock=0 */
+  return jit_imm32(p, 0);
+}
+
+/* decode instruction at pc as z80_decode() would */
+static void jit_decode(z80_t *z, uint16_t pc, int modifier, jit_instr_t *in) {
+  uint8_t b=z->dep->imemget8(z->dep_arg, pc);
+
+  memset(in, 0, sizeof(*in));
+  if(b==0xed) {
+    in->tabi=EI_TAB_ED;
+    in->rinc=1;
+    in->opcode=z->dep->imemget8(z->dep_arg, pc+1);
+    in->dlen=2;
+  } else if(b==0xcb && modifier!=0) {
+    in->tabi=EI_TAB_CB+modifier;
+    in->cbop=z->dep->imemget8(z->dep_arg, pc+1);
+    in->opcode=z->dep->imemget8(z->dep_arg, pc+2);
+    in->dlen=3;
+  } else if(b==0xcb) {
+    in->tabi=EI_TAB_CB;
+    in->rinc=1;
+    in->opcode=z->dep->imemget8(z->dep_arg, pc+1);
+    in->dlen=2;
+  } else {
+    in->tabi=EI_TAB_OP+modifier;
+    in->opcode=b;
+    in->dlen=1;
+  }
+  in->len=in->dlen+jit_info[in->tabi][in->opcode].oplen;
+}
+
+/* translate block starting at pc, NULL if it cannot be translated */
+static jit_blk_t *jit_translate(z80_t *z, uint16_t start) {
+  z80_jit_t *j=z->jit;
+  jit_blk_t *b;
+  jit_instr_t in;
+  jit_info_t *info;
+  uint8_t *p,*exit;
+  uint16_t pc;
+  unsigned n,i;
+  int modifier;
+
+  jit_decode(z, start, 0, &in);
+  if((start&0x3fff)+in.len > 0x4000) return NULL; /* spans two windows */
+
+  if(j->nblk>=JIT_NBLK || j->used+JIT_BLK_CODE > JIT_ARENA) jit_flush(j);
+  if(jit_protect(j, 1)!=0) return NULL;
+  b=&j->blk[j->nblk];
+
+  /* exit stub, then the entry point aligned to 16 bytes */
+  exit=p=j->arena+j->used;
+  p=jit_b(p, "\x48\x83\xc4\x08\x41\x5c\x5b\xc3", 8); /* add rsp,8; pop r12;
+                                                  pop rbx; ret */
+  while((uintptr_t)p & 15) *p++=0xcc;
+  b->code=p;
+  p=jit_b(p, "\x53\x41\x54\x48\x83\xec\x08\x48\x89\xfb\x49\xbc", 12);
+  p=jit_imm64(p, (uintptr_t)j);         /* push rbx; push r12; sub rsp,8;
+                                           mov rbx,rdi; mov r12,j */
+
+  pc=start;
+  n=0;
+  for(;;) {
+    info=&jit_info[in.tabi][in.opcode];
+#ifndef NO_Z80STAT
+    p=jit_emit_instr(p, &in, z->stat_on);
+#else
+    p=jit_emit_instr(p, &in, 0);
+#endif
+    pc+=in.len;
+    n++;
+
+    if(info->end || n==JIT_BLK_MAX) break;
+    modifier=info->modifier;
+    jit_decode(z, pc, modifier, &in);
+    if((start&0x3fff)+(uint16_t)(pc-start)+in.len > 0x4000) break;
+
+    p=jit_emit_next(p, pc, exit);
+  }
+
+  /* chain to the next block */
+  p=jit_b(p, "\x48\x89\xdf\x48\xb8", 5); /* mov rdi,rbx; mov rax,jit_chain */
+  p=jit_imm64(p, (uintptr_t)jit_chain);
+  p=jit_b(p, "\xff\xd0\x48\x85\xc0", 5); /* call rax; test rax,rax */
+  p=jit_jcc_exit(p, JIT_JE, exit);
+  p=jit_b(p, "\xff\xe0", 2);            /* jmp rax */
+  if(jit_protect(j, 0)!=0) { /* no block can run now */
+    jit_flush(j);
+    return NULL;
+  }
+
+  j->nblk++;
+  j->used=p-j->arena;
+  b->start=start;
+  b->len=(uint16_t)(pc-start);
+  b->next=j->page[start >> JIT_PAGE_SHIFT];
+  j->page[start >> JIT_PAGE_SHIFT]=b;
+  j->map[start]=b;
+  for(i=0;i<b->len;i++)
+    if(j->cover[(uint16_t)(start+i)]<255) j->cover[(uint16_t)(start+i)]++;
+  j->stat.blocks++;
+  return b;
+}
+
+/* recording dep (Z80_JIT_CHECK), forwards to the real dep */
+
+static void jit_log(z80_jit_t *j, int kind, uint16_t addr, uint8_t val) {
+  if(j->nlog<JIT_NLOG) {
+    j->log[j->nlog].kind=kind;
+    j->log[j->nlog].addr=addr;
+    j->log[j->nlog].val=val;
+  }
+  j->nlog++;
+}
+
+static uint8_t jit_rec_memget8(void *arg, uint16_t addr) {
+  z80_jit_t *j=((z80_t *)arg)->jit;
+  uint8_t v=j->dep->memget8(j->dep_arg, addr);
+
+  jit_log(j, JIT_LOG_RD, addr, v);
+  return v;
+}
+
+static uint8_t jit_rec_imemget8(void *arg, uint16_t addr) {
+  z80_jit_t *j=((z80_t *)arg)->jit;
+
+  return j->dep->imemget8(j->dep_arg, addr);
+}
+
+static void jit_rec_memset8(void *arg, uint16_t addr, uint8_t val) {
+  z80_jit_t *j=((z80_t *)arg)->jit;
+
+  jit_log(j, JIT_LOG_WR, addr, val);
+  j->dep->memset8(j->dep_arg, addr, val);
+}
+
+static void jit_rec_out8(void *arg, uint16_t addr, uint8_t val) {
+  z80_jit_t *j=((z80_t *)arg)->jit;
+
+  jit_log(j, JIT_LOG_OUT, addr, val);
+  j->dep->out8(j->dep_arg, addr, val);
+}
+
+static uint8_t jit_rec_in8(void *arg, uint16_t addr) {
+  z80_jit_t *j=((z80_t *)arg)->jit;
+  uint8_t v=j->dep->in8(j->dep_arg, addr);
+
+  jit_log(j, JIT_LOG_IN, addr, v);
+  return v;
+}
+
+static uint8_t jit_rec_snoop8(void *arg) {
+  z80_jit_t *j=((z80_t *)arg)->jit;
+  uint8_t v=j->dep->snoop8(j->dep_arg);
+
+  jit_log(j, JIT_LOG_SNOOP, 0, v);
+  return v;
+}
+
+static const z80_dep_t jit_rec_dep = {
+  jit_rec_memget8, jit_rec_imemget8, jit_rec_memset8,
+  jit_rec_out8, jit_rec_in8, jit_rec_snoop8
+};
+
+/* replaying dep (Z80_JIT_CHECK), checks accesses against the recording */
+
+static uint8_t jit_play(z80_jit_t *j, int kind, uint16_t addr, uint8_t val) {
+  jit_log_t *e;
+
+  if(j->plog>=j->nlog) {
+    j->bad=1;
+    return 0xff;
+  }
+  e=&j->log[j->plog++];
+  if(e->kind!=kind || e->addr!=addr) j->bad=1;
+  if((kind==JIT_LOG_WR || kind==JIT_LOG_OUT) && e->val!=val) j->bad=1;
+  return e->val;
+}
+
+static uint8_t jit_play_memget8(void *arg, uint16_t addr) {
+  return jit_play(((z80_t *)arg)->jit, JIT_LOG_RD, addr, 0);
+}
+
+static void jit_play_memset8(void *arg, uint16_t addr, uint8_t val) {
+  jit_play(((z80_t *)arg)->jit, JIT_LOG_WR, addr, val);
+}
+
+static void jit_play_out8(void *arg, uint16_t addr, uint8_t val) {
+  jit_play(((z80_t *)arg)->jit, JIT_LOG_OUT, addr, val);
+}
+
+static uint8_t jit_play_in8(void *arg, uint16_t addr) {
+  return jit_play(((z80_t *)arg)->jit, JIT_LOG_IN, addr, 0);
+}
+
+static uint8_t jit_play_snoop8(void *arg) {
+  return jit_play(((z80_t *)arg)->jit, JIT_LOG_SNOOP, 0, 0);
+}
+
+/* instruction fetches are not recorded, the block may have modified its code */
+static uint8_t jit_play_imemget8(void *arg, uint16_t addr) {
+  z80_jit_t *j=((z80_t *)arg)->jit;
+
+  if((uint16_t)(addr-j->src_start) < j->src_len)
+    return j->src[(uint16_t)(addr-j->src_start)];
+  return j->dep->imemget8(j->dep_arg, addr);
+}
+
+static const z80_dep_t jit_play_dep = {
+  jit_play_memget8, jit_play_imemget8, jit_play_memset8,
+  jit_play_out8, jit_play_in8, jit_play_snoop8
+};
+
+static int jit_same(z80s *a, z80s *b) {
+  return cpus_same(a, b) && a->R==b->R;
+}
+
+/* run block b and verify it by the interpreter */
+static void jit_check(z80_t *z, jit_blk_t *b) {
+  z80_jit_t *j=z->jit;
+  z80s pre,post;
+  unsigned long pre_clock,pre_iclock,post_clock,post_iclock;
+  unsigned i,n;
+#ifndef NO_Z80ICACHE
+  int icache_on;
+#endif
+
+  lazy_sync(z);
+  pre=z->cpus;
+  pre_clock=z->clock;
+  pre_iclock=z->iclock;
+
+  j->dep=z->dep;
+  j->dep_arg=z->dep_arg;
+  z->dep=&jit_rec_dep;
+  z->dep_arg=z;
+#ifndef NO_Z80IWIN
+  iwin_reset(z);
+#endif
+  j->nlog=0;
+  j->src_start=b->start;
+  j->src_len=b->len;
+  for(i=0;i<b->len;i++)
+    j->src[i]=j->dep->imemget8(j->dep_arg, b->start+i);
+
+  ((void (*)(z80_t *))b->code)(z);
+
+  lazy_sync(z);
+  post=z->cpus;
+  post_clock=z->clock;
+  post_iclock=z->iclock;
+  n=j->ninstr;
+
+  if(j->nlog<=JIT_NLOG) {
+    z->cpus=pre;
+    z->clock=pre_clock;
+    z->iclock=pre_iclock;
+    z->dep=&jit_play_dep;
+#ifndef NO_Z80IWIN
+    iwin_reset(z);
+#endif
+    j->plog=0;
+    j->bad=0;
+#ifndef NO_Z80ICACHE
+    icache_on=z->icache_on;
+    z->icache_on=0;         /* do not cache decodes of the old code */
+#endif
+
+    for(i=0;i<n;i++) {
+      if(i>0) {
+        z->iclock=z->clock;
+        z->cpus.int_lock=0;
+      }
+      z80_readinstr(z);
+      exec_decoded(z);
+      aot_executed(z);
+    }
+    lazy_sync(z);
+#ifndef NO_Z80ICACHE
+    z->icache_on=icache_on;
+#endif
+
+    j->stat.checked++;
+    if(j->bad || j->plog!=j->nlog || !jit_same(&z->cpus, &post) ||
+      z->clock!=post_clock) {
+      j->stat.mismatch++;
+      j->stat.mismatch_pc=j->src_start;
+    }
+
+    z->cpus=post;
+    z->clock=post_clock;
+    z->iclock=post_iclock;
+  }
+
+  z->dep=j->dep;
+  z->dep_arg=j->dep_arg;
+#ifndef NO_Z80IWIN
+  iwin_reset(z);
+#endif
+}
+
+/* execute translated block at PC, if there is one (or should be) */
+static int jit_run(z80_t *z) {
+  z80_jit_t *j=z->jit;
+  jit_blk_t *b;
+
+  if(j==NULL || j->mode==Z80_JIT_OFF || !z->aot_on || z->cpus.modifier!=0)
+    return 0;
+  b=j->map[z->cpus.PC];
+  if(b==NULL) {
+    if(++j->cnt[z->cpus.PC] < JIT_HOT) return 0;
+    j->cnt[z->cpus.PC]=0;
+    b=jit_translate(z, z->cpus.PC);
+    if(b==NULL) return 0;
+  }
+
+  j->dirty=0;
+  j->ninstr=0;
+  j->stat.runs++;
+  if(j->mode==Z80_JIT_CHECK)
+    jit_check(z, b);
+  else
+    ((void (*)(z80_t *))b->code)(z);
+  return 1;
+}
+#else
+static inline int jit_run(z80_t *z) {
+  (void)z;
+  return 0;
+}
+#endif
+
+/*
+ * set JIT mode (Z80_JIT_xxx), returns -1 if the JIT is not available
+ * (not compiled in or no executable memory)
+ */
+int z80_jit_enable(z80_t *z, int mode) {
+#ifdef Z80_JIT
+  z80_jit_t *j=z->jit;
+  void *arena;
+
+  if(j==NULL) {
+    if(mode==Z80_JIT_OFF) return 0;
+    arena=mmap(NULL, JIT_ARENA, PROT_READ | PROT_EXEC,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(arena==MAP_FAILED) return -1;
+    j=calloc(1, sizeof(z80_jit_t));
+    if(j==NULL) {
+      munmap(arena, JIT_ARENA);
+      return -1;
+    }
+    j->arena=arena;
+    z->jit=j;
+  }
+  j->mode=mode;
+  return 0;
+#else
+  (void)z;
+  return mode==Z80_JIT_OFF ? 0 : -1;
+#endif
+}
+
+/* get JIT statistics */
+void z80_jit_getstat(z80_t *z, z80_jit_stat_t *stat) {
+#ifdef Z80_JIT
+  if(z->jit!=NULL) {
+    *stat=z->jit->stat;
+    return;
+  }
+#else
+  (void)z;
+#endif
+  memset(stat, 0, sizeof(*stat));
+}
+
+void z80_resetstat(z80_t *z) {
+#ifndef NO_Z80STAT
+  int i,j;
+  
+  for(i=0;i<7;i++)
+    for(j=0;j<256;j++)
+      z->stat_tab[i][j]=0;
+#endif
+#ifndef NO_Z80IDLE
+  memset(&z->idle_stat, 0, sizeof(z->idle_stat));
+#endif
+}
+
+/* enable or disable counting of executed opcodes (see z80_getstat()) */
+void z80_stat_enable(z80_t *z, int enable) {
+#ifndef NO_Z80STAT
+  z->stat_on=enable;
+#ifdef Z80_JIT
+  /* translated code counts or not depending on stat_on at the time */
+  if(z->jit!=NULL) jit_flush(z->jit);
+#endif
+#else
+  (void)z;
+  (void)enable;
+#endif
+}
+
+unsigned z80_getstat(z80_t *z, int tab, uint8_t op)
+{
+#ifndef NO_Z80STAT
+	return z->stat_tab[tab][op];
+#else
+	return 0;
+#endif
+}
+
+/*
+ * base T-states of opcode op of decode table tab (as z80_getstat()), i.e.
+ * without a taken branch or repeat and, for DD/FD tables, without the prefix
+ */
+unsigned z80_op_tstates(int tab, uint8_t op)
+{
+	return pgm_read_byte(&ei_times[tab][op]);
+}
+
+/*
+ * Enable or disable profiling. With a host clock and a non-zero period,
+ * every period-th instruction is timed.
+ */
+void z80_prof_enable(z80_t *z, int enable, unsigned period,
+  z80_prof_clock_t clock) {
+#ifndef NO_Z80PROF
+  z->prof_on=enable;
+  z->prof_period=clock!=NULL ? period : 0;
+  z->prof_left=z->prof_period;
+  z->prof_clock=clock;
+#else
+  (void)z; (void)enable; (void)period; (void)clock;
+#endif
+}
+
+void z80_prof_reset(z80_t *z) {
+#ifndef NO_Z80PROF
+  memset(z->prof, 0, sizeof(z->prof));
+#else
+  (void)z;
+#endif
+}
+
+/* get profile of opcode op of decode table tab (as z80_getstat()) */
+void z80_prof_get(z80_t *z, int tab, uint8_t op, z80_prof_t *prof) {
+#ifndef NO_Z80PROF
+  *prof=z->prof[tab][op];
+#else
+  (void)z; (void)tab; (void)op;
+  memset(prof, 0, sizeof(*prof));
+#endif
+}
+
+#ifndef NO_Z80PROF
+static const char *const prof_tabs[7] = {
+  "op", "ddop", "fdop", "cbop", "ddcbop", "fdcbop", "edop"
+};
+#endif
+
+/* write profile of executed opcodes as CSV */
+int z80_prof_write_csv(z80_t *z, FILE *f) {
+#ifndef NO_Z80PROF
+  z80_prof_t *p;
+  int i,j;
+#endif
+
+  fprintf(f, "table,opcode,handler,count,tstates,samples,ns\n");
+#ifndef NO_Z80PROF
+  for(i=0;i<7;i++)
+    for(j=0;j<256;j++) {
+      p=&z->prof[i][j];
+      if(p->count==0) continue;
+      fprintf(f, "%s,0x%02x,%s,%lu,%lu,%lu,%llu\n", prof_tabs[i], j,
+        ei_names[i][j], p->count, p->tstates, p->samples, p->ns);
+    }
+#else
+  (void)z;
+#endif
+  return ferror(f) ? -1 : 0;
+}
+
+/* write profile of executed opcodes as JSON */
+int z80_prof_write_json(z80_t *z, FILE *f) {
+#ifndef NO_Z80PROF
+  z80_prof_t *p;
+  const char *sep="";
+  int i,j;
+#endif
+
+  fprintf(f, "[");
+#ifndef NO_Z80PROF
+  for(i=0;i<7;i++)
+    for(j=0;j<256;j++) {
+      p=&z->prof[i][j];
+      if(p->count==0) continue;
+      fprintf(f, "%s\n  {\"table\": \"%s\", \"opcode\": %d, "
+        "\"handler\": \"%s\", \"count\": %lu, \"tstates\": %lu, "
+        "\"samples\": %lu, \"ns\": %llu}", sep, prof_tabs[i], j,
+        ei_names[i][j], p->count, p->tstates, p->samples, p->ns);
+      sep=",";
+    }
+#else
+  (void)z;
+#endif
+  fprintf(f, "\n]\n");
+  return ferror(f) ? -1 : 0;
+}
+
+/* enable or disable skipping of idle loops (off after z80_init()) */
+void z80_idle_enable(z80_t *z, int enable) {
+#ifndef NO_Z80IDLE
+  z->idle_on=enable;
+#else
+  (void)z; (void)enable;
+#endif
+}
+
+/* get idle loop statistics */
+void z80_idle_getstat(z80_t *z, z80_idle_stat_t *stat) {
+#ifndef NO_Z80IDLE
+  *stat=z->idle_stat;
+#else
+  (void)z;
+  memset(stat, 0, sizeof(*stat));
+#endif
+}
+
+/*
+ * Decoded instruction cache
+ *
+ * Remembers for each address how the prefixes and opcode there were
+ * decoded, so that the decoder does not have to fetch them again.
+ * An entry is valid while its generation matches that of its 16K window.
+ * Writes by the CPU invalidate the affected entries, anyone else changing
+ * memory or the memory map must call z80_icache_inval() or flush.
+ */
+
+/* enable or disable the decoded instruction cache */
+void z80_icache_enable(z80_t *z, int enable) {
+#ifndef NO_Z80ICACHE
+  if(enable && !z->icache_on) z80_icache_flush(z);
+  z->icache_on=enable;
+#else
+  (void)z; (void)enable;
+#endif
+}
+
+/* memory at addr was modified */
+void z80_icache_inval(z80_t *z, uint16_t addr) {
+#ifndef NO_Z80ICACHE
+  icache_inval(z, addr);
+#endif
+#ifdef Z80_JIT
+  if(z->jit!=NULL) jit_inval(z, addr);
+#endif
+#if defined(NO_Z80ICACHE) && !defined(Z80_JIT)
+  (void)z; (void)addr;
+#endif
+}
+
+/* 16K window bank was remapped or modified */
+void z80_icache_flush_bank(z80_t *z, int bank) {
+#ifndef NO_Z80ICACHE
+  int i;
+#endif
+
+#ifndef NO_Z80IWIN
+  /* the window may map to different memory now */
+  z->iwin[bank]=NULL;
+  z->iwin_known&=~(1u << bank);
+#endif
+#ifndef NO_Z80ICACHE
+  if(++z->icgen[bank]==0) { /* wrapped around, start afresh */
+    memset(z->icache, 0, sizeof(z->icache));
+    for(i=0;i<Z80_ICACHE_WINS;i++)
+      z->icgen[i]=1;
+  }
+#endif
+#ifdef Z80_JIT
+  if(z->jit!=NULL) jit_inval_bank(z, bank);
+#endif
+#if defined(NO_Z80ICACHE) && !defined(Z80_JIT) && defined(NO_Z80IWIN)
+  (void)z; (void)bank;
+#endif
+}
+
+/* whole memory was modified */
+void z80_icache_flush(z80_t *z) {
+  int i;
+
+  for(i=0;i<4;i++)
+    z80_icache_flush_bank(z, i);
+}
+
+#ifndef NO_Z80ICACHE
+/* remember decode of the instruction at pc */
+static void icache_fill(z80_t *z, uint16_t pc, uint8_t rinc) {
+  z80_icent_t *e;
+  uint8_t len;
+
+  len=(uint16_t)(z->cpus.PC-pc);
+  if((pc & 0x3fff)+len > 0x4000) return; /* spans two windows */
+
+  e=&z->icache[pc];
+  e->gen=z->icgen[pc>>14];
+  e->modifier=z->cpus.modifier;
+  e->len=len;
+  e->tabi=z->ei_tabi;
+  e->opcode=z->opcode;
+  e->cbop=z->cbop;
+  e->rinc=rinc;
+}
+#endif
+
+static int z80_decode(z80_t *z) {
+
+  z->opcode=z80_iget8(z);
+
+  if(z->opcode==0xed) {
+    incr_R(z, 1);
+    z->opcode=z80_iget8(z);
+    z->ei_tabi=EI_TAB_ED;
+//    prefix2=0xed;    
+    return 1;
+  }
+
+  if(z->opcode==0xcb) {
+    if(z->cpus.modifier!=0) {
+      z->cbop=z80_iget8(z);
+    } else {
+      incr_R(z, 1);
+      z->opcode=z80_iget8(z);
+      z->ei_tabi=EI_TAB_CB;
+      return 1;
+    }
+    z->opcode=z80_iget8(z);
+    z->ei_tabi=EI_TAB_CB+z->cpus.modifier;
+//    prefix2=0xcb;
+    return 0;
+  }
+
+  /* one-byte z->opcode */
+//  prefix2=0;
+  z->ei_tabi=EI_TAB_OP+z->cpus.modifier;
+  return 0;
+}
+
+int z80_readinstr(z80_t *z) {
+#ifndef NO_Z80ICACHE
+  uint16_t pc;
+  z80_icent_t *e;
+
+  if(z->icache_on) {
+    pc=z->cpus.PC;
+    e=&z->icache[pc];
+    if(e->gen==z->icgen[pc>>14] && e->modifier==z->cpus.modifier) {
+      z->opcode=e->opcode;
+      z->ei_tabi=e->tabi;
+      z->cbop=e->cbop;
+      if(e->rinc) incr_R(z, 1);
+      z->cpus.PC+=e->len;
+      return 0;
+    }
+    icache_fill(z, pc, z80_decode(z));
+    return 0;
+  }
+#endif
+  z80_decode(z);
+  return 0;
+}
+
+/*
+ * While halted the CPU just executes NOPs until an interrupt arrives.
+ * Execute all the NOPs up to the deadline at once.
+ */
+static void halt_skip(z80_t *z) {
+#ifndef NO_Z80CLOCK
+  unsigned long n;
+
+  if((long)(z->clock - z->deadline) >= 0) return;
+  if(ev_due(z)) return;
+  if(brk_hit(z)) return;
+
+  /* number of NOPs starting before the deadline */
+  n=(z->deadline - z->clock + 3) / 4;
+  z->iclock=z->clock + 4*(n-1);
+  z->clock+=4*n;
+  incr_R(z, n & 0x7f);
+#endif
+}
+
+#ifndef NO_Z80IDLE
+/*
+ * Idle loops
+ *
+ * Programs often wait for a key or a change in memory by spinning in
+ * a short loop which only reads memory or stable ports and sets flags.
+ * When a jump goes back to where the previous one went, the registers
+ * (except R) are the same and there were no writes, outputs or reads of
+ * unstable ports in between, each further iteration will do just the same
+ * until the host gets control back: memory only changes by CPU writes and
+ * ports by devices, which run at the deadline. All whole iterations that
+ * end before the deadline are then skipped at once.
+ */
+
+#define IDLE_SPAN 64  /* longest backward jump that may close a loop */
+
+static void idle_count(z80_t *z, unsigned long period, unsigned long n) {
+  z80_idle_stat_t *st=&z->idle_stat;
+  z80_idle_loop_t *l;
+  unsigned i;
+
+  st->skips++;
+  st->iters+=n;
+  st->tstates+=n*period;
+
+  /* find the loop, else replace the one skipped least */
+  l=&st->loop[0];
+  for(i=0;i<st->nloops;i++) {
+    if(st->loop[i].pc==z->cpus.PC && st->loop[i].period==period) break;
+    if(st->loop[i].iters<l->iters) l=&st->loop[i];
+  }
+  if(i<st->nloops) {
+    l=&st->loop[i];
+  } else {
+    if(st->nloops<Z80_IDLE_LOOPS) l=&st->loop[st->nloops++];
+    l->pc=z->cpus.PC;
+    l->period=period;
+    l->skips=0;
+    l->iters=0;
+  }
+  l->skips++;
+  l->iters+=n;
+}
+
+/* a backward jump was taken, check for an idle loop */
+static __attribute__((noinline)) void idle_check(z80_t *z) {
+  unsigned long period,n;
+  uint8_t dr;
+
+  lazy_sync(z);
+  if(!z->idle_dirty && (long)(z->deadline - z->clock) > 0 &&
+    cpus_same(&z->idle_cpus, &z->cpus)) {
+    period=z->clock - z->idle_clock;
+    n=(z->deadline - z->clock - 1) / period;
+    if(n>0) {
+      dr=(z->cpus.R - z->idle_cpus.R) & 0x7f;
+      z->clock+=n*period;
+      z->iclock+=n*period;
+      incr_R(z, (n*dr) & 0x7f);
+      lazy_sync(z);
+      idle_count(z, period, n);
+    }
+  }
+
+  z->idle_cpus=z->cpus;
+  z->idle_clock=z->clock;
+  z->idle_dirty=0;
+}
+#endif
+
+#ifndef NO_Z80PROF
+/*
+ * execute the decoded instruction, adding it to the profile. Every
+ * prof_period-th instruction is also timed by the host clock (with block
+ * instructions, all iterations executed in one go count as timed).
+ */
+static void prof_dispatch(z80_t *z) {
+  z80_prof_t *p=&z->prof[z->ei_tabi][z->opcode];
+  unsigned long clock=z->clock;
+  unsigned long long t;
+
+  p->count++;
+  if(z->prof_period!=0 && --z->prof_left==0) {
+    z->prof_left=z->prof_period;
+    z->prof_timed=1;
+    p->samples++;
+    t=z->prof_clock();
+    exec_decoded(z);
+    p->ns+=z->prof_clock()-t;
+    z->prof_timed=0;
+  } else {
+    exec_decoded(z);
+  }
+  p->tstates+=z->clock-clock;
+}
+#endif
+
+/*
+ * While profiling, every instruction is executed by the interpreter, so
+ * that none are missed by running in translated code.
+ */
+static inline int prof_active(z80_t *z) {
+#ifndef NO_Z80PROF
+  return z->prof_on;
+#else
+  (void)z;
+  return 0;
+#endif
+}
+
+/*
+ * The interpreter loop is compiled in a variant for each setting of the
+ * run-time options it would otherwise have to test before every
+ * instruction (so far opcode statistics, see z80_stat_enable()).
+ * z80_execinstr() and z80_run_until() pick the variant once per call.
+ */
+static inline __attribute__((always_inline)) void execinstr_v(z80_t *z,
+  int stat) {
+  z->iclock=z->clock;
+
+  /* Process pending NMI or interrupt */
+  if(ev_due(z)) z80_events(z);
+
+  z->cpus.int_lock=0;
+
+  if(z->cpus.halted) { /* NOP */
+    z80_clock_inc(z, 4);
+    incr_R(z, 1);
+    halt_skip(z);
+  } else if(prof_active(z) || (!aot_run(z) && !jit_run(z))) {
+    /*
+     * A DD/FD prefix executes as a 4T instruction of its own which locks
+     * out interrupts. Unless the host needs control back right after it,
+     * go on with the instruction it modifies without leaving the loop.
+     */
+    for(;;) {
+      //printf("read instr..\n");
+      z80_readinstr(z);
+
+      //printf("exec instr..\n");
+#ifndef NO_Z80STAT
+      if(stat) z->stat_tab[z->ei_tabi][z->opcode]++;
+#else
+      (void)stat;
+#endif
+
+#ifndef NO_Z80PROF
+      if(z->prof_on) prof_dispatch(z);
+      else
+#endif
+      exec_decoded(z); /* FAST branch .. execute the instruction */
+
+      incr_R(z, 1);
+
+      /* turn off old modifier prefix (unless set just now) */
+      if(z->opcode!=0xdd && z->opcode!=0xfd) z->cpus.modifier=0;
+
+      if(z->ei_tabi>=EI_TAB_CB || z->cpus.modifier==0) break; /* not DD/FD */
+      if((long)(z->clock - z->deadline) >= 0 || brk_hit(z)) break;
+
+      z->iclock=z->clock;
+      z->cpus.int_lock=0;
+    }
+  }
+#ifdef NO_Z80CLOCK
+	z->clock += 12;
+#endif
+}
+
+void z80_execinstr(z80_t *z) {
+#ifndef NO_Z80STAT
+  if(z->stat_on) execinstr_v(z, 1);
+  else
+#endif
+  execinstr_v(z, 0);
+  lazy_sync(z);
+}
+
+static inline __attribute__((always_inline)) void run_until_v(z80_t *z,
+  unsigned long deadline, int stat) {
+#ifndef NO_Z80IDLE
+  uint16_t pc;
+
+  z->idle_dirty=1; /* the host may have changed anything */
+#endif
+  z->deadline=deadline;
+  do {
+#ifndef NO_Z80IDLE
+    pc=z->cpus.PC;
+#endif
+    execinstr_v(z, stat);
+#ifndef NO_Z80IDLE
+    if(z->idle_on && (uint16_t)(pc - z->cpus.PC - 1) < IDLE_SPAN)
+      idle_check(z);
+#endif
+  } while((long)(z->clock - deadline) < 0 && !brk_hit(z));
+  lazy_sync(z);
+}
+
+/*
+ * Execute instructions until the clock reaches deadline or PC reaches
+ * a breakpoint (but execute at least one instruction).
+ */
+void z80_run_until(z80_t *z, unsigned long deadline) {
+#ifndef NO_Z80STAT
+  if(z->stat_on) {
+    run_until_v(z, deadline, 1);
+    return;
+  }
+#endif
+  run_until_v(z, deadline, 0);
+}
+
+/* set or clear breakpoint at addr */
+void z80_set_brk(z80_t *z, uint16_t addr, int enable) {
+  if(enable)
+    z->brk[addr >> 3] |= 1 << (addr & 7);
+  else
+    z->brk[addr >> 3] &= ~(1 << (addr & 7));
+}
+
+static void z80_check_int(z80_t *z) {
+  uint16_t addr;
+  uint8_t data;
+//  printf("interrupt->DI\n");
+
+  if(!z->cpus.int_pending) return;
+  if(z->cpus.int_lock) return; /* after EI or DI or inside an instruction */
+
+  /* Clear interrupt pending flag */
+  z->cpus.int_pending=0;
+
+  /* If interrupts are disabled, just drop the interrupt */
+  if(!z->cpus.IFF1) return; /* IFF2 just tells the NMI service routine
+                               whether the interrupted program disabled
+			       maskable interrupts */
+  z->cpus.halted=0;
+  z->cpus.IFF1=z->cpus.IFF2=0;
+
+  switch(z->cpus.int_mode) {
+    case 0: /* this is not quite right yet ..*/
+      /* the actual instruction should be read from the data bus */
+      /* but if that instruction were longer than 1 byte? */
+      incr_R(z, 2);
+      _push16(z, z->cpus.PC);
+      z->cpus.PC=0x0038;
+      z80_clock_inc(z, 13);
+      break;
+    case 1:
+      incr_R(z, 2);
+      _push16(z, z->cpus.PC);
+      z->cpus.PC=0x0038;
+      z80_clock_inc(z, 13);
+      break;
+    case 2:
+      incr_R(z, 2);
+      _push16(z, z->cpus.PC);
+      data = z80_snoop8(z);
+      addr=((uint16_t)z->cpus.I<<8) | (uint16_t)data;
+      z->cpus.PC=z80_memget16(z, addr);
+//      printf("IM 2 INT: I=%02x D8=%02x tabi=%04x dst=%04x\n",z->cpus.I,data,addr,z->cpus.PC);
+      z80_clock_inc(z, 19);
+      break;
+  }
+}
+
+static void z80_check_nmi(z80_t *z) {
+
+  if(!z->cpus.nmi_pending) return;
+  if(z->cpus.int_lock) return;
+//  printf("NMI!\n");
+  
+  z->cpus.nmi_pending=0;
+  z->cpus.halted=0;
+  z->cpus.IFF1=0;
+
+  _push16(z, z->cpus.PC);
+  z->cpus.PC=0x0066;
+  
+  incr_R(z, 2);
+  z80_clock_inc(z, 11);
+}
+
+/*
+ * Slow path of execinstr(), taken only while an event is due. As long as
+ * INT or NMI stays pending (e.g. after EI or a DD/FD prefix), keep checking
+ * before every instruction.
+ */
+static void z80_events(z80_t *z) {
+  z80_check_nmi(z);
+  z80_check_int(z);
+
+  if(!z->cpus.int_pending && !z->cpus.nmi_pending)
+    z->ev_clock=z->clock+EV_NEVER;
+}
+
+void z80_int(z80_t *z)
+{
+  z->cpus.int_pending = 1;
+  z->ev_clock = z->clock;
+}
+
+void z80_nmi(z80_t *z)
+{
+  z->cpus.nmi_pending = 1;
+  z->ev_clock = z->clock;
+}
+
+int z80_reset(z80_t *z) {
+  z->cpus.IFF1=z->cpus.IFF2=0;
+  z->cpus.int_mode=0;
+  z->cpus.int_pending=0;
+  z->cpus.nmi_pending=0;
+  z->ev_clock=z->clock+EV_NEVER;
+  z->cpus.PC=0;
+
+  z->cpus.SP=0;
+  z->cpus.I=0;
+  setR(z, 0);
+  
+  z->cpus.halted=0;
+  z->cpus.int_lock=0;
+  z->cpus.modifier=0;
+  
+  z->cpus.r[rA]=0;  setF(z, 0);
+  z->cpus.r[rB]=0;  z->cpus.r[rC]=0;
+  z->cpus.r[rD]=0;  z->cpus.r[rE]=0;
+  z->cpus.r[rH]=0;  z->cpus.r[rL]=0;
+  z->cpus.IX=0;     z->cpus.IY=0;
+  z->cpus.r_[rA]=0; z->cpus.F_=0;
+  z->cpus.r_[rB]=0; z->cpus.r_[rC]=0;
+  z->cpus.r_[rD]=0; z->cpus.r_[rE]=0;
+  z->cpus.r_[rH]=0; z->cpus.r_[rL]=0;
+
+  return 0;
+}
+
+/* initialize a Z80 context, dep provides memory and I/O access */
+void z80_init(z80_t *z, const z80_dep_t *dep, void *dep_arg) {
+  z->rcpus=&z->cpus;
+  z->clock=0;
+  z->iclock=0;
+  z->deadline=0;
+  memset(z->brk, 0, sizeof(z->brk));
+  z->opcode=0;
+  z->cbop=0;
+  z->ei_tabi=0;
+  z->uoc=0;
+  z->smc=0;
+#ifndef NO_Z80STAT
+  z->stat_on=0;
+#endif
+#ifndef NO_Z80IDLE
+  z->idle_on=0;
+  z->idle_dirty=1;
+#endif
+  z80_resetstat(z);
+#ifndef NO_Z80PROF
+  z->prof_on=0;
+  z->prof_period=0;
+  z->prof_left=0;
+  z->prof_timed=0;
+  z->prof_clock=NULL;
+  z80_prof_reset(z);
+#endif
+#ifdef Z80_LAZY
+  z->lf_op=LF_NONE;
+  z->r_inc=0;
+#endif
+
+#if !defined(NO_Z80AOT) || defined(Z80_JIT)
+  z->aot=NULL;
+  z->aot_on=1;
+#endif
+#ifdef Z80_JIT
+  z->jit=NULL;
+#endif
+
+#ifndef NO_Z80ICACHE
+  memset(z->icache, 0, sizeof(z->icache));
+  memset(z->icgen, 0, sizeof(z->icgen));
+  z80_icache_flush(z);
+  z->icache_on=1;
+#endif
+
+  z->dep=dep;
+  z->dep_arg=dep_arg;
+#ifndef NO_Z80IWIN
+  iwin_reset(z);
+#endif
+
+  z80_reset(z);
 }
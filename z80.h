@@ -33,6 +33,7 @@
 #define Z80_H
 
 #include <stdint.h>
+#include <stdio.h>
 
 /* flags */
 #define fS  0x80
@@ -51,20 +52,59 @@
 #define fD  0xd7
 
 
-#define rA  0x7
+/*
+ * Register pairs are kept as 16-bit words in host byte order, so the index
+ * of an 8-bit register within r[] depends on the host. Always use these
+ * names (or Z80_REG8()) to index r[] and r_[], rBC etc. to index rp[], rp_[].
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define rA  0x6
+#define rF  0x7
 #define rB  0x0
 #define rC  0x1
 #define rD  0x2
 #define rE  0x3
 #define rH  0x4
 #define rL  0x5
+#define Z80_RSWAP 0
+#else
+#define rA  0x7
+#define rF  0x6
+#define rB  0x1
+#define rC  0x0
+#define rD  0x3
+#define rE  0x2
+#define rH  0x5
+#define rL  0x4
+#define Z80_RSWAP 1
+#endif
+
+#define rBC 0x0
+#define rDE 0x1
+#define rHL 0x2
+#define rAF 0x3
+
+/* index in r[] of register n as encoded in opcodes (B,C,D,E,H,L,F,A) */
+#define Z80_REG8(n) ((n) ^ Z80_RSWAP ^ (((n) >> 1) & ((n) >> 2) & 1))
 
 typedef struct _z80s {     /*** registers of the Z80 CPU ***/
-  uint8_t r[8];            /* all-purpose registers,HL reg */
-  uint8_t F;               /* flags register */
+  union {
+    uint8_t r[8];          /* all-purpose registers and flags */
+    uint16_t rp[4];        /* BC, DE, HL, AF */
+    struct {
+      uint8_t r_fpad[rF];
+      uint8_t F;           /* flags register */
+    };
+  };
 
-  uint8_t r_[8];      	   /* alternative registers */
-  uint8_t F_;
+  union {
+    uint8_t r_[8];         /* alternative registers */
+    uint16_t rp_[4];
+    struct {
+      uint8_t r_fpad_[rF];
+      uint8_t F_;
+    };
+  };
 
   uint8_t I;               /* interrupt page address register */
   uint16_t IX, IY;              /* index registers */
@@ -81,28 +121,223 @@ typedef struct _z80s {     /*** registers of the Z80 CPU ***/
   int halted;		   /* halted by the HALT instruction? */
 } z80s;
 
-extern z80s cpus;
-extern z80s *rcpus;
-extern unsigned long z80_clock;
-extern unsigned long uoc;
-extern unsigned long smc;
+/** Memory and I/O access callbacks of a Z80 context */
+typedef struct {
+  uint8_t (*memget8)(void *, uint16_t);
+  uint8_t (*imemget8)(void *, uint16_t);	/* instruction fetch */
+  void (*memset8)(void *, uint16_t, uint8_t);
+  void (*out8)(void *, uint16_t, uint8_t);
+  uint8_t (*in8)(void *, uint16_t);
+  uint8_t (*snoop8)(void *);		/* data bus during IM 2 ack */
+  /* port reads return the same value until the deadline (optional) */
+  int (*in8_stable)(void *, uint16_t);
+  /* host memory of the 16K window containing the address, from which
+     imemget8 fetches, or NULL (optional) */
+  const uint8_t *(*imemptr)(void *, uint16_t);
+  /* host memory of the 8K pages for data reads and writes (optional).
+     The tables may be repointed at any time. A NULL write page means
+     stores to it have to go through memset8 */
+  uint8_t *const *rpage;
+  uint8_t *const *wpage;
+} z80_dep_t;
+
+/* page size of z80_dep_t.rpage/wpage */
+#define Z80_PAGE_SHIFT 13
+#define Z80_PAGE_MASK  ((1 << Z80_PAGE_SHIFT) - 1)
+
+#ifndef NO_Z80ICACHE
+/** Decoded instruction cache entry (prefix and opcode decode of one address) */
+typedef struct {
+  uint16_t gen;            /* generation of the 16K window, 0 = invalid */
+  uint8_t modifier;        /* DD/FD modifier in effect when decoded */
+  uint8_t len;             /* bytes consumed by the decoder */
+  uint8_t tabi;            /* decode table */
+  uint8_t opcode;
+  uint8_t cbop;            /* displacement of DDCB/FDCB instruction */
+  uint8_t rinc;            /* extra R increment (CB/ED prefix) */
+} z80_icent_t;
+
+#define Z80_ICACHE_WINS 4  /* number of 16K windows */
+#endif
+
+#ifndef NO_Z80IDLE
+#define Z80_IDLE_LOOPS 16  /* idle loops to keep statistics for */
+
+/** Statistics of one idle loop */
+typedef struct {
+  uint16_t pc;             /* loop start */
+  unsigned long period;    /* T-states per iteration */
+  unsigned long skips;     /* times skipped ahead */
+  unsigned long iters;     /* iterations skipped */
+} z80_idle_loop_t;
+#endif
+
+/** Idle loop statistics */
+typedef struct {
+  unsigned long skips;     /* times skipped ahead */
+  unsigned long iters;     /* iterations skipped */
+  unsigned long tstates;   /* T-states skipped */
+#ifndef NO_Z80IDLE
+  unsigned nloops;         /* loops in loop[] */
+  z80_idle_loop_t loop[Z80_IDLE_LOOPS]; /* most recently skipped loops */
+#endif
+} z80_idle_stat_t;
+
+/** Translated code of a ROM image (see aotgen.c) */
+typedef struct z80_aot z80_aot_t;
+
+/** JIT translator state (-DZ80_JIT) */
+typedef struct z80_jit z80_jit_t;
+
+/* JIT modes */
+#define Z80_JIT_OFF   0    /* interpret */
+#define Z80_JIT_ON    1    /* execute translated blocks */
+#define Z80_JIT_CHECK 2    /* execute blocks, verify them by the interpreter */
+
+/** JIT statistics */
+typedef struct {
+  unsigned long blocks;    /* blocks translated */
+  unsigned long runs;      /* blocks entered from the interpreter */
+  unsigned long chains;    /* blocks entered from another block */
+  unsigned long invals;    /* blocks invalidated */
+  unsigned long flushes;   /* translation arena flushes */
+  unsigned long checked;   /* block runs verified (Z80_JIT_CHECK) */
+  unsigned long mismatch;  /* block runs that failed verification */
+  uint16_t mismatch_pc;    /* start of the last block that failed */
+} z80_jit_stat_t;
+
+/** Host clock used for profiling, returns nanoseconds */
+typedef unsigned long long (*z80_prof_clock_t)(void);
+
+/** Profile of one opcode (see z80_prof_enable()) */
+typedef struct {
+  unsigned long count;     /* executions */
+  unsigned long tstates;   /* emulated T-states spent */
+  unsigned long samples;   /* executions timed on the host */
+  unsigned long long ns;   /* host nanoseconds spent in timed executions */
+} z80_prof_t;
+
+/** Z80 CPU context */
+typedef struct _z80 {
+  z80s cpus;               /* registers */
+  z80s *rcpus;             /* CPU state used to read memory addresses from
+                              (differs from &cpus with Spec256) */
+  unsigned long clock;     /* T-state counter */
+  unsigned long iclock;    /* T-state at which the current instruction
+                              started */
+  unsigned long deadline;  /* the host needs control back at this T-state,
+                              until then the core may run ahead */
+  unsigned long ev_clock;  /* INT or NMI may be pending from this T-state
+                              on (see z80_int(), z80_nmi()) */
+
+#ifdef Z80_LAZY
+  /* flags and R are brought up to date only when needed */
+  uint8_t lf_op;           /* operation F does not reflect yet (LF_xxx) */
+  uint8_t lf_f;            /* flags known before the operation */
+  uint16_t lf_a, lf_b;     /* operands of the operation */
+  uint16_t lf_res;         /* result of the operation */
+  unsigned r_inc;          /* increments of R not applied yet */
+#endif
+
+  uint8_t opcode;          /* opcode being executed */
+  uint8_t cbop;            /* displacement of DDCB/FDCB instruction */
+  int ei_tabi;             /* decode table of the current instruction */
+
+  /* debugging & statistics */
+  unsigned long uoc;       /* unsupported opcode counter */
+  unsigned long smc;       /* stray modifier counter */
+#ifndef NO_Z80STAT
+  int stat_on;             /* count executed opcodes in stat_tab */
+  unsigned stat_tab[7][256];
+#endif
+
+#ifndef NO_Z80PROF
+  /* per-opcode profile, indexed like stat_tab */
+  int prof_on;             /* profiling enabled */
+  unsigned prof_period;    /* time every prof_period-th instruction */
+  unsigned prof_left;      /* instructions until the next timed one */
+  int prof_timed;          /* the current instruction is being timed */
+  z80_prof_clock_t prof_clock;
+  z80_prof_t prof[7][256];
+#endif
+
+  uint8_t brk[65536/8];    /* breakpoint bitmap for z80_run_until() */
+
+#ifndef NO_Z80IDLE
+  /* idle loop detection in z80_run_until() */
+  int idle_on;             /* idle loop skipping enabled */
+  int idle_dirty;          /* side effects since idle_cpus was taken */
+  z80s idle_cpus;          /* state at the previous backward jump */
+  unsigned long idle_clock;
+  z80_idle_stat_t idle_stat;
+#endif
+
+#if !defined(NO_Z80AOT) || defined(Z80_JIT)
+  z80_aot_t *aot;          /* translated code of the ROM at 0000-3FFF */
+  int aot_on;              /* translated code (ROM and JIT) enabled */
+#endif
+#ifdef Z80_JIT
+  z80_jit_t *jit;          /* JIT translator state, NULL until enabled */
+#endif
+
+  const z80_dep_t *dep;    /* memory and I/O access */
+  void *dep_arg;           /* argument to dep callbacks */
+
+#ifndef NO_Z80IWIN
+  /* instruction fetch straight from host memory (dep->imemptr) */
+  const uint8_t *iwin[4];  /* memory of each 16K window, NULL if none */
+  unsigned iwin_known;     /* bitmap of windows for which iwin[] is known */
+#endif
+
+#ifndef NO_Z80ICACHE
+  int icache_on;           /* decoded instruction cache enabled */
+  uint16_t icgen[Z80_ICACHE_WINS]; /* current generation of each window */
+  z80_icent_t icache[65536];
+#endif
+} z80_t;
 
 void z80_init_tables(void);
-void z80_execinstr(void);
-int z80_reset(void);
-void z80_nmi(void);
-void z80_int(void);
-
-void z80_resetstat(void);
-unsigned z80_getstat(int, uint8_t);
-
-uint16_t z80_getAF(void);
-uint16_t z80_getBC(void);
-uint16_t z80_getDE(void);
-uint16_t z80_getHL(void);
-uint16_t z80_getAF_(void);
-uint16_t z80_getBC_(void);
-uint16_t z80_getDE_(void);
-uint16_t z80_getHL_(void);
+void z80_init(z80_t *, const z80_dep_t *, void *);
+void z80_execinstr(z80_t *);
+void z80_run_until(z80_t *, unsigned long);
+void z80_set_brk(z80_t *, uint16_t, int);
+int z80_reset(z80_t *);
+void z80_nmi(z80_t *);
+void z80_int(z80_t *);
+
+void z80_resetstat(z80_t *);
+void z80_stat_enable(z80_t *, int);
+unsigned z80_getstat(z80_t *, int, uint8_t);
+unsigned z80_op_tstates(int, uint8_t);
+
+void z80_prof_enable(z80_t *, int, unsigned, z80_prof_clock_t);
+void z80_prof_reset(z80_t *);
+void z80_prof_get(z80_t *, int, uint8_t, z80_prof_t *);
+int z80_prof_write_csv(z80_t *, FILE *);
+int z80_prof_write_json(z80_t *, FILE *);
+
+void z80_idle_enable(z80_t *, int);
+void z80_idle_getstat(z80_t *, z80_idle_stat_t *);
+
+void z80_icache_enable(z80_t *, int);
+void z80_icache_inval(z80_t *, uint16_t);
+void z80_icache_flush_bank(z80_t *, int);
+void z80_icache_flush(z80_t *);
+
+z80_aot_t *z80_aot_find(const uint8_t *);
+void z80_aot_map(z80_t *, z80_aot_t *);
+void z80_aot_enable(z80_t *, int);
+
+int z80_jit_enable(z80_t *, int);
+void z80_jit_getstat(z80_t *, z80_jit_stat_t *);
+
+uint16_t z80_getAF(z80_t *);
+uint16_t z80_getBC(z80_t *);
+uint16_t z80_getDE(z80_t *);
+uint16_t z80_getHL(z80_t *);
+uint16_t z80_getAF_(z80_t *);
+uint16_t z80_getBC_(z80_t *);
+uint16_t z80_getDE_(z80_t *);
+uint16_t z80_getHL_(z80_t *);
 
 #endif
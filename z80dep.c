@@ -31,34 +31,127 @@
 
 #include <stdint.h>
 #include "memio.h"
+#include "video/defs.h"
 #include "z80dep.h"
+#include "zx.h"
+#include "zx_scr.h"
 
-uint8_t z80_memget8(uint16_t addr)
+/*
+ * The video generator does not catch up with the CPU after every
+ * instruction, so it needs to do so before the CPU changes what is being
+ * displayed or reads what the video generator puts on the bus.
+ */
+
+/** Determine if address maps to displayed screen memory */
+static int zx_z80_is_scr(zx_machine_t *mach, uint16_t addr)
+{
+	uintptr_t p = (uintptr_t)(mach->wpage[addr >> ZX_PAGE_SHIFT] +
+	    (addr & ZX_PAGE_MASK));
+
+	return p - (uintptr_t)mach->scr <= ZX_ATTR_END;
+}
+
+/** Update the pages the core stores to after the memory map changed.
+ *
+ * Pages holding displayed screen memory and, while write tracking is on,
+ * RAM pages not yet marked dirty are left out (NULL in
+ * zx_machine_t.z80_wpage) so that those stores go through
+ * zx_z80_memset8().
+ */
+void zx_z80_remap(zx_machine_t *mach)
+{
+	uintptr_t p;
+	int i;
+
+	for (i = 0; i < ZX_PAGES; i++) {
+		p = (uintptr_t)mach->wpage[i];
+		if (p <= (uintptr_t)mach->scr + ZX_ATTR_END &&
+		    (uintptr_t)mach->scr < p + ZX_PAGE_SIZE)
+			mach->z80_wpage[i] = NULL;
+		else if (zx_mem_wprotect(mach, mach->wpage[i]))
+			mach->z80_wpage[i] = NULL;
+		else
+			mach->z80_wpage[i] = mach->wpage[i];
+	}
+}
+
+static uint8_t zx_z80_memget8(void *arg, uint16_t addr)
 {
-	return zx_memget8(addr);
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	return zx_memget8(mach, addr);
 }
 
-uint8_t z80_imemget8(uint16_t addr)
+static uint8_t zx_z80_imemget8(void *arg, uint16_t addr)
 {
-	return zx_imemget8(addr);
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	return zx_imemget8(mach, addr);
 }
 
-void z80_memset8(uint16_t addr, uint8_t val)
+static void zx_z80_memset8(void *arg, uint16_t addr, uint8_t val)
 {
-	zx_memset8(addr, val);
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	if (zx_z80_is_scr(mach, addr))
+		zx_scr_sync(mach, mach->cpu.iclock);
+	zx_memset8(mach, addr, val);
 }
 
-uint8_t z80_in8(uint16_t a)
+static uint8_t zx_z80_in8(void *arg, uint16_t a)
 {
-	return zx_in8(a);
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	zx_scr_sync(mach, mach->cpu.iclock);
+	return zx_in8(mach, a);
 }
 
-void z80_out8(uint16_t addr, uint8_t val)
+static void zx_z80_out8(void *arg, uint16_t addr, uint8_t val)
 {
-	zx_out8(addr, val);
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	zx_scr_sync(mach, mach->cpu.iclock);
+	zx_out8(mach, addr, val);
 }
 
-uint8_t z80_snoop8(void)
+static uint8_t zx_z80_snoop8(void *arg)
 {
 	return 0xff;
 }
+
+static int zx_z80_in8_stable(void *arg, uint16_t addr)
+{
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	return zx_in8_stable(mach, addr);
+}
+
+/*
+ * Instructions can be fetched straight from the switched in banks (the core
+ * is told by z80_icache_flush_bank() when they change), except with
+ * the ZX81 where the 8K banks are mirrored.
+ */
+static const uint8_t *zx_z80_imemptr(void *arg, uint16_t addr)
+{
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	if (mach->mem_model == ZXM_ZX81)
+		return NULL;
+
+	return mach->bnk[addr >> 14];
+}
+
+/** Spectrum memory and I/O as seen by the Z80 CPU.
+ *
+ * Each machine uses a copy with its page tables filled in.
+ */
+const z80_dep_t zx_z80_dep = {
+	.memget8 = zx_z80_memget8,
+	.imemget8 = zx_z80_imemget8,
+	.memset8 = zx_z80_memset8,
+	.out8 = zx_z80_out8,
+	.in8 = zx_z80_in8,
+	.snoop8 = zx_z80_snoop8,
+	.in8_stable = zx_z80_in8_stable,
+	.imemptr = zx_z80_imemptr
+};
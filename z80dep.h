@@ -30,24 +30,23 @@
  */
 
 /*
- * Functions required by a Z80 core.
+ * Z80 core platform definitions and the Spectrum memory and I/O
+ * callbacks for the Z80 core.
  */
 
 #ifndef Z80DEP_H
 #define Z80DEP_H
 
 #include <stdint.h>
+#include "z80.h"
+#include "zx.h"
 
 #define PROGMEM
 #define pgm_read_ptr(x) (*(x))
+#define pgm_read_byte(x) (*(x))
 
-uint8_t z80_memget8(uint16_t addr);
-uint8_t z80_imemget8(uint16_t addr);
-void z80_memset8(uint16_t addr, uint8_t val);
+extern const z80_dep_t zx_z80_dep;
 
-void z80_out8(uint16_t addr, uint8_t val);
-uint8_t z80_in8(uint16_t addr);
-
-uint8_t z80_snoop8(void);
+extern void zx_z80_remap(zx_machine_t *);
 
 #endif
@@ -34,232 +34,1239 @@
 #include <stdlib.h>
 
 #include "memio.h"
+#include "z80dep.h"
 #include "z80g.h"
+#include "zx.h"
 #include "zx_scr.h"
 
-/** Allow probing for GFX and turning on GPU when needed */
-bool gpu_allow = true;
+/*
+ * The GPU planes execute the same code as the CPU, each on its own copy of
+ * memory and of the data registers. The program counter, the stack pointer,
+ * the control state and the addresses of memory operands all come from the
+ * CPU, as does the code itself.
+ *
+ * Each byte of GPU memory and each GPU register is a 64-bit word with one
+ * byte lane per plane, so most instructions update all planes at once with
+ * word-wide operations. Flags other than carry are taken over from the CPU
+ * before each instruction, so only carry is computed in the lanes.
+ * Undocumented instructions and taking an interrupt (which may read
+ * a different IM 2 vector in each plane) are left to the Z80 core, which
+ * then executes the instruction for each plane in turn.
+ */
 
-z80s gpus[NGP];		/* GPUs */
-z80s tmps;		/* temporary place to store the CPU */
+#define LANE_LSB 0x0101010101010101ULL
+#define LANE_MSB 0x8080808080808080ULL
 
-uint8_t *gfxrom[NGP];
-uint8_t *gfxram[NGP];
-uint8_t *gfxscr[NGP];
-static uint8_t *gfxbnk[NGP][4];
-static bool gpu_on;
+/*
+ * Indices within gpu_regs_t.r, in opcode order (6 stands for (HL) in
+ * opcodes). Note these differ from rB etc., which index z80s.r.
+ */
+#define gB 0
+#define gC 1
+#define gD 2
+#define gE 3
+#define gH 4
+#define gL 5
+#define gF 6
+#define gA 7
 
 /************************************************************************/
 /************************************************************************/
 
-void gpu_set_allow(bool allow)
+void gpu_set_allow(zx_machine_t *mach, bool allow)
+{
+	mach->gpu.allow = allow;
+	if (!allow && mach->gpu.on)
+		gpu_disable(mach);
+}
+
+/** Initialize the GPU of a machine (it is off and allowed to turn on).
+ *
+ * @param mach Machine
+ */
+void gpu_init(zx_machine_t *mach)
 {
-	gpu_allow = allow;
-	if (!allow && gpu_on)
-		gpu_disable();
+	mach->gpu.cpu = &mach->cpu;
+	mach->gpu.allow = true;
+	mach->gpu.lanes = true;
+	mach->gpu.mem = NULL;
+	mach->gpu.on = false;
 }
 
-void gpu_init(void)
+/** Set up GPU memory with the 48K ROM and random RAM contents in all planes.
+ *
+ * @param gpu GPU
+ * @param rom 48K ROM
+ * @return Zero on success, -1 if out of memory
+ */
+static int gpu_mem_init(gpu_t *gpu, const uint8_t *rom)
 {
-  int i;
+	unsigned u;
+	int i;
+	uint64_t w;
 
-  for(i=0;i<NGP;i++) {
-    gfxrom[i]=NULL;
-    gfxram[i]=NULL;
-  }
+	if (gpu->mem == NULL) {
+		gpu->mem = malloc(0x10000 * sizeof(uint64_t));
+		if (gpu->mem == NULL)
+			return -1;
+	}
 
-  gpu_on = false;
+	for (u = 0; u < 0x4000; u++)
+		gpu->mem[u] = LANE_LSB * rom[u];
+
+	for (u = 0x4000; u < 0x10000; u++) {
+		w = 0;
+		for (i = 0; i < NGP; i++)
+			w = (w << 8) | (uint8_t)rand();
+		gpu->mem[u] = w;
+	}
+
+	return 0;
 }
 
-int gpu_enable(void)
+int gpu_enable(zx_machine_t *mach)
 {
-  if (mem_model != ZXM_48K)
+  if (mach->mem_model != ZXM_48K)
     return -1;
-  gfx_select_memmodel(ZXM_48K);
-  if (zx_scr_init_spec256_pal() < 0)
+  if (gpu_mem_init(&mach->gpu, mach->rom) < 0)
     return -1;
-  gfxrom_load("roms/rom0.gfx",0);
-  gpu_on = true;
+  if (zx_scr_init_spec256_pal(mach) < 0)
+    return -1;
+  gfxrom_load(mach, "roms/rom0.gfx",0);
+  /* the CPU and the GPU are stepped by single instructions */
+  z80_icache_enable(&mach->cpu, 0);
+  z80_aot_enable(&mach->cpu, 0);
+  mach->gpu.on = true;
   return 0;
 }
 
-void gpu_disable(void)
-{
-  int i;
-
-  for(i=0;i<NGP;i++) {
-    free(gfxrom[i]);
-    gfxrom[i]=NULL;
-    free(gfxram[i]);
-    gfxram[i]=NULL;
-  }
-
-  gpu_on = false;
-  zx_scr_mode(0);
-}
-
-bool gpu_is_on(void)
-{
-  return gpu_on;
-}
-
-void gfx_select_memmodel(int model) {
-  int i;
-  uint8_t *tmpram,*tmprom,*tmpscr;
-  uint8_t *tmpbnk[4];
-  
-  tmprom=zxrom;
-  tmpram=zxram;
-  tmpscr=zxscr;
-  
-  tmpbnk[0]=zxbnk[0];
-  tmpbnk[1]=zxbnk[1];
-  tmpbnk[2]=zxbnk[2];
-  tmpbnk[3]=zxbnk[3];
-  
-  for(i=0;i<NGP;i++) {
-    zxrom=gfxrom[i];
-    zxram=gfxram[i];
-    zxscr=gfxscr[i];
-    
-    zx_select_memmodel(model);
-    
-    gfxrom[i]=zxrom;
-    gfxram[i]=zxram;
-    gfxscr[i]=zxscr;
-    
-    gfxbnk[i][0]=zxbnk[0];
-    gfxbnk[i][1]=zxbnk[1];
-    gfxbnk[i][2]=zxbnk[2];
-    gfxbnk[i][3]=zxbnk[3];
-  }
-  
-  zxrom=tmprom;
-  zxram=tmpram;
-  zxscr=tmpscr;
-  
-  zxbnk[0]=tmpbnk[0];
-  zxbnk[1]=tmpbnk[1];
-  zxbnk[2]=tmpbnk[2];
-  zxbnk[3]=tmpbnk[3];
-}
-
-#define GRANU 1
+void gpu_disable(zx_machine_t *mach)
+{
+  free(mach->gpu.mem);
+  mach->gpu.mem = NULL;
+
+  mach->gpu.on = false;
+  z80_icache_enable(&mach->cpu, 1);
+  z80_aot_enable(&mach->cpu, 1);
+  zx_scr_mode(mach, 0);
+}
+
+bool gpu_is_on(zx_machine_t *mach)
+{
+  return mach->gpu.on;
+}
 
-/* execute instruction using both CPU and GPU */
-void z80_g_execinstr(void) {
-  int i,j;
-  unsigned long tmp_clock;
-  uint8_t *tmpbnk[4];
-
-  tmp_clock=z80_clock;
-
-  /*
-   * Synchronize GPUs with CPU
-   *
-   * Synchronize everything but Gfx registers
-   */
-  for(i=0;i<NGP;i++) {
-    gpus[i].PC=cpus.PC;
-    gpus[i].SP=cpus.SP;
-    gpus[i].I=cpus.I;
-    gpus[i].R=cpus.R;
-    gpus[i].IFF1=cpus.IFF1;
-    gpus[i].IFF2=cpus.IFF2;
-    gpus[i].modifier=cpus.modifier;
-    gpus[i].int_lock=cpus.int_lock;
-    gpus[i].halted=cpus.halted;
-    gpus[i].int_mode=cpus.int_mode;
-    /* Sync all flags but Carry */
-    gpus[i].F=(gpus[i].F&fC)|(cpus.F&~fC);
-  }
-    
-  /* execute instrucion on all GPUs */
-  tmps=cpus; /* save CPU for a while */
-  rcpus = &tmps;
-
-  tmpbnk[0]=zxbnk[0];
-  tmpbnk[1]=zxbnk[1];
-  tmpbnk[2]=zxbnk[2];
-  tmpbnk[3]=zxbnk[3];
-
-  for(i=0;i<NGP;i++) {
-    zxbnk[0]=gfxbnk[i][0];
-    zxbnk[1]=gfxbnk[i][1];
-    zxbnk[2]=gfxbnk[i][2];
-    zxbnk[3]=gfxbnk[i][3];
-  
-    cpus=gpus[i];
-    
-    for(j=0;j<GRANU;j++)
-      z80_execinstr();
-    
-    gpus[i]=cpus;
-  }
-  cpus=tmps; /* restore CPU */
-  rcpus=&cpus;
-  
-  zxbnk[0]=tmpbnk[0];
-  zxbnk[1]=tmpbnk[1];
-  zxbnk[2]=tmpbnk[2];
-  zxbnk[3]=tmpbnk[3];
-
-  z80_clock=tmp_clock;
-  
-  /* execute on CPU */
-  for(j=0;j<GRANU;j++)
-    z80_execinstr();
+/** Execute instructions in all planes at once where possible, or always
+ * one plane after another on the Z80 core.
+ *
+ * Both must give the same results, the latter serves to verify that.
+ *
+ * @param mach Machine
+ * @param lanes @c true to execute in lanes (default)
+ */
+void gpu_set_lanes(zx_machine_t *mach, bool lanes)
+{
+	mach->gpu.lanes = lanes;
+}
+
+/** Transpose 8x8 bit matrix (bit j of byte i becomes bit i of byte j).
+ *
+ * This converts between the bit-sliced layout of .gfx files (and of
+ * Spec256 pixel colors) and one byte lane per plane.
+ *
+ * @param x Matrix
+ * @return Transposed matrix
+ */
+uint64_t gfx_transpose(uint64_t x)
+{
+	uint64_t t;
+
+	t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+	x = x ^ t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+	x = x ^ t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+	x = x ^ t ^ (t << 28);
+	return x;
+}
+
+/************************************************************************/
+
+static uint64_t lane_bcast(uint8_t v)
+{
+	return LANE_LSB * v;
+}
+
+static uint8_t lane_get(uint64_t w, int i)
+{
+	return (w >> (8 * i)) & 0xff;
+}
+
+static uint64_t lane_set(uint64_t w, int i, uint8_t v)
+{
+	return (w & ~(0xffULL << (8 * i))) | ((uint64_t)v << (8 * i));
+}
+
+/** Add lanes.
+ *
+ * @param a First operand
+ * @param b Second operand
+ * @param c Carry in (0 or 1 in each lane)
+ * @param co Place to store carry out (0 or 1 in each lane)
+ * @return a + b + c in each lane
+ */
+static uint64_t lane_add(uint64_t a, uint64_t b, uint64_t c, uint64_t *co)
+{
+	uint64_t s;
+
+	/* add the low seven bits, then bit 7 without carrying into next lane */
+	s = ((a & ~LANE_MSB) + (b & ~LANE_MSB) + c) ^ ((a ^ b) & LANE_MSB);
+	*co = (((a & b) | ((a | b) & ~s)) & LANE_MSB) >> 7;
+	return s;
+}
+
+/** Subtract lanes, a - b - c with borrow out stored to @a bo. */
+static uint64_t lane_sub(uint64_t a, uint64_t b, uint64_t c, uint64_t *bo)
+{
+	uint64_t s;
+
+	s = lane_add(a, ~b, c ^ LANE_LSB, bo);
+	*bo ^= LANE_LSB;
+	return s;
+}
+
+/** Lanes that are zero (0 or 1 in each lane) */
+static uint64_t lane_zero(uint64_t a)
+{
+	return (~(((a & ~LANE_MSB) + ~LANE_MSB) | a) & LANE_MSB) >> 7;
+}
+
+/** Add 16-bit value in each lane, given as high and low byte lanes */
+static void lane_add16(uint64_t *h, uint64_t *l, uint64_t bh, uint64_t bl,
+    uint64_t c, uint64_t *co)
+{
+	uint64_t c1;
+
+	*l = lane_add(*l, bl, c, &c1);
+	*h = lane_add(*h, bh, c1, co);
+}
+
+static void lane_sub16(uint64_t *h, uint64_t *l, uint64_t bh, uint64_t bl,
+    uint64_t c, uint64_t *bo)
+{
+	uint64_t b1;
+
+	*l = lane_sub(*l, bl, c, &b1);
+	*h = lane_sub(*h, bh, b1, bo);
+}
+
+/** Increment (d = 1) or decrement (d = -1) 16-bit lanes */
+static void lane_step16(uint64_t *h, uint64_t *l, int d)
+{
+	uint64_t c;
+
+	if (d > 0)
+		lane_add16(h, l, 0, LANE_LSB, 0, &c);
+	else
+		lane_sub16(h, l, 0, LANE_LSB, 0, &c);
+}
+
+/************************************************************************/
+
+/*
+ * GPU memory access. ROM writes are discarded like with the CPU.
+ */
+
+static uint64_t gpu_get8(gpu_t *gpu, uint16_t addr)
+{
+	return gpu->mem[addr];
+}
+
+static void gpu_set8(gpu_t *gpu, uint16_t addr, uint64_t v)
+{
+	if (addr >= 0x4000)
+		gpu->mem[addr] = v;
+}
+
+/** Write only lanes selected by mask @a m. */
+static void gpu_set8m(gpu_t *gpu, uint16_t addr, uint64_t v, uint64_t m)
+{
+	if (addr >= 0x4000)
+		gpu->mem[addr] = (gpu->mem[addr] & ~m) | (v & m);
+}
+
+/** Push 16-bit value (the same in all planes) selected by mask @a m. */
+static void gpu_push(gpu_t *gpu, uint16_t val, uint64_t m)
+{
+	uint16_t sp = gpu->cpu->cpus.SP;
+
+	gpu_set8m(gpu, sp - 2, lane_bcast(val & 0xff), m);
+	gpu_set8m(gpu, sp - 1, lane_bcast(val >> 8), m);
+}
+
+/** Fetch code byte (from CPU memory) */
+static uint8_t gpu_iget8(gpu_t *gpu, uint16_t addr)
+{
+	return gpu->cpu->dep->imemget8(gpu->cpu->dep_arg, addr);
+}
+
+static uint16_t gpu_iget16(gpu_t *gpu, uint16_t addr)
+{
+	return gpu_iget8(gpu, addr) | ((uint16_t)gpu_iget8(gpu, addr + 1) << 8);
+}
+
+/** Read port given by high and low byte lanes, for each plane in turn. */
+static uint64_t gpu_in8(gpu_t *gpu, uint64_t ah, uint64_t al)
+{
+	uint64_t v;
+	int i;
+
+	gpu->cpu->iclock = gpu->cpu->clock;
+	v = 0;
+	for (i = 0; i < NGP; i++) {
+		v |= (uint64_t)gpu->cpu->dep->in8(gpu->cpu->dep_arg,
+		    ((uint16_t)lane_get(ah, i) << 8) | lane_get(al, i)) << (8 * i);
+	}
+
+	return v;
+}
+
+/** Write port given by high and low byte lanes, for each plane in turn. */
+static void gpu_out8(gpu_t *gpu, uint64_t ah, uint64_t al, uint64_t v)
+{
+	int i;
+
+	gpu->cpu->iclock = gpu->cpu->clock;
+	for (i = 0; i < NGP; i++) {
+		gpu->cpu->dep->out8(gpu->cpu->dep_arg,
+		    ((uint16_t)lane_get(ah, i) << 8) | lane_get(al, i),
+		    lane_get(v, i));
+	}
+}
+
+/************************************************************************/
+
+static uint64_t gpu_carry(gpu_t *gpu)
+{
+	return gpu->regs.r[gF] & LANE_LSB;
+}
+
+static void gpu_set_carry(gpu_t *gpu, uint64_t c)
+{
+	gpu->regs.r[gF] = (gpu->regs.r[gF] & ~LANE_LSB) | c;
+}
+
+/** Get register pair.
+ *
+ * @param p Register pair (0 = BC, 1 = DE, 2 = HL, 3 = SP)
+ * @param x 0 for HL, 1 for IX, 2 for IY
+ * @param h Place to store high byte lanes
+ * @param l Place to store low byte lanes
+ */
+static void gpu_rp_get(gpu_t *gpu, int p, int x, uint64_t *h, uint64_t *l)
+{
+	switch (p) {
+	case 2:
+		if (x != 0) {
+			*h = gpu->regs.xh[x - 1];
+			*l = gpu->regs.xl[x - 1];
+			break;
+		}
+		/* fall through */
+	case 0:
+	case 1:
+		*h = gpu->regs.r[2 * p];
+		*l = gpu->regs.r[2 * p + 1];
+		break;
+	default:
+		*h = lane_bcast(gpu->cpu->cpus.SP >> 8);
+		*l = lane_bcast(gpu->cpu->cpus.SP & 0xff);
+		break;
+	}
+}
+
+/** Set register pair (SP is kept by the CPU). */
+static void gpu_rp_set(gpu_t *gpu, int p, int x, uint64_t h, uint64_t l)
+{
+	switch (p) {
+	case 2:
+		if (x != 0) {
+			gpu->regs.xh[x - 1] = h;
+			gpu->regs.xl[x - 1] = l;
+			break;
+		}
+		/* fall through */
+	case 0:
+	case 1:
+		gpu->regs.r[2 * p] = h;
+		gpu->regs.r[2 * p + 1] = l;
+		break;
+	default:
+		break;
+	}
+}
+
+/** Lanes (0xff) in which condition @a cc is true */
+static uint64_t gpu_cond(gpu_t *gpu, int cc)
+{
+	uint8_t f;
+
+	switch (cc >> 1) {
+	case 0:
+		f = gpu->cpu->cpus.F & fZ;
+		break;
+	case 1:
+		/* carry is different in each plane */
+		return (gpu_carry(gpu) ^ ((cc & 1) ? 0 : LANE_LSB)) * 0xff;
+	case 2:
+		f = gpu->cpu->cpus.F & fPV;
+		break;
+	default:
+		f = gpu->cpu->cpus.F & fS;
+		break;
+	}
+
+	return ((f != 0) == (cc & 1)) ? ~0ULL : 0;
+}
+
+/** Address of (HL), (IX+d) or (IY+d) operand with d at @a dpc */
+static uint16_t gpu_maddr(gpu_t *gpu, int x, uint16_t dpc)
+{
+	const z80s *c = &gpu->cpu->cpus;
+
+	switch (x) {
+	case 0:
+		return c->rp[rHL];
+	case 1:
+		return c->IX + (int8_t)gpu_iget8(gpu, dpc);
+	default:
+		return c->IY + (int8_t)gpu_iget8(gpu, dpc);
+	}
+}
+
+/** 8-bit arithmetic or logical operation @a y (ADD ... CP) on A */
+static void gpu_alu(gpu_t *gpu, int y, uint64_t b)
+{
+	uint64_t a = gpu->regs.r[gA];
+	uint64_t c = 0;
+	uint64_t r;
+
+	switch (y) {
+	case 0:
+		r = lane_add(a, b, 0, &c);
+		break;
+	case 1:
+		r = lane_add(a, b, gpu_carry(gpu), &c);
+		break;
+	case 2:
+		r = lane_sub(a, b, 0, &c);
+		break;
+	case 3:
+		r = lane_sub(a, b, gpu_carry(gpu), &c);
+		break;
+	case 4:
+		r = a & b;
+		break;
+	case 5:
+		r = a ^ b;
+		break;
+	case 6:
+		r = a | b;
+		break;
+	default:
+		lane_sub(a, b, 0, &c);
+		r = a;
+		break;
+	}
+
+	gpu->regs.r[gA] = r;
+	gpu_set_carry(gpu, c);
+}
+
+/** Rotate or shift @a y (RLC, RRC, RL, RR, SLA, SRA, SRL; not SLL) */
+static uint64_t gpu_rot(gpu_t *gpu, int y, uint64_t v)
+{
+	uint64_t c;
+	uint64_t r;
+
+	switch (y) {
+	case 0:
+		c = (v >> 7) & LANE_LSB;
+		r = ((v & ~LANE_MSB) << 1) | c;
+		break;
+	case 1:
+		c = v & LANE_LSB;
+		r = ((v >> 1) & ~LANE_MSB) | (c << 7);
+		break;
+	case 2:
+		c = (v >> 7) & LANE_LSB;
+		r = ((v & ~LANE_MSB) << 1) | gpu_carry(gpu);
+		break;
+	case 3:
+		c = v & LANE_LSB;
+		r = ((v >> 1) & ~LANE_MSB) | (gpu_carry(gpu) << 7);
+		break;
+	case 4:
+		c = (v >> 7) & LANE_LSB;
+		r = (v & ~LANE_MSB) << 1;
+		break;
+	case 5:
+		c = v & LANE_LSB;
+		r = ((v >> 1) & ~LANE_MSB) | (v & LANE_MSB);
+		break;
+	default:
+		c = v & LANE_LSB;
+		r = (v >> 1) & ~LANE_MSB;
+		break;
+	}
+
+	gpu_set_carry(gpu, c);
+	return r;
+}
+
+/** DAA, which uses the CPU's H and N flags */
+static void gpu_daa(gpu_t *gpu)
+{
+	uint8_t f = gpu->cpu->cpus.F;
+	uint16_t res;
+	uint64_t a = 0;
+	uint64_t c = gpu_carry(gpu);
+	int i;
+
+	for (i = 0; i < NGP; i++) {
+		res = lane_get(gpu->regs.r[gA], i);
+		if ((f & fN) == 0) {
+			if (lane_get(c, i)) {
+				res += 0x60;
+			} else if (res > 0x99) {
+				res += 0x60;
+				c |= 1ULL << (8 * i);
+			}
+			if ((f & fHC) != 0 || (res & 0x0f) > 0x09)
+				res += 0x06;
+		} else {
+			if (lane_get(c, i)) {
+				res -= 0x60;
+			} else if (res > 0x99) {
+				res -= 0x60;
+				c |= 1ULL << (8 * i);
+			}
+			if ((f & fHC) != 0 || (res & 0x0f) > 0x09)
+				res -= 0x06;
+		}
+		a |= (uint64_t)(res & 0xff) << (8 * i);
+	}
+
+	gpu->regs.r[gA] = a;
+	gpu_set_carry(gpu, c);
+}
+
+/** Register used instead of HL by an instruction after a DD/FD prefix.
+ *
+ * @param op Opcode
+ * @param mod CPU modifier (0, 1 for DD or 2 for FD)
+ * @return 0 for HL, 1 for IX, 2 for IY or -1 if the instruction is
+ *	   undocumented (uses IXh, IXl, IYh or IYl)
+ */
+static int gpu_op_index(uint8_t op, int mod)
+{
+	int y = (op >> 3) & 7;
+	int z = op & 7;
+
+	if (mod == 0)
+		return 0;
+
+	switch (op >> 6) {
+	case 0:
+		if ((z == 1 || z == 3) && ((y >> 1) == 2 || (op & 0x0f) == 9))
+			return mod;
+		if (z == 2 && (y == 4 || y == 5))
+			return mod;
+		if (z >= 4 && z <= 6 && y == 6)
+			return mod;
+		if (z >= 4 && z <= 6 && (y == 4 || y == 5))
+			return -1;
+		return 0;
+	case 1:
+		if (op == 0x76)
+			return 0;
+		if (y == 6 || z == 6)
+			return mod;
+		if (y == 4 || y == 5 || z == 4 || z == 5)
+			return -1;
+		return 0;
+	case 2:
+		if (z == 6)
+			return mod;
+		if (z == 4 || z == 5)
+			return -1;
+		return 0;
+	default:
+		if (op == 0xe1 || op == 0xe3 || op == 0xe5 || op == 0xe9 ||
+		    op == 0xf9)
+			return mod;
+		return 0;
+	}
+}
+
+/** Execute unprefixed (or DD/FD prefixed) instruction on all planes. */
+static bool gpu_op(gpu_t *gpu, uint8_t op)
+{
+	const z80s *c = &gpu->cpu->cpus;
+	uint64_t *r = gpu->regs.r;
+	uint64_t *r_ = gpu->regs.r_;
+	uint64_t h, l, h2, l2, v;
+	uint16_t pc, nn;
+	uint16_t ma = 0;
+	int x, y, z, p, k;
+
+	x = gpu_op_index(op, c->modifier);
+	if (x < 0)
+		return false;
+
+	y = (op >> 3) & 7;
+	z = op & 7;
+	p = y >> 1;
+	pc = c->PC + 1;
+
+	switch (op >> 6) {
+	case 0:
+		switch (z) {
+		case 0:
+			if (y == 1) {
+				/* EX AF,AF' */
+				v = r[gA]; r[gA] = r_[gA]; r_[gA] = v;
+				v = r[gF]; r[gF] = r_[gF]; r_[gF] = v;
+			} else if (y == 2) {
+				/* DJNZ */
+				r[gB] = lane_sub(r[gB], LANE_LSB, 0, &v);
+			}
+			break;
+		case 1:
+			if ((y & 1) == 0) {
+				/* LD rp,nn */
+				gpu_rp_set(gpu, p, x,
+				    lane_bcast(gpu_iget8(gpu, pc + 1)),
+				    lane_bcast(gpu_iget8(gpu, pc)));
+			} else {
+				/* ADD HL,rp */
+				gpu_rp_get(gpu, 2, x, &h, &l);
+				gpu_rp_get(gpu, p, x, &h2, &l2);
+				lane_add16(&h, &l, h2, l2, 0, &v);
+				gpu_rp_set(gpu, 2, x, h, l);
+				gpu_set_carry(gpu, v);
+			}
+			break;
+		case 2:
+			switch (y) {
+			case 0:
+				gpu_set8(gpu, c->rp[rBC], r[gA]);
+				break;
+			case 1:
+				r[gA] = gpu_get8(gpu, c->rp[rBC]);
+				break;
+			case 2:
+				gpu_set8(gpu, c->rp[rDE], r[gA]);
+				break;
+			case 3:
+				r[gA] = gpu_get8(gpu, c->rp[rDE]);
+				break;
+			case 4:
+				nn = gpu_iget16(gpu, pc);
+				gpu_rp_get(gpu, 2, x, &h, &l);
+				gpu_set8(gpu, nn, l);
+				gpu_set8(gpu, nn + 1, h);
+				break;
+			case 5:
+				nn = gpu_iget16(gpu, pc);
+				gpu_rp_set(gpu, 2, x, gpu_get8(gpu, nn + 1),
+				    gpu_get8(gpu, nn));
+				break;
+			case 6:
+				gpu_set8(gpu, gpu_iget16(gpu, pc), r[gA]);
+				break;
+			default:
+				r[gA] = gpu_get8(gpu, gpu_iget16(gpu, pc));
+				break;
+			}
+			break;
+		case 3:
+			/* INC rp, DEC rp */
+			gpu_rp_get(gpu, p, x, &h, &l);
+			lane_step16(&h, &l, (y & 1) ? -1 : 1);
+			gpu_rp_set(gpu, p, x, h, l);
+			break;
+		case 4:
+		case 5:
+			/* INC r, DEC r (carry is not affected) */
+			if (y == 6) {
+				ma = gpu_maddr(gpu, x, pc);
+				v = gpu_get8(gpu, ma);
+			} else {
+				v = r[y];
+			}
+			if (z == 4)
+				v = lane_add(v, LANE_LSB, 0, &h);
+			else
+				v = lane_sub(v, LANE_LSB, 0, &h);
+			if (y == 6)
+				gpu_set8(gpu, ma, v);
+			else
+				r[y] = v;
+			break;
+		case 6:
+			/* LD r,n */
+			if (y == 6) {
+				ma = gpu_maddr(gpu, x, pc);
+				gpu_set8(gpu, ma, lane_bcast(gpu_iget8(gpu,
+				    x ? pc + 1 : pc)));
+			} else {
+				r[y] = lane_bcast(gpu_iget8(gpu, pc));
+			}
+			break;
+		default:
+			switch (y) {
+			case 4:
+				gpu_daa(gpu);
+				break;
+			case 5:
+				r[gA] = ~r[gA];
+				break;
+			case 6:
+				gpu_set_carry(gpu, LANE_LSB);
+				break;
+			case 7:
+				gpu_set_carry(gpu, gpu_carry(gpu) ^ LANE_LSB);
+				break;
+			default:
+				/* RLCA, RRCA, RLA, RRA */
+				r[gA] = gpu_rot(gpu, y, r[gA]);
+				break;
+			}
+			break;
+		}
+		break;
+	case 1:
+		/* LD r,r' */
+		if (op == 0x76)
+			break;
+		if (z == 6)
+			r[y] = gpu_get8(gpu, gpu_maddr(gpu, x, pc));
+		else if (y == 6)
+			gpu_set8(gpu, gpu_maddr(gpu, x, pc), r[z]);
+		else
+			r[y] = r[z];
+		break;
+	case 2:
+		gpu_alu(gpu, y, z == 6 ? gpu_get8(gpu, gpu_maddr(gpu, x, pc)) :
+		    r[z]);
+		break;
+	default:
+		switch (z) {
+		case 1:
+			if ((y & 1) == 0) {
+				/* POP rp */
+				l = gpu_get8(gpu, c->SP);
+				h = gpu_get8(gpu, c->SP + 1);
+				if (p == 3) {
+					r[gA] = h;
+					r[gF] = l;
+				} else {
+					gpu_rp_set(gpu, p, x, h, l);
+				}
+			} else if (y == 3) {
+				/* EXX */
+				for (k = gB; k <= gL; k++) {
+					v = r[k]; r[k] = r_[k]; r_[k] = v;
+				}
+			}
+			break;
+		case 3:
+			switch (y) {
+			case 2:
+				/* OUT (n),A */
+				gpu_out8(gpu, r[gA], lane_bcast(gpu_iget8(gpu, pc)),
+				    r[gA]);
+				break;
+			case 3:
+				/* IN A,(n) */
+				r[gA] = gpu_in8(gpu, r[gA],
+				    lane_bcast(gpu_iget8(gpu, pc)));
+				break;
+			case 4:
+				/* EX (SP),HL */
+				l2 = gpu_get8(gpu, c->SP);
+				h2 = gpu_get8(gpu, c->SP + 1);
+				gpu_rp_get(gpu, 2, x, &h, &l);
+				gpu_set8(gpu, c->SP, l);
+				gpu_set8(gpu, c->SP + 1, h);
+				gpu_rp_set(gpu, 2, x, h2, l2);
+				break;
+			case 5:
+				/* EX DE,HL */
+				v = r[gD]; r[gD] = r[gH]; r[gH] = v;
+				v = r[gE]; r[gE] = r[gL]; r[gL] = v;
+				break;
+			default:
+				break;
+			}
+			break;
+		case 4:
+			/* CALL cc,nn */
+			v = gpu_cond(gpu, y);
+			if (v != 0)
+				gpu_push(gpu, c->PC + 3, v);
+			break;
+		case 5:
+			if ((y & 1) == 0) {
+				/* PUSH rp */
+				if (p == 3) {
+					h = r[gA];
+					l = r[gF];
+				} else {
+					gpu_rp_get(gpu, p, x, &h, &l);
+				}
+				gpu_set8(gpu, c->SP - 2, l);
+				gpu_set8(gpu, c->SP - 1, h);
+			} else if (y == 1) {
+				/* CALL nn */
+				gpu_push(gpu, c->PC + 3, ~0ULL);
+			}
+			break;
+		case 6:
+			gpu_alu(gpu, y, lane_bcast(gpu_iget8(gpu, pc)));
+			break;
+		case 7:
+			/* RST */
+			gpu_push(gpu, c->PC + 1, ~0ULL);
+			break;
+		default:
+			/* RET cc, JP cc only change PC */
+			break;
+		}
+		break;
+	}
+
+	return true;
+}
+
+/** Execute CB (x = 0) or DD CB/FD CB (x = 1, 2) prefixed instruction. */
+static bool gpu_cbop(gpu_t *gpu, int x, uint8_t op, uint16_t dpc)
+{
+	uint64_t v;
+	uint16_t ma = 0;
+	int y = (op >> 3) & 7;
+	int z = op & 7;
+
+	/* BIT only sets flags */
+	if ((op >> 6) == 1)
+		return true;
+
+	/* SLL and storing the result to a register are undocumented */
+	if (((op >> 6) == 0 && y == 6) || (x != 0 && z != 6))
+		return false;
+
+	if (z == 6) {
+		ma = gpu_maddr(gpu, x, dpc);
+		v = gpu_get8(gpu, ma);
+	} else {
+		v = gpu->regs.r[z];
+	}
+
+	switch (op >> 6) {
+	case 0:
+		v = gpu_rot(gpu, y, v);
+		break;
+	case 2:
+		v &= ~lane_bcast(1 << y);
+		break;
+	default:
+		v |= lane_bcast(1 << y);
+		break;
+	}
+
+	if (z == 6)
+		gpu_set8(gpu, ma, v);
+	else
+		gpu->regs.r[z] = v;
+	return true;
+}
+
+/** Execute ED prefixed instruction on all planes. */
+static bool gpu_edop(gpu_t *gpu, uint8_t op)
+{
+	const z80s *c = &gpu->cpu->cpus;
+	uint64_t *r = gpu->regs.r;
+	uint64_t h, l, h2, l2, v, m;
+	uint16_t pc, nn, hl;
+	int y, z, p, d;
+
+	y = (op >> 3) & 7;
+	z = op & 7;
+	p = y >> 1;
+	pc = c->PC + 2;
+	hl = c->rp[rHL];
+
+	if (op >= 0xa0 && op < 0xc0 && z < 4) {
+		/* block instructions, one iteration */
+		d = (y & 1) ? -1 : 1;
+		switch (z) {
+		case 0:
+			/* LDI, LDD, LDIR, LDDR */
+			gpu_set8(gpu, c->rp[rDE],
+			    gpu_get8(gpu, hl));
+			lane_step16(&r[gD], &r[gE], d);
+			lane_step16(&r[gB], &r[gC], -1);
+			break;
+		case 1:
+			/* CPI, CPD, CPIR, CPDR */
+			lane_step16(&r[gB], &r[gC], -1);
+			break;
+		case 2:
+			/* INI, IND, INIR, INDR */
+			gpu_set8(gpu, hl, gpu_in8(gpu, r[gB], r[gC]));
+			r[gB] = lane_sub(r[gB], LANE_LSB, 0, &v);
+			break;
+		default:
+			/* OUTI, OUTD, OTIR, OTDR */
+			gpu_out8(gpu, r[gB], r[gC], gpu_get8(gpu, hl));
+			r[gB] = lane_sub(r[gB], LANE_LSB, 0, &v);
+			if (op == 0xab)
+				r[gB] &= lane_bcast(0x0f); /* as the core does */
+			break;
+		}
+		lane_step16(&r[gH], &r[gL], d);
+		return true;
+	}
+
+	/* the rest (except undocumented NOPs) */
+	if (op < 0x40 || op >= 0x80)
+		return true;
+
+	switch (z) {
+	case 0:
+		/* IN r,(C) */
+		if (y == 6)
+			return false;
+		r[y] = gpu_in8(gpu, r[gB], r[gC]);
+		break;
+	case 1:
+		/* OUT (C),r */
+		if (y == 6)
+			return false;
+		gpu_out8(gpu, r[gB], r[gC], r[y]);
+		break;
+	case 2:
+		/* SBC HL,rp and ADC HL,rp */
+		gpu_rp_get(gpu, p, 0, &h2, &l2);
+		h = r[gH];
+		l = r[gL];
+		if ((y & 1) == 0)
+			lane_sub16(&h, &l, h2, l2, gpu_carry(gpu), &v);
+		else
+			lane_add16(&h, &l, h2, l2, gpu_carry(gpu), &v);
+		r[gH] = h;
+		r[gL] = l;
+		gpu_set_carry(gpu, v);
+		break;
+	case 3:
+		nn = gpu_iget16(gpu, pc);
+		if ((y & 1) == 0) {
+			/* LD (nn),rp */
+			gpu_rp_get(gpu, p, 0, &h, &l);
+			gpu_set8(gpu, nn, l);
+			gpu_set8(gpu, nn + 1, h);
+		} else {
+			/* LD rp,(nn) */
+			gpu_rp_set(gpu, p, 0, gpu_get8(gpu, nn + 1),
+			    gpu_get8(gpu, nn));
+		}
+		break;
+	case 4:
+		/* NEG, sets carry if A was zero like the core does */
+		if (op != 0x44)
+			return false;
+		v = r[gA];
+		r[gA] = lane_sub(0, v, 0, &m);
+		gpu_set_carry(gpu, lane_zero(v));
+		break;
+	case 7:
+		switch (y) {
+		case 2:
+			/* LD A,I */
+			r[gA] = lane_bcast(c->I);
+			break;
+		case 3:
+			/* LD A,R */
+			r[gA] = 0;
+			break;
+		case 4:
+			/* RRD */
+			v = gpu_get8(gpu, hl);
+			l = r[gA];
+			r[gA] = (l & lane_bcast(0xf0)) | (v & lane_bcast(0x0f));
+			gpu_set8(gpu, hl, ((v >> 4) & lane_bcast(0x0f)) |
+			    ((l << 4) & lane_bcast(0xf0)));
+			break;
+		case 5:
+			/* RLD */
+			v = gpu_get8(gpu, hl);
+			l = r[gA];
+			r[gA] = (l & lane_bcast(0xf0)) |
+			    ((v >> 4) & lane_bcast(0x0f));
+			gpu_set8(gpu, hl, ((v << 4) & lane_bcast(0xf0)) |
+			    (l & lane_bcast(0x0f)));
+			break;
+		default:
+			/* LD I,A, LD R,A only change CPU registers */
+			break;
+		}
+		break;
+	default:
+		/* RETN, RETI, IM only change CPU registers */
+		break;
+	}
+
+	return true;
+}
+
+/** Execute one instruction on all planes at once.
+ *
+ * @return @c true on success, @c false if it needs to be executed
+ *	   for each plane separately (nothing has been changed then)
+ */
+static bool gpu_step_lanes(gpu_t *gpu)
+{
+	const z80s *c = &gpu->cpu->cpus;
+	uint8_t op;
+
+	if ((gpu->regs.int_pending || gpu->regs.nmi_pending) && !c->int_lock)
+		return false;
+
+	/* Sync all flags but Carry */
+	gpu->regs.r[gF] = (gpu->regs.r[gF] & LANE_LSB) | lane_bcast(c->F & ~fC);
+
+	if (c->halted)
+		return true;
+
+	op = gpu_iget8(gpu, c->PC);
+	switch (op) {
+	case 0xdd:
+	case 0xfd:
+		/* unless the instruction that follows executes right away */
+		return (long)(gpu->cpu->clock - gpu->cpu->deadline) >= 0;
+	case 0xcb:
+		if (c->modifier != 0)
+			return gpu_cbop(gpu, c->modifier,
+			    gpu_iget8(gpu, c->PC + 2), c->PC + 1);
+		return gpu_cbop(gpu, 0, gpu_iget8(gpu, c->PC + 1), 0);
+	case 0xed:
+		return gpu_edop(gpu, gpu_iget8(gpu, c->PC + 1));
+	default:
+		return gpu_op(gpu, op);
+	}
+}
+
+/************************************************************************/
+
+/*
+ * Memory as seen by the Z80 core executing for plane gpu_t.plane. Code is
+ * fetched from CPU memory. The argument is the machine, as for zx_z80_dep.
+ */
+
+static uint8_t gpu_z80_memget8(void *arg, uint16_t addr)
+{
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	return lane_get(mach->gpu.mem[addr], mach->gpu.plane);
+}
+
+static uint8_t gpu_z80_imemget8(void *arg, uint16_t addr)
+{
+	return zx_z80_dep.imemget8(arg, addr);
+}
+
+static const uint8_t *gpu_z80_imemptr(void *arg, uint16_t addr)
+{
+	return zx_z80_dep.imemptr(arg, addr);
+}
+
+static void gpu_z80_memset8(void *arg, uint16_t addr, uint8_t val)
+{
+	zx_machine_t *mach = (zx_machine_t *)arg;
+	gpu_t *gpu = &mach->gpu;
+
+	if (addr >= 0x4000)
+		gpu->mem[addr] = lane_set(gpu->mem[addr], gpu->plane, val);
+}
+
+static void gpu_z80_out8(void *arg, uint16_t addr, uint8_t val)
+{
+	zx_z80_dep.out8(arg, addr, val);
+}
+
+static uint8_t gpu_z80_in8(void *arg, uint16_t addr)
+{
+	return zx_z80_dep.in8(arg, addr);
+}
+
+static uint8_t gpu_z80_snoop8(void *arg)
+{
+	return zx_z80_dep.snoop8(arg);
+}
+
+static const z80_dep_t gpu_z80_dep = {
+	.memget8 = gpu_z80_memget8,
+	.imemget8 = gpu_z80_imemget8,
+	.memset8 = gpu_z80_memset8,
+	.out8 = gpu_z80_out8,
+	.in8 = gpu_z80_in8,
+	.snoop8 = gpu_z80_snoop8,
+	.imemptr = gpu_z80_imemptr
+};
+
+/** Load registers of plane @a i into @a s (which holds the CPU state). */
+static void gpu_regs_load(gpu_t *gpu, int i, z80s *s)
+{
+	int k;
+
+	for (k = 0; k < 8; k++) {
+		if (k == gF)
+			continue;
+		s->r[Z80_REG8(k)] = lane_get(gpu->regs.r[k], i);
+		s->r_[Z80_REG8(k)] = lane_get(gpu->regs.r_[k], i);
+	}
+
+	/* Sync all flags but Carry */
+	s->F = (lane_get(gpu->regs.r[gF], i) & fC) | (s->F & ~fC);
+	s->F_ = lane_get(gpu->regs.r_[gF], i);
+	s->IX = ((uint16_t)lane_get(gpu->regs.xh[0], i) << 8) |
+	    lane_get(gpu->regs.xl[0], i);
+	s->IY = ((uint16_t)lane_get(gpu->regs.xh[1], i) << 8) |
+	    lane_get(gpu->regs.xl[1], i);
+}
+
+/** Store registers of plane @a i from @a s. */
+static void gpu_regs_store(gpu_t *gpu, int i, const z80s *s)
+{
+	int k;
+
+	for (k = 0; k < 8; k++) {
+		if (k == gF)
+			continue;
+		gpu->regs.r[k] = lane_set(gpu->regs.r[k], i,
+		    s->r[Z80_REG8(k)]);
+		gpu->regs.r_[k] = lane_set(gpu->regs.r_[k], i,
+		    s->r_[Z80_REG8(k)]);
+	}
+
+	gpu->regs.r[gF] = lane_set(gpu->regs.r[gF], i, s->F);
+	gpu->regs.r_[gF] = lane_set(gpu->regs.r_[gF], i, s->F_);
+	gpu->regs.xh[0] = lane_set(gpu->regs.xh[0], i, s->IX >> 8);
+	gpu->regs.xl[0] = lane_set(gpu->regs.xl[0], i, s->IX & 0xff);
+	gpu->regs.xh[1] = lane_set(gpu->regs.xh[1], i, s->IY >> 8);
+	gpu->regs.xl[1] = lane_set(gpu->regs.xl[1], i, s->IY & 0xff);
+}
+
+/** Execute one instruction on the Z80 core for each plane in turn. */
+static void gpu_step_planes(gpu_t *gpu)
+{
+	z80s cpus;
+	unsigned long clock;
+	unsigned long ev_clock;
+	const z80_dep_t *dep;
+	int i;
+
+	cpus = gpu->cpu->cpus; /* save CPU for a while */
+	clock = gpu->cpu->clock;
+	ev_clock = gpu->cpu->ev_clock;
+	dep = gpu->cpu->dep;
+
+	gpu->cpu->rcpus = &cpus;
+	gpu->cpu->dep = &gpu_z80_dep;
+
+	for (i = 0; i < NGP; i++) {
+		gpu->plane = i;
+		gpu->cpu->cpus = cpus;
+		gpu_regs_load(gpu, i, &gpu->cpu->cpus);
+		gpu->cpu->cpus.int_pending = gpu->regs.int_pending;
+		gpu->cpu->cpus.nmi_pending = gpu->regs.nmi_pending;
+		/* let it check for INT, NMI */
+		gpu->cpu->ev_clock = gpu->cpu->clock;
+		z80_execinstr(gpu->cpu);
+		gpu_regs_store(gpu, i, &gpu->cpu->cpus);
+	}
+
+	/* all planes take an interrupt together */
+	gpu->regs.int_pending = gpu->cpu->cpus.int_pending;
+	gpu->regs.nmi_pending = gpu->cpu->cpus.nmi_pending;
+
+	gpu->cpu->cpus = cpus; /* restore CPU */
+	gpu->cpu->rcpus = &gpu->cpu->cpus;
+	gpu->cpu->dep = dep;
+	gpu->cpu->clock = clock;
+	gpu->cpu->ev_clock = ev_clock;
 }
 
 /* execute instruction using both CPU and GPU */
-void z80_g_int(void) {
-  int i;
-  unsigned long tmp_clock;
-  uint8_t *tmpbnk[4];
- 
-  tmp_clock=z80_clock;
-    
-  /* execute int on all GPUs */
-  tmps=cpus; /* save CPU for a while */
-  
-  tmpbnk[0]=zxbnk[0];
-  tmpbnk[1]=zxbnk[1];
-  tmpbnk[2]=zxbnk[2];
-  tmpbnk[3]=zxbnk[3];
-
-  for(i=0;i<NGP;i++) {
-    zxbnk[0]=gfxbnk[i][0];
-    zxbnk[1]=gfxbnk[i][1];
-    zxbnk[2]=gfxbnk[i][2];
-    zxbnk[3]=gfxbnk[i][3];
-  
-    cpus=gpus[i];
-    
-    z80_int();
-    
-    gpus[i]=cpus;
-  }
-  cpus=tmps; /* restore CPU */
-  
-  zxbnk[0]=tmpbnk[0];
-  zxbnk[1]=tmpbnk[1];
-  zxbnk[2]=tmpbnk[2];
-  zxbnk[3]=tmpbnk[3];
-
-  z80_clock=tmp_clock;
-  
-  /* execute on CPU */
-  z80_int();
-}
-
-int gpu_reset(void) {
-  int i;
-  
+void z80_g_execinstr(zx_machine_t *mach)
+{
+	gpu_t *gpu = &mach->gpu;
+
+	if (!gpu->lanes || !gpu_step_lanes(gpu))
+		gpu_step_planes(gpu);
+
+	/* execute on CPU */
+	z80_execinstr(gpu->cpu);
+}
+
+/* INT both on CPU and GPU */
+void z80_g_int(zx_machine_t *mach)
+{
+	mach->gpu.regs.int_pending = true;
+	z80_int(&mach->cpu);
+}
+
+/** Set registers of all planes to @a s. */
+void gpu_set_regs(zx_machine_t *mach, const z80s *s)
+{
+	gpu_t *gpu = &mach->gpu;
+	int k;
+
+	/* F is register 6 in z80s.r as well */
+	for (k = 0; k < 8; k++) {
+		gpu->regs.r[k] = lane_bcast(s->r[Z80_REG8(k)]);
+		gpu->regs.r_[k] = lane_bcast(s->r_[Z80_REG8(k)]);
+	}
+
+	gpu->regs.xh[0] = lane_bcast(s->IX >> 8);
+	gpu->regs.xl[0] = lane_bcast(s->IX & 0xff);
+	gpu->regs.xh[1] = lane_bcast(s->IY >> 8);
+	gpu->regs.xl[1] = lane_bcast(s->IY & 0xff);
+	gpu->regs.int_pending = s->int_pending;
+	gpu->regs.nmi_pending = s->nmi_pending;
+}
+
+/** Get registers of plane @a i.
+ *
+ * Control registers and flags other than carry are those of the CPU.
+ *
+ * @param mach Machine
+ * @param i Plane
+ * @param s Place to store registers
+ */
+void gpu_get_regs(zx_machine_t *mach, int i, z80s *s)
+{
+	*s = mach->cpu.cpus;
+	gpu_regs_load(&mach->gpu, i, s);
+}
+
+int gpu_reset(zx_machine_t *mach) {
   /* set power on defaults */
-  z80_reset();
-  
+  z80_reset(&mach->cpu);
+
   /* store to all gpus */
-  for(i=0;i<NGP;i++) gpus[i]=cpus;
-  
+  gpu_set_regs(mach, &mach->cpu.cpus);
+
   return 0;
 }
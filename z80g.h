@@ -36,24 +36,22 @@
 #include <stdint.h>
 #include "z80.h"
 
-/* Number of graphical planes */
+/* Number of graphical planes (one byte lane of a 64-bit word each) */
 #define NGP 8
 
-extern bool gpu_allow;
-extern z80s gpus[NGP];
+struct zx_machine;
 
-extern uint8_t *gfxrom[NGP];
-extern uint8_t *gfxram[NGP];
-extern uint8_t *gfxscr[NGP];
-
-void gpu_set_allow(bool);
-void gpu_init(void);
-int gpu_enable(void);
-void gpu_disable(void);
-int gpu_reset(void);
-bool gpu_is_on(void);
-void z80_g_execinstr(void); /* execute both on CPU and GPU */
-void z80_g_int(void);       /* INT both on CPU and GPU */
-void gfx_select_memmodel(int model);
+void gpu_set_allow(struct zx_machine *, bool);
+void gpu_init(struct zx_machine *);
+int gpu_enable(struct zx_machine *);
+void gpu_disable(struct zx_machine *);
+int gpu_reset(struct zx_machine *);
+void gpu_set_regs(struct zx_machine *, const z80s *);
+void gpu_get_regs(struct zx_machine *, int, z80s *);
+void gpu_set_lanes(struct zx_machine *, bool);
+bool gpu_is_on(struct zx_machine *);
+void z80_g_execinstr(struct zx_machine *); /* execute both on CPU and GPU */
+void z80_g_int(struct zx_machine *);       /* INT both on CPU and GPU */
+uint64_t gfx_transpose(uint64_t);
 
 #endif
@@ -29,33 +29,241 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+/**
+ * @file ZX Spectrum machine.
+ *
+ * A machine owns the CPU, memory, devices and the event scheduler that
+ * drives them. The frontend creates a machine, hooks into the end of
+ * each field and then calls zx_machine_step() until it is done.
+ */
+
 #include <stdbool.h>
+#include <stdlib.h>
 
 #include "ay.h"
+#include "clock.h"
 #include "joystick/kempston.h"
+#include "memio.h"
 #include "rs232.h"
+#include "sched.h"
 #include "tape/deck.h"
+#include "video/spec256.h"
+#include "video/ula.h"
+#include "z80.h"
+#include "z80dep.h"
+#include "z80g.h"
 #include "zx.h"
 #include "zx_kbd.h"
+#include "zx_scr.h"
+#include "zx_sound.h"
+
+/** End of field: bring the picture up to date and let the frontend in. */
+static void zx_machine_frame_event(void *arg)
+{
+	zx_machine_t *mach = (zx_machine_t *)arg;
+	unsigned long t;
+
+	/*
+	 * Bring the picture up to date before it is shown. If the field ends
+	 * now, too, leave that to the video event which comes next.
+	 */
+	t = zx_scr_next_event(mach);
+	zx_scr_sync(mach, CLOCK_LT(mach->cpu.clock, t) ? mach->cpu.clock :
+	    t - 1);
+
+	mach->disp_t += ULA_FIELD_TICKS;
+	if (mach->frame != NULL)
+		mach->frame(mach->frame_arg);
+
+	sched_add(&mach->sched, &mach->ev_frame, mach->disp_t +
+	    ULA_FIELD_TICKS);
+}
+
+/** Let the video generator catch up when it next has something to do
+ * other than drawing (writes to screen memory and I/O make it catch up,
+ * too).
+ */
+static void zx_machine_video_event(void *arg)
+{
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	zx_scr_sync(mach, mach->cpu.clock);
+	sched_add(&mach->sched, &mach->ev_video, zx_scr_next_event(mach));
+}
+
+/** Build a new sound sample */
+static void zx_machine_sound_event(void *arg)
+{
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	zx_sound_smp(mach, ay_get_sample(&mach->ay) +
+	    (mach->tape_smp ? +16 : -16));
+	mach->snd_t += ZX_SOUND_TICKS_SMP;
+	sched_add(&mach->sched, &mach->ev_sound, mach->snd_t +
+	    ZX_SOUND_TICKS_SMP);
+}
+
+/** Get a new sample from the tape */
+static void zx_machine_tape_event(void *arg)
+{
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	tape_deck_getsmp(mach->tape_deck, &mach->tape_smp);
+	mach->ear = mach->tape_smp;
+	mach->tapp_t += ZX_TAPE_TICKS_SMP;
+	sched_add(&mach->sched, &mach->ev_tape, mach->tapp_t +
+	    ZX_TAPE_TICKS_SMP);
+}
+
+/** Value was written to the I/O port of the first AY (RS-232 out) */
+static void zx_machine_ay_ioport_write(void *arg, uint8_t val)
+{
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	rs232_write(&mach->rs232, val);
+}
+
+/** Character was sent via the RS-232 port (to MIDI) */
+static void zx_machine_rs232_sendchar(void *arg, uint8_t val)
+{
+	zx_machine_t *mach = (zx_machine_t *)arg;
+
+	midi_port_write(&mach->midi, val);
+}
+
+/** Schedule all periodic events relative to the current timestamps.
+ *
+ * @param mach Machine
+ */
+static void zx_machine_sched_init(zx_machine_t *mach)
+{
+	sched_init(&mach->sched);
+	sched_event_init(&mach->ev_frame, 0, zx_machine_frame_event, mach);
+	sched_event_init(&mach->ev_video, 1, zx_machine_video_event, mach);
+	sched_event_init(&mach->ev_sound, 2, zx_machine_sound_event, mach);
+	sched_event_init(&mach->ev_tape, 3, zx_machine_tape_event, mach);
 
-/** First AY */
-ay_t ay0;
-/** First AY enabled */
-bool ay0_enable = true;
+	sched_add(&mach->sched, &mach->ev_frame, mach->disp_t +
+	    ULA_FIELD_TICKS);
+	sched_add(&mach->sched, &mach->ev_video, zx_scr_next_event(mach));
+	sched_add(&mach->sched, &mach->ev_sound, mach->snd_t +
+	    ZX_SOUND_TICKS_SMP);
+	sched_add(&mach->sched, &mach->ev_tape, mach->tapp_t +
+	    ZX_TAPE_TICKS_SMP);
+}
 
-/** First Kempston joystick */
-kempston_joy_t kjoy0;
-/** First Kempston joystick enabled */
-bool kjoy0_enable = true;
+/** Create ZX Spectrum machine.
+ *
+ * The new machine is a 48K Spectrum after reset.
+ *
+ * @param vout Video output
+ * @param rmach Place to store pointer to new machine
+ * @return Zero on success, -1 on error
+ */
+int zx_machine_create(struct video_out *vout, zx_machine_t **rmach)
+{
+	zx_machine_t *mach;
+
+	mach = calloc(1, sizeof(zx_machine_t));
+	if (mach == NULL)
+		return -1;
+
+	mach->dep = zx_z80_dep;
+	mach->dep.rpage = mach->rpage;
+	mach->dep.wpage = mach->z80_wpage;
+	z80_init(&mach->cpu, &mach->dep, mach);
+
+	if (zx_io_init(mach) < 0)
+		goto error;
+	if (zx_select_memmodel(mach, ZXM_48K) < 0)
+		goto error;
+	if (video_ula_init(&mach->ula, mach, 0, vout) != 0)
+		goto error;
+	if (video_spec256_init(&mach->spec256, mach, vout) != 0)
+		goto error;
+	gpu_init(mach);
+	if (zx_keys_init(&mach->keys) < 0)
+		goto error;
+	if (ay_init(&mach->ay, ZX_SOUND_TICKS_SMP) < 0)
+		goto error;
+	mach->ay_enable = true;
+	kempston_joy_init(&mach->kjoy);
+	mach->kjoy_enable = true;
 
-/** MIDI port */
-midi_port_t midi;
+	rs232_init(&mach->rs232, Z80_CLOCK / MIDI_BAUD);
+	midi_port_init(&mach->midi);
+	mach->ay.ioport_write = zx_machine_ay_ioport_write;
+	mach->ay.ioport_write_arg = mach;
+	mach->rs232.sendchar = zx_machine_rs232_sendchar;
+	mach->rs232.sendchar_arg = mach;
 
-/** RS-232 port */
-rs232_t rs232;
+	if (tape_deck_create(&mach->tape_deck, true) != 0)
+		goto error;
+	mach->tape_deck->delta_t = ZX_TAPE_TICKS_SMP;
 
-/** Virtual tape deck */
-tape_deck_t *tape_deck;
+	mach->run = zx_machine_run;
+	zx_machine_reset(mach);
+	zx_machine_sched_init(mach);
+	mach->border = 7;
 
-/** Keyboard */
-zx_keys_t keys;
+	*rmach = mach;
+	return 0;
+error:
+	zx_machine_destroy(mach);
+	return -1;
+}
+
+/** Destroy ZX Spectrum machine.
+ *
+ * @param mach Machine
+ */
+void zx_machine_destroy(zx_machine_t *mach)
+{
+	if (mach->tape_deck != NULL)
+		tape_deck_destroy(mach->tape_deck);
+	if (mach->iorec != NULL)
+		(void) iorec_close(mach->iorec);
+	free(mach->ram);
+	free(mach->rom_copy);
+	free(mach->gpu.mem);
+	video_spec256_fini(&mach->spec256);
+	free(mach);
+}
+
+/** Reset ZX Spectrum machine.
+ *
+ * @param mach Machine
+ */
+void zx_machine_reset(zx_machine_t *mach)
+{
+	video_ula_reset(&mach->ula);
+	z80_reset(&mach->cpu);
+	ay_reset(&mach->ay);
+
+	/* select default banks */
+	mach->bnk_lock48 = 0;
+	zx_out8(mach, 0x7ffd, 0x07);
+}
+
+/** Run the CPU until the next event is due.
+ *
+ * This is the default for zx_machine_t.run.
+ *
+ * @param mach Machine
+ */
+void zx_machine_run(zx_machine_t *mach)
+{
+	z80_run_until(&mach->cpu, sched_next(&mach->sched));
+}
+
+/** Advance the machine.
+ *
+ * Fires the events that are due, then runs the CPU until the next one.
+ *
+ * @param mach Machine
+ */
+void zx_machine_step(zx_machine_t *mach)
+{
+	sched_run(&mach->sched, mach->cpu.clock);
+	mach->run(mach);
+}
@@ -33,21 +33,150 @@
 #define ZX_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "ay.h"
+#include "iorec.h"
 #include "joystick/kempston.h"
 #include "midi.h"
 #include "rs232.h"
 #include "tape/deck.h"
+#include "types/iodec.h"
+#include "types/memio.h"
+#include "types/sched.h"
+#include "types/video/spec256.h"
+#include "types/video/ula.h"
+#include "types/z80g.h"
+#include "z80.h"
 #include "zx_kbd.h"
 
-extern ay_t ay0;
-extern bool ay0_enable;
-extern kempston_joy_t kjoy0;
-extern bool kjoy0_enable;
-extern midi_port_t midi;
-extern rs232_t rs232;
-extern tape_deck_t *tape_deck;
-extern zx_keys_t keys;
+struct video_out;
+
+/** ZX Spectrum machine.
+ *
+ * Everything the emulated machine consists of. The CPU callbacks and
+ * the I/O devices get the machine as their argument, the emulator code
+ * is passed the machine it works on.
+ */
+typedef struct zx_machine {
+	/** CPU */
+	z80_t cpu;
+	/** Memory and I/O as seen by the CPU (zx_z80_dep with our tables) */
+	z80_dep_t dep;
+
+	/** Memory model (ZXM_xxx) */
+	int mem_model;
+	/** RAM, all banks */
+	uint8_t *ram;
+	/** ROM, all banks (the shared image of the model or rom_copy) */
+	uint8_t *rom;
+	/** Private ROM, used once the machine writes to its ROM */
+	uint8_t *rom_copy;
+	/** RAM size in bytes */
+	uint32_t ram_size;
+	/** ROM size in bytes */
+	uint32_t rom_size;
+	/** Currently switched in 16K banks */
+	uint8_t *bnk[4];
+	/** Displayed screen bank */
+	uint8_t *scr;
+	/** Pages seen by reads */
+	uint8_t *rpage[ZX_PAGES];
+	/** Pages seen by writes */
+	uint8_t *wpage[ZX_PAGES];
+	/** Pages the CPU core stores to directly (NULL for screen pages) */
+	uint8_t *z80_wpage[ZX_PAGES];
+	/** Writes to ROM land here */
+	uint8_t discard[ZX_PAGE_SIZE];
+	/** Reads of unmapped memory come from here (0xff) */
+	uint8_t unmapped[ZX_PAGE_SIZE];
+	/** Translated code of the ROM banks */
+	z80_aot_t *rom_aot[2];
+	/** Machine has 128K paging */
+	int has_banksw;
+	/** 128K paging is locked (48K mode) */
+	int bnk_lock48;
+	/** Last value written to the page select port */
+	uint8_t page_reg;
+	/** RAM write tracking enabled (see zx_mem_track()) */
+	bool dirty_on;
+	/** Bitmap of RAM pages written to since the last zx_mem_dirty_clear() */
+	uint32_t dirty;
+
+	/** I/O port decoder */
+	iodec_t iodec;
+	/** Devices attached to @c iodec, the first answers unclaimed ports */
+	iodec_dev_t io_dev[iodec_max_devs];
+	/** Border colour */
+	uint8_t border;
+	/** Speaker output */
+	uint8_t spk;
+	/** MIC output */
+	uint8_t mic;
+	/** EAR input */
+	uint8_t ear;
+	/** ULA video generator */
+	video_ula_t ula;
+	/** Spec256 video generator */
+	video_spec256_t spec256;
+	/** Spec256 video is displayed (instead of ULA video) */
+	bool spec256_on;
+	/** Spec256 GPU */
+	gpu_t gpu;
+	/** Keyboard */
+	zx_keys_t keys;
+	/** First AY */
+	ay_t ay;
+	/** First AY enabled */
+	bool ay_enable;
+	/** First Kempston joystick */
+	kempston_joy_t kjoy;
+	/** First Kempston joystick enabled */
+	bool kjoy_enable;
+	/** RS-232 port, driven through the I/O port of the first AY */
+	rs232_t rs232;
+	/** MIDI port, receives the characters sent via RS-232 */
+	midi_port_t midi;
+	/** I/O recording, NULL if not recording */
+	iorec_t *iorec;
+	/** Virtual tape deck */
+	tape_deck_t *tape_deck;
+	/** Last sample from the tape */
+	uint8_t tape_smp;
+
+	/** Event scheduler */
+	sched_t sched;
+	/** End of field */
+	sched_event_t ev_frame;
+	/** Video generator catches up */
+	sched_event_t ev_video;
+	/** Sound sample */
+	sched_event_t ev_sound;
+	/** Tape sample */
+	sched_event_t ev_tape;
+	/** Clock at the start of the current field */
+	unsigned long disp_t;
+	/** Clock of the last sound sample */
+	unsigned long snd_t;
+	/** Clock of the last tape sample */
+	unsigned long tapp_t;
+
+	/** Run CPU until the next event is due */
+	void (*run)(struct zx_machine *);
+	/** Breakpoints set by zx_run_select() */
+	uint16_t brk_addr[3];
+	/** Number of entries in @c brk_addr */
+	int nbrk;
+	/** Called at the end of each field (optional) */
+	void (*frame)(void *);
+	/** Argument to @c frame */
+	void *frame_arg;
+} zx_machine_t;
+
+extern int zx_machine_create(struct video_out *, zx_machine_t **);
+extern void zx_machine_destroy(zx_machine_t *);
+extern void zx_machine_reset(zx_machine_t *);
+extern void zx_machine_run(zx_machine_t *);
+extern void zx_machine_step(zx_machine_t *);
 
 #endif
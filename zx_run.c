@@ -0,0 +1,216 @@
+/*
+ * GZX - George's ZX Spectrum Emulator
+ * Run loops
+ *
+ * Copyright (c) 1999-2017 Jiri Svoboda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file Run loops.
+ *
+ * zx_machine_t.run points to one of these. zx_run_plain() batches
+ * instructions up to the next event. The others step by single
+ * instructions because the Spec256 GPU, the execution map, the trace or
+ * the debugger need to see each one. zx_run_select() picks the loop
+ * whenever the configuration might have changed.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "debug.h"
+#include "gzx.h"
+#include "sched.h"
+#include "tape/quick.h"
+#include "xmap.h"
+#include "xtrace.h"
+#include "z80.h"
+#include "z80g.h"
+#include "zx.h"
+#include "zx_run.h"
+#include "zx_scr.h"
+
+/** Set CPU breakpoints at addresses which need our attention.
+ *
+ * These are the tape traps and the debugger stop address.
+ *
+ * @param mach Machine
+ */
+static void zx_run_update_brk(zx_machine_t *mach)
+{
+	int i;
+
+	for (i = 0; i < mach->nbrk; i++)
+		z80_set_brk(&mach->cpu, mach->brk_addr[i], 0);
+
+	mach->nbrk = 0;
+	if (!slow_load) {
+		mach->brk_addr[mach->nbrk++] = TAPE_LDBYTES_TRAP;
+		mach->brk_addr[mach->nbrk++] = TAPE_SABYTES_TRAP;
+	}
+	if (dbg_stop_enabled)
+		mach->brk_addr[mach->nbrk++] = dbg_stop_addr;
+
+	for (i = 0; i < mach->nbrk; i++)
+		z80_set_brk(&mach->cpu, mach->brk_addr[i], 1);
+}
+
+/** Handle tape traps and the debugger stop address.
+ *
+ * @param mach Machine
+ * @return @c true if the debugger was entered (and the configuration
+ *         may have changed)
+ */
+static bool zx_run_traps(zx_machine_t *mach)
+{
+	if (!slow_load) {
+		if (mach->cpu.cpus.PC == TAPE_LDBYTES_TRAP) {
+			printf("load trapped!\n");
+			zx_scr_sync(mach, mach->cpu.clock);
+			tape_quick_ldbytes(mach);
+		}
+		if (mach->cpu.cpus.PC == TAPE_SABYTES_TRAP) {
+			printf("save trapped!\n");
+			tape_quick_sabytes(mach);
+		}
+	}
+	if (dbg_stop_enabled && mach->cpu.cpus.PC == dbg_stop_addr) {
+		zx_scr_sync(mach, mach->cpu.clock);
+		debugger(mach);
+		zx_run_select(mach);
+		return true;
+	}
+
+	return false;
+}
+
+/** Run the CPU until the next event is due.
+ *
+ * @param mach Machine
+ */
+void zx_run_plain(zx_machine_t *mach)
+{
+	if (zx_run_traps(mach))
+		return;
+
+	zx_machine_run(mach);
+}
+
+/** Execute one instruction in step mode.
+ *
+ * The video generator catches up after every instruction. The run loops
+ * below call this with constant arguments where they can, so that
+ * features which are off cost nothing.
+ *
+ * @param mach Machine
+ * @param gpu Spec256 GPU is on
+ * @param trace Execution map or trace is on
+ * @param itrap Enter debugger after the instruction
+ */
+static inline void zx_run_step(zx_machine_t *mach, bool gpu, bool trace,
+    bool itrap)
+{
+	zx_scr_sync(mach, mach->cpu.clock);
+	if (zx_run_traps(mach))
+		return;
+
+	if (trace) {
+		if (xmap_enabled)
+			xmap_mark(mach);
+		if (xtrace_enabled)
+			xtrace_instr(mach);
+	}
+
+	mach->cpu.deadline = mach->cpu.clock;
+	if (gpu)
+		z80_g_execinstr(mach);
+	else
+		z80_execinstr(&mach->cpu);
+
+	if (itrap) {
+		debugger(mach);
+		zx_run_select(mach);
+	}
+}
+
+/** Run loop with Spec256 GPU on.
+ *
+ * @param mach Machine
+ */
+void zx_run_gpu(zx_machine_t *mach)
+{
+	zx_run_step(mach, true, false, false);
+}
+
+/** Run loop with execution map or trace on.
+ *
+ * @param mach Machine
+ */
+void zx_run_trace(zx_machine_t *mach)
+{
+	zx_run_step(mach, gpu_is_on(mach), true, false);
+}
+
+/** Run loop entering the debugger after every instruction.
+ *
+ * @param mach Machine
+ */
+void zx_run_debug(zx_machine_t *mach)
+{
+	zx_run_step(mach, gpu_is_on(mach), xmap_enabled || xtrace_enabled,
+	    true);
+}
+
+/** Select run loop after the configuration might have changed.
+ *
+ * The configuration only changes from the user interface (processed
+ * in the frame event) or from the debugger.
+ *
+ * @param mach Machine
+ */
+void zx_run_select(zx_machine_t *mach)
+{
+	void (*run)(zx_machine_t *);
+
+	if (dbg_itrap_enabled)
+		run = zx_run_debug;
+	else if (xmap_enabled || xtrace_enabled)
+		run = zx_run_trace;
+	else if (gpu_is_on(mach))
+		run = zx_run_gpu;
+	else
+		run = zx_run_plain;
+
+	/* In step mode the video generator catches up without events */
+	if (run == zx_run_plain && mach->run != zx_run_plain)
+		sched_add(&mach->sched, &mach->ev_video,
+		    zx_scr_next_event(mach));
+
+	mach->run = run;
+	zx_run_update_brk(mach);
+}
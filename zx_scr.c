@@ -29,6 +29,7 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "clock.h"
 #include "video/defs.h"
 #include "video/display.h"
 #include "video/spec256.h"
@@ -36,60 +37,50 @@
 #include "mgfx.h"
 #include "zx_scr.h"
 #include "z80g.h"
+#include "zx.h"
 
-static void g_scr_disp_fast(void);
-
-static void n_scr_disp_fast(void);
-static void n_scr_disp(void);
-
-void (*zx_scr_disp_fast)(void) = n_scr_disp_fast;
-void (*zx_scr_disp)(void)      = n_scr_disp;
-static int video_mode = 0;
-
-static video_out_t video_out;
+video_out_t video_out;
 video_area_t video_out_area = varea_320x200;
 
-video_ula_t video_ula;
-
-static video_spec256_t video_spec256;
-
-/* crude and fast display routine, called 50 times a second */
-static void n_scr_disp_fast(void)
-{
-	video_ula_disp_fast(&video_ula);
-}
-
-static void g_scr_disp_fast(void)
+/** Crude and fast display routine, called 50 times a second.
+ *
+ * @param mach Machine
+ */
+void zx_scr_disp_fast(zx_machine_t *mach)
 {
-	video_spec256_disp_fast(&video_spec256);
+	if (mach->spec256_on)
+		video_spec256_disp_fast(&mach->spec256);
+	else
+		video_ula_disp_fast(&mach->ula);
 }
 
-/* slow and fine display routine, called after each instruction! */
-static void n_scr_disp(void)
+/** Slow and fine display routine, called after each instruction!
+ *
+ * @param mach Machine
+ */
+void zx_scr_disp(zx_machine_t *mach)
 {
-	video_ula_disp(&video_ula);
+	video_ula_disp(&mach->ula);
 }
 
-void zx_scr_mode(int mode)
+void zx_scr_mode(zx_machine_t *mach, int mode)
 {
-	if (mode && gpu_is_on()) {
-		zx_scr_disp_fast = g_scr_disp_fast;
-		video_spec256_setpal(&video_spec256);
-		video_mode = 1;
+	if (mode && gpu_is_on(mach)) {
+		video_spec256_setpal(&mach->spec256);
+		mach->spec256_on = true;
 	} else {
-		zx_scr_disp_fast = n_scr_disp_fast;
-		video_ula_setpal(&video_ula);
-		video_mode = 0;
+		video_ula_setpal(&mach->ula);
+		mach->spec256_on = false;
 	}
 }
 
-void zx_scr_update_pal(void)
+void zx_scr_update_pal(zx_machine_t *mach)
 {
-	if (!video_mode)
-		video_ula_setpal(&video_ula);
+	if (!mach->spec256_on)
+		video_ula_setpal(&mach->ula);
 }
 
-int zx_scr_init(unsigned long clock)
+int zx_scr_init(void)
 {
 	int w, h;
 
@@ -101,12 +92,6 @@ int zx_scr_init(unsigned long clock)
 	video_out.x0 = scr_xs / 2 - zx_field_w / 2;
 	video_out.y0 = scr_ys / 2 - zx_field_h / 2;
 
-	if (video_ula_init(&video_ula, clock, &video_out))
-		return -1;
-
-	if (video_spec256_init(&video_spec256, &video_out))
-		return -1;
-
 	return 0;
 }
 
@@ -125,40 +110,71 @@ int zx_scr_set_area(video_area_t area)
 	return 0;
 }
 
-void zx_scr_reset(void)
+int zx_scr_init_spec256_pal(zx_machine_t *mach)
 {
-	video_ula_reset(&video_ula);
+	return video_spec256_init_pal(&mach->spec256);
 }
 
-int zx_scr_init_spec256_pal(void)
+int zx_scr_load_bg(zx_machine_t *mach, const char *fname, int idx)
 {
-	return video_spec256_init_pal(&video_spec256);
+	return video_spec256_load_bg(&mach->spec256, fname, idx);
 }
 
-int zx_scr_load_bg(const char *fname, int idx)
+void zx_scr_prev_bg(zx_machine_t *mach)
 {
-	return video_spec256_load_bg(&video_spec256, fname, idx);
+	video_spec256_prev_bg(&mach->spec256);
 }
 
-void zx_scr_prev_bg(void)
+void zx_scr_next_bg(zx_machine_t *mach)
 {
-	video_spec256_prev_bg(&video_spec256);
+	video_spec256_next_bg(&mach->spec256);
 }
 
-void zx_scr_next_bg(void)
+void zx_scr_clear_bg(zx_machine_t *mach)
 {
-	video_spec256_next_bg(&video_spec256);
+	video_spec256_clear_bg(&mach->spec256);
 }
 
-void zx_scr_clear_bg(void)
+unsigned long zx_scr_get_clock(zx_machine_t *mach)
 {
-	video_spec256_clear_bg(&video_spec256);
+	if (mach->spec256_on)
+		return video_spec256_get_clock(&mach->spec256);
+	else
+		return video_ula_get_clock(&mach->ula);
 }
 
-unsigned long zx_scr_get_clock(void)
+/** Catch up with the CPU.
+ *
+ * Generate video up to (but not including) the specified CPU clock value.
+ * This must be done before anything that changes the picture (writes
+ * to the screen memory, border changes) or depends on the video
+ * generator (floating bus).
+ *
+ * @param mach Machine
+ * @param clock CPU clock value
+ */
+void zx_scr_sync(zx_machine_t *mach, unsigned long clock)
 {
-	if (video_mode)
-		return video_spec256_get_clock(&video_spec256);
-	else
-		return video_ula_get_clock(&video_ula);
+	if (!gpu_is_on(mach)) {
+		while (CLOCK_LT(zx_scr_get_clock(mach), clock))
+			zx_scr_disp(mach);
+	} else {
+		while (CLOCK_LT(zx_scr_get_clock(mach), clock))
+			zx_scr_disp_fast(mach);
+	}
+}
+
+/** Get CPU clock at which the video generator raises the next interrupt.
+ *
+ * Until then it is enough to call zx_scr_sync() when needed.
+ *
+ * @param mach Machine
+ * @return CPU clock value
+ */
+unsigned long zx_scr_next_event(zx_machine_t *mach)
+{
+	if (gpu_is_on(mach))
+		return zx_scr_get_clock(mach) + 1;
+
+	return video_ula_next_event(&mach->ula);
 }
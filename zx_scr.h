@@ -32,24 +32,26 @@
 #define ZX_SCR_H
 
 #include "types/video/display.h"
-#include "types/video/ula.h"
+#include "types/video/out.h"
 
-extern video_ula_t video_ula;
+struct zx_machine;
+
+extern video_out_t video_out;
 extern video_area_t video_out_area;
 
-extern int zx_scr_init(unsigned long);
-extern void zx_scr_reset(void);
-extern int zx_scr_init_spec256_pal(void);
-extern int zx_scr_load_bg(const char *, int);
-extern void zx_scr_prev_bg(void);
-extern void zx_scr_next_bg(void);
-extern void zx_scr_clear_bg(void);
-extern void zx_scr_mode(int mode);
-extern void zx_scr_update_pal(void);
-extern unsigned long zx_scr_get_clock(void);
+extern int zx_scr_init(void);
+extern int zx_scr_init_spec256_pal(struct zx_machine *);
+extern int zx_scr_load_bg(struct zx_machine *, const char *, int);
+extern void zx_scr_prev_bg(struct zx_machine *);
+extern void zx_scr_next_bg(struct zx_machine *);
+extern void zx_scr_clear_bg(struct zx_machine *);
+extern void zx_scr_mode(struct zx_machine *, int mode);
+extern void zx_scr_update_pal(struct zx_machine *);
+extern unsigned long zx_scr_get_clock(struct zx_machine *);
+extern void zx_scr_sync(struct zx_machine *, unsigned long);
+extern unsigned long zx_scr_next_event(struct zx_machine *);
 extern int zx_scr_set_area(video_area_t);
-
-extern void (*zx_scr_disp)(void);
-extern void (*zx_scr_disp_fast)(void);
+extern void zx_scr_disp(struct zx_machine *);
+extern void zx_scr_disp_fast(struct zx_machine *);
 
 #endif
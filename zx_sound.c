@@ -67,12 +67,12 @@ void zx_sound_done(void)
 	free(snd_buf);
 }
 
-void zx_sound_smp(int ay_out)
+void zx_sound_smp(zx_machine_t *mach, int ay_out)
 {
 	/* Mixing */
 
-	snd_buf[snd_bff++] = 128 + (ay0_enable ? ay_out : 0) +
-	    (spk ? -16 : +16) + (mic ? -16 : +16);
+	snd_buf[snd_bff++] = 128 + (mach->ay_enable ? ay_out : 0) +
+	    (mach->spk ? -16 : +16) + (mach->mic ? -16 : +16);
 
 	if (snd_bff >= snd_bufs) {
 		snd_bff = 0;
@@ -32,10 +32,12 @@
 #ifndef ZX_SOUND_H
 #define ZX_SOUND_H
 
+struct zx_machine;
+
 int zx_sound_init(void);
 int zx_sound_start_capture(const char *);
 void zx_sound_stop_capture(void);
 void zx_sound_done(void);
-void zx_sound_smp(int ay_out);
+void zx_sound_smp(struct zx_machine *, int ay_out);
 
 #endif